@@ -0,0 +1,153 @@
+/** @file
+  Implementacja alokatora pamięci tymczasowej (areny).
+  Bloki areny, także nieużywane bloki czekające na ponowne użycie, są
+  doliczane do licznika używanej pamięci.
+  @author Julia Podrażka
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <stdalign.h>
+
+#include "poly.h"
+#include "arena.h"
+#include "memory_budget.h"
+
+/** Domyślny rozmiar bloku areny w bajtach. */
+#define CHUNK_SIZE (64 * 1024)
+/** Maksymalna liczba nieużywanych bloków przechowywanych do ponownego użycia. */
+#define MAX_SPARE_CHUNKS 4
+/** Wyrównanie przydzielanej pamięci. */
+#define ALIGNMENT alignof(max_align_t)
+
+/**
+ * To jest struktura przechowująca blok areny.
+ */
+typedef struct ArenaChunk {
+    struct ArenaChunk *prev; ///< poprzedni blok areny
+    size_t capacity; ///< liczba bajtów w bloku
+    size_t used; ///< liczba zajętych bajtów w bloku
+    alignas(max_align_t) unsigned char data[]; ///< pamięć bloku
+} ArenaChunk;
+
+/** Blok areny, z którego aktualnie przydzielamy pamięć. */
+static _Thread_local ArenaChunk *current = NULL;
+/** Nieużywane bloki o domyślnym rozmiarze, przechowywane do ponownego użycia. */
+static _Thread_local ArenaChunk *spare = NULL;
+/** Liczba nieużywanych bloków. */
+static _Thread_local size_t spare_count = 0;
+
+/**
+ * Zaokrągla rozmiar w górę do wielokrotności wyrównania.
+ * @param[in] size : rozmiar w bajtach
+ * @return zaokrąglony rozmiar
+ */
+static size_t AlignUp(size_t size) {
+
+    return (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+}
+
+/**
+ * Zwalnia blok areny.
+ * @param[in] chunk : blok
+ */
+static void FreeChunk(ArenaChunk *chunk) {
+
+    MemoryUncharge(sizeof(ArenaChunk) + chunk -> capacity);
+    free(chunk);
+
+}
+
+/**
+ * Dokłada na szczyt areny nowy blok, w którym zmieści się @p size bajtów.
+ * @param[in] size : liczba bajtów
+ */
+static void PushChunk(size_t size) {
+
+    ArenaChunk *chunk;
+    if (size <= CHUNK_SIZE && spare != NULL) {
+        chunk = spare;
+        spare = spare -> prev;
+        spare_count--;
+    } else {
+        size_t capacity = size > CHUNK_SIZE ? size : CHUNK_SIZE;
+        MemoryCharge(sizeof(ArenaChunk) + capacity);
+        chunk = (ArenaChunk *) malloc(sizeof(ArenaChunk) + capacity);
+        CHECK_PTR(chunk);
+        chunk -> capacity = capacity;
+    }
+    chunk -> used = 0;
+    chunk -> prev = current;
+    current = chunk;
+
+}
+
+/**
+ * Zdejmuje blok ze szczytu areny.
+ */
+static void PopChunk(void) {
+
+    ArenaChunk *chunk = current;
+    current = chunk -> prev;
+    if (chunk -> capacity == CHUNK_SIZE && spare_count < MAX_SPARE_CHUNKS) {
+        chunk -> prev = spare;
+        spare = chunk;
+        spare_count++;
+    } else FreeChunk(chunk);
+
+}
+
+ArenaMark ArenaGetMark(void) {
+
+    return (ArenaMark) {.chunk = current,
+                        .used = current != NULL ? current -> used : 0};
+
+}
+
+void ArenaReset(ArenaMark mark) {
+
+    while (current != mark.chunk) PopChunk();
+    if (current != NULL) current -> used = mark.used;
+
+}
+
+void *ArenaAlloc(size_t size) {
+
+    size = AlignUp(size);
+    if (current == NULL || current -> capacity - current -> used < size)
+        PushChunk(size);
+    void *ptr = current -> data + current -> used;
+    current -> used += size;
+    return ptr;
+
+}
+
+void *ArenaRealloc(void *ptr, size_t old_size, size_t new_size) {
+
+    if (ptr == NULL) return ArenaAlloc(new_size);
+    old_size = AlignUp(old_size);
+    size_t aligned_size = AlignUp(new_size);
+    unsigned char *block = (unsigned char *) ptr;
+    // Ostatnio przydzielony blok powiększamy w miejscu, jeśli się zmieści.
+    if (block + old_size == current -> data + current -> used &&
+        (size_t) (block - current -> data) + aligned_size <= current -> capacity) {
+        current -> used = (size_t) (block - current -> data) + aligned_size;
+        return ptr;
+    }
+    if (new_size <= old_size) return ptr;
+    void *new_ptr = ArenaAlloc(new_size);
+    memcpy(new_ptr, ptr, old_size);
+    return new_ptr;
+
+}
+
+void ArenaReleaseSpare(void) {
+
+    while (spare != NULL) {
+        ArenaChunk *chunk = spare;
+        spare = chunk -> prev;
+        FreeChunk(chunk);
+    }
+    spare_count = 0;
+
+}
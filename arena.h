@@ -0,0 +1,62 @@
+/** @file
+  Interfejs alokatora pamięci tymczasowej (areny) używanego przez operacje
+  na wielomianach.
+  Pamięć przydzielana jest przez przesuwanie wskaźnika i zwalniana w całości
+  przez powrót do wcześniej zapamiętanego znacznika, więc zwalnianie musi
+  odbywać się w kolejności odwrotnej do zapamiętywania znaczników.
+  Każdy wątek ma własną arenę.
+  @author Julia Podrażka
+ */
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+struct ArenaChunk;
+
+/**
+ * To jest struktura przechowująca stan areny, do którego można wrócić
+ * funkcją ArenaReset.
+ */
+typedef struct ArenaMark {
+    struct ArenaChunk *chunk; ///< aktualny blok areny
+    size_t used; ///< liczba zajętych bajtów aktualnego bloku
+} ArenaMark;
+
+/**
+ * Zapamiętuje aktualny stan areny.
+ * @return znacznik stanu areny
+ */
+ArenaMark ArenaGetMark(void);
+
+/**
+ * Zwalnia całą pamięć przydzieloną z areny po utworzeniu znacznika @p mark.
+ * @param[in] mark : znacznik stanu areny
+ */
+void ArenaReset(ArenaMark mark);
+
+/**
+ * Przydziela z areny @p size bajtów pamięci.
+ * @param[in] size : liczba bajtów
+ * @return wskaźnik na przydzieloną pamięć
+ */
+void *ArenaAlloc(size_t size);
+
+/**
+ * Zmienia rozmiar bloku przydzielonego z areny. Jeśli blok był ostatnio
+ * przydzielonym blokiem i mieści się w aktualnym bloku areny, to jest
+ * powiększany w miejscu, w przeciwnym przypadku jego zawartość jest kopiowana.
+ * @param[in] ptr : wskaźnik na blok przydzielony z areny
+ * @param[in] old_size : aktualny rozmiar bloku w bajtach
+ * @param[in] new_size : nowy rozmiar bloku w bajtach
+ * @return wskaźnik na blok o nowym rozmiarze
+ */
+void *ArenaRealloc(void *ptr, size_t old_size, size_t new_size);
+
+/**
+ * Zwalnia nieużywane bloki areny bieżącego wątku. Wywoływana przed
+ * zakończeniem wątku.
+ */
+void ArenaReleaseSpare(void);
+
+#endif
@@ -3,19 +3,26 @@
   stosującego odwrotną notację polską.
   @author Julia Podrażka
  */
-/** Pozwala korzystać z funkcji getline. */
-#define _GNU_SOURCE
-
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
-#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
 
 #include "poly.h"
-#include "make_command.h"
 #include "stack.h"
 #include "make_poly.h"
+#include "reader.h"
+#include "program.h"
+#include "library.h"
+#include "intern.h"
+#include "thread_pool.h"
+#include "pipeline.h"
+#include "server.h"
+#include "stats.h"
+#include "memory_budget.h"
+#include "trace.h"
+#include "cli_common.h"
 
 /** Pierwszy indeks w tablicy. */
 #define FIRST_IDX 0
@@ -29,105 +36,294 @@
 #define COMMENT 35
 /** Kod ascii znaku nowej linii. */
 #define NEWLINE 10
-/** Kod ascii znaku otwierającego nawiasu. */
-#define OPEN_BRACKET 40
 /** Kod ascii znaku zamykającego nawiasu. */
 #define CLOSE_BRACKET 41
 /** Kod ascii znaku plus. */
 #define PLUS 43
 /** Kod ascii znaku przecinka. */
 #define COMMA 44
-/** Kod ascii znaku minusa. */
-#define MINUS 45
-/** Baza konwertowania liczb. */
-#define BASE 10
-/** Wartość getline po wczytaniu końca pliku. */
-#define LAST_LINE -1
-/** Początkowa wartość errno. */
-#define ERRNO 0
+/** Opcja ustawiająca liczbę wątków. */
+#define THREADS_OPTION "--threads="
+/** Opcja otwierająca bibliotekę nazwanych wielomianów. */
+#define LIBRARY_OPTION "--library="
+/** Opcja wykonująca skompilowany skrypt dla zestawów literałów z wejścia. */
+#define PROGRAM_OPTION "--program="
+/** Opcja wykonująca komendy potokiem wątków. */
+#define PIPELINE_OPTION "--pipeline"
+/** Opcja uruchamiająca serwer na gnieździe domeny Uniksa. */
+#define SERVER_OPTION "--server="
+/** Opcja ustawiająca liczbę jednocześnie obsługiwanych sesji serwera. */
+#define SESSIONS_OPTION "--sessions="
+/** Opcja ograniczająca liczbę wielomianów na stosie sesji. */
+#define MAX_STACK_OPTION "--max-stack="
+/** Opcja ograniczająca długość wiersza sesji. */
+#define MAX_LINE_OPTION "--max-line="
+/** Opcja ograniczająca pamięć wielomianów sesji. */
+#define MAX_MEMORY_OPTION "--max-memory="
+/** Opcja ustawiająca czas oczekiwania na klienta sesji. */
+#define IDLE_TIMEOUT_OPTION "--idle-timeout="
+/** Opcja włączająca wypisywanie statystyk komend. */
+#define STATS_DUMP_OPTION "--stats-dump"
+/** Opcja ustawiająca budżet pamięci operacji. */
+#define MEMORY_BUDGET_OPTION "--memory-budget="
+/** Opcja włączająca śledzenie wykonania. */
+#define TRACE_OPTION "--trace="
+/** Opcja ustawiająca liczbę śledzonych przedziałów w buforze wątku. */
+#define TRACE_EVENTS_OPTION "--trace-events="
+/** Maksymalna liczba wątków. */
+#define MAX_THREADS 1024
+/** Domyślna liczba jednocześnie obsługiwanych sesji. */
+#define DEFAULT_SESSIONS 4
+/** Domyślna maksymalna liczba wielomianów na stosie sesji. */
+#define DEFAULT_STACK_LIMIT (1 << 20)
+/** Domyślna maksymalna długość wiersza sesji. */
+#define DEFAULT_LINE_LIMIT (16 << 20)
+/** Domyślna maksymalna liczba bajtów pamięci wielomianów sesji. */
+#define DEFAULT_MEMORY_LIMIT ((size_t) 1 << 30)
+/** Domyślny czas oczekiwania na klienta sesji w sekundach. */
+#define DEFAULT_IDLE_SECONDS 60
+/** Maksymalna wartość ograniczenia zasobów sesji. */
+#define MAX_LIMIT ((size_t) 1 << 40)
+/** Maksymalna liczba śledzonych przedziałów w buforze wątku. */
+#define MAX_TRACE_EVENTS ((size_t) 1 << 24)
+
+/** Czy komendy wykonywać potokiem wątków. */
+static bool pipelined = false;
 
 /**
- * Wyświetla błąd ze znakiem zerowym w zależności od początku wiersza.
- * @param[in] char_arr : tablica ze znakami z wiersza
- * @param[in] line_number : numer wiersza
+ * Wczytuje kolejne wiersze ze standardowego wejścia, kompiluje każdy z nich
+ * do instrukcji i od razu ją wykonuje. Wielomiany są parsowane bezpośrednio
+ * z bufora wejścia, a komendy, które dzielone są funkcją strtok, z kopii
+ * wiersza zakończonej znakiem zerowym. Przy wykonywaniu potokiem wątków
+ * wiersze kompilowane są w osobnym wątku, a wyniki wypisywane w kolejnym.
  */
-static void PrintNullError(char *char_arr, size_t line_number) {
-
-    if ((int) char_arr[FIRST_IDX] != NULL_CHAR &&
-        isalpha(char_arr[FIRST_IDX])) {
-        if (strncmp(char_arr, "AT", 2) == 0 && isspace(char_arr[2]))
-            fprintf(stderr, "ERROR %zu AT WRONG VALUE\n", line_number);
-        else if (strncmp(char_arr, "DEG_BY", 6) == 0 &&
-                 isspace(char_arr[6]))
-            fprintf(stderr, "ERROR %zu DEG BY WRONG VARIABLE\n", line_number);
-        else if (strncmp(char_arr, "COMPOSE", 7) == 0 &&
-                 isspace(char_arr[7]))
-            fprintf(stderr, "ERROR %zu COMPOSE WRONG PARAMETER\n", line_number);
-        else fprintf(stderr, "ERROR %zu WRONG COMMAND\n", line_number);
-    } else fprintf(stderr, "ERROR %zu WRONG POLY\n", line_number);
+static void Read() {
+
+    if (pipelined) {
+        PipelineRun();
+        InternClear();
+        LibraryClose();
+        return;
+    }
+
+    stack s = InitStack();
+    Program program = ProgramInit();
+    Reader reader;
+    ReaderInit(&reader, STDIN_FILENO);
+
+    size_t line_number = ONE_ELEMENT;
+    size_t line;
+    char *char_arr = ReadLine(&reader, &line);
+
+    while (char_arr != NULL) {
+        ProgramCompileLine(&program, &reader, char_arr, line, line_number);
+        ProgramRunAndClear(&program, &s);
+        char_arr = ReadLine(&reader, &line);
+        line_number++;
+    }
+
+    ReaderFree(&reader);
+    ProgramFree(&program);
+    RemoveStack(&s);
+    InternClear();
+    LibraryClose();
 
 }
 
 /**
- * Wczytuje kolejne wiersze ze standardowego wejścia i przekierowuje wiersze
- * odpowiednio do funkcji zajmującej się parsowaniem wielomianów i do funckji
- * zajmującej się parsowaniem komend lub omija wiersz czy wypisuje błąd wczytywania.
+ * Wykonuje skompilowany program na nowym stosie z podanymi wartościami
+ * literałów.
+ * @param[in] program : program
+ * @param[in] inputs : wartości literałów
  */
-static void Read() {
+static void RunOnce(const Program *program, const Poly inputs[]) {
 
     stack s = InitStack();
+    ProgramRun(program, &s, inputs);
+    RemoveStack(&s);
 
-    ssize_t line_number = ONE_ELEMENT;
-    size_t char_arr_size = SIZE;
-    char *char_arr = (char *) malloc(char_arr_size);
-    CHECK_PTR(char_arr);
-
-    errno = ERRNO;
-    ssize_t line = getline(&char_arr, &char_arr_size, stdin);
-    if (errno == ENOMEM) exit(1);
-    CHECK_PTR(char_arr);
-
-    while (line != (ssize_t) LAST_LINE) {
-        ssize_t char_number = strlen(char_arr);
-        // Sprawdza, czy wczytano znak zerowy, jeśli tak, to wypisuje
-        // odpowiedni błąd.
-        if (char_number != line) PrintNullError(char_arr, line_number);
-        else if (char_number > FIRST_IDX && char_arr[FIRST_IDX] != COMMENT &&
-                 char_arr[FIRST_IDX] != NEWLINE) {
-            if (isalpha(char_arr[FIRST_IDX])) {
-                // Jeśli na końcu wczytanego wiersza mamy znak przejścia do
-                // następnej linii, to przekazujemy o jeden mniejszy rozmiar wiersza
-                if (char_arr[char_number - ONE_ELEMENT] == NEWLINE) {
-                    MakeCommand(&s, char_arr, char_number - ONE_ELEMENT,
-                                line_number);
-                } else MakeCommand(&s, char_arr, char_number, line_number);
-            } else if (isdigit(char_arr[FIRST_IDX]) ||
-                       char_arr[FIRST_IDX] == OPEN_BRACKET ||
-                       char_arr[FIRST_IDX] == MINUS) {
-                MakePoly(&s, char_arr, line_number);
-            } else {
-                fprintf(stderr, "ERROR %zu WRONG POLY\n", line_number);
+}
+
+/**
+ * Kompiluje raz skrypt z pliku @p path, a następnie wykonuje go dla
+ * kolejnych zestawów literałów ze standardowego wejścia. Zestawy oddzielone
+ * są pustymi wierszami, a każdy wielomian zestawu zastępuje kolejny literał
+ * skryptu; pozostałe literały mają wartości ze skryptu. Zestaw z błędnym
+ * wielomianem lub ze zbyt wieloma wielomianami nie jest wykonywany. Jeśli
+ * wejście nie zawiera żadnego zestawu, to skrypt wykonywany jest raz
+ * z literałami ze skryptu. Każde wykonanie zaczyna się od pustego stosu.
+ * @param[in] path : ścieżka pliku ze skryptem
+ * @return Czy udało się otworzyć plik ze skryptem?
+ */
+static bool ReadInputs(const char *path) {
+
+    int fd = open(path, O_RDONLY);
+    if (fd < FIRST_IDX) return false;
+    Program program = ProgramInit();
+    ProgramCompile(&program, fd);
+    close(fd);
+
+    size_t count = program.literal_count;
+    Poly *inputs = (Poly *) malloc((count + ONE_ELEMENT) * sizeof(Poly));
+    CHECK_PTR(inputs);
+    Reader reader;
+    ReaderInit(&reader, STDIN_FILENO);
+
+    // Wielomiany inputs[0..given) zostały wczytane z wejścia i należą do
+    // zestawu, a pozostałe są pożyczone z programu.
+    size_t given = FIRST_IDX;
+    bool is_correct = true, is_started = false, was_run = false;
+    size_t line_number = ONE_ELEMENT;
+    size_t line;
+    char *char_arr = ReadLine(&reader, &line);
+    while (true) {
+        bool is_end = char_arr == NULL || (int) char_arr[FIRST_IDX] == NEWLINE;
+        if (is_end && is_started) {
+            if (is_correct) {
+                memcpy(inputs + given, program.literals + given,
+                       (count - given) * sizeof(Poly));
+                RunOnce(&program, inputs);
             }
+            for (size_t i = FIRST_IDX; i < given; i++) PolyDestroy(&inputs[i]);
+            given = FIRST_IDX;
+            is_correct = true;
+            is_started = false;
+            was_run = true;
+        } else if (!is_end && (int) char_arr[FIRST_IDX] != COMMENT) {
+            // Po pierwszym błędzie pozostałe wiersze zestawu są pomijane.
+            is_started = true;
+            Poly p;
+            if (is_correct && given == count) {
+                fprintf(stderr, "ERROR %zu TOO MANY INPUTS\n", line_number);
+                is_correct = false;
+            } else if (is_correct && (memchr(char_arr, NULL_CHAR, line) != NULL ||
+                                      !MakePoly(char_arr, &p))) {
+                fprintf(stderr, "ERROR %zu WRONG POLY\n", line_number);
+                is_correct = false;
+            } else if (is_correct) inputs[given++] = p;
         }
-        errno = ERRNO;
-        line = getline(&char_arr, &char_arr_size, stdin);
-        if (errno == ENOMEM) exit(1);
-        CHECK_PTR(char_arr);
+        if (char_arr == NULL) break;
+        char_arr = ReadLine(&reader, &line);
         line_number++;
     }
+    if (!was_run) RunOnce(&program, program.literals);
 
-    free(char_arr);
-    RemoveStack(&s);
+    ReaderFree(&reader);
+    free(inputs);
+    ProgramFree(&program);
+    InternClear();
+    LibraryClose();
+    return true;
 
 }
 
 /**
- * Funkcja wykonująca program.
+ * Funkcja wykonująca program. Obsługiwane opcje:
+ * - `--intern` włącza tryb współdzielenia wielomianów,
+ * - `--threads=N` wykonuje obliczenia przy pomocy @p N wątków,
+ * - `--library=PLIK` otwiera bibliotekę nazwanych wielomianów dla komendy
+ *   LOAD_NAMED,
+ * - `--program=PLIK` kompiluje raz skrypt z pliku @p PLIK i wykonuje go dla
+ *   kolejnych zestawów literałów ze standardowego wejścia,
+ * - `--pipeline` wykonuje komendy potokiem trzech wątków: parsującego,
+ *   wykonującego i wypisującego; nie dotyczy opcji `--program`,
+ * - `--server=ŚCIEŻKA` zamiast czytać standardowe wejście nasłuchuje na
+ *   gnieździe domeny Uniksa @p ŚCIEŻKA, a każde połączenie jest sesją
+ *   z własnym stosem; działa do sygnału SIGINT lub SIGTERM,
+ * - `--sessions=N` ustawia liczbę jednocześnie obsługiwanych sesji,
+ * - `--max-stack=N`, `--max-line=N`, `--max-memory=BAJTY`
+ *   i `--idle-timeout=SEKUNDY` ustawiają ograniczenia zasobów sesji: liczbę
+ *   wielomianów na stosie, długość wiersza, pamięć wielomianów i czas
+ *   oczekiwania na klienta,
+ * - `--stats-dump` wypisuje statystyki komend w formacie JSON na
+ *   standardowe wyjście błędów po sygnale SIGUSR1 i przy zakończeniu
+ *   programu,
+ * - `--memory-budget=BAJTY` ogranicza pamięć używaną przez wielomiany:
+ *   komenda ADD, MUL, SUB, AT, AT_MANY lub COMPOSE, która przekroczyłaby
+ *   budżet, jest przerywana z błędem `MEMORY BUDGET EXCEEDED`, a stos
+ *   pozostaje bez zmian,
+ * - `--trace=PLIK` zapisuje przy zakończeniu programu do pliku @p PLIK
+ *   przedziały czasu wykonania wierszy, parsowania, mnożenia, sortowania
+ *   i scalania jednomianów, usuwania zerowych wielomianów oraz wypisywania
+ *   w formacie zdarzeń Chrome,
+ * - `--trace-events=N` ustawia liczbę ostatnich przedziałów zachowywanych
+ *   przez każdy wątek.
+ * @param[in] argc : liczba argumentów
+ * @param[in] argv : argumenty
  * @return kod wyjścia programu
  */
-int main() {
+int main(int argc, char *argv[]) {
 
-    Read();
+    size_t threads = ONE_ELEMENT, sessions = DEFAULT_SESSIONS, budget = FIRST_IDX;
+    size_t trace_events = TRACE_DEFAULT_EVENTS;
+    ServerLimits limits = (ServerLimits) {.stack_size = DEFAULT_STACK_LIMIT,
+                                          .line_length = DEFAULT_LINE_LIMIT,
+                                          .memory = DEFAULT_MEMORY_LIMIT,
+                                          .idle_seconds = DEFAULT_IDLE_SECONDS};
+    const char *program = NULL, *server = NULL, *trace = NULL;
+    for (int i = ONE_ELEMENT; i < argc; i++) {
+        if (strcmp(argv[i], "--intern") == 0) InternEnable();
+        else if (strcmp(argv[i], PIPELINE_OPTION) == 0) pipelined = true;
+        else if (strcmp(argv[i], STATS_DUMP_OPTION) == 0) StatsEnableDump();
+        else if (ParseCount(argv[i], THREADS_OPTION, MAX_THREADS, &threads) ||
+                 ParseCount(argv[i], SESSIONS_OPTION, MAX_THREADS, &sessions) ||
+                 ParseCount(argv[i], MAX_STACK_OPTION, MAX_LIMIT, &limits.stack_size) ||
+                 ParseCount(argv[i], MAX_LINE_OPTION, MAX_LIMIT, &limits.line_length) ||
+                 ParseCount(argv[i], MAX_MEMORY_OPTION, MAX_LIMIT, &limits.memory) ||
+                 ParseCount(argv[i], IDLE_TIMEOUT_OPTION, MAX_LIMIT,
+                            &limits.idle_seconds) ||
+                 ParseCount(argv[i], MEMORY_BUDGET_OPTION, MAX_LIMIT, &budget) ||
+                 ParseCount(argv[i], TRACE_EVENTS_OPTION, MAX_TRACE_EVENTS,
+                            &trace_events)) continue;
+        else if (strncmp(argv[i], LIBRARY_OPTION, strlen(LIBRARY_OPTION)) == 0) {
+            if (!LibraryOpen(argv[i] + strlen(LIBRARY_OPTION))) {
+                fprintf(stderr, "CANNOT OPEN LIBRARY %s\n",
+                        argv[i] + strlen(LIBRARY_OPTION));
+                return 1;
+            }
+        } else if (strncmp(argv[i], PROGRAM_OPTION, strlen(PROGRAM_OPTION)) == 0)
+            program = argv[i] + strlen(PROGRAM_OPTION);
+        else if (strncmp(argv[i], SERVER_OPTION, strlen(SERVER_OPTION)) == 0)
+            server = argv[i] + strlen(SERVER_OPTION);
+        else if (strncmp(argv[i], TRACE_OPTION, strlen(TRACE_OPTION)) == 0)
+            trace = argv[i] + strlen(TRACE_OPTION);
+        else {
+            fprintf(stderr, "UNKNOWN OPTION %s\n", argv[i]);
+            return 1;
+        }
+    }
+    MemorySetBudget(budget);
+    if (trace != NULL && !TraceStart(trace, trace_events)) {
+        fprintf(stderr, "CANNOT OPEN TRACE %s\n", trace);
+        return 1;
+    }
+
+    if (server != NULL) {
+        // Sesje działają w osobnych wątkach, więc obliczenia każdej z nich
+        // są wykonywane przez jej wątek, bez puli wątków.
+        bool is_listening = ServerRun(server, sessions, &limits);
+        InternClear();
+        LibraryClose();
+        TraceStop();
+        if (is_listening && StatsDumpEnabled()) StatsDump();
+        if (!is_listening) {
+            fprintf(stderr, "CANNOT LISTEN %s\n", server);
+            return 1;
+        }
+        return 0;
+    }
+
+    ThreadPoolStart(threads);
+    bool is_correct = true;
+    if (program == NULL) Read();
+    else is_correct = ReadInputs(program);
+    ThreadPoolStop();
+    TraceStop();
+    if (is_correct && StatsDumpEnabled()) StatsDump();
+    if (!is_correct) {
+        fprintf(stderr, "CANNOT OPEN PROGRAM %s\n", program);
+        return 1;
+    }
     return 0;
 
 }
\ No newline at end of file
@@ -0,0 +1,525 @@
+/** @file
+  Benchmarki całego kalkulatora na reprezentatywnych skryptach.
+  Program ma trzy tryby:
+  - `generate KATALOG` zapisuje w katalogu skrypty obciążeń, z których każde
+    obciąża inną fazę działania kalkulatora: parsowanie wielomianów, długie
+    łańcuchy dodawań i mnożeń, głębokie złożenia oraz wypisywanie wyników,
+  - `run PROGRAM KATALOG` wykonuje program kalkulatora na każdym skrypcie
+    i wypisuje w formacie JSON mediany czasu rzeczywistego, czasu
+    użytkownika i systemu oraz maksymalną pamięć rezydentną,
+  - `compare BAZOWY AKTUALNY` porównuje dwa wyniki trybu run i kończy się
+    kodem 1, jeśli któraś miara pogorszyła się bardziej niż o zadany próg.
+  @author Julia Podrażka
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+
+#include "cli_common.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Dwa elementy w tablicy. */
+#define TWO_ELEMENTS 2
+/** Kod ascii znaku zerowego. */
+#define NULL_CHAR 0
+/** Maksymalna długość ścieżki pliku. */
+#define MAX_PATH 4096
+/** Maksymalna długość wiersza pliku z wynikami. */
+#define MAX_LINE 1024
+/** Maksymalna liczba wyników w pliku z wynikami. */
+#define MAX_RESULTS 64
+/** Maksymalna liczba powtórzeń pomiaru. */
+#define MAX_REPEAT 101
+/** Maksymalny rozmiar obciążenia. */
+#define MAX_SIZE 100000000
+/** Maksymalny moduł współczynnika w skryptach. */
+#define COEFF 1000
+/** Liczba milisekund w sekundzie. */
+#define MILLISECONDS 1000.0
+/** Liczba mikrosekund w milisekundzie. */
+#define MICROSECONDS 1000.0
+/** Liczba nanosekund w milisekundzie. */
+#define NANOSECONDS 1000000.0
+/** Liczba procentów w całości. */
+#define PERCENT 100.0
+/** Domyślny rozmiar obciążenia w wierszach. */
+#define DEFAULT_SIZE 100000
+/** Domyślne ziarno generatora. */
+#define DEFAULT_SEED 42
+/** Domyślna liczba powtórzeń pomiaru. */
+#define DEFAULT_REPEAT 5
+/** Domyślny próg regresji w procentach. */
+#define DEFAULT_THRESHOLD 10
+/** Zmiana czasu w milisekundach, poniżej której nie zgłaszamy regresji. */
+#define MIN_DELTA_MS 5.0
+/** Zmiana pamięci w kilobajtach, poniżej której nie zgłaszamy regresji. */
+#define MIN_DELTA_KB 1024.0
+/** Liczba zmiennych wielomianów w skryptach. */
+#define VARS 3
+/** Maksymalny wykładnik w wielomianach w skryptach. */
+#define DEGREE 20
+/** Liczba operacji w jednym łańcuchu dodawań i mnożeń. */
+#define CHAIN_LENGTH 16
+/** Co który element łańcucha jest mnożony zamiast dodawany. */
+#define CHAIN_MUL_EVERY 4
+/** Liczba kolejnych złożeń wielomianu z samym sobą. */
+#define COMPOSE_DEPTH 6
+/** Liczba wierszy PRINT przypadających na jeden wielomian. */
+#define PRINTS_PER_POLY 100
+/** Minimalna liczba wyrazów wielomianu parsowanego. */
+#define PARSE_MIN_TERMS 8
+/** Rozrzut liczby wyrazów wielomianu parsowanego. */
+#define PARSE_SPREAD_TERMS 24
+/** Liczba wyrazów elementu łańcucha dodawań i mnożeń. */
+#define CHAIN_TERMS 3
+/** Liczba wyrazów wielomianu wypisywanego. */
+#define PRINT_TERMS 32
+/** Liczba wierszy łańcucha albo złożeń poza parami operacji. */
+#define TAIL_LINES 3
+
+/**
+ * To są mierzone wielkości.
+ */
+typedef enum Metric {
+    WALL_MS, ///< czas rzeczywisty w milisekundach
+    USER_MS, ///< czas użytkownika w milisekundach
+    SYS_MS, ///< czas systemu w milisekundach
+    PEAK_RSS_KB, ///< maksymalna pamięć rezydentna w kilobajtach
+    METRIC_COUNT ///< liczba mierzonych wielkości
+} Metric;
+
+/** Nazwy mierzonych wielkości. */
+static const char *const METRICS[METRIC_COUNT] = {
+    [WALL_MS] = "wall_ms",
+    [USER_MS] = "user_ms",
+    [SYS_MS] = "sys_ms",
+    [PEAK_RSS_KB] = "peak_rss_kb"
+};
+
+/**
+ * To jest struktura przechowująca wynik pomiaru jednego obciążenia.
+ */
+typedef struct Result {
+    char workload[MAX_LINE]; ///< nazwa obciążenia
+    double values[METRIC_COUNT]; ///< wartości mierzonych wielkości
+} Result;
+
+/**
+ * To jest struktura opisująca obciążenie.
+ */
+typedef struct Workload {
+    const char *name; ///< nazwa obciążenia i pliku ze skryptem
+    /** Zapisuje skrypt obciążenia o około @p size wierszach. */
+    void (*generate)(FILE *file, uint64_t *state, size_t size);
+} Workload;
+
+/**
+ * Zapisuje losowy wielomian w formacie kalkulatora. Wielomian ma około
+ * @p terms wyrazów w @p vars zmiennych, a wykładniki jednomianów rosną.
+ * @param[in] file : plik
+ * @param[in,out] state : stan generatora
+ * @param[in] vars : liczba zmiennych
+ * @param[in] terms : liczba wyrazów
+ */
+static void WriteRandomPoly(FILE *file, uint64_t *state, size_t vars, size_t terms) {
+
+    if (vars == FIRST_IDX || terms == FIRST_IDX) {
+        long coeff = (long) RandomUpTo(state, COEFF - ONE_ELEMENT) + ONE_ELEMENT;
+        fprintf(file, "%ld", NextRandom(state) & ONE_ELEMENT ? coeff : -coeff);
+        return;
+    }
+    size_t monos = ONE_ELEMENT + RandomUpTo(state, terms - ONE_ELEMENT);
+    size_t exp = RandomUpTo(state, DEGREE);
+    for (size_t i = FIRST_IDX; i < monos; i++) {
+        if (i > FIRST_IDX) fputc('+', file);
+        fputc('(', file);
+        WriteRandomPoly(file, state, vars - ONE_ELEMENT, terms / monos);
+        fprintf(file, ",%zu)", exp);
+        exp += ONE_ELEMENT + RandomUpTo(state, DEGREE);
+    }
+
+}
+
+/**
+ * Zapisuje skrypt z dużymi wielomianami, z których każdy jest od razu
+ * zdejmowany ze stosu, więc czas zajmuje głównie parsowanie.
+ * @param[in] file : plik
+ * @param[in,out] state : stan generatora
+ * @param[in] size : liczba wierszy
+ */
+static void GenerateParse(FILE *file, uint64_t *state, size_t size) {
+
+    for (size_t i = FIRST_IDX; i < size; i += TWO_ELEMENTS) {
+        WriteRandomPoly(file, state, VARS,
+                        PARSE_MIN_TERMS + RandomUpTo(state, PARSE_SPREAD_TERMS));
+        fputs("\nPOP\n", file);
+    }
+
+}
+
+/**
+ * Zapisuje skrypt z łańcuchami dodawań i mnożeń małych wielomianów. Każdy
+ * łańcuch zaczyna się od pustego stosu i kończy sprawdzeniem wyniku.
+ * @param[in] file : plik
+ * @param[in,out] state : stan generatora
+ * @param[in] size : liczba wierszy
+ */
+static void GenerateChain(FILE *file, uint64_t *state, size_t size) {
+
+    for (size_t i = FIRST_IDX; i < size; i += TWO_ELEMENTS * CHAIN_LENGTH + TAIL_LINES) {
+        WriteRandomPoly(file, state, TWO_ELEMENTS, CHAIN_TERMS);
+        fputc('\n', file);
+        for (size_t j = ONE_ELEMENT; j <= CHAIN_LENGTH; j++) {
+            WriteRandomPoly(file, state, TWO_ELEMENTS, CHAIN_TERMS);
+            fputs(j % CHAIN_MUL_EVERY == FIRST_IDX ? "\nMUL\n" : "\nADD\n", file);
+        }
+        fputs("IS_ZERO\nPOP\n", file);
+    }
+
+}
+
+/**
+ * Zapisuje skrypt, w którym wielomian jest wielokrotnie składany z samym
+ * sobą, więc jego stopień rośnie wykładniczo z głębokością złożenia.
+ * @param[in] file : plik
+ * @param[in,out] state : stan generatora
+ * @param[in] size : liczba wierszy
+ */
+static void GenerateCompose(FILE *file, uint64_t *state, size_t size) {
+
+    for (size_t i = FIRST_IDX; i < size; i += TWO_ELEMENTS * COMPOSE_DEPTH + TAIL_LINES) {
+        fputs("(1,1)\n", file);
+        for (size_t j = FIRST_IDX; j < COMPOSE_DEPTH; j++) {
+            long c = (long) RandomUpTo(state, COEFF);
+            fprintf(file, "(%ld,0)+(1,1)+(1,2)\nCOMPOSE 1\n", c);
+        }
+        fputs("DEG\nPOP\n", file);
+    }
+
+}
+
+/**
+ * Zapisuje skrypt, w którym większość wierszy to komendy PRINT
+ * wypisujące średniej wielkości wielomiany.
+ * @param[in] file : plik
+ * @param[in,out] state : stan generatora
+ * @param[in] size : liczba wierszy
+ */
+static void GeneratePrint(FILE *file, uint64_t *state, size_t size) {
+
+    for (size_t i = FIRST_IDX; i < size; i += PRINTS_PER_POLY + TWO_ELEMENTS) {
+        WriteRandomPoly(file, state, VARS, PRINT_TERMS);
+        fputc('\n', file);
+        for (size_t j = FIRST_IDX; j < PRINTS_PER_POLY; j++) fputs("PRINT\n", file);
+        fputs("POP\n", file);
+    }
+
+}
+
+/** Obciążenia w kolejności pomiaru. */
+static const Workload WORKLOADS[] = {
+    {.name = "parse", .generate = GenerateParse},
+    {.name = "chain", .generate = GenerateChain},
+    {.name = "compose", .generate = GenerateCompose},
+    {.name = "print", .generate = GeneratePrint}
+};
+
+/** Liczba obciążeń. */
+#define WORKLOAD_COUNT (sizeof(WORKLOADS) / sizeof(WORKLOADS[FIRST_IDX]))
+
+/**
+ * Zapisuje ścieżkę skryptu obciążenia.
+ * @param[out] path : ścieżka
+ * @param[in] dir : katalog ze skryptami
+ * @param[in] workload : obciążenie
+ * @return Czy ścieżka zmieściła się w tablicy?
+ */
+static bool WorkloadPath(char path[MAX_PATH], const char *dir, const Workload *workload) {
+
+    int length = snprintf(path, MAX_PATH, "%s/%s.txt", dir, workload -> name);
+    return length >= FIRST_IDX && length < MAX_PATH;
+
+}
+
+/**
+ * Zapisuje skrypty wszystkich obciążeń w katalogu @p dir.
+ * @param[in] dir : katalog
+ * @param[in] size : liczba wierszy każdego skryptu
+ * @param[in] seed : ziarno generatora
+ * @return kod wyjścia programu
+ */
+static int Generate(const char *dir, size_t size, uint64_t seed) {
+
+    for (size_t i = FIRST_IDX; i < WORKLOAD_COUNT; i++) {
+        char path[MAX_PATH];
+        FILE *file = WorkloadPath(path, dir, &WORKLOADS[i]) ? fopen(path, "w") : NULL;
+        if (file == NULL) {
+            fprintf(stderr, "CANNOT WRITE %s/%s.txt\n", dir, WORKLOADS[i].name);
+            return 1;
+        }
+        uint64_t state = seed + i;
+        WORKLOADS[i].generate(file, &state, size);
+        if (fclose(file) != FIRST_IDX) {
+            fprintf(stderr, "CANNOT WRITE %s\n", path);
+            return 1;
+        }
+    }
+    return 0;
+
+}
+
+/**
+ * Zamienia czas ze struktury timeval na milisekundy.
+ * @param[in] time : czas
+ * @return czas w milisekundach
+ */
+static double ToMilliseconds(struct timeval time) {
+
+    return (double) time.tv_sec * MILLISECONDS + (double) time.tv_usec / MICROSECONDS;
+
+}
+
+/**
+ * Wykonuje program kalkulatora ze skryptem na standardowym wejściu,
+ * porzucając jego wyjście.
+ * @param[in] argv : program i jego argumenty, zakończone NULL
+ * @param[in] path : ścieżka skryptu
+ * @param[out] values : zmierzone wielkości
+ * @return Czy program zakończył się kodem 0?
+ */
+static bool RunScript(char *argv[], const char *path, double values[METRIC_COUNT]) {
+
+    int input = open(path, O_RDONLY);
+    if (input < FIRST_IDX) return false;
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pid_t pid = fork();
+    if (pid == FIRST_IDX) {
+        int null = open("/dev/null", O_WRONLY);
+        if (null < FIRST_IDX || dup2(input, STDIN_FILENO) < FIRST_IDX ||
+            dup2(null, STDOUT_FILENO) < FIRST_IDX || dup2(null, STDERR_FILENO) < FIRST_IDX)
+            _exit(127);
+        execv(argv[FIRST_IDX], argv);
+        _exit(127);
+    }
+    close(input);
+    if (pid < FIRST_IDX) return false;
+
+    int status;
+    struct rusage usage;
+    if (wait4(pid, &status, FIRST_IDX, &usage) != pid) return false;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    values[WALL_MS] = (double) (end.tv_sec - start.tv_sec) * MILLISECONDS +
+                      (double) (end.tv_nsec - start.tv_nsec) / NANOSECONDS;
+    values[USER_MS] = ToMilliseconds(usage.ru_utime);
+    values[SYS_MS] = ToMilliseconds(usage.ru_stime);
+    values[PEAK_RSS_KB] = (double) usage.ru_maxrss;
+    return WIFEXITED(status) && WEXITSTATUS(status) == FIRST_IDX;
+
+}
+
+/**
+ * Porównuje liczby rzeczywiste dla funkcji qsort.
+ * @param[in] a : pierwsza liczba
+ * @param[in] b : druga liczba
+ * @return wynik porównania
+ */
+static int CompareDoubles(const void *a, const void *b) {
+
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+
+}
+
+/**
+ * Mierzy każde obciążenie @p repeat razy i wypisuje mediany mierzonych
+ * wielkości w formacie JSON, po jednym obciążeniu w wierszu.
+ * @param[in] argv : program i jego argumenty, zakończone NULL
+ * @param[in] dir : katalog ze skryptami
+ * @param[in] repeat : liczba powtórzeń
+ * @return kod wyjścia programu
+ */
+static int Run(char *argv[], const char *dir, size_t repeat) {
+
+    printf("{\"binary\": \"%s\", \"repeat\": %zu, \"results\": [\n", argv[FIRST_IDX],
+           repeat);
+    for (size_t i = FIRST_IDX; i < WORKLOAD_COUNT; i++) {
+        char path[MAX_PATH];
+        double samples[METRIC_COUNT][MAX_REPEAT];
+        for (size_t r = FIRST_IDX; r < repeat; r++) {
+            double values[METRIC_COUNT];
+            if (!WorkloadPath(path, dir, &WORKLOADS[i]) || !RunScript(argv, path, values)) {
+                fprintf(stderr, "CALC FAILED %s/%s.txt\n", dir, WORKLOADS[i].name);
+                return 1;
+            }
+            for (size_t m = FIRST_IDX; m < METRIC_COUNT; m++)
+                samples[m][r] = values[m];
+        }
+        printf("    {\"workload\": \"%s\"", WORKLOADS[i].name);
+        for (size_t m = FIRST_IDX; m < METRIC_COUNT; m++) {
+            qsort(samples[m], repeat, sizeof(double), CompareDoubles);
+            printf(", \"%s\": %.3f", METRICS[m], samples[m][repeat / TWO_ELEMENTS]);
+        }
+        printf("}%s\n", i + ONE_ELEMENT < WORKLOAD_COUNT ? "," : "");
+        fflush(stdout);
+    }
+    printf("]}\n");
+    return 0;
+
+}
+
+/**
+ * Wczytuje wyniki trybu run. Każdy wynik zajmuje jeden wiersz.
+ * @param[in] path : ścieżka pliku z wynikami
+ * @param[out] results : wyniki
+ * @param[out] count : liczba wyników
+ * @return Czy udało się wczytać plik?
+ */
+static bool ReadResults(const char *path, Result results[MAX_RESULTS], size_t *count) {
+
+    FILE *file = fopen(path, "r");
+    if (file == NULL) return false;
+    char line[MAX_LINE];
+    *count = FIRST_IDX;
+    bool is_correct = true;
+    while (is_correct && fgets(line, MAX_LINE, file) != NULL) {
+        char *name = strstr(line, "\"workload\": \"");
+        if (name == NULL) continue;
+        if (*count == MAX_RESULTS) break;
+        Result *result = &results[(*count)++];
+        name += strlen("\"workload\": \"");
+        size_t length = strcspn(name, "\"");
+        memcpy(result -> workload, name, length);
+        result -> workload[length] = NULL_CHAR;
+        for (size_t m = FIRST_IDX; m < METRIC_COUNT; m++) {
+            char key[MAX_LINE];
+            snprintf(key, MAX_LINE, "\"%s\": ", METRICS[m]);
+            char *value = strstr(line, key);
+            if (value == NULL) is_correct = false;
+            else result -> values[m] = strtod(value + strlen(key), NULL);
+        }
+    }
+    fclose(file);
+    return is_correct;
+
+}
+
+/**
+ * Porównuje wyniki z wynikami bazowymi i wypisuje zmiany mierzonych
+ * wielkości. Regresją jest wzrost o więcej niż @p threshold procent,
+ * o ile jest też większy od szumu pomiaru.
+ * @param[in] baseline_path : ścieżka pliku z wynikami bazowymi
+ * @param[in] current_path : ścieżka pliku z aktualnymi wynikami
+ * @param[in] threshold : próg regresji w procentach
+ * @return 0, jeśli nie ma regresji, 1, jeśli jest, a 2 przy błędzie
+ */
+static int Compare(const char *baseline_path, const char *current_path,
+                   size_t threshold) {
+
+    static Result baseline[MAX_RESULTS], current[MAX_RESULTS];
+    size_t baseline_count, current_count;
+    if (!ReadResults(baseline_path, baseline, &baseline_count)) {
+        fprintf(stderr, "CANNOT READ %s\n", baseline_path);
+        return 2;
+    }
+    if (!ReadResults(current_path, current, &current_count)) {
+        fprintf(stderr, "CANNOT READ %s\n", current_path);
+        return 2;
+    }
+
+    int code = 0;
+    for (size_t i = FIRST_IDX; i < current_count; i++) {
+        size_t j = FIRST_IDX;
+        while (j < baseline_count && strcmp(baseline[j].workload, current[i].workload) != 0)
+            j++;
+        if (j == baseline_count) {
+            printf("%-10s new workload\n", current[i].workload);
+            continue;
+        }
+        for (size_t m = FIRST_IDX; m < METRIC_COUNT; m++) {
+            double before = baseline[j].values[m], after = current[i].values[m];
+            double change = before > FIRST_IDX ? (after - before) / before * PERCENT : FIRST_IDX;
+            double min_delta = m == PEAK_RSS_KB ? MIN_DELTA_KB : MIN_DELTA_MS;
+            bool is_regression = change > (double) threshold && after - before > min_delta;
+            if (is_regression) code = 1;
+            printf("%-10s %-12s %12.3f %12.3f %+8.1f%% %s\n", current[i].workload,
+                   METRICS[m], before, after, change, is_regression ? "REGRESSION" : "ok");
+        }
+    }
+    return code;
+
+}
+
+/**
+ * Wypisuje sposób użycia programu.
+ * @return kod wyjścia programu
+ */
+static int Usage(void) {
+
+    fprintf(stderr, "USAGE: calc_bench generate DIR [--size=N] [--seed=N]\n"
+                    "       calc_bench run CALC DIR [--repeat=N] [-- CALC_OPTIONS...]\n"
+                    "       calc_bench compare BASELINE CURRENT [--threshold=PERCENT]\n");
+    return 2;
+
+}
+
+/**
+ * Funkcja wykonująca program w jednym z trybów opisanych w nagłówku pliku.
+ * Opcje:
+ * - `--size=N` ustawia liczbę wierszy każdego skryptu,
+ * - `--seed=N` ustawia ziarno generatora,
+ * - `--repeat=N` ustawia liczbę powtórzeń pomiaru, z których brana jest
+ *   mediana,
+ * - `--threshold=PROCENT` ustawia próg regresji,
+ * - argumenty po `--` przekazywane są programowi kalkulatora.
+ * @param[in] argc : liczba argumentów
+ * @param[in] argv : argumenty
+ * @return kod wyjścia programu
+ */
+int main(int argc, char *argv[]) {
+
+    if (argc < 3) return Usage();
+    const char *mode = argv[ONE_ELEMENT];
+    size_t size = DEFAULT_SIZE, seed = DEFAULT_SEED, repeat = DEFAULT_REPEAT;
+    size_t threshold = DEFAULT_THRESHOLD;
+    int paths = strcmp(mode, "generate") == 0 ? ONE_ELEMENT : TWO_ELEMENTS;
+    if (argc < TWO_ELEMENTS + paths) return Usage();
+
+    int i = TWO_ELEMENTS + paths;
+    for (; i < argc && strcmp(argv[i], "--") != 0; i++) {
+        if (!ParseCount(argv[i], "--size=", MAX_SIZE, &size) &&
+            !ParseCount(argv[i], "--seed=", SIZE_MAX, &seed) &&
+            !ParseCount(argv[i], "--repeat=", MAX_REPEAT, &repeat) &&
+            !ParseCount(argv[i], "--threshold=", SIZE_MAX, &threshold)) {
+            fprintf(stderr, "UNKNOWN OPTION %s\n", argv[i]);
+            return 2;
+        }
+    }
+
+    if (strcmp(mode, "generate") == 0) return Generate(argv[2], size, seed);
+    if (strcmp(mode, "compare") == 0) return Compare(argv[2], argv[3], threshold);
+    if (strcmp(mode, "run") != 0) return Usage();
+
+    // Program kalkulatora dostaje argumenty występujące po "--".
+    char **calc_argv = (char **) malloc((size_t) (argc + ONE_ELEMENT) * sizeof(char *));
+    if (calc_argv == NULL) return 2;
+    int calc_argc = FIRST_IDX;
+    calc_argv[calc_argc++] = argv[2];
+    for (i += ONE_ELEMENT; i < argc; i++) calc_argv[calc_argc++] = argv[i];
+    calc_argv[calc_argc] = NULL;
+    int code = Run(calc_argv, argv[3], repeat);
+    free(calc_argv);
+    return code;
+
+}
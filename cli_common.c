@@ -0,0 +1,45 @@
+/** @file
+  Implementacja funkcji wspólnych dla programów wiersza poleceń.
+  @author Julia Podrażka
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "cli_common.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Kod ascii znaku zerowego. */
+#define NULL_CHAR 0
+/** Baza konwertowania liczb. */
+#define BASE 10
+
+bool ParseCount(const char *arg, const char *option, size_t max, size_t *value) {
+
+    size_t length = strlen(option);
+    if (strncmp(arg, option, length) != 0 || !isdigit(arg[length])) return false;
+    char *end;
+    unsigned long long parsed = strtoull(arg + length, &end, BASE);
+    if (parsed == FIRST_IDX || parsed > max || *end != NULL_CHAR) return false;
+    *value = (size_t) parsed;
+    return true;
+
+}
+
+uint64_t NextRandom(uint64_t *state) {
+
+    uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+
+}
+
+size_t RandomUpTo(uint64_t *state, size_t bound) {
+
+    return (size_t) (NextRandom(state) % ((uint64_t) bound + ONE_ELEMENT));
+
+}
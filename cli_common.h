@@ -0,0 +1,41 @@
+/** @file
+  Interfejs funkcji wspólnych dla programów wiersza poleceń: kalkulatora
+  i benchmarków. Zawiera odczytywanie opcji liczbowych oraz generator
+  pseudolosowy, dzięki któremu benchmarki generują te same dane z tego
+  samego ziarna.
+  @author Julia Podrażka
+ */
+#ifndef CLI_COMMON_H
+#define CLI_COMMON_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Odczytuje wartość opcji liczbowej.
+ * @param[in] arg : argument programu
+ * @param[in] option : nazwa opcji razem ze znakiem równości
+ * @param[in] max : maksymalna wartość opcji
+ * @param[out] value : wartość opcji
+ * @return Czy argument jest opcją @p option z dodatnią liczbą nie większą
+ * od @p max?
+ */
+bool ParseCount(const char *arg, const char *option, size_t max, size_t *value);
+
+/**
+ * Zwraca kolejną liczbę pseudolosową generatora splitmix64.
+ * @param[in,out] state : stan generatora
+ * @return liczba pseudolosowa
+ */
+uint64_t NextRandom(uint64_t *state);
+
+/**
+ * Losuje liczbę z przedziału [0, @p bound].
+ * @param[in,out] state : stan generatora
+ * @param[in] bound : koniec przedziału
+ * @return liczba pseudolosowa
+ */
+size_t RandomUpTo(uint64_t *state, size_t bound);
+
+#endif
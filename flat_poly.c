@@ -0,0 +1,683 @@
+/** @file
+  Implementacja płaskiej reprezentacji wielomianów rzadkich wielu zmiennych.
+  Operacje arytmetyczne działają na wartościach, które są albo
+  współczynnikami, albo wskaźnikami na węzły. Węzeł wyniku budowany jest
+  z posortowanej listy składników dopiero wtedy, gdy znany jest jego rozmiar,
+  więc każdy wynik pośredni zajmuje dokładnie jeden blok pamięci.
+  @author Julia Podrażka
+ */
+#include <stdlib.h>
+#include <string.h>
+
+#include "poly.h"
+#include "arena.h"
+#include "mono_pool.h"
+#include "intern.h"
+#include "flat_poly.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Dwa elementy. */
+#define TWO 2
+/** Liczba słów nagłówka węzła. */
+#define NODE_HEADER 2
+/** Liczba słów zajmowanych przez jednomian w tablicy węzła. */
+#define MONO_WORDS 2
+/** Bit słowa z wykładnikiem oznaczający, że współczynnik jest stały. */
+#define COEFF_FLAG ((uint64_t) 1 << 32)
+/** Maska wyłuskująca wykładnik ze słowa. */
+#define EXP_MASK ((uint64_t) 0xffffffffu)
+/** Wykładnik zerowy. */
+#define EXP_ZERO 0
+/** Wartość zwracana, jeśli wielomian jest zerowy. */
+#define POLY_ZERO -1
+/** Wartość zwracana, jeśli wielomian jest stały. */
+#define POLY_COEFF 0
+/** Wartość zwracana przez funkcję modulo, jeśli liczba jest parzysta. */
+#define PARITY 0
+
+/**
+ * To jest struktura przechowująca wartość pośrednią obliczeń: współczynnik
+ * stały (wtedy `node == NULL`) albo węzeł. Jeśli `owned != NULL`, to węzeł
+ * znajduje się w buforze należącym do tej wartości.
+ */
+typedef struct FlatValue {
+    poly_coeff_t coeff; ///< współczynnik stały
+    const uint64_t *node; ///< węzeł wielomianu niestałego
+    FlatPoly *owned; ///< bufor należący do wartości
+} FlatValue;
+
+/**
+ * To jest struktura przechowująca składnik budowanego węzła.
+ */
+typedef struct FlatTerm {
+    poly_exp_t exp; ///< wykładnik
+    FlatValue value; ///< współczynnik
+} FlatTerm;
+
+/**
+ * Zwraca liczbę jednomianów węzła.
+ * @param[in] node : węzeł
+ * @return liczba jednomianów
+ */
+static size_t NodeSize(const uint64_t *node) {
+
+    return (size_t) node[FIRST_IDX];
+
+}
+
+/**
+ * Zwraca liczbę słów zajmowanych przez węzeł razem z poddrzewami.
+ * @param[in] node : węzeł
+ * @return liczba słów
+ */
+static size_t NodeWords(const uint64_t *node) {
+
+    return (size_t) node[ONE_ELEMENT];
+
+}
+
+/**
+ * Zwraca wykładnik jednomianu węzła.
+ * @param[in] node : węzeł
+ * @param[in] k : indeks jednomianu
+ * @return wykładnik
+ */
+static poly_exp_t TermExp(const uint64_t *node, size_t k) {
+
+    return (poly_exp_t) (uint32_t) (node[NODE_HEADER + MONO_WORDS * k] & EXP_MASK);
+
+}
+
+/**
+ * Zwraca współczynnik jednomianu węzła jako wartość pożyczoną z węzła.
+ * @param[in] node : węzeł
+ * @param[in] k : indeks jednomianu
+ * @return współczynnik
+ */
+static FlatValue TermValue(const uint64_t *node, size_t k) {
+
+    uint64_t word = node[NODE_HEADER + MONO_WORDS * k + ONE_ELEMENT];
+    if (node[NODE_HEADER + MONO_WORDS * k] & COEFF_FLAG)
+        return (FlatValue) {.coeff = (poly_coeff_t) word, .node = NULL, .owned = NULL};
+    return (FlatValue) {.coeff = FIRST_IDX, .node = node + word, .owned = NULL};
+
+}
+
+/**
+ * Tworzy wartość będącą współczynnikiem stałym.
+ * @param[in] c : współczynnik
+ * @return wartość
+ */
+static FlatValue CoeffValue(poly_coeff_t c) {
+
+    return (FlatValue) {.coeff = c, .node = NULL, .owned = NULL};
+
+}
+
+/**
+ * Sprawdza, czy wartość jest zerem.
+ * @param[in] v : wartość
+ * @return Czy wartość jest zerem?
+ */
+static bool ValueIsZero(const FlatValue *v) {
+
+    return v -> node == NULL && v -> coeff == FIRST_IDX;
+
+}
+
+/**
+ * Zwalnia bufor należący do wartości.
+ * @param[in] v : wartość
+ */
+static void ValueRelease(FlatValue *v) {
+
+    free(v -> owned);
+    v -> owned = NULL;
+
+}
+
+/**
+ * Przydziela bufor mieszczący @p words słów.
+ * @param[in] words : liczba słów
+ * @return bufor
+ */
+static FlatPoly *NewFlatPoly(size_t words) {
+
+    FlatPoly *p = (FlatPoly *) malloc(sizeof(FlatPoly) + words * sizeof(uint64_t));
+    CHECK_PTR(p);
+    p -> words = words;
+    return p;
+
+}
+
+/**
+ * Zwraca składniki wartości @p v. Współczynnik stały jest składnikiem
+ * o wykładniku zerowym, a współczynniki węzła są pożyczane z węzła.
+ * @param[in] v : wartość
+ * @param[in] count : liczba składników
+ * @return tablica składników przydzielona z areny
+ */
+static FlatTerm *TermsOf(const FlatValue *v, size_t *count) {
+
+    if (v -> node == NULL) {
+        FlatTerm *terms = (FlatTerm *) ArenaAlloc(sizeof(FlatTerm));
+        *count = v -> coeff != FIRST_IDX ? ONE_ELEMENT : FIRST_IDX;
+        terms[FIRST_IDX] = (FlatTerm) {.exp = EXP_ZERO, .value = *v};
+        return terms;
+    }
+    *count = NodeSize(v -> node);
+    FlatTerm *terms = (FlatTerm *) ArenaAlloc(*count * sizeof(FlatTerm));
+    for (size_t k = FIRST_IDX; k < *count; k++) {
+        terms[k] = (FlatTerm) {.exp = TermExp(v -> node, k),
+                               .value = TermValue(v -> node, k)};
+    }
+    return terms;
+
+}
+
+/**
+ * Buduje wartość ze składników posortowanych ściśle malejąco po wykładnikach.
+ * Pomija składniki zerowe, a węzeł tożsamościowo równy stałej zamienia na
+ * stałą. Zwalnia bufory należące do składników.
+ * @param[in] terms : tablica składników
+ * @param[in] count : liczba składników
+ * @return wartość
+ */
+static FlatValue EmitTerms(FlatTerm *terms, size_t count) {
+
+    size_t n = FIRST_IDX;
+    size_t words = NODE_HEADER;
+    size_t last = FIRST_IDX;
+    for (size_t k = FIRST_IDX; k < count; k++) {
+        if (ValueIsZero(&terms[k].value)) continue;
+        n++;
+        last = k;
+        words += MONO_WORDS;
+        if (terms[k].value.node != NULL) words += NodeWords(terms[k].value.node);
+    }
+    if (n == FIRST_IDX) return CoeffValue(FIRST_IDX);
+    if (n == ONE_ELEMENT && terms[last].exp == EXP_ZERO &&
+        terms[last].value.node == NULL)
+        return terms[last].value;
+
+    FlatPoly *p = NewFlatPoly(words);
+    uint64_t *node = p -> data;
+    node[FIRST_IDX] = n;
+    node[ONE_ELEMENT] = words;
+    size_t child = NODE_HEADER + MONO_WORDS * n;
+    size_t slot = NODE_HEADER;
+    for (size_t k = FIRST_IDX; k < count; k++) {
+        FlatValue *v = &terms[k].value;
+        if (ValueIsZero(v)) continue;
+        uint64_t exp_word = (uint64_t) (uint32_t) terms[k].exp;
+        if (v -> node == NULL) {
+            node[slot] = exp_word | COEFF_FLAG;
+            node[slot + ONE_ELEMENT] = (uint64_t) v -> coeff;
+        } else {
+            node[slot] = exp_word;
+            node[slot + ONE_ELEMENT] = child;
+            memcpy(node + child, v -> node, NodeWords(v -> node) * sizeof(uint64_t));
+            child += NodeWords(v -> node);
+            ValueRelease(v);
+        }
+        slot += MONO_WORDS;
+    }
+    return (FlatValue) {.coeff = FIRST_IDX, .node = node, .owned = p};
+
+}
+
+/**
+ * Porównuje wykładniki składników tak, aby sortować je malejąco.
+ * @param[in] a : pierwszy składnik
+ * @param[in] b : drugi składnik
+ * @return wynik porównania
+ */
+static int CompareTerms(const void *a, const void *b) {
+
+    poly_exp_t exp_a = ((const FlatTerm *) a) -> exp;
+    poly_exp_t exp_b = ((const FlatTerm *) b) -> exp;
+    return (exp_a < exp_b) - (exp_a > exp_b);
+
+}
+
+static FlatValue AddValues(const FlatValue *a, const FlatValue *b);
+
+/**
+ * Sortuje składniki, sumuje składniki o równych wykładnikach i buduje z nich
+ * wartość. Przejmuje na własność bufory należące do składników.
+ * @param[in] terms : tablica składników
+ * @param[in] count : liczba składników
+ * @return wartość
+ */
+static FlatValue SumTerms(FlatTerm *terms, size_t count) {
+
+    qsort(terms, count, sizeof(FlatTerm), CompareTerms);
+    size_t merged = FIRST_IDX;
+    for (size_t k = FIRST_IDX; k < count; k++) {
+        if (merged != FIRST_IDX && terms[merged - ONE_ELEMENT].exp == terms[k].exp) {
+            FlatValue sum = AddValues(&terms[merged - ONE_ELEMENT].value,
+                                      &terms[k].value);
+            ValueRelease(&terms[merged - ONE_ELEMENT].value);
+            ValueRelease(&terms[k].value);
+            terms[merged - ONE_ELEMENT].value = sum;
+        } else terms[merged++] = terms[k];
+    }
+    return EmitTerms(terms, merged);
+
+}
+
+/**
+ * Dodaje dwie wartości.
+ * @param[in] a : wartość @f$a@f$
+ * @param[in] b : wartość @f$b@f$
+ * @return @f$a + b@f$
+ */
+static FlatValue AddValues(const FlatValue *a, const FlatValue *b) {
+
+    if (a -> node == NULL && b -> node == NULL)
+        return CoeffValue(a -> coeff + b -> coeff);
+
+    ArenaMark mark = ArenaGetMark();
+    size_t count_a, count_b;
+    FlatTerm *terms_a = TermsOf(a, &count_a);
+    FlatTerm *terms_b = TermsOf(b, &count_b);
+    FlatTerm *terms = (FlatTerm *) ArenaAlloc((count_a + count_b) * sizeof(FlatTerm));
+    size_t i = FIRST_IDX, j = FIRST_IDX, count = FIRST_IDX;
+    while (i < count_a || j < count_b) {
+        if (j == count_b || (i < count_a && terms_a[i].exp > terms_b[j].exp)) {
+            terms[count++] = terms_a[i++];
+        } else if (i == count_a || terms_b[j].exp > terms_a[i].exp) {
+            terms[count++] = terms_b[j++];
+        } else {
+            terms[count++] = (FlatTerm) {
+                    .exp = terms_a[i].exp,
+                    .value = AddValues(&terms_a[i].value, &terms_b[j].value)};
+            i++;
+            j++;
+        }
+    }
+    FlatValue result = EmitTerms(terms, count);
+    ArenaReset(mark);
+    return result;
+
+}
+
+/**
+ * Mnoży wartość przez skalar.
+ * @param[in] a : wartość @f$a@f$
+ * @param[in] scalar : skalar
+ * @return @f$a * scalar@f$
+ */
+static FlatValue ScaleValue(const FlatValue *a, poly_coeff_t scalar) {
+
+    if (a -> node == NULL) return CoeffValue(a -> coeff * scalar);
+    if (scalar == FIRST_IDX) return CoeffValue(FIRST_IDX);
+
+    ArenaMark mark = ArenaGetMark();
+    size_t count;
+    FlatTerm *terms = TermsOf(a, &count);
+    for (size_t k = FIRST_IDX; k < count; k++)
+        terms[k].value = ScaleValue(&terms[k].value, scalar);
+    FlatValue result = EmitTerms(terms, count);
+    ArenaReset(mark);
+    return result;
+
+}
+
+/**
+ * Mnoży dwie wartości.
+ * @param[in] a : wartość @f$a@f$
+ * @param[in] b : wartość @f$b@f$
+ * @return @f$a * b@f$
+ */
+static FlatValue MulValues(const FlatValue *a, const FlatValue *b) {
+
+    if (a -> node == NULL) return ScaleValue(b, a -> coeff);
+    if (b -> node == NULL) return ScaleValue(a, b -> coeff);
+
+    ArenaMark mark = ArenaGetMark();
+    size_t count_a, count_b;
+    FlatTerm *terms_a = TermsOf(a, &count_a);
+    FlatTerm *terms_b = TermsOf(b, &count_b);
+    FlatTerm *terms = (FlatTerm *) ArenaAlloc(count_a * count_b * sizeof(FlatTerm));
+    size_t count = FIRST_IDX;
+    for (size_t i = FIRST_IDX; i < count_a; i++) {
+        for (size_t j = FIRST_IDX; j < count_b; j++) {
+            terms[count++] = (FlatTerm) {
+                    .exp = terms_a[i].exp + terms_b[j].exp,
+                    .value = MulValues(&terms_a[i].value, &terms_b[j].value)};
+        }
+    }
+    FlatValue result = SumTerms(terms, count);
+    ArenaReset(mark);
+    return result;
+
+}
+
+/**
+ * Podnosi @p x do potęgi @p exp w czasie logarytmicznym.
+ * @param[in] x : baza potęgowania
+ * @param[in] exp : potęga potęgowania
+ * @return @f$x^exp@f$
+ */
+static poly_coeff_t FastPow(poly_coeff_t x, poly_exp_t exp) {
+
+    poly_coeff_t result = ONE_ELEMENT;
+    while (exp > FIRST_IDX) {
+        if (exp % TWO != PARITY) result *= x;
+        x *= x;
+        exp /= TWO;
+    }
+    return result;
+
+}
+
+/**
+ * Zwraca wartość węzła głównego wielomianu w płaskiej reprezentacji.
+ * @param[in] p : wielomian w płaskiej reprezentacji
+ * @return wartość pożyczona z @p p
+ */
+static FlatValue RootValue(const FlatPoly *p) {
+
+    if (NodeSize(p -> data) == FIRST_IDX)
+        return CoeffValue((poly_coeff_t) p -> data[ONE_ELEMENT]);
+    return (FlatValue) {.coeff = FIRST_IDX, .node = p -> data, .owned = NULL};
+
+}
+
+/**
+ * Tworzy wielomian w płaskiej reprezentacji z wartości.
+ * Przejmuje na własność bufor należący do wartości.
+ * @param[in] v : wartość
+ * @return wielomian w płaskiej reprezentacji
+ */
+static FlatPoly *FromValue(FlatValue v) {
+
+    if (v.node == NULL) {
+        FlatPoly *p = NewFlatPoly(NODE_HEADER);
+        p -> data[FIRST_IDX] = FIRST_IDX;
+        p -> data[ONE_ELEMENT] = (uint64_t) v.coeff;
+        return p;
+    }
+    if (v.owned != NULL && v.owned -> data == v.node) return v.owned;
+    FlatPoly *p = NewFlatPoly(NodeWords(v.node));
+    memcpy(p -> data, v.node, NodeWords(v.node) * sizeof(uint64_t));
+    free(v.owned);
+    return p;
+
+}
+
+/**
+ * Sprawdza, czy wielomian jest tożsamościowo równy stałej i jeśli tak,
+ * to zapisuje tę stałą w @p c.
+ * @param[in] p : wielomian
+ * @param[out] c : stała
+ * @return Czy wielomian jest stały?
+ */
+static bool PolyConstant(const Poly *p, poly_coeff_t *c) {
+
+    if (PolyIsZero(p)) *c = FIRST_IDX;
+    else if (AllExpZero(p)) *c = GetCoeff(p);
+    else return false;
+    return true;
+
+}
+
+/**
+ * Zwraca liczbę słów potrzebnych na zapisanie węzła wielomianu niestałego.
+ * @param[in] p : wielomian niestały
+ * @return liczba słów
+ */
+static size_t PolyWords(const Poly *p) {
+
+    size_t words = NODE_HEADER;
+    for (size_t i = FIRST_IDX; i < p -> size; i++) {
+        poly_coeff_t c;
+        if (PolyIsZero(&p -> arr[i].p)) continue;
+        words += MONO_WORDS;
+        if (!PolyConstant(&p -> arr[i].p, &c)) words += PolyWords(&p -> arr[i].p);
+    }
+    return words;
+
+}
+
+/**
+ * Zapisuje węzeł wielomianu niestałego pod adresem @p node.
+ * @param[in] node : miejsce na węzeł
+ * @param[in] p : wielomian niestały
+ * @return liczba zapisanych słów
+ */
+static size_t EmitPoly(uint64_t *node, const Poly *p) {
+
+    size_t n = FIRST_IDX;
+    for (size_t i = FIRST_IDX; i < p -> size; i++) {
+        if (!PolyIsZero(&p -> arr[i].p)) n++;
+    }
+    size_t child = NODE_HEADER + MONO_WORDS * n;
+    size_t slot = NODE_HEADER;
+    for (size_t i = FIRST_IDX; i < p -> size; i++) {
+        Mono mono = p -> arr[i];
+        poly_coeff_t c;
+        if (PolyIsZero(&mono.p)) continue;
+        uint64_t exp_word = (uint64_t) (uint32_t) MonoGetExp(&mono);
+        if (PolyConstant(&mono.p, &c)) {
+            node[slot] = exp_word | COEFF_FLAG;
+            node[slot + ONE_ELEMENT] = (uint64_t) c;
+        } else {
+            node[slot] = exp_word;
+            node[slot + ONE_ELEMENT] = child;
+            child += EmitPoly(node + child, &mono.p);
+        }
+        slot += MONO_WORDS;
+    }
+    node[FIRST_IDX] = n;
+    node[ONE_ELEMENT] = child;
+    return child;
+
+}
+
+FlatPoly *FlatPolyFromPoly(const Poly *p) {
+
+    poly_coeff_t c;
+    if (PolyConstant(p, &c)) return FromValue(CoeffValue(c));
+    FlatPoly *flat = NewFlatPoly(PolyWords(p));
+    EmitPoly(flat -> data, p);
+    return flat;
+
+}
+
+/**
+ * Tworzy wielomian w zwykłej reprezentacji z węzła.
+ * @param[in] node : węzeł
+ * @return wielomian
+ */
+static Poly NodeToPoly(const uint64_t *node) {
+
+    size_t n = NodeSize(node);
+    Mono *arr = MonoArrAlloc(n);
+    for (size_t k = FIRST_IDX; k < n; k++) {
+        FlatValue v = TermValue(node, k);
+        Poly p = v.node == NULL ? PolyFromCoeff(v.coeff) : NodeToPoly(v.node);
+        arr[k] = (Mono) {.p = p, .exp = TermExp(node, k)};
+    }
+    return InternPoly((Poly) {.size = n, .arr = arr});
+
+}
+
+Poly FlatPolyToPoly(const FlatPoly *p) {
+
+    if (FlatPolyIsCoeff(p)) return PolyFromCoeff((poly_coeff_t) p -> data[ONE_ELEMENT]);
+    return NodeToPoly(p -> data);
+
+}
+
+FlatPoly *FlatPolyClone(const FlatPoly *p) {
+
+    FlatPoly *clone = NewFlatPoly(p -> words);
+    memcpy(clone -> data, p -> data, p -> words * sizeof(uint64_t));
+    return clone;
+
+}
+
+void FlatPolyDestroy(FlatPoly *p) {
+
+    free(p);
+
+}
+
+bool FlatPolyIsCoeff(const FlatPoly *p) {
+
+    return NodeSize(p -> data) == FIRST_IDX;
+
+}
+
+bool FlatPolyIsZero(const FlatPoly *p) {
+
+    return FlatPolyIsCoeff(p) && p -> data[ONE_ELEMENT] == FIRST_IDX;
+
+}
+
+FlatPoly *FlatPolyAdd(const FlatPoly *p, const FlatPoly *q) {
+
+    FlatValue a = RootValue(p);
+    FlatValue b = RootValue(q);
+    return FromValue(AddValues(&a, &b));
+
+}
+
+FlatPoly *FlatPolyMul(const FlatPoly *p, const FlatPoly *q) {
+
+    FlatValue a = RootValue(p);
+    FlatValue b = RootValue(q);
+    return FromValue(MulValues(&a, &b));
+
+}
+
+FlatPoly *FlatPolyAt(const FlatPoly *p, poly_coeff_t x) {
+
+    if (FlatPolyIsCoeff(p)) return FlatPolyClone(p);
+
+    ArenaMark mark = ArenaGetMark();
+    const uint64_t *node = p -> data;
+    size_t n = NodeSize(node);
+    // Zliczamy składniki wyniku: współczynnik stały daje jeden składnik,
+    // a węzeł tyle składników, ile ma jednomianów.
+    size_t count = FIRST_IDX;
+    for (size_t k = FIRST_IDX; k < n; k++) {
+        FlatValue v = TermValue(node, k);
+        count += v.node == NULL ? ONE_ELEMENT : NodeSize(v.node);
+    }
+    FlatTerm *terms = (FlatTerm *) ArenaAlloc(count * sizeof(FlatTerm));
+    FlatPoly **scaled = (FlatPoly **) ArenaAlloc(n * sizeof(FlatPoly *));
+    count = FIRST_IDX;
+    for (size_t k = FIRST_IDX; k < n; k++) {
+        FlatValue v = TermValue(node, k);
+        poly_coeff_t power = FastPow(x, TermExp(node, k));
+        FlatValue s = ScaleValue(&v, power);
+        scaled[k] = s.owned;
+        if (s.node == NULL) {
+            terms[count++] = (FlatTerm) {.exp = EXP_ZERO, .value = s};
+        } else {
+            for (size_t i = FIRST_IDX; i < NodeSize(s.node); i++) {
+                terms[count++] = (FlatTerm) {.exp = TermExp(s.node, i),
+                                             .value = TermValue(s.node, i)};
+            }
+        }
+    }
+    FlatPoly *result = FromValue(SumTerms(terms, count));
+    for (size_t k = FIRST_IDX; k < n; k++) free(scaled[k]);
+    ArenaReset(mark);
+    return result;
+
+}
+
+bool FlatPolyIsEq(const FlatPoly *p, const FlatPoly *q) {
+
+    return p -> words == q -> words &&
+           memcmp(p -> data, q -> data, p -> words * sizeof(uint64_t)) == FIRST_IDX;
+
+}
+
+/**
+ * Zwraca stopień węzła.
+ * @param[in] node : węzeł
+ * @return stopień węzła
+ */
+static poly_exp_t NodeDeg(const uint64_t *node) {
+
+    poly_exp_t max = POLY_COEFF;
+    for (size_t k = FIRST_IDX; k < NodeSize(node); k++) {
+        FlatValue v = TermValue(node, k);
+        poly_exp_t deg = TermExp(node, k);
+        if (v.node != NULL) deg += NodeDeg(v.node);
+        if (deg > max) max = deg;
+    }
+    return max;
+
+}
+
+poly_exp_t FlatPolyDeg(const FlatPoly *p) {
+
+    if (FlatPolyIsZero(p)) return POLY_ZERO;
+    if (FlatPolyIsCoeff(p)) return POLY_COEFF;
+    return NodeDeg(p -> data);
+
+}
+
+/**
+ * Zwraca stopień węzła ze względu na zmienną o indeksie @p var_idx.
+ * @param[in] node : węzeł
+ * @param[in] var_idx : indeks zmiennej
+ * @param[in] current_idx : indeks zmiennej węzła
+ * @return stopień węzła ze względu na zmienną
+ */
+static poly_exp_t NodeDegBy(const uint64_t *node, size_t var_idx,
+                            size_t current_idx) {
+
+    if (var_idx == current_idx) return TermExp(node, FIRST_IDX);
+    poly_exp_t max = POLY_COEFF;
+    for (size_t k = FIRST_IDX; k < NodeSize(node); k++) {
+        FlatValue v = TermValue(node, k);
+        if (v.node == NULL) continue;
+        poly_exp_t deg = NodeDegBy(v.node, var_idx, current_idx + ONE_ELEMENT);
+        if (deg > max) max = deg;
+    }
+    return max;
+
+}
+
+poly_exp_t FlatPolyDegBy(const FlatPoly *p, size_t var_idx) {
+
+    if (FlatPolyIsZero(p)) return POLY_ZERO;
+    if (FlatPolyIsCoeff(p)) return POLY_COEFF;
+    return NodeDegBy(p -> data, var_idx, FIRST_IDX);
+
+}
+
+/**
+ * Wypisuje węzeł w formacie komendy PRINT.
+ * @param[in] node : węzeł
+ * @param[in] out : strumień wyjściowy
+ */
+static void NodePrint(const uint64_t *node, FILE *out) {
+
+    for (size_t k = NodeSize(node); k > FIRST_IDX; k--) {
+        FlatValue v = TermValue(node, k - ONE_ELEMENT);
+        fputc('(', out);
+        if (v.node == NULL) fprintf(out, "%ld", v.coeff);
+        else NodePrint(v.node, out);
+        fprintf(out, ",%d)", TermExp(node, k - ONE_ELEMENT));
+        if (k != ONE_ELEMENT) fputc('+', out);
+    }
+
+}
+
+void FlatPolyPrint(const FlatPoly *p, FILE *out) {
+
+    if (FlatPolyIsCoeff(p)) fprintf(out, "%ld", (poly_coeff_t) p -> data[ONE_ELEMENT]);
+    else NodePrint(p -> data, out);
+
+}
@@ -0,0 +1,135 @@
+/** @file
+  Interfejs płaskiej reprezentacji wielomianów rzadkich wielu zmiennych.
+  Cały wielomian zapisany jest w jednym ciągłym buforze słów 64-bitowych
+  w porządku pre-order. Węzeł wielomianu niestałego ma postać:
+  - słowo 0: liczba jednomianów @f$n > 0@f$
+  - słowo 1: liczba słów zajmowanych przez węzeł razem z poddrzewami
+  - dla każdego z @f$n@f$ jednomianów dwa słowa: wykładnik (z bitem
+  oznaczającym współczynnik stały) oraz współczynnik stały albo przesunięcie
+  węzła współczynnika względem początku bieżącego węzła
+  - węzły współczynników niestałych, w kolejności jednomianów.
+
+  Wielomian stały zapisany jest jako dwa słowa: zero i wartość współczynnika.
+  Przesunięcia są względne, więc każde poddrzewo można skopiować funkcją
+  memcpy. Reprezentacja jest kanoniczna: jednomiany są posortowane malejąco
+  po wykładnikach, nie ma jednomianów o zerowych współczynnikach, a węzły
+  tożsamościowo równe stałej zapisywane są jako stałe. Dzięki temu dwa
+  wielomiany są równe wtedy i tylko wtedy, gdy ich bufory są identyczne.
+  @author Julia Podrażka
+ */
+#ifndef FLAT_POLY_H
+#define FLAT_POLY_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "poly.h"
+
+/**
+ * To jest struktura przechowująca wielomian w płaskiej reprezentacji.
+ */
+typedef struct FlatPoly {
+    size_t words; ///< liczba słów bufora
+    uint64_t data[]; ///< bufor z węzłem głównym na początku
+} FlatPoly;
+
+/**
+ * Tworzy płaską reprezentację wielomianu @p p.
+ * @param[in] p : wielomian
+ * @return wielomian w płaskiej reprezentacji
+ */
+FlatPoly *FlatPolyFromPoly(const Poly *p);
+
+/**
+ * Tworzy wielomian w zwykłej reprezentacji z płaskiej reprezentacji.
+ * @param[in] p : wielomian w płaskiej reprezentacji
+ * @return wielomian
+ */
+Poly FlatPolyToPoly(const FlatPoly *p);
+
+/**
+ * Robi kopię wielomianu w płaskiej reprezentacji.
+ * @param[in] p : wielomian w płaskiej reprezentacji
+ * @return skopiowany wielomian
+ */
+FlatPoly *FlatPolyClone(const FlatPoly *p);
+
+/**
+ * Usuwa wielomian w płaskiej reprezentacji z pamięci.
+ * @param[in] p : wielomian w płaskiej reprezentacji
+ */
+void FlatPolyDestroy(FlatPoly *p);
+
+/**
+ * Sprawdza, czy wielomian w płaskiej reprezentacji jest stały.
+ * @param[in] p : wielomian w płaskiej reprezentacji
+ * @return Czy wielomian jest współczynnikiem?
+ */
+bool FlatPolyIsCoeff(const FlatPoly *p);
+
+/**
+ * Sprawdza, czy wielomian w płaskiej reprezentacji jest tożsamościowo równy
+ * zeru.
+ * @param[in] p : wielomian w płaskiej reprezentacji
+ * @return Czy wielomian jest równy zeru?
+ */
+bool FlatPolyIsZero(const FlatPoly *p);
+
+/**
+ * Dodaje dwa wielomiany w płaskiej reprezentacji.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p + q@f$
+ */
+FlatPoly *FlatPolyAdd(const FlatPoly *p, const FlatPoly *q);
+
+/**
+ * Mnoży dwa wielomiany w płaskiej reprezentacji.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+FlatPoly *FlatPolyMul(const FlatPoly *p, const FlatPoly *q);
+
+/**
+ * Wylicza wartość wielomianu w płaskiej reprezentacji w punkcie @p x,
+ * tak jak funkcja PolyAt.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] x : wartość argumentu @f$x@f$
+ * @return @f$p(x, x_0, x_1, ...)@f$
+ */
+FlatPoly *FlatPolyAt(const FlatPoly *p, poly_coeff_t x);
+
+/**
+ * Sprawdza równość dwóch wielomianów w płaskiej reprezentacji.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p = q@f$
+ */
+bool FlatPolyIsEq(const FlatPoly *p, const FlatPoly *q);
+
+/**
+ * Zwraca stopień wielomianu w płaskiej reprezentacji (-1 dla wielomianu
+ * tożsamościowo równego zeru).
+ * @param[in] p : wielomian w płaskiej reprezentacji
+ * @return stopień wielomianu @p p
+ */
+poly_exp_t FlatPolyDeg(const FlatPoly *p);
+
+/**
+ * Zwraca stopień wielomianu w płaskiej reprezentacji ze względu na zmienną
+ * o indeksie @p var_idx, tak jak funkcja PolyDegBy.
+ * @param[in] p : wielomian w płaskiej reprezentacji
+ * @param[in] var_idx : indeks zmiennej
+ * @return stopień wielomianu @p p z względu na zmienną o indeksie @p var_idx
+ */
+poly_exp_t FlatPolyDegBy(const FlatPoly *p, size_t var_idx);
+
+/**
+ * Wypisuje wielomian w płaskiej reprezentacji w formacie komendy PRINT.
+ * @param[in] p : wielomian w płaskiej reprezentacji
+ * @param[in] out : strumień wyjściowy
+ */
+void FlatPolyPrint(const FlatPoly *p, FILE *out);
+
+#endif
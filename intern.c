@@ -0,0 +1,415 @@
+/** @file
+  Implementacja trybu współdzielenia wielomianów.
+  Tablica unikalnych węzłów nie trzyma odwołań do tablic jednomianów:
+  tablica jest z niej usuwana, gdy zwalniane jest ostatnie odwołanie.
+  Znacznik współdzielonej tablicy jednomianów przechowuje jej unikalny
+  identyfikator przesunięty o jeden bit oraz bit postaci kanonicznej.
+  Identyfikatory nie są używane ponownie. Wpis pamięci podręcznej wyników
+  trzyma kopie argumentów, więc dopóki wpis istnieje, równy argument
+  utworzony ponownie (np. wczytany drugi raz) dostaje ten sam identyfikator.
+  Tablicę unikalnych węzłów i pamięć podręczną chroni jedna blokada. Pod nią
+  zmniejszane są też liczniki odwołań współdzielonych tablic, żeby żaden wątek
+  nie znalazł w tablicy węzła, którego ostatnie odwołanie jest właśnie
+  zwalniane. Operacja wykonywana pod strażnikiem budżetu pamięci może zostać
+  przerwana, a jej tablice zwolnione, więc nie dodaje ich do tablicy
+  unikalnych węzłów ani nie zapamiętuje wyników, a jedynie korzysta
+  z wcześniej współdzielonych węzłów i wyników.
+  @author Julia Podrażka
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "poly.h"
+#include "mono_pool.h"
+#include "memory_budget.h"
+#include "intern.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Wykładnik zerowy. */
+#define EXP_ZERO 0
+/** Znacznik tablicy jednomianów spoza tablicy unikalnych węzłów. */
+#define NO_TAG 0
+/** Bit znacznika oznaczający postać kanoniczną. */
+#define CANONICAL_BIT 1
+/** Przesunięcie identyfikatora w znaczniku. */
+#define ID_SHIFT 1
+/** Początkowa liczba kubełków tablicy unikalnych węzłów. */
+#define INITIAL_BUCKETS 1024
+/** Liczba wpisów pamięci podręcznej wyników operacji. */
+#define MEMO_SIZE 4096
+/** Stała mnożenia przy mieszaniu wartości skrótu. */
+#define HASH_MUL 0x9e3779b97f4a7c15ULL
+
+/**
+ * To jest struktura przechowująca wpis tablicy unikalnych węzłów.
+ */
+typedef struct InternEntry {
+    Mono *arr; ///< tablica jednomianów
+    size_t size; ///< liczba jednomianów
+    uint64_t hash; ///< skrót węzła
+    struct InternEntry *next; ///< następny wpis w kubełku
+} InternEntry;
+
+/**
+ * To jest struktura przechowująca klucz argumentu operacji: identyfikator
+ * współdzielonej tablicy jednomianów albo wartość współczynnika.
+ */
+typedef struct OperandKey {
+    bool is_coeff; ///< czy argument jest współczynnikiem
+    uint64_t value; ///< identyfikator tablicy lub wartość współczynnika
+} OperandKey;
+
+/**
+ * To jest struktura przechowująca wpis pamięci podręcznej wyników operacji.
+ */
+typedef struct MemoEntry {
+    bool used; ///< czy wpis jest zajęty
+    InternOp op; ///< operacja
+    OperandKey p; ///< klucz pierwszego argumentu
+    OperandKey q; ///< klucz drugiego argumentu
+    Poly args[2]; ///< kopie argumentów, utrzymujące ich identyfikatory
+    Poly result; ///< wynik operacji
+} MemoEntry;
+
+/** Czy tryb współdzielenia jest włączony. */
+static bool enabled = false;
+/** Kubełki tablicy unikalnych węzłów. */
+static InternEntry **buckets = NULL;
+/** Liczba kubełków, zawsze potęga dwójki. */
+static size_t bucket_count = FIRST_IDX;
+/** Liczba wpisów tablicy unikalnych węzłów. */
+static size_t entry_count = FIRST_IDX;
+/** Następny wolny identyfikator. */
+static uint64_t next_id = ONE_ELEMENT;
+/** Pamięć podręczna wyników operacji. */
+static MemoEntry *memo = NULL;
+/** Blokada tablicy unikalnych węzłów i pamięci podręcznej. */
+static pthread_mutex_t intern_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * Miesza wartość skrótu z kolejnym słowem.
+ * @param[in] hash : dotychczasowy skrót
+ * @param[in] word : słowo
+ * @return nowy skrót
+ */
+static uint64_t Mix(uint64_t hash, uint64_t word) {
+
+    hash = (hash ^ word) * HASH_MUL;
+    return hash ^ (hash >> 32);
+
+}
+
+/**
+ * Wylicza skrót węzła na podstawie wykładników i współczynników jego
+ * jednomianów. Współczynniki niestałe są już współdzielone, więc wystarczą
+ * ich identyfikatory.
+ * @param[in] arr : tablica jednomianów
+ * @param[in] size : liczba jednomianów
+ * @return skrót węzła
+ */
+static uint64_t NodeHash(const Mono *arr, size_t size) {
+
+    uint64_t hash = Mix(HASH_MUL, size);
+    for (size_t i = FIRST_IDX; i < size; i++) {
+        hash = Mix(hash, (uint64_t) arr[i].exp);
+        if (PolyIsCoeff(&arr[i].p))
+            hash = Mix(hash, (uint64_t) arr[i].p.coeff << ONE_ELEMENT);
+        else hash = Mix(hash, MonoArrGetTag(arr[i].p.arr) | CANONICAL_BIT);
+    }
+    return hash;
+
+}
+
+/**
+ * Sprawdza, czy dwa węzły o współdzielonych współczynnikach są identyczne.
+ * @param[in] arr1 : pierwsza tablica jednomianów
+ * @param[in] arr2 : druga tablica jednomianów
+ * @param[in] size : liczba jednomianów obu tablic
+ * @return Czy węzły są identyczne?
+ */
+static bool NodeEq(const Mono *arr1, const Mono *arr2, size_t size) {
+
+    for (size_t i = FIRST_IDX; i < size; i++) {
+        if (arr1[i].exp != arr2[i].exp) return false;
+        if (PolyIsCoeff(&arr1[i].p) != PolyIsCoeff(&arr2[i].p)) return false;
+        if (PolyIsCoeff(&arr1[i].p)) {
+            if (arr1[i].p.coeff != arr2[i].p.coeff) return false;
+        } else if (arr1[i].p.arr != arr2[i].p.arr) return false;
+    }
+    return true;
+
+}
+
+/**
+ * Sprawdza, czy węzeł o współdzielonych współczynnikach jest w postaci
+ * kanonicznej.
+ * @param[in] arr : tablica jednomianów
+ * @param[in] size : liczba jednomianów
+ * @return Czy węzeł jest w postaci kanonicznej?
+ */
+static bool NodeIsCanonical(const Mono *arr, size_t size) {
+
+    if (size == ONE_ELEMENT && arr[FIRST_IDX].exp == EXP_ZERO &&
+        PolyIsCoeff(&arr[FIRST_IDX].p)) return false;
+    for (size_t i = FIRST_IDX; i < size; i++) {
+        if (!PolyIsCoeff(&arr[i].p) && !InternIsCanonical(arr[i].p.arr))
+            return false;
+    }
+    return true;
+
+}
+
+/**
+ * Podwaja liczbę kubełków tablicy unikalnych węzłów.
+ */
+static void Grow(void) {
+
+    size_t new_count = bucket_count == FIRST_IDX ? INITIAL_BUCKETS
+                                                 : 2 * bucket_count;
+    InternEntry **new_buckets =
+            (InternEntry **) calloc(new_count, sizeof(InternEntry *));
+    CHECK_PTR(new_buckets);
+    for (size_t i = FIRST_IDX; i < bucket_count; i++) {
+        InternEntry *entry = buckets[i];
+        while (entry != NULL) {
+            InternEntry *next = entry -> next;
+            size_t bucket = entry -> hash & (new_count - ONE_ELEMENT);
+            entry -> next = new_buckets[bucket];
+            new_buckets[bucket] = entry;
+            entry = next;
+        }
+    }
+    free(buckets);
+    buckets = new_buckets;
+    bucket_count = new_count;
+
+}
+
+void InternEnable(void) {
+
+    enabled = true;
+
+}
+
+bool InternEnabled(void) {
+
+    return enabled;
+
+}
+
+Poly InternPoly(Poly p) {
+
+    // Tablic stałych nie wstawiamy do tablicy unikalnych węzłów, bo nie
+    // można zmienić ich znacznika.
+    if (!enabled || PolyIsCoeff(&p) || InternIsShared(p.arr) ||
+        MonoArrIsStatic(p.arr)) return p;
+
+    bool guarded = MemoryCurrentGuard() != NULL;
+    for (size_t i = FIRST_IDX; i < p.size; i++) {
+        if (PolyIsCoeff(&p.arr[i].p)) continue;
+        p.arr[i].p = InternPoly(p.arr[i].p);
+        // Węzeł z niewspółdzielonym poddrzewem nie może być w tablicy.
+        if (guarded && !InternIsShared(p.arr[i].p.arr)) return p;
+    }
+
+    uint64_t hash = NodeHash(p.arr, p.size);
+    bool canonical = NodeIsCanonical(p.arr, p.size);
+    pthread_mutex_lock(&intern_lock);
+    if (entry_count >= bucket_count) Grow();
+    size_t bucket = hash & (bucket_count - ONE_ELEMENT);
+    for (InternEntry *entry = buckets[bucket]; entry != NULL;
+         entry = entry -> next) {
+        if (entry -> hash == hash && entry -> size == p.size &&
+            NodeEq(entry -> arr, p.arr, p.size)) {
+            Poly found = (Poly) {.size = entry -> size, .arr = entry -> arr};
+            found = PolyClone(&found);
+            pthread_mutex_unlock(&intern_lock);
+            PolyDestroy(&p);
+            return found;
+        }
+    }
+
+    if (guarded) {
+        pthread_mutex_unlock(&intern_lock);
+        return p;
+    }
+
+    InternEntry *entry = (InternEntry *) malloc(sizeof(InternEntry));
+    CHECK_PTR(entry);
+    *entry = (InternEntry) {.arr = p.arr, .size = p.size, .hash = hash,
+                            .next = buckets[bucket]};
+    buckets[bucket] = entry;
+    entry_count++;
+    uint64_t tag = next_id++ << ID_SHIFT;
+    if (canonical) tag |= CANONICAL_BIT;
+    MonoArrSetTag(p.arr, tag);
+    pthread_mutex_unlock(&intern_lock);
+    return p;
+
+}
+
+bool InternIsShared(const Mono *arr) {
+
+    return MonoArrGetTag(arr) != NO_TAG;
+
+}
+
+bool InternIsCanonical(const Mono *arr) {
+
+    return (MonoArrGetTag(arr) & CANONICAL_BIT) != NO_TAG;
+
+}
+
+bool InternRelease(const Poly *p) {
+
+    uint64_t hash = NodeHash(p -> arr, p -> size);
+    pthread_mutex_lock(&intern_lock);
+    bool last = MonoArrRelease(p -> arr);
+    if (last && bucket_count > FIRST_IDX) {
+        InternEntry **link = &buckets[hash & (bucket_count - ONE_ELEMENT)];
+        while (*link != NULL && (*link) -> arr != p -> arr)
+            link = &(*link) -> next;
+        if (*link != NULL) {
+            InternEntry *entry = *link;
+            *link = entry -> next;
+            free(entry);
+            entry_count--;
+        }
+    }
+    pthread_mutex_unlock(&intern_lock);
+    return last;
+
+}
+
+/**
+ * Wyznacza klucz argumentu operacji.
+ * @param[in] p : wielomian
+ * @param[out] key : klucz
+ * @return Czy argument ma klucz, czyli czy jest współczynnikiem lub
+ * współdzielonym wielomianem?
+ */
+static bool GetOperandKey(const Poly *p, OperandKey *key) {
+
+    if (PolyIsCoeff(p)) {
+        *key = (OperandKey) {.is_coeff = true, .value = (uint64_t) p -> coeff};
+        return true;
+    }
+    *key = (OperandKey) {.is_coeff = false, .value = MonoArrGetTag(p -> arr)};
+    return key -> value != NO_TAG;
+
+}
+
+/**
+ * Wyznacza wpis pamięci podręcznej dla operacji. Obie operacje są
+ * przemienne, więc klucze argumentów są porządkowane.
+ * @param[in] op : operacja
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[out] key : wzorcowy wpis z kluczem operacji
+ * @return wskaźnik na wpis lub NULL, jeśli operacji nie zapamiętujemy
+ */
+static MemoEntry *FindSlot(InternOp op, const Poly *p, const Poly *q,
+                           MemoEntry *key) {
+
+    if (!enabled || (PolyIsCoeff(p) && PolyIsCoeff(q))) return NULL;
+    OperandKey key_p, key_q;
+    if (!GetOperandKey(p, &key_p) || !GetOperandKey(q, &key_q)) return NULL;
+    if (key_p.is_coeff > key_q.is_coeff ||
+        (key_p.is_coeff == key_q.is_coeff && key_p.value > key_q.value)) {
+        OperandKey tmp = key_p;
+        key_p = key_q;
+        key_q = tmp;
+    }
+    *key = (MemoEntry) {.used = true, .op = op, .p = key_p, .q = key_q};
+
+    if (memo == NULL) {
+        memo = (MemoEntry *) calloc(MEMO_SIZE, sizeof(MemoEntry));
+        CHECK_PTR(memo);
+    }
+    uint64_t hash = Mix(Mix(Mix(HASH_MUL, op), key_p.value ^ key_p.is_coeff),
+                        key_q.value ^ key_q.is_coeff);
+    return &memo[hash & (MEMO_SIZE - ONE_ELEMENT)];
+
+}
+
+/**
+ * Usuwa wielomiany trzymane przez wpis pamięci podręcznej.
+ * @param[in] entry : wpis pamięci podręcznej
+ */
+static void DestroyEntry(MemoEntry *entry) {
+
+    PolyDestroy(&entry -> args[FIRST_IDX]);
+    PolyDestroy(&entry -> args[ONE_ELEMENT]);
+    PolyDestroy(&entry -> result);
+
+}
+
+bool InternMemoFind(InternOp op, const Poly *p, const Poly *q, Poly *result) {
+
+    if (!enabled) return false;
+
+    MemoEntry key;
+    pthread_mutex_lock(&intern_lock);
+    MemoEntry *slot = FindSlot(op, p, q, &key);
+    bool found = slot != NULL && slot -> used && slot -> op == key.op &&
+                 slot -> p.is_coeff == key.p.is_coeff &&
+                 slot -> p.value == key.p.value &&
+                 slot -> q.is_coeff == key.q.is_coeff &&
+                 slot -> q.value == key.q.value;
+    if (found) *result = PolyClone(&slot -> result);
+    pthread_mutex_unlock(&intern_lock);
+    return found;
+
+}
+
+void InternMemoStore(InternOp op, const Poly *p, const Poly *q,
+                     const Poly *result) {
+
+    if (!enabled || MemoryCurrentGuard() != NULL) return;
+
+    MemoEntry key;
+    pthread_mutex_lock(&intern_lock);
+    MemoEntry *slot = FindSlot(op, p, q, &key);
+    if (slot == NULL) {
+        pthread_mutex_unlock(&intern_lock);
+        return;
+    }
+    // Usunięcie wypartego wpisu może zwolnić współdzielone tablice, co wymaga
+    // blokady, więc robimy to po jej zwolnieniu.
+    MemoEntry old = *slot;
+    key.args[FIRST_IDX] = PolyClone(p);
+    key.args[ONE_ELEMENT] = PolyClone(q);
+    key.result = PolyClone(result);
+    *slot = key;
+    pthread_mutex_unlock(&intern_lock);
+    if (old.used) DestroyEntry(&old);
+
+}
+
+void InternClear(void) {
+
+    if (memo != NULL) {
+        for (size_t i = FIRST_IDX; i < MEMO_SIZE; i++) {
+            if (memo[i].used) DestroyEntry(&memo[i]);
+        }
+        free(memo);
+        memo = NULL;
+    }
+    for (size_t i = FIRST_IDX; i < bucket_count; i++) {
+        InternEntry *entry = buckets[i];
+        while (entry != NULL) {
+            InternEntry *next = entry -> next;
+            free(entry);
+            entry = next;
+        }
+    }
+    free(buckets);
+    buckets = NULL;
+    bucket_count = FIRST_IDX;
+    entry_count = FIRST_IDX;
+
+}
@@ -0,0 +1,99 @@
+/** @file
+  Interfejs trybu współdzielenia wielomianów (ang. hash-consing).
+  W tym trybie każda tablica jednomianów tworzona przez operacje na
+  wielomianach trafia do globalnej tablicy unikalnych węzłów, więc równe
+  strukturalnie poddrzewa są przechowywane tylko raz. Dodatkowo wyniki
+  funkcji PolyAdd i PolyMul są zapamiętywane w pamięci podręcznej
+  indeksowanej identyfikatorami argumentów. Tryb jest domyślnie wyłączony.
+  @author Julia Podrażka
+ */
+#ifndef INTERN_H
+#define INTERN_H
+
+#include "poly.h"
+
+/**
+ * To jest typ wyliczeniowy operacji, których wyniki są zapamiętywane.
+ */
+typedef enum InternOp {
+    INTERN_ADD, ///< dodawanie wielomianów
+    INTERN_MUL ///< mnożenie wielomianów
+} InternOp;
+
+/**
+ * Włącza tryb współdzielenia wielomianów. Należy ją wywołać przed
+ * utworzeniem pierwszego wielomianu.
+ */
+void InternEnable(void);
+
+/**
+ * Sprawdza, czy tryb współdzielenia wielomianów jest włączony.
+ * @return Czy tryb jest włączony?
+ */
+bool InternEnabled(void);
+
+/**
+ * Zamienia nowo utworzony wielomian na jego współdzielony odpowiednik.
+ * Przejmuje wielomian @p p na własność. Jeśli tryb współdzielenia jest
+ * wyłączony, to zwraca @p p. Pod strażnikiem budżetu pamięci tylko szuka
+ * odpowiednika w tablicy unikalnych węzłów, a węzły, których tam nie ma,
+ * zostawia niewspółdzielone.
+ * @param[in] p : wielomian, którego tablica jednomianów nie jest współdzielona
+ * @return wielomian równy @p p
+ */
+Poly InternPoly(Poly p);
+
+/**
+ * Sprawdza, czy tablica jednomianów należy do tablicy unikalnych węzłów.
+ * @param[in] arr : tablica jednomianów
+ * @return Czy tablica jest współdzielona przez tryb współdzielenia?
+ */
+bool InternIsShared(const Mono *arr);
+
+/**
+ * Sprawdza, czy tablica jednomianów należy do tablicy unikalnych węzłów
+ * i ani ona, ani żadne jej poddrzewo nie jest tożsamościowo równe stałej.
+ * Dwa wielomiany o takich tablicach są równe wtedy i tylko wtedy, gdy
+ * mają tę samą tablicę.
+ * @param[in] arr : tablica jednomianów
+ * @return Czy tablica jest w postaci kanonicznej?
+ */
+bool InternIsCanonical(const Mono *arr);
+
+/**
+ * Zwalnia odwołanie do współdzielonej tablicy jednomianów wielomianu @p p.
+ * Jeśli było to ostatnie odwołanie, to usuwa tablicę z tablicy unikalnych
+ * węzłów, a wywołujący powinien zwolnić jej jednomiany i samą tablicę.
+ * @param[in] p : wielomian niestały ze współdzieloną tablicą jednomianów
+ * @return Czy było to ostatnie odwołanie do tablicy?
+ */
+bool InternRelease(const Poly *p);
+
+/**
+ * Szuka zapamiętanego wyniku operacji @p op na wielomianach @p p i @p q.
+ * @param[in] op : operacja
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[out] result : kopia zapamiętanego wyniku
+ * @return Czy wynik został znaleziony?
+ */
+bool InternMemoFind(InternOp op, const Poly *p, const Poly *q, Poly *result);
+
+/**
+ * Zapamiętuje wynik operacji @p op na wielomianach @p p i @p q.
+ * Nie przejmuje wyniku na własność. Pod strażnikiem budżetu pamięci nic
+ * nie robi.
+ * @param[in] op : operacja
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @param[in] result : wynik operacji
+ */
+void InternMemoStore(InternOp op, const Poly *p, const Poly *q,
+                     const Poly *result);
+
+/**
+ * Usuwa zapamiętane wyniki operacji i zwalnia tablicę unikalnych węzłów.
+ */
+void InternClear(void);
+
+#endif
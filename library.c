@@ -0,0 +1,677 @@
+/** @file
+  Implementacja biblioteki nazwanych wielomianów zapisanej w pliku
+  odwzorowywanym w pamięci.
+  @author Julia Podrażka
+ */
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "poly.h"
+#include "mono_pool.h"
+#include "pointer_map.h"
+#include "writer.h"
+#include "library.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Mnożnik rozmiaru tablicy przy powiększaniu. */
+#define SIZE 2
+/** Początkowy rozmiar tablic. */
+#define INITIAL_SIZE 16
+/** Bajty rozpoczynające plik. */
+#define MAGIC "UPOLYLIB"
+/** Liczba bajtów rozpoczynających plik. */
+#define MAGIC_SIZE 8
+/** Wersja formatu pliku. */
+#define VERSION 2
+/** Adres bazowy, dla którego liczone są wskaźniki w pliku. Leży z dala od
+ * adresów, pod którymi system umieszcza stertę, biblioteki i stos. */
+#define BASE_ADDRESS 0x200000000000ULL
+/** Wyrównanie węzłów i indeksu w pliku. */
+#define ALIGNMENT 16
+/** Przyrostek nazwy pliku tymczasowego. */
+#define TMP_SUFFIX ".tmp"
+/** Uprawnienia tworzonego pliku. */
+#define FILE_MODE 0644
+
+/**
+ * To jest struktura przechowująca nagłówek pliku biblioteki.
+ */
+typedef struct LibraryHeader {
+    char magic[MAGIC_SIZE]; ///< bajty rozpoczynające plik
+    uint32_t version; ///< wersja formatu
+    uint32_t mono_size; ///< rozmiar jednomianu
+    uint64_t header_size; ///< rozmiar nagłówka tablicy jednomianów
+    uint64_t base; ///< adres bazowy
+    uint64_t file_size; ///< rozmiar pliku
+    uint64_t entry_count; ///< liczba wielomianów
+    uint64_t index_offset; ///< położenie indeksu nazw
+    uint64_t reloc_count; ///< liczba relokacji
+    uint64_t reloc_offset; ///< położenie tablicy relokacji
+} LibraryHeader;
+
+/**
+ * To jest struktura przechowująca wpis indeksu nazw.
+ */
+typedef struct LibraryEntry {
+    uint64_t name_offset; ///< położenie nazwy w pliku
+    uint64_t name_length; ///< długość nazwy
+    Poly poly; ///< wielomian
+} LibraryEntry;
+
+/**
+ * To jest struktura przechowująca odwzorowaną bibliotekę.
+ */
+typedef struct Library {
+    char *map; ///< odwzorowanie pliku
+    size_t size; ///< rozmiar odwzorowania
+    const LibraryEntry *entries; ///< indeks nazw
+    size_t count; ///< liczba wielomianów
+    struct Library *next; ///< wcześniej otwarta biblioteka
+} Library;
+
+/** Ostatnio otwarta biblioteka. */
+static Library *library = NULL;
+
+/**
+ * To jest struktura przechowująca węzeł, którego jednomiany są zapisywane.
+ */
+typedef struct SaveFrame {
+    const Poly *p; ///< wielomian
+    size_t idx; ///< indeks kolejnego jednomianu
+    Mono *copy; ///< kopia jednomianów ze wskaźnikami na zapisane węzły
+} SaveFrame;
+
+/**
+ * To jest struktura przechowująca stan zapisywania biblioteki.
+ */
+typedef struct SaveState {
+    Writer writer; ///< stan wypisywania do pliku
+    size_t offset; ///< liczba zapisanych bajtów
+    unsigned char *node_header; ///< nagłówek tablicy stałej
+    SaveFrame *frames; ///< stos węzłów
+    size_t frame_size; ///< rozmiar stosu węzłów
+    uint64_t *relocs; ///< położenia wskaźników w pliku
+    size_t reloc_count; ///< liczba relokacji
+    size_t reloc_size; ///< rozmiar tablicy relokacji
+} SaveState;
+
+/**
+ * Zapisuje bajty do pliku biblioteki.
+ * @param[in] state : stan zapisywania
+ * @param[in] bytes : bajty
+ * @param[in] count : liczba bajtów
+ */
+static void Emit(SaveState *state, const void *bytes, size_t count) {
+
+    WriteChars(&state -> writer, (const char *) bytes, count);
+    state -> offset += count;
+
+}
+
+/**
+ * Dopisuje zera, aż liczba zapisanych bajtów będzie wielokrotnością
+ * wyrównania.
+ * @param[in] state : stan zapisywania
+ */
+static void Pad(SaveState *state) {
+
+    while (state -> offset % ALIGNMENT != FIRST_IDX) {
+        WriteChar(&state -> writer, FIRST_IDX);
+        state -> offset++;
+    }
+
+}
+
+/**
+ * Zapamiętuje położenie wskaźnika na tablicę jednomianów w pliku.
+ * @param[in] state : stan zapisywania
+ * @param[in] offset : położenie pola arr
+ */
+static void AddReloc(SaveState *state, size_t offset) {
+
+    if (state -> reloc_count == state -> reloc_size) {
+        state -> reloc_size *= SIZE;
+        state -> relocs = (uint64_t *) realloc(state -> relocs,
+                                               state -> reloc_size * sizeof(uint64_t));
+        CHECK_PTR(state -> relocs);
+    }
+    state -> relocs[state -> reloc_count++] = offset;
+
+}
+
+/**
+ * Zapisuje węzeł, którego wszystkie współczynniki są już zapisane.
+ * @param[in] state : stan zapisywania
+ * @param[in] frame : węzeł
+ * @return wielomian wskazujący na zapisany węzeł pod adresem bazowym
+ */
+static Poly EmitNode(SaveState *state, SaveFrame *frame) {
+
+    Pad(state);
+    size_t arr_offset = state -> offset + MonoArrHeaderSize();
+    // Liczba wyrazów zapisana w nagłówku oszczędza jej liczenia po
+    // wczytaniu, bo nagłówka tablicy w pliku nie można zmieniać.
+    MonoArrSetTerms((Mono *) (state -> node_header + MonoArrHeaderSize()),
+                    PolyTerms(frame -> p));
+    Emit(state, state -> node_header, MonoArrHeaderSize());
+    for (size_t i = FIRST_IDX; i < frame -> p -> size; i++) {
+        if (!PolyIsCoeff(&frame -> copy[i].p))
+            AddReloc(state, arr_offset + i * sizeof(Mono) + offsetof(Mono, p) +
+                            offsetof(Poly, arr));
+    }
+    Emit(state, frame -> copy, frame -> p -> size * sizeof(Mono));
+    return (Poly) {.size = frame -> p -> size,
+                   .arr = (Mono *) (uintptr_t) (BASE_ADDRESS + arr_offset)};
+
+}
+
+/**
+ * Dokłada węzeł na stos zapisywanych węzłów.
+ * @param[in] state : stan zapisywania
+ * @param[in] depth : liczba węzłów na stosie
+ * @param[in] p : wielomian niestały
+ */
+static void PushFrame(SaveState *state, size_t *depth, const Poly *p) {
+
+    if (*depth == state -> frame_size) {
+        state -> frame_size *= SIZE;
+        state -> frames = (SaveFrame *) realloc(state -> frames,
+                                                state -> frame_size * sizeof(SaveFrame));
+        CHECK_PTR(state -> frames);
+    }
+    // Zerujemy kopię, żeby wyrównanie wewnątrz jednomianów nie zawierało
+    // przypadkowych bajtów.
+    Mono *copy = (Mono *) calloc(p -> size, sizeof(Mono));
+    CHECK_PTR(copy);
+    state -> frames[(*depth)++] = (SaveFrame) {.p = p, .idx = FIRST_IDX, .copy = copy};
+
+}
+
+/**
+ * Zapisuje węzły wielomianu, zaczynając od współczynników, tak żeby każdy
+ * węzeł wskazywał na zapisane już węzły.
+ * @param[in] state : stan zapisywania
+ * @param[in] p : wielomian
+ * @return wielomian wskazujący na zapisane węzły pod adresem bazowym
+ */
+static Poly EmitPoly(SaveState *state, const Poly *p) {
+
+    if (PolyIsCoeff(p)) return *p;
+
+    size_t depth = FIRST_IDX;
+    PushFrame(state, &depth, p);
+    while (true) {
+        SaveFrame *frame = &state -> frames[depth - ONE_ELEMENT];
+        if (frame -> idx < frame -> p -> size) {
+            const Mono *mono = &frame -> p -> arr[frame -> idx];
+            frame -> copy[frame -> idx].exp = mono -> exp;
+            if (PolyIsCoeff(&mono -> p)) {
+                frame -> copy[frame -> idx++].p = mono -> p;
+            } else PushFrame(state, &depth, &mono -> p);
+            continue;
+        }
+
+        Poly node = EmitNode(state, frame);
+        free(frame -> copy);
+        if (--depth == FIRST_IDX) return node;
+        frame = &state -> frames[depth - ONE_ELEMENT];
+        frame -> copy[frame -> idx++].p = node;
+    }
+
+}
+
+/**
+ * Porównuje nazwy.
+ * @param[in] name1 : pierwsza nazwa
+ * @param[in] length1 : długość pierwszej nazwy
+ * @param[in] name2 : druga nazwa
+ * @param[in] length2 : długość drugiej nazwy
+ * @return liczba ujemna, zero lub dodatnia, jak w funkcji memcmp
+ */
+static int CompareNames(const char *name1, size_t length1, const char *name2,
+                        size_t length2) {
+
+    int result = memcmp(name1, name2, length1 < length2 ? length1 : length2);
+    if (result != FIRST_IDX) return result;
+    return (length1 > length2) - (length1 < length2);
+
+}
+
+/**
+ * To jest struktura przechowująca wielomian do zapisania razem z nazwą.
+ */
+typedef struct NamedPoly {
+    const char *name; ///< nazwa
+    size_t length; ///< długość nazwy
+    size_t idx; ///< indeks wielomianu na stosie
+    Poly poly; ///< wielomian zapisany pod adresem bazowym
+} NamedPoly;
+
+/**
+ * Porównuje wielomiany według nazw, dla funkcji qsort.
+ * @param[in] arr1 : pierwszy wielomian
+ * @param[in] arr2 : drugi wielomian
+ * @return liczba ujemna, zero lub dodatnia
+ */
+static int CompareNamed(const void *arr1, const void *arr2) {
+
+    const NamedPoly *named1 = (const NamedPoly *) arr1;
+    const NamedPoly *named2 = (const NamedPoly *) arr2;
+    return CompareNames(named1 -> name, named1 -> length, named2 -> name,
+                        named2 -> length);
+
+}
+
+/**
+ * Zapisuje indeks nazw i tablicę relokacji za węzłami.
+ * @param[in] state : stan zapisywania
+ * @param[in] named : wielomiany posortowane według nazw
+ * @param[in] count : liczba wielomianów
+ * @param[out] header : nagłówek pliku do uzupełnienia
+ */
+static void EmitIndex(SaveState *state, NamedPoly *named, size_t count,
+                      LibraryHeader *header) {
+
+    Pad(state);
+    header -> index_offset = state -> offset;
+    size_t name_offset = state -> offset + count * sizeof(LibraryEntry);
+    for (size_t i = FIRST_IDX; i < count; i++) {
+        LibraryEntry entry = (LibraryEntry) {.name_offset = name_offset,
+                                             .name_length = named[i].length,
+                                             .poly = named[i].poly};
+        if (!PolyIsCoeff(&entry.poly))
+            AddReloc(state, state -> offset + offsetof(LibraryEntry, poly) +
+                            offsetof(Poly, arr));
+        Emit(state, &entry, sizeof(LibraryEntry));
+        name_offset += named[i].length;
+    }
+    for (size_t i = FIRST_IDX; i < count; i++)
+        Emit(state, named[i].name, named[i].length);
+
+    Pad(state);
+    header -> reloc_offset = state -> offset;
+    header -> reloc_count = state -> reloc_count;
+    Emit(state, state -> relocs, state -> reloc_count * sizeof(uint64_t));
+    header -> file_size = state -> offset;
+
+}
+
+bool LibrarySave(stack *s, size_t count, char *names[], const char *path) {
+
+    NamedPoly *named = (NamedPoly *) malloc((count + ONE_ELEMENT) * sizeof(NamedPoly));
+    CHECK_PTR(named);
+    size_t first = NumberOfElements(s) - count;
+    for (size_t i = FIRST_IDX; i < count; i++)
+        named[i] = (NamedPoly) {.name = names[i], .length = strlen(names[i]),
+                                .idx = first + i};
+    qsort(named, count, sizeof(NamedPoly), CompareNamed);
+    for (size_t i = ONE_ELEMENT; i < count; i++) {
+        if (CompareNamed(&named[i - ONE_ELEMENT], &named[i]) == FIRST_IDX) {
+            free(named);
+            return false;
+        }
+    }
+
+    char *tmp_path = (char *) malloc(strlen(path) + sizeof(TMP_SUFFIX));
+    CHECK_PTR(tmp_path);
+    strcpy(tmp_path, path);
+    strcat(tmp_path, TMP_SUFFIX);
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, FILE_MODE);
+    if (fd < FIRST_IDX) {
+        free(tmp_path);
+        free(named);
+        return false;
+    }
+
+    SaveState state = (SaveState) {.offset = FIRST_IDX, .frame_size = INITIAL_SIZE,
+                                   .reloc_count = FIRST_IDX,
+                                   .reloc_size = INITIAL_SIZE};
+    WriterInit(&state.writer, fd, false);
+    state.frames = (SaveFrame *) malloc(state.frame_size * sizeof(SaveFrame));
+    CHECK_PTR(state.frames);
+    state.relocs = (uint64_t *) malloc(state.reloc_size * sizeof(uint64_t));
+    CHECK_PTR(state.relocs);
+    state.node_header = (unsigned char *) malloc(MonoArrHeaderSize());
+    CHECK_PTR(state.node_header);
+    MonoArrInitStatic(state.node_header);
+
+    // Nagłówek zapisujemy na końcu, gdy znane są położenia indeksu i relokacji.
+    LibraryHeader header;
+    memset(&header, FIRST_IDX, sizeof(LibraryHeader));
+    Emit(&state, &header, sizeof(LibraryHeader));
+    for (size_t i = FIRST_IDX; i < count; i++)
+        named[i].poly = EmitPoly(&state, &s -> poly_stack[named[i].idx]);
+    memcpy(header.magic, MAGIC, MAGIC_SIZE);
+    header.version = VERSION;
+    header.mono_size = sizeof(Mono);
+    header.header_size = MonoArrHeaderSize();
+    header.base = BASE_ADDRESS;
+    header.entry_count = count;
+    EmitIndex(&state, named, count, &header);
+
+    WriterFlush(&state.writer);
+    bool saved = !state.writer.failed &&
+                 pwrite(fd, &header, sizeof(LibraryHeader), FIRST_IDX) ==
+                 (ssize_t) sizeof(LibraryHeader);
+    WriterFree(&state.writer);
+    if (close(fd) != FIRST_IDX) saved = false;
+    if (saved) saved = rename(tmp_path, path) == FIRST_IDX;
+    if (!saved) unlink(tmp_path);
+
+    free(state.frames);
+    free(state.relocs);
+    free(state.node_header);
+    free(tmp_path);
+    free(named);
+    return saved;
+
+}
+
+/**
+ * Sprawdza, czy obszar pliku mieści się w pliku.
+ * @param[in] offset : początek obszaru
+ * @param[in] count : liczba elementów obszaru
+ * @param[in] size : rozmiar elementu
+ * @param[in] file_size : rozmiar pliku
+ * @return Czy obszar mieści się w pliku?
+ */
+static bool InFile(uint64_t offset, uint64_t count, uint64_t size, uint64_t file_size) {
+
+    return offset <= file_size && count <= (file_size - offset) / size;
+
+}
+
+/**
+ * Przesuwa wskaźniki w odwzorowaniu pliku odwzorowanego pod innym adresem
+ * niż adres bazowy.
+ * @param[in] map : odwzorowanie pliku
+ * @param[in] header : nagłówek pliku
+ * @return Czy relokacje są poprawne?
+ */
+static bool Relocate(char *map, const LibraryHeader *header) {
+
+    uint64_t delta = (uint64_t) (uintptr_t) map - header -> base;
+    const uint64_t *relocs = (const uint64_t *) (map + header -> reloc_offset);
+    for (size_t i = FIRST_IDX; i < header -> reloc_count; i++) {
+        uint64_t offset = relocs[i];
+        if (offset % sizeof(uint64_t) != FIRST_IDX ||
+            !InFile(offset, ONE_ELEMENT, sizeof(uint64_t), header -> reloc_offset))
+            return false;
+        *(uint64_t *) (map + offset) += delta;
+    }
+    return true;
+
+}
+
+/**
+ * Sprawdza nagłówek pliku biblioteki.
+ * @param[in] header : nagłówek
+ * @param[in] file_size : rozmiar pliku
+ * @return Czy nagłówek jest poprawny?
+ */
+static bool CheckHeader(const LibraryHeader *header, size_t file_size) {
+
+    return memcmp(header -> magic, MAGIC, MAGIC_SIZE) == FIRST_IDX &&
+           header -> version == VERSION && header -> mono_size == sizeof(Mono) &&
+           header -> header_size == MonoArrHeaderSize() &&
+           header -> base % ALIGNMENT == FIRST_IDX &&
+           header -> file_size == file_size &&
+           header -> index_offset % ALIGNMENT == FIRST_IDX &&
+           header -> reloc_offset % ALIGNMENT == FIRST_IDX &&
+           InFile(header -> index_offset, header -> entry_count,
+                  sizeof(LibraryEntry), file_size) &&
+           InFile(header -> reloc_offset, header -> reloc_count,
+                  sizeof(uint64_t), file_size);
+
+}
+
+/**
+ * Sprawdza, czy nazwy w indeksie mieszczą się w pliku i są posortowane.
+ * @param[in] map : odwzorowanie pliku
+ * @param[in] header : nagłówek pliku
+ * @return Czy indeks jest poprawny?
+ */
+static bool CheckIndex(const char *map, const LibraryHeader *header) {
+
+    const LibraryEntry *entries = (const LibraryEntry *) (map + header -> index_offset);
+    for (size_t i = FIRST_IDX; i < header -> entry_count; i++) {
+        if (!InFile(entries[i].name_offset, entries[i].name_length, ONE_ELEMENT,
+                    header -> file_size))
+            return false;
+        if (i > FIRST_IDX &&
+            CompareNames(map + entries[i - ONE_ELEMENT].name_offset,
+                         entries[i - ONE_ELEMENT].name_length,
+                         map + entries[i].name_offset, entries[i].name_length) >= FIRST_IDX)
+            return false;
+    }
+    return true;
+
+}
+
+/**
+ * To jest struktura przechowująca węzeł sprawdzany przy otwieraniu biblioteki.
+ */
+typedef struct CheckFrame {
+    const Poly *p; ///< wielomian wskazujący na węzeł
+    size_t idx; ///< indeks kolejnego jednomianu
+    size_t terms; ///< liczba wyrazów sprawdzonych jednomianów
+} CheckFrame;
+
+/**
+ * Zwraca położenie tablicy jednomianów w pliku.
+ * @param[in] map : odwzorowanie pliku
+ * @param[in] arr : tablica jednomianów
+ * @return położenie tablicy, dowolnie duże dla wskaźnika spoza pliku
+ */
+static uint64_t ArrOffset(const char *map, const Mono *arr) {
+
+    return (uint64_t) ((uintptr_t) arr - (uintptr_t) map);
+
+}
+
+/**
+ * Sprawdza węzeł bez jego współczynników niestałych: położenie i rozmiar
+ * tablicy jednomianów, nagłówek tablicy stałej, malejące wykładniki
+ * i niezerowe współczynniki stałe. Zapisane węzły poprzedzają w pliku
+ * węzły, które na nie wskazują, więc tablica musi się kończyć przed
+ * początkiem @p limit; dzięki temu sprawdzanie się kończy, nawet jeśli
+ * plik został zmieniony.
+ * @param[in] map : odwzorowanie pliku
+ * @param[in] header : nagłówek pliku
+ * @param[in] p : wielomian niestały wskazujący na węzeł
+ * @param[in] limit : położenie, przed którym musi się kończyć tablica
+ * @return Czy węzeł jest poprawny?
+ */
+static bool CheckNode(const char *map, const LibraryHeader *header, const Poly *p,
+                      uint64_t limit) {
+
+    uint64_t offset = ArrOffset(map, p -> arr);
+    if (offset < sizeof(LibraryHeader) + header -> header_size ||
+        (offset - header -> header_size) % ALIGNMENT != FIRST_IDX ||
+        p -> size == FIRST_IDX || !InFile(offset, p -> size, sizeof(Mono), limit) ||
+        !MonoArrIsStatic(p -> arr) || MonoArrGetTag(p -> arr) != FIRST_IDX)
+        return false;
+
+    for (size_t i = FIRST_IDX; i < p -> size; i++) {
+        const Mono *mono = &p -> arr[i];
+        if (mono -> exp < FIRST_IDX ||
+            (i > FIRST_IDX && mono -> exp >= p -> arr[i - ONE_ELEMENT].exp) ||
+            (PolyIsCoeff(&mono -> p) && mono -> p.coeff == FIRST_IDX))
+            return false;
+    }
+    return true;
+
+}
+
+/**
+ * Sprawdza wszystkie węzły wielomianu bez rekurencji, przy pomocy stosu
+ * węzłów. Węzły wspólne dla kilku wielomianów sprawdzane są raz.
+ * @param[in] map : odwzorowanie pliku
+ * @param[in] header : nagłówek pliku
+ * @param[in] root : wielomian niestały z indeksu
+ * @param[in,out] checked : sprawdzone tablice jednomianów wraz z rozmiarami
+ * @param[in,out] frames : stos węzłów
+ * @param[in,out] frame_size : rozmiar stosu węzłów
+ * @return Czy wielomian jest poprawny?
+ */
+static bool CheckTree(const char *map, const LibraryHeader *header, const Poly *root,
+                      PointerMap *checked, CheckFrame **frames, size_t *frame_size) {
+
+    int64_t size;
+    if (PointerMapFind(checked, root -> arr, &size)) return (size_t) size == root -> size;
+    if (!CheckNode(map, header, root, header -> index_offset)) return false;
+
+    size_t depth = FIRST_IDX;
+    (*frames)[depth++] = (CheckFrame) {.p = root, .idx = FIRST_IDX, .terms = FIRST_IDX};
+    while (depth > FIRST_IDX) {
+        CheckFrame *frame = &(*frames)[depth - ONE_ELEMENT];
+        if (frame -> idx < frame -> p -> size) {
+            const Poly *child = &frame -> p -> arr[frame -> idx].p;
+            if (PolyIsCoeff(child)) {
+                frame -> terms++;
+                frame -> idx++;
+            } else if (PointerMapFind(checked, child -> arr, &size)) {
+                if ((size_t) size != child -> size) return false;
+                frame -> terms += MonoArrGetTerms(child -> arr);
+                frame -> idx++;
+            } else {
+                uint64_t start = ArrOffset(map, frame -> p -> arr) - header -> header_size;
+                if (!CheckNode(map, header, child, start)) return false;
+                if (depth == *frame_size) {
+                    *frame_size *= SIZE;
+                    *frames = (CheckFrame *) realloc(*frames, *frame_size * sizeof(CheckFrame));
+                    CHECK_PTR(*frames);
+                }
+                (*frames)[depth++] = (CheckFrame) {.p = child, .idx = FIRST_IDX,
+                                                   .terms = FIRST_IDX};
+            }
+            continue;
+        }
+
+        // Liczba wyrazów zapisana w nagłówku zastępuje jej liczenie, więc
+        // musi się zgadzać z rzeczywistą.
+        if (MonoArrGetTerms(frame -> p -> arr) != frame -> terms) return false;
+        PointerMapSet(checked, frame -> p -> arr, (int64_t) frame -> p -> size);
+        if (--depth > FIRST_IDX) {
+            (*frames)[depth - ONE_ELEMENT].terms += frame -> terms;
+            (*frames)[depth - ONE_ELEMENT].idx++;
+        }
+    }
+    return true;
+
+}
+
+/**
+ * Sprawdza wielomiany z indeksu, zanim zostaną użyte, tak jak sprawdzane
+ * są wielomiany wczytywane z pliku stosu.
+ * @param[in] map : odwzorowanie pliku
+ * @param[in] header : nagłówek pliku
+ * @return Czy wszystkie wielomiany są poprawne?
+ */
+static bool CheckPolys(const char *map, const LibraryHeader *header) {
+
+    const LibraryEntry *entries = (const LibraryEntry *) (map + header -> index_offset);
+    PointerMap checked = PointerMapInit();
+    size_t frame_size = INITIAL_SIZE;
+    CheckFrame *frames = (CheckFrame *) malloc(frame_size * sizeof(CheckFrame));
+    CHECK_PTR(frames);
+    bool is_correct = true;
+    for (size_t i = FIRST_IDX; is_correct && i < header -> entry_count; i++) {
+        if (!PolyIsCoeff(&entries[i].poly))
+            is_correct = CheckTree(map, header, &entries[i].poly, &checked,
+                                   &frames, &frame_size);
+    }
+    free(frames);
+    PointerMapFree(&checked);
+    return is_correct;
+
+}
+
+bool LibraryOpen(const char *path) {
+
+    int fd = open(path, O_RDONLY);
+    if (fd < FIRST_IDX) return false;
+    struct stat info;
+    LibraryHeader header;
+    if (fstat(fd, &info) != FIRST_IDX || !S_ISREG(info.st_mode) ||
+        pread(fd, &header, sizeof(LibraryHeader), FIRST_IDX) !=
+        (ssize_t) sizeof(LibraryHeader) ||
+        !CheckHeader(&header, (size_t) info.st_size)) {
+        close(fd);
+        return false;
+    }
+
+    // Najpierw próbujemy odwzorować plik pod adresem bazowym. Adres jest
+    // tylko wskazówką dla systemu, więc nie nadpisujemy istniejących
+    // odwzorowań.
+    size_t size = (size_t) info.st_size;
+    char *map = (char *) mmap((void *) (uintptr_t) header.base, size, PROT_READ,
+                              MAP_PRIVATE, fd, FIRST_IDX);
+    bool is_correct = map != MAP_FAILED;
+    if (is_correct && (uintptr_t) map != header.base) {
+        munmap(map, size);
+        map = (char *) mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                            fd, FIRST_IDX);
+        is_correct = map != MAP_FAILED && Relocate(map, &header) &&
+                     mprotect(map, size, PROT_READ) == FIRST_IDX;
+    }
+    close(fd);
+    if (is_correct) is_correct = CheckIndex(map, &header) && CheckPolys(map, &header);
+    if (!is_correct) {
+        if (map != MAP_FAILED) munmap(map, size);
+        return false;
+    }
+
+    Library *opened = (Library *) malloc(sizeof(Library));
+    CHECK_PTR(opened);
+    *opened = (Library) {.map = map, .size = size,
+                         .entries = (const LibraryEntry *) (map + header.index_offset),
+                         .count = header.entry_count, .next = library};
+    library = opened;
+    return true;
+
+}
+
+bool LibraryFind(const char *name, Poly *p) {
+
+    if (library == NULL) return false;
+
+    size_t length = strlen(name);
+    size_t left = FIRST_IDX;
+    size_t right = library -> count;
+    while (left < right) {
+        size_t middle = left + (right - left) / SIZE;
+        const LibraryEntry *entry = &library -> entries[middle];
+        int result = CompareNames(library -> map + entry -> name_offset,
+                                  entry -> name_length, name, length);
+        if (result == FIRST_IDX) {
+            *p = entry -> poly;
+            return true;
+        }
+        if (result < FIRST_IDX) left = middle + ONE_ELEMENT;
+        else right = middle;
+    }
+    return false;
+
+}
+
+void LibraryClose(void) {
+
+    while (library != NULL) {
+        Library *next = library -> next;
+        munmap(library -> map, library -> size);
+        free(library);
+        library = next;
+    }
+
+}
@@ -0,0 +1,67 @@
+/** @file
+  Interfejs biblioteki nazwanych wielomianów zapisanej w pliku, który
+  kalkulator odwzorowuje w pamięci tylko do odczytu.
+
+  Węzły wielomianów zapisane są w pliku dokładnie tak, jak w pamięci:
+  tablice jednomianów poprzedzone nagłówkami tablic stałych (patrz
+  MonoArrInitStatic) ze wskaźnikami policzonymi dla adresu bazowego
+  zapisanego w nagłówku pliku. Jeśli plik uda się odwzorować pod tym
+  adresem, to wielomiany z biblioteki są gotowe do użycia bez żadnego
+  kopiowania. W przeciwnym przypadku wskaźniki są przesuwane według tablicy
+  relokacji zapisanej na końcu pliku. Za węzłami zapisany jest posortowany
+  indeks nazw, po którym nazwy wyszukiwane są binarnie.
+
+  Wielomiany z biblioteki są zwykłymi wielomianami o tablicach stałych,
+  więc działają na nich wszystkie funkcje z poly.h. Operacje tylko czytające
+  wielomian czytają bezpośrednio odwzorowaną pamięć, a operacje zmieniające
+  wielomian w miejscu najpierw go kopiują. Plik jest zależny od architektury
+  i jest traktowany jak plik wykonywalny: jego zawartość nie jest
+  sprawdzana poza nagłówkiem, indeksem i relokacjami.
+  @author Julia Podrażka
+ */
+#ifndef LIBRARY_H
+#define LIBRARY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "poly.h"
+#include "stack.h"
+
+/**
+ * Zapisuje @p count wielomianów z wierzchołka stosu jako bibliotekę
+ * w pliku @p path. Wielomian z wierzchołka stosu dostaje ostatnią nazwę.
+ * Plik zapisywany jest pod nazwą tymczasową i dopiero na końcu zastępuje
+ * plik @p path, więc można nadpisać bibliotekę, która jest otwarta.
+ * @param[in] s : stos wielomianów, zawierający co najmniej @p count wielomianów
+ * @param[in] count : liczba wielomianów
+ * @param[in] names : różne nazwy wielomianów
+ * @param[in] path : ścieżka pliku
+ * @return Czy nazwy są różne i udało się zapisać plik?
+ */
+bool LibrarySave(stack *s, size_t count, char *names[], const char *path);
+
+/**
+ * Otwiera bibliotekę z pliku @p path. Wcześniej otwarta biblioteka
+ * pozostaje odwzorowana w pamięci do końca działania programu, bo mogą
+ * się do niej odwoływać wielomiany.
+ * @param[in] path : ścieżka pliku
+ * @return Czy plik jest poprawną biblioteką?
+ */
+bool LibraryOpen(const char *path);
+
+/**
+ * Wyszukuje w otwartej bibliotece wielomian o nazwie @p name.
+ * @param[in] name : nazwa
+ * @param[out] p : wielomian; jego usunięcie nic nie robi
+ * @return Czy biblioteka jest otwarta i zawiera wielomian o tej nazwie?
+ */
+bool LibraryFind(const char *name, Poly *p);
+
+/**
+ * Usuwa odwzorowania wszystkich otwartych bibliotek. Wcześniej należy
+ * usunąć wszystkie wielomiany.
+ */
+void LibraryClose(void);
+
+#endif
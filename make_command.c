@@ -2,17 +2,15 @@
   Implementacja klasy parsującej komendy.
   @author Julia Podrażka
  */
-#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
 #include <ctype.h>
 
 #include "poly.h"
+#include "library.h"
 #include "make_command.h"
 
-/** Kod ascii znaku nowej linii. */
-#define NEWLINE 10
 /** Pierwszy indeks w tablicy. */
 #define FIRST_IDX 0
 /** Jeden element w tablicy. */
@@ -37,237 +35,77 @@
 #define NULL_CHAR 0
 
 /**
- * Wypisuje na standardowe wyjście błędów błąd parsowania komendy.
- * @param[in] line_number : numer aktualnego wiersza
- */
-static void PrintStackUnderflow(size_t line_number) {
-
-    fprintf(stderr, "ERROR %zu STACK UNDERFLOW\n", line_number);
-
-}
-
-/**
- * Wykonuje komendy IS_ZERO i ZERO.
- * @param[in] s : stos wielomianów
- * @param[in] line_number : numer aktualnego wiersza
- * @param[in] op : funkcja będąca albo AllExpZero albo PolyIsZero
- */
-static void ParseZero(stack *s, size_t line_number, bool (*op)(const Poly *)) {
-
-    if (IsEmpty(s)) PrintStackUnderflow(line_number);
-    else {
-        Poly p = Top(s);
-        if (op(&p)) printf("1\n");
-        else printf("0\n");
-    }
-
-}
-
-/**
- * Wykonuje komendę CLONE.
- * @param[in] s : stos wielomianów
- * @param[in] line_number : numer aktualnego wiersza
- */
-static void ParseClone(stack *s, size_t line_number) {
-
-    if (IsEmpty(s)) PrintStackUnderflow(line_number);
-    else {
-        Poly p = Top(s);
-        Push(s, PolyClone(&p));
-    }
-
-}
-
-/**
- * Wykonuje komendy ADD, MUL i SUB.
- * @param[in] s : stos wielomianów
- * @param[in] line_number : numer aktualnego wiersza
- * @param[in] op : funkcja dwuargumentowa będąca albo PolyAdd albo PolySub albo PolyMul
- */
-static void ParseTwoArgumentFunctions(stack *s, size_t line_number,
-                                      Poly (*op)(const Poly *, const Poly *)) {
-
-    if (!AreTwoElements(s)) PrintStackUnderflow(line_number);
-    else {
-        Poly p1 = Pop(s);
-        Poly p2 = Pop(s);
-        Push(s, op(&p1, &p2));
-        PolyDestroy(&p1);
-        PolyDestroy(&p2);
-    }
-
-}
-
-/**
- * Wykonuje komendę NEG.
- * @param[in] s : stos wielomianów
- * @param[in] line_number : numer aktualnego wiersza
- */
-static void ParseNeg(stack *s, size_t line_number) {
-
-    if (IsEmpty(s)) PrintStackUnderflow(line_number);
-    else {
-        Poly p = Pop(s);
-        Push(s, PolyNeg(&p));
-        PolyDestroy(&p);
-    }
-
-}
-
-/**
- * Wykonuje komendę IS_EQ.
- * @param[in] s : stos wielomianów
- * @param[in] line_number : numer aktualnego wiersza
- */
-static void ParseIsEq(stack *s, size_t line_number) {
-
-    if (!AreTwoElements(s)) PrintStackUnderflow(line_number);
-    else {
-        Poly p1 = Top(s);
-        Poly p2 = SecondTop(s);
-        if (PolyIsEq(&p1, &p2)) printf("1\n");
-        else printf("0\n");
-    }
-
-}
-
-/**
- * Wykonuje komendę DEG.
- * @param[in] s : stos wielomianów
- * @param[in] line_number : numer aktualnego wiersza
- */
-static void ParseDeg(stack *s, size_t line_number) {
-
-    if (IsEmpty(s)) PrintStackUnderflow(line_number);
-    else {
-        Poly p = Top(s);
-        printf("%d\n", PolyDeg(&p));
-    }
-
-}
-
-/**
- * Wypisuje na standardowe wyjście wielomian.
- * @param[in] p : wielomian
- */
-static void Print(Poly p) {
-
-    if (PolyIsCoeff(&p) || AllExpZero(&p)) printf("%ld", GetCoeff(&p));
-    else {
-        for (long long int i = p.size - ONE_ELEMENT; i >= FIRST_IDX; i--) {
-            Mono current_mono = p.arr[i];
-            printf("(");
-            Print(current_mono.p);
-            printf(",%d)", MonoGetExp(&current_mono));
-            if (i != FIRST_IDX) printf("+");
-        }
-    }
-
-}
-
-/**
- * Wykonuje komendę PRINT.
- * @param[in] s : stos wielomianów
- * @param[in] line_number : numer aktualnego wiersza
- */
-static void PolyPrint(stack *s, size_t line_number) {
-
-    if (IsEmpty(s)) PrintStackUnderflow(line_number);
-    else {
-        Poly p = Top(s);
-        Print(p);
-        printf("\n");
-    }
-
-}
-
-/**
- * Wykonuje komendę POP.
- * @param[in] s : stos wielomianów
- * @param[in] line_number : numer aktualnego wiersza
- */
-static void ParsePop(stack *s, size_t line_number) {
-
-    if (IsEmpty(s)) PrintStackUnderflow(line_number);
-    else {
-        Poly p = Pop(s);
-        PolyDestroy(&p);
-    }
-
-}
-
-/**
- * Wypisuje błąd dotyczący komendy AT na standardowe wyjście błędów.
- * @param[in] line_number : numer aktualnego wiersza
- */
-static void PrintAtError(size_t line_number) {
-
-    fprintf(stderr, "ERROR %zu AT WRONG VALUE\n", line_number);
-
-}
-
-/**
- * Wypisuje błąd dotyczący komendy DEG_BY na standardowe wyjście błędów.
- * @param[in] line_number : numer aktualnego wiersza
+ * Zamienia instrukcję w instrukcję wypisującą błąd.
+ * @param[out] instruction : instrukcja
+ * @param[in] error : treść błędu
  */
-static void PrintDegByError(size_t line_number) {
+static void SetError(Instruction *instruction, const char *error) {
 
-    fprintf(stderr, "ERROR %zu DEG BY WRONG VARIABLE\n", line_number);
+    instruction -> opcode = OP_ERROR;
+    instruction -> error = error;
 
 }
 
 /**
- * Wypisuje błąd dotyczący komendy COMPOSE na standardowe wyjście błędów.
- * @param[in] line_number : numer aktualnego wiersza
+ * Ustawia błąd dotyczący komendy COMPOSE lub DEG_BY w zależności od
+ * wartości @p is_deg_by.
+ * @param[out] instruction : instrukcja
+ * @param[in] is_deg_by : zmienna określająca, czy ustawić błąd DEG_BY czy
+ * COMPOSE
  */
-static void PrintComposeError(size_t line_number) {
+static void SetDegByOrComposeError(Instruction *instruction, bool is_deg_by) {
 
-    fprintf(stderr, "ERROR %zu COMPOSE WRONG PARAMETER\n", line_number);
+    SetError(instruction, is_deg_by ? ERROR_DEG_BY : ERROR_COMPOSE);
 
 }
 
 /**
- * Wypisuje błąd dotyczący komendy COMPOSE lub DEG_BY na standardowe wyjście
- * błędów w zależności od wartości @p is_deg_by.
- * @param[in] line_number : numer aktualnego wiersza
- * @param[in] is_deg_by : zmienna określająca, czy wypisać błąd DEG_BY czy
- * COMPOSE
+ * Kopiuje słowa oddzielone znakami zerowymi do jednego bloku pamięci
+ * i zapisuje je jako argument instrukcji.
+ * @param[out] instruction : instrukcja
+ * @param[in] words : słowa leżące kolejno w jednym wierszu
+ * @param[in] count : liczba słów
+ * @param[in] length : łączna długość słów wraz ze znakami zerowymi
  */
-static void PrintDegByOrComposeError(size_t line_number, bool is_deg_by) {
-
-    if (is_deg_by) PrintDegByError(line_number);
-    else PrintComposeError(line_number);
+static void SetWords(Instruction *instruction, char *words[], size_t count,
+                     size_t length) {
+
+    char *copy = (char *) malloc(length);
+    CHECK_PTR(copy);
+    memcpy(copy, words[FIRST_IDX], length);
+    instruction -> words = (char **) malloc(count * sizeof(char *));
+    CHECK_PTR(instruction -> words);
+    for (size_t k = FIRST_IDX; k < count; k++)
+        instruction -> words[k] = copy + (words[k] - words[FIRST_IDX]);
+    instruction -> word_count = count;
 
 }
 
 /**
- * Wykonuje komendę AT.
+ * Parsuje argument komendy AT.
  * @param[in] char_arr : tablica znaków aktualnego wiersza
  * @param[in] char_number : liczba znaków w aktualnym wierszu
- * @param[in] line_number : numer aktualnego wiersza
- * @param[in] s : stos wielomianów
+ * @param[out] instruction : instrukcja
  */
-static void ParseAt(char *char_arr, size_t char_number, size_t line_number,
-                    stack *s) {
+static void ParseAt(char *char_arr, size_t char_number, Instruction *instruction) {
 
     size_t i = 2;
     if ((i + TWO_ELEMENTS) > char_number || (int) char_arr[i] != SPACE ||
         (!isdigit(char_arr[i + ONE_ELEMENT]) &&
         (int) char_arr[i + ONE_ELEMENT] != MINUS)) {
-        if (!isspace(char_arr[i])) {
-            fprintf(stderr, "ERROR %zu WRONG COMMAND\n", line_number);
-        } else PrintAtError(line_number);
+        if (!isspace(char_arr[i])) SetError(instruction, ERROR_WRONG_COMMAND);
+        else SetError(instruction, ERROR_AT);
     } else {
         char space[] = " ";
         char *divided_char = strtok(char_arr, space);
         size_t divided_idx = FIRST_IDX;
         while (divided_char != NULL) {
             if (divided_idx == FIRST_IDX && strcmp(divided_char, "AT") != SAME) {
-                PrintAtError(line_number);
+                SetError(instruction, ERROR_AT);
                 break;
             } else if (divided_idx == ONE_ELEMENT) {
                 if ((int) divided_char[FIRST_IDX] == PLUS) {
-                    PrintAtError(line_number);
+                    SetError(instruction, ERROR_AT);
                     break;
                 }
                 char *last_char;
@@ -278,21 +116,17 @@ static void ParseAt(char *char_arr, size_t char_number, size_t line_number,
                     (int) last_char[FIRST_IDX] == NULL_CHAR)) {
                     divided_char = strtok(NULL, space);
                     if (divided_char != NULL) {
-                        PrintAtError(line_number);
+                        SetError(instruction, ERROR_AT);
                         break;
                     }
-                    if (IsEmpty(s)) PrintStackUnderflow(line_number);
-                    else {
-                        Poly p = Pop(s);
-                        Push(s, PolyAt(&p, value));
-                        PolyDestroy(&p);
-                    }
+                    instruction -> opcode = OP_AT;
+                    instruction -> value = value;
                 } else {
-                    PrintAtError(line_number);
+                    SetError(instruction, ERROR_AT);
                     break;
                 }
             } else if (divided_idx > ONE_ELEMENT) {
-                PrintAtError(line_number);
+                SetError(instruction, ERROR_AT);
                 break;
             }
             divided_char = strtok(NULL, space);
@@ -303,53 +137,176 @@ static void ParseAt(char *char_arr, size_t char_number, size_t line_number,
 }
 
 /**
- * Wykonuje komendę COMPOSE zakładając, że mamy wystarczająco dużo wielomianów
- * na stosie @p s.
- * @param[in] s : stos wielomianów
- * @param[in] value : argument komendy COMPOSE
+ * Parsuje argumenty komendy AT_MANY, czyli punkty oddzielone spacjami.
+ * @param[in] char_arr : tablica znaków aktualnego wiersza
+ * @param[in] char_number : liczba znaków w aktualnym wierszu
+ * @param[out] instruction : instrukcja
  */
-static void MakeCompose(stack *s, unsigned long long int value) {
-
-    Poly p = Pop(s);
-    Poly *q;
-    if (value != FIRST_IDX) {
-        q = (Poly *) malloc(value *
-                            sizeof(Poly));
-        for (size_t k = ONE_ELEMENT;
-             k <= value; k++) q[value - k] = Pop(s);
-    } else q = (Poly *) malloc(ONE_ELEMENT *
-                               sizeof(Poly));
-    CHECK_PTR(q);
-    Push(s, PolyCompose(&p, value, q));
-    PolyDestroy(&p);
-    if (value != FIRST_IDX) {
-        for (size_t k = ONE_ELEMENT;
-             k <= value; k++) PolyDestroy(&q[value - k]);
+static void ParseAtMany(char *char_arr, size_t char_number, Instruction *instruction) {
+
+    size_t i = 7;
+    if (i >= char_number || (int) char_arr[i] != SPACE) {
+        if (!isspace(char_arr[i])) SetError(instruction, ERROR_WRONG_COMMAND);
+        else SetError(instruction, ERROR_AT);
+        return;
     }
-    free(q);
+
+    size_t xs_size = TWO_ELEMENTS;
+    size_t count = FIRST_IDX;
+    poly_coeff_t *xs = (poly_coeff_t *) malloc(xs_size * sizeof(poly_coeff_t));
+    CHECK_PTR(xs);
+    while (i < char_number) {
+        char *value_start = char_arr + i + ONE_ELEMENT;
+        if ((int) char_arr[i] != SPACE || (!isdigit(value_start[FIRST_IDX]) &&
+            ((int) value_start[FIRST_IDX] != MINUS ||
+             !isdigit(value_start[ONE_ELEMENT])))) {
+            SetError(instruction, ERROR_AT);
+            free(xs);
+            return;
+        }
+        char *last_char;
+        errno = ERRNO;
+        long long int value = strtoll(value_start, &last_char, BASE);
+        i = last_char - char_arr;
+        if (errno != ERRNO || (i < char_number && (int) char_arr[i] != SPACE)) {
+            SetError(instruction, ERROR_AT);
+            free(xs);
+            return;
+        }
+        if (count == xs_size) {
+            xs_size *= TWO_ELEMENTS;
+            xs = (poly_coeff_t *) realloc(xs, xs_size * sizeof(poly_coeff_t));
+            CHECK_PTR(xs);
+        }
+        xs[count++] = value;
+    }
+
+    instruction -> opcode = OP_AT_MANY;
+    instruction -> point_count = count;
+    instruction -> points = xs;
 
 }
 
 /**
- * Wykonuje komendę DEG_BY lub COMPOSE a zależności od @p is_deg_by.
+ * Parsuje argument komendy SAVE lub LOAD w zależności od @p is_save.
+ * Nazwą pliku jest cała reszta wiersza po spacji.
  * @param[in] char_arr : tablica znaków aktualnego wiersza
  * @param[in] char_number : liczba znaków w aktualnym wierszu
- * @param[in] line_number : numer aktualnego wiersza
- * @param[in] s : stos wielomianów
- * @param[in] is_deg_by : określa, czy wykonać komendę DEG_BY czy COMPOSE
+ * @param[out] instruction : instrukcja
+ * @param[in] is_save : określa, czy parsować komendę SAVE czy LOAD
  */
-static void ParseDegByOrCompose(char *char_arr, size_t char_number, size_t line_number,
-                                stack *s, bool is_deg_by) {
+static void ParseSnapshot(char *char_arr, size_t char_number,
+                          Instruction *instruction, bool is_save) {
+
+    size_t i = 4;
+    if (i >= char_number || (int) char_arr[i] != SPACE ||
+        i + ONE_ELEMENT == char_number) {
+        if (!isspace(char_arr[i])) SetError(instruction, ERROR_WRONG_COMMAND);
+        else SetError(instruction, is_save ? ERROR_SAVE : ERROR_LOAD);
+    } else {
+        // Kończymy nazwę pliku w miejscu znaku nowej linii.
+        char_arr[char_number] = NULL_CHAR;
+        char *path = char_arr + i + ONE_ELEMENT;
+        instruction -> opcode = is_save ? OP_SAVE : OP_LOAD;
+        SetWords(instruction, &path, ONE_ELEMENT, char_number - i);
+    }
+
+}
+
+/**
+ * Parsuje argumenty komendy SAVE_LIBRARY. Po nazwie komendy następuje
+ * ścieżka pliku i nazwy wielomianów z wierzchołka stosu, oddzielone
+ * pojedynczymi spacjami. Ostatnia nazwa należy do wielomianu
+ * z wierzchołka stosu.
+ * @param[in] char_arr : tablica znaków aktualnego wiersza
+ * @param[in] char_number : liczba znaków w aktualnym wierszu
+ * @param[out] instruction : instrukcja
+ */
+static void ParseSaveLibrary(char *char_arr, size_t char_number,
+                             Instruction *instruction) {
+
+    size_t i = 12;
+    if (i >= char_number || (int) char_arr[i] != SPACE) {
+        if (!isspace(char_arr[i])) SetError(instruction, ERROR_WRONG_COMMAND);
+        else SetError(instruction, ERROR_SAVE_LIBRARY);
+        return;
+    }
+
+    // Dzielimy resztę wiersza na słowa, wpisując znaki zerowe w miejsce spacji.
+    char_arr[char_number] = NULL_CHAR;
+    size_t words_size = TWO_ELEMENTS;
+    size_t count = FIRST_IDX;
+    char **words = (char **) malloc(words_size * sizeof(char *));
+    CHECK_PTR(words);
+    while (i < char_number) {
+        char *word = char_arr + i + ONE_ELEMENT;
+        char *space = strchr(word, SPACE);
+        i = space == NULL ? char_number : (size_t) (space - char_arr);
+        if (space != NULL) *space = NULL_CHAR;
+        if ((int) word[FIRST_IDX] == NULL_CHAR) {
+            SetError(instruction, ERROR_SAVE_LIBRARY);
+            free(words);
+            return;
+        }
+        if (count == words_size) {
+            words_size *= TWO_ELEMENTS;
+            words = (char **) realloc(words, words_size * sizeof(char *));
+            CHECK_PTR(words);
+        }
+        words[count++] = word;
+    }
+
+    if (count < TWO_ELEMENTS) SetError(instruction, ERROR_SAVE_LIBRARY);
+    else {
+        instruction -> opcode = OP_SAVE_LIBRARY;
+        SetWords(instruction, words, count,
+                 char_number + ONE_ELEMENT - (words[FIRST_IDX] - char_arr));
+    }
+    free(words);
+
+}
+
+/**
+ * Parsuje argument komendy LOAD_NAMED. Nazwą wielomianu jest cała reszta
+ * wiersza po spacji. Wielomian wyszukiwany jest w bibliotece już podczas
+ * parsowania.
+ * @param[in] char_arr : tablica znaków aktualnego wiersza
+ * @param[in] char_number : liczba znaków w aktualnym wierszu
+ * @param[out] instruction : instrukcja
+ */
+static void ParseLoadNamed(char *char_arr, size_t char_number,
+                           Instruction *instruction) {
+
+    size_t i = 10;
+    if (i >= char_number || (int) char_arr[i] != SPACE) {
+        if (!isspace(char_arr[i])) SetError(instruction, ERROR_WRONG_COMMAND);
+        else SetError(instruction, ERROR_LOAD_NAMED);
+    } else {
+        char_arr[char_number] = NULL_CHAR;
+        if (LibraryFind(char_arr + i + ONE_ELEMENT, &instruction -> poly))
+            instruction -> opcode = OP_LOAD_NAMED;
+        else SetError(instruction, ERROR_LOAD_NAMED);
+    }
+
+}
+
+/**
+ * Parsuje argument komendy DEG_BY lub COMPOSE w zależności od @p is_deg_by.
+ * @param[in] char_arr : tablica znaków aktualnego wiersza
+ * @param[in] char_number : liczba znaków w aktualnym wierszu
+ * @param[out] instruction : instrukcja
+ * @param[in] is_deg_by : określa, czy parsować komendę DEG_BY czy COMPOSE
+ */
+static void ParseDegByOrCompose(char *char_arr, size_t char_number,
+                                Instruction *instruction, bool is_deg_by) {
 
     size_t i;
     if (is_deg_by) i = 6;
     else i = 7;
     if ((i + TWO_ELEMENTS) > char_number || (int) char_arr[i] != SPACE ||
         !isdigit(char_arr[i + ONE_ELEMENT])) {
-        if (!isspace(char_arr[i])) {
-            fprintf(stderr, "ERROR %zu WRONG COMMAND\n", line_number);
-        } else if (is_deg_by) PrintDegByError(line_number);
-        else PrintComposeError(line_number);
+        if (!isspace(char_arr[i])) SetError(instruction, ERROR_WRONG_COMMAND);
+        else SetDegByOrComposeError(instruction, is_deg_by);
     } else {
         char space[] = " ";
         char *divided_char = strtok(char_arr, space);
@@ -357,12 +314,12 @@ static void ParseDegByOrCompose(char *char_arr, size_t char_number, size_t line_
         while (divided_char != NULL) {
             if (divided_idx == FIRST_IDX && strcmp(divided_char, "DEG_BY") != SAME
                 && strcmp(divided_char, "COMPOSE") != SAME) {
-                PrintDegByOrComposeError(line_number, is_deg_by);
+                SetDegByOrComposeError(instruction, is_deg_by);
                 break;
             } else if (divided_idx == ONE_ELEMENT) {
                 if ((int) divided_char[FIRST_IDX] == PLUS ||
                     (int) divided_char[FIRST_IDX] == MINUS) {
-                    PrintDegByOrComposeError(line_number, is_deg_by);
+                    SetDegByOrComposeError(instruction, is_deg_by);
                     break;
                 }
                 char *last_char;
@@ -373,28 +330,17 @@ static void ParseDegByOrCompose(char *char_arr, size_t char_number, size_t line_
                                        (int) last_char[FIRST_IDX] == NULL_CHAR)) {
                     divided_char = strtok(NULL, space);
                     if (divided_char != NULL) {
-                        PrintDegByOrComposeError(line_number, is_deg_by);
+                        SetDegByOrComposeError(instruction, is_deg_by);
                         break;
                     }
-                    if (IsEmpty(s)) PrintStackUnderflow(line_number);
-                    else {
-                        if (is_deg_by) {
-                            Poly p = Top(s);
-                            printf("%d\n", PolyDegBy(&p, value));
-                        } else {
-                            if (NumberOfElements(s) - ONE_ELEMENT < value) {
-                                PrintStackUnderflow(line_number);
-                                break;
-                            }
-                            MakeCompose(s, value);
-                        }
-                    }
+                    instruction -> opcode = is_deg_by ? OP_DEG_BY : OP_COMPOSE;
+                    instruction -> count = value;
                 } else {
-                    PrintDegByOrComposeError(line_number, is_deg_by);
+                    SetDegByOrComposeError(instruction, is_deg_by);
                     break;
                 }
             } else if (divided_idx > ONE_ELEMENT) {
-                PrintDegByOrComposeError(line_number, is_deg_by);
+                SetDegByOrComposeError(instruction, is_deg_by);
                 break;
             }
             divided_char = strtok(NULL, space);
@@ -404,40 +350,83 @@ static void ParseDegByOrCompose(char *char_arr, size_t char_number, size_t line_
 
 }
 
-void MakeCommand(stack *s, char *char_arr, size_t char_number, size_t line_number) {
+void CompileCommand(char *char_arr, size_t char_number, size_t line_number,
+                    Instruction *instruction) {
 
     assert ((int) char_arr[char_number - ONE_ELEMENT] != NEWLINE);
 
-    if (char_number == 4 && strncmp(char_arr, "ZERO", char_number) == SAME)
-        Push(s, PolyZero());
-    else if (char_number == 8 && strncmp(char_arr, "IS_COEFF", char_number) == SAME)
-        ParseZero(s, line_number, AllExpZero);
-    else if (char_number == 7 && strncmp(char_arr, "IS_ZERO", char_number) == SAME)
-        ParseZero(s, line_number, PolyIsZero);
-    else if (char_number == 5 && strncmp(char_arr, "CLONE", char_number) == SAME)
-        ParseClone(s, line_number);
-    else if (char_number == 3 && strncmp(char_arr, "ADD", char_number) == SAME)
-        ParseTwoArgumentFunctions(s, line_number, PolyAdd);
-    else if (char_number == 3 && strncmp(char_arr, "MUL", char_number) == SAME)
-        ParseTwoArgumentFunctions(s, line_number, PolyMul);
-    else if (char_number == 3 && strncmp(char_arr, "NEG", char_number) == SAME)
-        ParseNeg(s, line_number);
-    else if (char_number == 3 && strncmp(char_arr, "SUB", char_number) == SAME)
-        ParseTwoArgumentFunctions(s, line_number, PolySub);
-    else if (char_number == 5 && strncmp(char_arr, "IS_EQ", char_number) == SAME)
-        ParseIsEq(s, line_number);
-    else if (char_number == 3 && strncmp(char_arr, "DEG", char_number) == SAME)
-        ParseDeg(s, line_number);
-    else if (char_number == 5 && strncmp(char_arr, "PRINT", char_number) == SAME)
-        PolyPrint(s, line_number);
-    else if (char_number == 3 && strncmp(char_arr, "POP", char_number) == SAME)
-        ParsePop(s, line_number);
-    else if (strncmp(char_arr, "AT", 2) == SAME)
-        ParseAt(char_arr, char_number, line_number, s);
-    else if (strncmp(char_arr, "DEG_BY", 6) == SAME)
-        ParseDegByOrCompose(char_arr, char_number, line_number, s, true);
-    else if (strncmp(char_arr, "COMPOSE", 7) == SAME)
-        ParseDegByOrCompose(char_arr, char_number, line_number, s, false);
-    else fprintf(stderr, "ERROR %zu WRONG COMMAND\n", line_number);
-
-}
\ No newline at end of file
+    // Komendy rozróżniamy najpierw po pierwszej literze, a dopiero potem
+    // porównujemy nazwy. Komenda bez argumentów musi być całym wierszem,
+    // a nazwa komendy z argumentami tylko jego początkiem.
+    instruction -> line_number = line_number;
+    SetError(instruction, ERROR_WRONG_COMMAND);
+    switch (char_arr[FIRST_IDX]) {
+        case 'A':
+            if (char_number == 3 && strncmp(char_arr, "ADD", char_number) == SAME)
+                instruction -> opcode = OP_ADD;
+            else if (strncmp(char_arr, "AT_MANY", 7) == SAME)
+                ParseAtMany(char_arr, char_number, instruction);
+            else if (strncmp(char_arr, "AT", 2) == SAME)
+                ParseAt(char_arr, char_number, instruction);
+            break;
+        case 'C':
+            if (char_number == 5 && strncmp(char_arr, "CLONE", char_number) == SAME)
+                instruction -> opcode = OP_CLONE;
+            else if (strncmp(char_arr, "COMPOSE", 7) == SAME)
+                ParseDegByOrCompose(char_arr, char_number, instruction, false);
+            break;
+        case 'D':
+            if (char_number == 3 && strncmp(char_arr, "DEG", char_number) == SAME)
+                instruction -> opcode = OP_DEG;
+            else if (strncmp(char_arr, "DEG_BY", 6) == SAME)
+                ParseDegByOrCompose(char_arr, char_number, instruction, true);
+            break;
+        case 'I':
+            if (char_number == 8 && strncmp(char_arr, "IS_COEFF", char_number) == SAME)
+                instruction -> opcode = OP_IS_COEFF;
+            else if (char_number == 7 && strncmp(char_arr, "IS_ZERO", char_number) == SAME)
+                instruction -> opcode = OP_IS_ZERO;
+            else if (char_number == 5 && strncmp(char_arr, "IS_EQ", char_number) == SAME)
+                instruction -> opcode = OP_IS_EQ;
+            break;
+        case 'L':
+            if (strncmp(char_arr, "LOAD_NAMED", 10) == SAME)
+                ParseLoadNamed(char_arr, char_number, instruction);
+            else if (strncmp(char_arr, "LOAD", 4) == SAME)
+                ParseSnapshot(char_arr, char_number, instruction, false);
+            break;
+        case 'M':
+            if (char_number == 3 && strncmp(char_arr, "MUL", char_number) == SAME)
+                instruction -> opcode = OP_MUL;
+            break;
+        case 'N':
+            if (char_number == 3 && strncmp(char_arr, "NEG", char_number) == SAME)
+                instruction -> opcode = OP_NEG;
+            break;
+        case 'P':
+            if (char_number == 5 && strncmp(char_arr, "PRINT", char_number) == SAME)
+                instruction -> opcode = OP_PRINT;
+            else if (char_number == 3 && strncmp(char_arr, "POP", char_number) == SAME)
+                instruction -> opcode = OP_POP;
+            break;
+        case 'S':
+            if (char_number == 3 && strncmp(char_arr, "SUB", char_number) == SAME)
+                instruction -> opcode = OP_SUB;
+            else if (char_number == 5 && strncmp(char_arr, "STATS", char_number) == SAME)
+                instruction -> opcode = OP_STATS;
+            else if (char_number == 4 && strncmp(char_arr, "SIZE", char_number) == SAME)
+                instruction -> opcode = OP_SIZE;
+            else if (strncmp(char_arr, "SAVE_LIBRARY", 12) == SAME)
+                ParseSaveLibrary(char_arr, char_number, instruction);
+            else if (strncmp(char_arr, "SAVE", 4) == SAME)
+                ParseSnapshot(char_arr, char_number, instruction, true);
+            break;
+        case 'Z':
+            if (char_number == 4 && strncmp(char_arr, "ZERO", char_number) == SAME)
+                instruction -> opcode = OP_ZERO;
+            break;
+        default:
+            break;
+    }
+
+}
@@ -5,16 +5,18 @@
 #ifndef MAKE_COMMAND_H
 #define MAKE_COMMAND_H
 
-#include "stack.h"
+#include "program.h"
 
 /**
- * Parsuje wiersz zawierający komendę i ją wykonuje jeśli nie
- * znaleziono żadnego błędu.
- * @param[in] s : stos
+ * Parsuje wiersz zawierający komendę i tworzy z niego instrukcję z kodem
+ * operacji komendy i wczytanymi argumentami albo, jeśli znaleziono błąd,
+ * instrukcję wypisującą ten błąd.
  * @param[in] char_arr : tablica znaków aktualnego wiersza
  * @param[in] char_number : liczba znaków w aktualnym wierszu
  * @param[in] line_number : numer aktualnego wiersza
+ * @param[out] instruction : instrukcja
  */
-void MakeCommand(stack *s, char *char_arr, size_t char_number, size_t line_number);
+void CompileCommand(char *char_arr, size_t char_number, size_t line_number,
+                    Instruction *instruction);
 
-#endif
\ No newline at end of file
+#endif
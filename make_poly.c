@@ -1,17 +1,22 @@
 /** @file
   Implementacja klasy parsującej wielomian.
+  Wiersz jest czytany jednokrotnie, od lewej do prawej. Jednomiany wszystkich
+  rozpoczętych, a jeszcze niezakończonych wielomianów przechowywane są na
+  jednym stosie jednomianów, a dla każdego z tych wielomianów pamiętamy
+  indeks jego pierwszego jednomianu na tym stosie. Po wczytaniu ostatniego
+  jednomianu wielomianu tworzymy z jego jednomianów wielomian i zdejmujemy
+  je ze stosu. Oba stosy rosną dwukrotnie, a zerowe jednomiany pomijamy od
+  razu, więc parsowanie zajmuje czas liniowy względem długości wiersza, także
+  dla głęboko zagnieżdżonych wielomianów, i nie korzysta z rekurencji.
   @author Julia Podrażka
  */
 
-#include <stdio.h>
 #include <stdlib.h>
-#include <ctype.h>
-#include <errno.h>
 #include <limits.h>
 
 #include "poly.h"
-#include "stack.h"
 #include "make_poly.h"
+#include "memory_budget.h"
 
 /** Pierwszy indeks w tablicy. */
 #define FIRST_IDX 0
@@ -21,8 +26,6 @@
 #define SIZE 2
 /** Kod ascii znaku zerowego. */
 #define NULL_CHAR 0
-/** Kod ascii znaku hash. */
-#define COMMENT 35
 /** Kod ascii znaku nowej linii. */
 #define NEWLINE 10
 /** Kod ascii znaku otwierającego nawiasu. */
@@ -35,213 +38,232 @@
 #define COMMA 44
 /** Kod ascii znaku minusa. */
 #define MINUS 45
+/** Kod ascii znaku zera. */
+#define ZERO_CHAR 48
 /** Baza konwertowania liczb. */
 #define BASE 10
-/** Początkowa wartość errno. */
-#define ERRNO 0
 
 /**
- * Wypisuje na standardowe wyjście błędów błąd parsowania wielomianu.
- * @param[in] line_number : numer aktualnego wiersza
- * @param[in] is_error : określa, czy znaleziono już błąd przy parsowaniu
+ * To jest struktura przechowująca stan parsowania wiersza.
  */
-static void PrintError(size_t line_number, bool *is_error) {
+typedef struct Parser {
+    const char *pos; ///< aktualna pozycja w wierszu
+    Mono *monos; ///< jednomiany rozpoczętych wielomianów
+    size_t mono_count; ///< liczba jednomianów na stosie
+    size_t mono_size; ///< rozmiar tablicy jednomianów
+    size_t *bases; ///< indeksy pierwszych jednomianów rozpoczętych wielomianów
+    size_t base_count; ///< liczba rozpoczętych wielomianów
+    size_t base_size; ///< rozmiar tablicy indeksów
+} Parser;
 
-    fprintf(stderr, "ERROR %zu WRONG POLY\n", line_number);
-    (*is_error) = true;
+/**
+ * Sprawdza, czy znak jest cyfrą dziesiętną.
+ * @param[in] c : znak
+ * @return Czy znak jest cyfrą?
+ */
+static bool IsDigit(char c) {
+
+    return (unsigned) ((int) c - ZERO_CHAR) < BASE;
 
 }
 
 /**
- * Wypisuje na standardowe wyjście błędów błąd parsowania wielomianu i zwraca
- * wielomian zerowy.
- * @param[in] line_number : numer aktualnego wiersza
- * @param[in] is_error : określa, czy znaleziono już błąd przy parsowaniu
- * @return wielomian zerowy
+ * Wczytuje ciąg cyfr jako liczbę nie większą od @p limit. Przesuwa pozycję
+ * za ostatnią wczytaną cyfrę.
+ * @param[in] parser : stan parsowania
+ * @param[in] limit : największa dozwolona wartość
+ * @param[out] number : wczytana liczba
+ * @return Czy wczytano co najmniej jedną cyfrę i liczba nie przekracza @p limit?
  */
-static Poly PrintPolyError(size_t line_number, bool *is_error) {
+static bool ParseDigits(Parser *parser, unsigned long long int limit,
+                        unsigned long long int *number) {
 
-    if (!(*is_error)) PrintError(line_number, is_error);
-    return PolyZero();
+    if (!IsDigit(parser -> pos[FIRST_IDX])) return false;
+    unsigned long long int value = FIRST_IDX;
+    while (IsDigit(parser -> pos[FIRST_IDX])) {
+        unsigned digit = (unsigned) ((int) parser -> pos[FIRST_IDX] - ZERO_CHAR);
+        if (value > (limit - digit) / BASE) return false;
+        value = value * BASE + digit;
+        parser -> pos++;
+    }
+    *number = value;
+    return true;
 
 }
 
 /**
- * Wypisuje na standardowe wyjście błędów błąd parsowania wielomianu i zwraca
- * jednomian o zerowym wielomianie.
- * @param[in] poly : wielomian do usunięcia
- * @param[in] line_number : numer aktualnego wiersza
- * @param[in] is_error : określa, czy znaleziono już błąd przy parsowaniu
- * @return jednomian o zerowym wielomianie
+ * Wczytuje współczynnik, czyli liczbę z opcjonalnym minusem, mieszczącą się
+ * w typie poly_coeff_t. Nie przesuwa pozycji, jeśli współczynnik jest pusty.
+ * @param[in] parser : stan parsowania
+ * @param[out] coeff : wczytany współczynnik
+ * @return Czy współczynnik jest poprawny?
  */
-static Mono PrintMonoError(Poly poly, size_t line_number, bool *is_error) {
+static bool ParseCoeff(Parser *parser, poly_coeff_t *coeff) {
 
-    PolyDestroy(&poly);
-    if (!(*is_error)) PrintError(line_number, is_error);
-    Poly p = PolyZero();
-    return MonoFromPoly(&p, FIRST_IDX);
+    // Pusty współczynnik jednomianu, jak w (,1), zawsze był wczytywany jako 0.
+    if ((int) parser -> pos[FIRST_IDX] == COMMA) {
+        *coeff = FIRST_IDX;
+        return true;
+    }
+    bool negative = (int) parser -> pos[FIRST_IDX] == MINUS;
+    if (negative) parser -> pos++;
+    unsigned long long int limit = (unsigned long long int) LONG_MAX + negative;
+    unsigned long long int value;
+    if (!ParseDigits(parser, limit, &value)) return false;
+    // Liczbę ujemną składamy tak, żeby nie przepełnić typu dla LONG_MIN.
+    if (negative && value > FIRST_IDX)
+        *coeff = -(poly_coeff_t) (value - ONE_ELEMENT) - ONE_ELEMENT;
+    else *coeff = (poly_coeff_t) value;
+    return true;
 
 }
 
 /**
- * Zlicza znaki będące plusami należące do aktualnie przetwarzanego wielomianu
- * w wierszu i sprawdza, czy nie występują błędne znaki nie należące do wielomianu.
- * @param[in] char_arr : tablica znaków w wierszu
- * @param[in] plus_number : liczba plusów
- * @param[in] is_error_char : określa, czy znaleziono błędny znak
+ * Wczytuje wykładnik, czyli liczbę mieszczącą się w typie poly_exp_t.
+ * @param[in] parser : stan parsowania
+ * @param[out] exp : wczytany wykładnik
+ * @return Czy wykładnik jest poprawny?
  */
-static void CheckChars(char **char_arr, size_t *plus_number,
-                       bool *is_error_char) {
-
-    size_t open_brackets = FIRST_IDX;
-    size_t closed_brackets = FIRST_IDX;
-    size_t i = FIRST_IDX;
-    while ((int) (*char_arr)[i] != NULL_CHAR && (int) (*char_arr)[i] != NEWLINE &&
-           ((int) (*char_arr)[i] != COMMA || open_brackets != closed_brackets)) {
-        if ((int) (*char_arr)[i] == PLUS && open_brackets == closed_brackets)
-            (*plus_number)++;
-        else if ((int) (*char_arr)[i] == OPEN_BRACKET) open_brackets++;
-        else if ((int) (*char_arr)[i] == CLOSE_BRACKET) closed_brackets++;
-        else if (!isdigit((*char_arr)[i]) && (int) (*char_arr)[i] != MINUS &&
-                 (int) (*char_arr)[i] != COMMA && (int) (*char_arr)[i] != PLUS) {
-            *is_error_char = true;
-            break;
-        }
-        i++;
-    }
-    if (open_brackets != closed_brackets) *is_error_char = true;
+static bool ParseExp(Parser *parser, poly_exp_t *exp) {
+
+    unsigned long long int value;
+    if (!ParseDigits(parser, INT_MAX, &value)) return false;
+    *exp = (poly_exp_t) value;
+    return true;
 
 }
 
 /**
- * Parsuje tablice znaków sprawdzając, czy na jej początku wystepuje liczba.
- * Jeśli tak, to parsuje ją do odpowiedniego typu, w przeciwnym przypadku
- * wyspiuje błąd. Zwraca wielomian stały równy tej liczbie.
- * @param[in] char_arr : tablica znaków w wierszu
- * @param[in] line_number : numer aktualnego wiersza
- * @param[in] is_error : określa, czy znaleziono już błąd przy parsowaniu
- * @return wielomian stały
+ * Rozpoczyna nowy wielomian niestały.
+ * @param[in] parser : stan parsowania
  */
-static Poly ParseCoeff(char **char_arr, size_t line_number, bool *is_error) {
-
-    if ((int) (*char_arr)[FIRST_IDX] == PLUS)
-        return PrintPolyError(line_number, is_error);
-    char *last_char;
-    errno = ERRNO;
-    long long int number = strtoll(*char_arr, &last_char, BASE);
-    if (errno == ERRNO && (last_char == NULL ||
-        (int) last_char[FIRST_IDX] == COMMA ||
-        (int) last_char[FIRST_IDX] == NEWLINE ||
-        (int) last_char[FIRST_IDX] == NULL_CHAR)) {
-        *char_arr = last_char;
-        return PolyFromCoeff(number);
-    } else return PrintPolyError(line_number, is_error);
+static void OpenPoly(Parser *parser) {
+
+    if (parser -> base_count == parser -> base_size) {
+        parser -> base_size *= SIZE;
+        parser -> bases = (size_t *) MemoryRealloc(parser -> bases,
+                                                   parser -> base_size * sizeof(size_t));
+    }
+    parser -> bases[parser -> base_count++] = parser -> mono_count;
 
 }
 
 /**
- * Tworzy wielomian z aktualnego wiersza i go zwraca. Jeśli napotka na błędny znak,
- * to wypisuje błąd i zwraca wielomian zerowy.
- * @param[in] char_arr : tablica znaków w wierszu
- * @param[in] is_error : określa, czy znaleziono już błąd przy parsowaniu
- * @param[in] line_number : numer aktualnego wiersza
- * @return wielomian
+ * Dokłada jednomian do aktualnie wczytywanego wielomianu.
+ * @param[in] parser : stan parsowania
+ * @param[in] mono : jednomian
  */
-static Poly MakePolyHelper(char **char_arr, bool *is_error, size_t line_number);
+static void PushMono(Parser *parser, Mono mono) {
+
+    if (parser -> mono_count == parser -> mono_size) {
+        parser -> mono_size *= SIZE;
+        parser -> monos = (Mono *) MemoryRealloc(parser -> monos,
+                                                 parser -> mono_size * sizeof(Mono));
+    }
+    parser -> monos[parser -> mono_count++] = mono;
+
+}
 
 /**
- * Tworzy jednomian, który jest na początku tablicy znaków i go zwraca.
- * Jeśli napotka na błędny znak, to wypisuje błąd i zwraca jednomian o
- * wielomianie zerowym.
- * @param[in] char_arr : tablica znaków w wierszu
- * @param[in] is_error : określa, czy znaleziono już błąd przy parsowaniu
- * @param[in] line_number : numer aktualnego wiersza
- * @return jednomian
+ * Kończy aktualnie wczytywany wielomian niestały i zwraca go.
+ * @param[in] parser : stan parsowania
+ * @return wielomian będący sumą wczytanych jednomianów
  */
-static Mono MakeMonoHelper(char **char_arr, bool *is_error, size_t line_number) {
+static Poly ClosePoly(Parser *parser) {
 
-    if (*is_error) {
-        Poly p = PolyZero();
-        return MonoFromPoly(&p, FIRST_IDX);
-    }
-    // Pomijamy nawias otwierający
-    (*char_arr)++;
-    Poly poly = MakePolyHelper(char_arr, is_error, line_number);
-    if ((int) (*char_arr)[FIRST_IDX] != COMMA)
-        return PrintMonoError(poly, line_number, is_error);
-    else {
-        (*char_arr)++;
-        if (!isdigit((*char_arr)[FIRST_IDX]))
-            return PrintMonoError(poly, line_number, is_error);
-        char *last_char;
-        long int number = strtol(*char_arr, &last_char, BASE);
-        if (number > INT_MAX) return PrintMonoError(poly, line_number, is_error);
-        *char_arr = last_char;
-        if ((int) (*char_arr)[FIRST_IDX] != CLOSE_BRACKET)
-            return PrintMonoError(poly, line_number, is_error);
-        else {
-            // Pomijamy nawias zamykający
-            (*char_arr)++;
-            return MonoFromPoly(&poly, number);
-        }
-    }
+    size_t base = parser -> bases[--parser -> base_count];
+    size_t count = parser -> mono_count - base;
+    Mono *monos = parser -> monos + base;
+    bool is_sorted = true;
+    for (size_t i = ONE_ELEMENT; i < count && is_sorted; i++)
+        is_sorted = monos[i - ONE_ELEMENT].exp > monos[i].exp;
+    // Współczynniki na stosie są niezerowe, więc jeśli wykładniki maleją,
+    // to nie ma czego sumować ani usuwać.
+    Poly p = is_sorted ? PolyFromSortedMonos(count, monos)
+                       : PolyAddMonos(count, monos);
+    parser -> mono_count = base;
+    return p;
 
 }
 
-static Poly MakePolyHelper(char **char_arr, bool *is_error, size_t line_number) {
-
-    if (*is_error) return PolyZero();
-
-    if ((int) (*char_arr)[FIRST_IDX] == OPEN_BRACKET) {
-        size_t plus_number = ONE_ELEMENT;
-        bool is_error_char = false;
-
-        CheckChars(char_arr, &plus_number, &is_error_char);
-        if (is_error_char == true) return PrintPolyError(line_number, is_error);
-
-        Mono *mono_arr = (Mono *) malloc(plus_number * sizeof(Mono));
-        CHECK_PTR(mono_arr);
-        size_t k = FIRST_IDX;
-        while ((int) (*char_arr)[FIRST_IDX] != COMMA &&
-               (int) (*char_arr)[FIRST_IDX] != NULL_CHAR &&
-               (int) (*char_arr)[FIRST_IDX] != NEWLINE) {
-            mono_arr[k] = MakeMonoHelper(char_arr, is_error, line_number);
-            k++;
-            if (*is_error) {
-                for (size_t l = FIRST_IDX; l < k; l++) MonoDestroy(&mono_arr[l]);
-                free(mono_arr);
-                return PolyZero();
+/**
+ * Parsuje wielomian zaczynający się na początku wiersza. Wielomian to
+ * współczynnik albo jednomiany postaci (wielomian,wykładnik) oddzielone
+ * plusami.
+ * @param[in] parser : stan parsowania
+ * @param[out] result : wczytany wielomian
+ * @return Czy wielomian jest poprawny?
+ */
+static bool ParsePoly(Parser *parser, Poly *result) {
+
+    while (true) {
+        // Otwieramy wielomiany, dopóki nie dojdziemy do współczynnika.
+        while ((int) parser -> pos[FIRST_IDX] == OPEN_BRACKET) {
+            OpenPoly(parser);
+            parser -> pos++;
+        }
+        poly_coeff_t coeff;
+        if (!ParseCoeff(parser, &coeff)) return false;
+        Poly p = PolyFromCoeff(coeff);
+
+        // Wczytany wielomian p jest współczynnikiem jednomianu ostatnio
+        // otwartego wielomianu. Kończymy jednomiany i wielomiany, aż do
+        // napotkania plusa rozpoczynającego kolejny jednomian.
+        while (true) {
+            if (parser -> base_count == FIRST_IDX) {
+                *result = p;
+                return true;
             }
-            if ((int) (*char_arr)[FIRST_IDX] == PLUS) (*char_arr)++;
-            else if ((int) (*char_arr)[FIRST_IDX] != COMMA &&
-                     (int) (*char_arr)[FIRST_IDX] != NULL_CHAR &&
-                     (int) (*char_arr)[FIRST_IDX] != NEWLINE) {
-                for (size_t l = FIRST_IDX; l < k; l++) MonoDestroy(&mono_arr[l]);
-                free(mono_arr);
-                return PrintPolyError(line_number, is_error);
+            poly_exp_t exp;
+            if ((int) parser -> pos[FIRST_IDX] != COMMA) {
+                PolyDestroy(&p);
+                return false;
             }
+            parser -> pos++;
+            if (!ParseExp(parser, &exp) ||
+                (int) parser -> pos[FIRST_IDX] != CLOSE_BRACKET) {
+                PolyDestroy(&p);
+                return false;
+            }
+            parser -> pos++;
+            // Wielomian p jest współczynnikiem albo wynikiem ClosePoly, więc
+            // jest zerowy tylko jako współczynnik zero. Nie sprawdzamy tego
+            // funkcją PolyIsZero, która schodzi w głąb wielomianu, i nie
+            // odkładamy zerowego jednomianu na stos.
+            if (!PolyIsCoeff(&p) || p.coeff != FIRST_IDX)
+                PushMono(parser, (Mono) {.p = p, .exp = exp});
+            if ((int) parser -> pos[FIRST_IDX] == PLUS) {
+                parser -> pos++;
+                if ((int) parser -> pos[FIRST_IDX] != OPEN_BRACKET) return false;
+                parser -> pos++;
+                break;
+            }
+            p = ClosePoly(parser);
         }
-        if (k != plus_number) {
-            for (size_t l = FIRST_IDX; l < k; l++) MonoDestroy(&mono_arr[l]);
-            free(mono_arr);
-            return PrintPolyError(line_number, is_error);
-        }
-        Poly p = PolyAddMonos(plus_number, mono_arr);
-        free(mono_arr);
-        return p;
-    } else return ParseCoeff(char_arr, line_number, is_error);
+    }
 
 }
 
-void MakePoly(stack *s, char *char_arr, size_t line_number) {
+bool MakePoly(const char *char_arr, Poly *p) {
 
-    bool is_error = false;
-    Poly p = MakePolyHelper(&char_arr, &is_error, line_number);
-    if (!is_error && (int) char_arr[FIRST_IDX] != NEWLINE &&
-        (int) char_arr[FIRST_IDX] != NULL_CHAR) {
-        PrintError(line_number, &is_error);
-        PolyDestroy(&p);
+    Parser parser = (Parser) {.pos = char_arr, .mono_count = FIRST_IDX,
+                              .mono_size = SIZE, .base_count = FIRST_IDX,
+                              .base_size = SIZE};
+    parser.monos = (Mono *) MemoryAlloc(parser.mono_size * sizeof(Mono));
+    parser.bases = (size_t *) MemoryAlloc(parser.base_size * sizeof(size_t));
+
+    bool is_correct = ParsePoly(&parser, p);
+    if (is_correct && (int) parser.pos[FIRST_IDX] != NEWLINE &&
+        (int) parser.pos[FIRST_IDX] != NULL_CHAR) {
+        PolyDestroy(p);
+        is_correct = false;
+    }
+    if (!is_correct) {
+        for (size_t i = FIRST_IDX; i < parser.mono_count; i++)
+            MonoDestroy(&parser.monos[i]);
     }
-    if (!is_error) Push(s, p);
+    MemoryFree(parser.monos);
+    MemoryFree(parser.bases);
+    return is_correct;
 
-}
\ No newline at end of file
+}
@@ -5,13 +5,17 @@
 #ifndef MAKE_POLY_H
 #define MAKE_POLY_H
 
+#include <stdbool.h>
+
+#include "poly.h"
+
 /**
- * Parsuje wiersz zawierający wielomian i wstawia go na stos, jeśli nie
- * znaleziono żadnego błędu.
- * @param[in] s : stos
- * @param[in] char_arr : tablica znaków aktualnego wiersza
- * @param[in] line_number : numer aktualnego wiersza
+ * Parsuje wiersz zawierający wielomian.
+ * @param[in] char_arr : tablica znaków aktualnego wiersza, zakończonego
+ * znakiem nowej linii lub znakiem zerowym
+ * @param[out] p : wczytany wielomian, jeśli wiersz jest poprawny
+ * @return Czy wiersz zawiera poprawny wielomian?
  */
-void MakePoly(stack *s, char *char_arr, size_t line_number);
+bool MakePoly(const char *char_arr, Poly *p);
 
 #endif
@@ -0,0 +1,344 @@
+/** @file
+  Implementacja rozliczania pamięci i budżetu pamięci operacji na
+  wielomianach.
+  Liczniki pamięci są globalne i atomowe. Strażnik operacji jest zmienną
+  wątku, którą wątki puli przejmują na czas wykonywania zadań operacji.
+  Przerwać operację może tylko wątek, który ją rozpoczął, i tylko wtedy,
+  gdy żaden inny wątek nie wykonuje jej zadań, więc skok nie omija ramek
+  stosu używanych przez inne wątki ani zajętych blokad.
+  @author Julia Podrażka
+ */
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+
+#include "mono_pool.h"
+#include "memory_budget.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Wartość w mapie utworzonych obiektów oznaczająca tablicę jednomianów. */
+#define CREATED_ARRAY 0
+/** Wartość w mapie utworzonych obiektów oznaczająca blok pamięci. */
+#define CREATED_BLOCK 1
+
+/**
+ * To jest nagłówek rozliczanego bloku pamięci, przechowujący jego rozmiar.
+ * Unia zachowuje wyrównanie pamięci następującej po nagłówku.
+ */
+typedef union BlockSize {
+    size_t size; ///< liczba bajtów bloku bez nagłówka
+    max_align_t align; ///< wyrównanie nagłówka
+} BlockSize;
+
+/** Liczba bajtów używanej pamięci. */
+static atomic_size_t in_use = FIRST_IDX;
+/** Największa liczba bajtów pamięci używanych jednocześnie. */
+static atomic_size_t peak = FIRST_IDX;
+/** Budżet pamięci w bajtach albo zero. */
+static atomic_size_t budget = FIRST_IDX;
+/** Strażnik operacji wykonywanej przez bieżący wątek. */
+static _Thread_local MemoryGuard *current = NULL;
+/** Liczba wstrzymań przerywania operacji w bieżącym wątku. */
+static _Thread_local size_t held = FIRST_IDX;
+/** Konto pamięci bieżącego wątku. */
+static _Thread_local MemoryAccount *thread_account = NULL;
+
+void MemorySetBudget(size_t bytes) {
+
+    atomic_store(&budget, bytes);
+
+}
+
+size_t MemoryBudget(void) {
+
+    return atomic_load_explicit(&budget, memory_order_relaxed);
+
+}
+
+MemoryAccount MemoryAccountInit(size_t limit) {
+
+    return (MemoryAccount) {.used = FIRST_IDX, .limit = limit};
+
+}
+
+void MemorySetAccount(MemoryAccount *account) {
+
+    thread_account = account;
+
+}
+
+/**
+ * Zwraca konto, na którym bieżący wątek rozlicza pamięć: konto operacji,
+ * którą wykonuje, albo własne konto.
+ * @return konto albo NULL
+ */
+static MemoryAccount *CurrentAccount(void) {
+
+    return current != NULL ? current -> account : thread_account;
+
+}
+
+bool MemoryLimited(void) {
+
+    MemoryAccount *charged = CurrentAccount();
+    return MemoryBudget() != FIRST_IDX ||
+           (charged != NULL && charged -> limit != FIRST_IDX);
+
+}
+
+size_t MemoryInUse(void) {
+
+    return atomic_load_explicit(&in_use, memory_order_relaxed);
+
+}
+
+size_t MemoryPeak(void) {
+
+    return atomic_load_explicit(&peak, memory_order_relaxed);
+
+}
+
+void MemoryCharge(size_t bytes) {
+
+    size_t used = atomic_fetch_add_explicit(&in_use, bytes, memory_order_relaxed) + bytes;
+    size_t seen = atomic_load_explicit(&peak, memory_order_relaxed);
+    while (used > seen && !atomic_compare_exchange_weak_explicit(
+            &peak, &seen, used, memory_order_relaxed, memory_order_relaxed));
+
+    MemoryAccount *charged = CurrentAccount();
+    long long owned = FIRST_IDX;
+    if (charged != NULL)
+        owned = atomic_fetch_add_explicit(&charged -> used, (long long) bytes,
+                                          memory_order_relaxed) + (long long) bytes;
+
+    if (current == NULL || held > FIRST_IDX) return;
+    size_t limit = atomic_load_explicit(&budget, memory_order_relaxed);
+    bool is_over_budget = limit != FIRST_IDX && used > limit;
+    bool is_over_account = charged != NULL && charged -> limit != FIRST_IDX &&
+                           owned > (long long) charged -> limit;
+    if (!is_over_budget && !is_over_account) return;
+    atomic_fetch_sub_explicit(&in_use, bytes, memory_order_relaxed);
+    if (charged != NULL)
+        atomic_fetch_sub_explicit(&charged -> used, (long long) bytes, memory_order_relaxed);
+    MemoryGuard *guard = current;
+    current = NULL;
+    longjmp(guard -> env, ONE_ELEMENT);
+
+}
+
+void MemoryUncharge(size_t bytes) {
+
+    atomic_fetch_sub_explicit(&in_use, bytes, memory_order_relaxed);
+    MemoryAccount *charged = CurrentAccount();
+    if (charged != NULL)
+        atomic_fetch_sub_explicit(&charged -> used, (long long) bytes, memory_order_relaxed);
+
+}
+
+/**
+ * Zapisuje nowy obiekt w mapie utworzonych obiektów strażnika bieżącego
+ * wątku.
+ * @param[in] ptr : nowy obiekt
+ * @param[in] kind : CREATED_ARRAY lub CREATED_BLOCK
+ */
+static void Track(const void *ptr, int64_t kind) {
+
+    if (current == NULL) return;
+    pthread_mutex_lock(&current -> lock);
+    PointerMapSet(&current -> created, ptr, kind);
+    pthread_mutex_unlock(&current -> lock);
+
+}
+
+/**
+ * Usuwa obiekt z mapy utworzonych obiektów strażnika bieżącego wątku.
+ * @param[in] ptr : obiekt
+ * @return Czy obiekt został utworzony przez operację bieżącego strażnika?
+ */
+static bool Untrack(const void *ptr) {
+
+    if (current == NULL) return false;
+    pthread_mutex_lock(&current -> lock);
+    bool is_created = PointerMapErase(&current -> created, ptr);
+    pthread_mutex_unlock(&current -> lock);
+    return is_created;
+
+}
+
+void *MemoryAlloc(size_t size) {
+
+    MemoryCharge(size + sizeof(BlockSize));
+    BlockSize *header = (BlockSize *) malloc(sizeof(BlockSize) + size);
+    CHECK_PTR(header);
+    header -> size = size;
+    Track(header, CREATED_BLOCK);
+    return header + ONE_ELEMENT;
+
+}
+
+void *MemoryCalloc(size_t count, size_t size) {
+
+    MemoryCharge(count * size + sizeof(BlockSize));
+    BlockSize *header = (BlockSize *) calloc(ONE_ELEMENT, sizeof(BlockSize) + count * size);
+    CHECK_PTR(header);
+    header -> size = count * size;
+    Track(header, CREATED_BLOCK);
+    return header + ONE_ELEMENT;
+
+}
+
+void *MemoryRealloc(void *ptr, size_t size) {
+
+    if (ptr == NULL) return MemoryAlloc(size);
+
+    BlockSize *header = ((BlockSize *) ptr) - ONE_ELEMENT;
+    size_t old_size = header -> size;
+    // Pamięć doliczamy przed zmianą bloku, żeby przerwanie go nie uszkodziło.
+    if (size > old_size) MemoryCharge(size - old_size);
+    // Stary wskaźnik jest po zmianie bloku nieważny, więc usuwamy go ze
+    // strażnika wcześniej. Przeniesiony blok sprzed operacji nadal do niej
+    // nie należy.
+    bool is_created = Untrack(header);
+    BlockSize *moved = (BlockSize *) realloc(header, sizeof(BlockSize) + size);
+    CHECK_PTR(moved);
+    if (size < old_size) MemoryUncharge(old_size - size);
+    moved -> size = size;
+    if (is_created) Track(moved, CREATED_BLOCK);
+    return moved + ONE_ELEMENT;
+
+}
+
+/**
+ * Zwalnia rozliczany blok pamięci bez usuwania go ze strażnika.
+ * @param[in] header : nagłówek bloku
+ */
+static void FreeBlock(BlockSize *header) {
+
+    MemoryUncharge(header -> size + sizeof(BlockSize));
+    free(header);
+
+}
+
+void MemoryFree(void *ptr) {
+
+    if (ptr == NULL) return;
+
+    BlockSize *header = ((BlockSize *) ptr) - ONE_ELEMENT;
+    Untrack(header);
+    FreeBlock(header);
+
+}
+
+void MemoryGuardBegin(MemoryGuard *guard) {
+
+    pthread_mutex_init(&guard -> lock, NULL);
+    guard -> created = PointerMapInit();
+    guard -> retained = PointerMapInit();
+    guard -> mark = ArenaGetMark();
+    guard -> account = thread_account;
+    current = guard;
+
+}
+
+/**
+ * Zwalnia pamięć strażnika.
+ * @param[in] guard : strażnik
+ */
+static void GuardFree(MemoryGuard *guard) {
+
+    PointerMapFree(&guard -> created);
+    PointerMapFree(&guard -> retained);
+    pthread_mutex_destroy(&guard -> lock);
+
+}
+
+void MemoryGuardEnd(MemoryGuard *guard) {
+
+    current = NULL;
+    GuardFree(guard);
+
+}
+
+void MemoryGuardAbort(MemoryGuard *guard) {
+
+    current = NULL;
+    const void *key;
+    int64_t value;
+    // Odwołania do wcześniejszych tablic trzymały tylko obiekty przerwanej
+    // operacji. Ostatniego odwołania nie zwalniamy, bo zwolnienie tablicy
+    // wymagałoby znajomości jej rozmiaru; tablica zostaje wtedy w pamięci.
+    for (size_t i = FIRST_IDX; i < guard -> retained.capacity; i++) {
+        if (!PointerMapEntry(&guard -> retained, i, &key, &value)) continue;
+        Mono *arr = (Mono *) key;
+        for (; value > FIRST_IDX && MonoArrIsShared(arr); value--) MonoArrRelease(arr);
+    }
+    // Utworzone tablice są osiągalne tylko z obiektów operacji, więc
+    // zwalniamy je wszystkie bez zwalniania ich jednomianów.
+    for (size_t i = FIRST_IDX; i < guard -> created.capacity; i++) {
+        if (!PointerMapEntry(&guard -> created, i, &key, &value)) continue;
+        if (value == CREATED_ARRAY) MonoArrFree((Mono *) key);
+        else FreeBlock((BlockSize *) key);
+    }
+    ArenaReset(guard -> mark);
+    GuardFree(guard);
+
+}
+
+MemoryGuard *MemoryCurrentGuard(void) {
+
+    return current;
+
+}
+
+MemoryGuard *MemorySwapGuard(MemoryGuard *guard) {
+
+    MemoryGuard *previous = current;
+    current = guard;
+    return previous;
+
+}
+
+void MemoryHoldAborts(void) {
+
+    held++;
+
+}
+
+void MemoryAllowAborts(void) {
+
+    assert(held > FIRST_IDX);
+    held--;
+
+}
+
+void MemoryTrackArray(const Mono *arr) {
+
+    Track(arr, CREATED_ARRAY);
+
+}
+
+void MemoryUntrackArray(const Mono *arr) {
+
+    if (current == NULL) return;
+    pthread_mutex_lock(&current -> lock);
+    PointerMapErase(&current -> created, arr);
+    PointerMapErase(&current -> retained, arr);
+    pthread_mutex_unlock(&current -> lock);
+
+}
+
+void MemoryTrackRefs(const Mono *arr, int delta) {
+
+    if (current == NULL) return;
+    pthread_mutex_lock(&current -> lock);
+    int64_t refs = FIRST_IDX;
+    if (!PointerMapFind(&current -> created, arr, &refs)) {
+        PointerMapFind(&current -> retained, arr, &refs);
+        PointerMapSet(&current -> retained, arr, refs + delta);
+    }
+    pthread_mutex_unlock(&current -> lock);
+
+}
@@ -0,0 +1,210 @@
+/** @file
+  Interfejs rozliczania pamięci i budżetu pamięci operacji na wielomianach.
+  Tablice jednomianów, bloki areny oraz bloki przydzielane funkcjami
+  MemoryAlloc, MemoryCalloc i MemoryRealloc są doliczane do licznika
+  używanej pamięci. Jeśli ustawiono budżet, to operacja wykonywana pod
+  strażnikiem (MemoryGuard), która przekroczyłaby budżet, jest przerywana
+  skokiem funkcją longjmp do miejsca rozpoczęcia operacji. Strażnik
+  zapamiętuje tablice i bloki utworzone przez operację oraz zmiany
+  liczników odwołań tablic istniejących przed operacją, więc po przerwaniu
+  można zwolnić całą pamięć operacji i przywrócić liczniki odwołań.
+  Alokacje poza strażnikiem są tylko liczone.
+
+  Niezależnie od budżetu wątek może rozliczać pamięć na własnym koncie
+  (MemoryAccount), np. jednej sesji serwera. Konto ma własny limit, po
+  którego przekroczeniu operacja pod strażnikiem jest przerywana tak samo
+  jak po przekroczeniu budżetu. Zadania puli wątków rozliczają pamięć na
+  koncie wątku, który rozpoczął operację.
+  @author Julia Podrażka
+ */
+#ifndef MEMORY_BUDGET_H
+#define MEMORY_BUDGET_H
+
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#include "arena.h"
+#include "poly.h"
+#include "pointer_map.h"
+
+/**
+ * To jest struktura przechowująca konto pamięci. Licznik jest ze znakiem, bo
+ * pamięć przydzielona przed ustawieniem konta może zostać zwolniona na nim.
+ */
+typedef struct MemoryAccount {
+    atomic_llong used; ///< liczba bajtów rozliczonych na koncie
+    size_t limit; ///< limit konta w bajtach albo zero
+} MemoryAccount;
+
+/**
+ * To jest struktura przechowująca stan operacji wykonywanej pod strażnikiem.
+ * Pola ustawia funkcja MemoryGuardBegin, a wywołujący tylko przekazuje @p env
+ * funkcji setjmp przed jej wywołaniem.
+ */
+typedef struct MemoryGuard {
+    jmp_buf env; ///< miejsce, do którego wraca przerwana operacja
+    pthread_mutex_t lock; ///< blokada map, które mogą zmieniać wątki puli
+    PointerMap created; ///< tablice jednomianów i bloki utworzone przez operację
+    PointerMap retained; ///< zmiany liczników odwołań wcześniejszych tablic
+    ArenaMark mark; ///< stan areny na początku operacji
+    MemoryAccount *account; ///< konto wątku, który rozpoczął operację
+} MemoryGuard;
+
+/**
+ * Ustawia budżet pamięci.
+ * @param[in] bytes : budżet w bajtach albo zero, jeśli pamięć nie jest ograniczona
+ */
+void MemorySetBudget(size_t bytes);
+
+/**
+ * Zwraca budżet pamięci.
+ * @return budżet w bajtach albo zero, jeśli pamięć nie jest ograniczona
+ */
+size_t MemoryBudget(void);
+
+/**
+ * Tworzy puste konto pamięci.
+ * @param[in] limit : limit konta w bajtach albo zero
+ * @return konto pamięci
+ */
+MemoryAccount MemoryAccountInit(size_t limit);
+
+/**
+ * Ustawia konto pamięci bieżącego wątku.
+ * @param[in] account : konto albo NULL
+ */
+void MemorySetAccount(MemoryAccount *account);
+
+/**
+ * Sprawdza, czy operacje bieżącego wątku mogą zostać przerwane, czyli czy
+ * ustawiono budżet pamięci albo konto wątku ma limit.
+ * @return Czy pamięć jest ograniczona?
+ */
+bool MemoryLimited(void);
+
+/**
+ * Zwraca liczbę bajtów używanej pamięci.
+ * @return liczba bajtów
+ */
+size_t MemoryInUse(void);
+
+/**
+ * Zwraca największą liczbę bajtów pamięci używanych jednocześnie.
+ * @return liczba bajtów
+ */
+size_t MemoryPeak(void);
+
+/**
+ * Dolicza pamięć do licznika używanej pamięci i do konta bieżącego wątku.
+ * Jeśli przekroczyłoby to budżet albo limit konta, a bieżący wątek wykonuje
+ * operację pod strażnikiem, to nie zmienia liczników i przerywa operację.
+ * @param[in] bytes : liczba bajtów
+ */
+void MemoryCharge(size_t bytes);
+
+/**
+ * Odejmuje pamięć od licznika używanej pamięci i od konta bieżącego wątku.
+ * @param[in] bytes : liczba bajtów
+ */
+void MemoryUncharge(size_t bytes);
+
+/**
+ * Przydziela rozliczany blok pamięci, który należy zwolnić funkcją MemoryFree.
+ * @param[in] size : liczba bajtów
+ * @return wskaźnik na blok
+ */
+void *MemoryAlloc(size_t size);
+
+/**
+ * Przydziela rozliczany blok pamięci wypełniony zerami.
+ * @param[in] count : liczba elementów
+ * @param[in] size : rozmiar elementu w bajtach
+ * @return wskaźnik na blok
+ */
+void *MemoryCalloc(size_t count, size_t size);
+
+/**
+ * Zmienia rozmiar rozliczanego bloku pamięci.
+ * @param[in] ptr : blok przydzielony funkcją MemoryAlloc lub NULL
+ * @param[in] size : nowa liczba bajtów
+ * @return wskaźnik na blok o nowym rozmiarze
+ */
+void *MemoryRealloc(void *ptr, size_t size);
+
+/**
+ * Zwalnia rozliczany blok pamięci.
+ * @param[in] ptr : blok przydzielony funkcją MemoryAlloc lub NULL
+ */
+void MemoryFree(void *ptr);
+
+/**
+ * Rozpoczyna w bieżącym wątku operację pod strażnikiem. Wywołujący musi
+ * wcześniej wywołać setjmp(guard -> env); niezerowy wynik oznacza, że
+ * operacja została przerwana i należy wywołać MemoryGuardAbort.
+ * @param[out] guard : strażnik
+ */
+void MemoryGuardBegin(MemoryGuard *guard);
+
+/**
+ * Kończy operację, która nie została przerwana.
+ * @param[in] guard : strażnik
+ */
+void MemoryGuardEnd(MemoryGuard *guard);
+
+/**
+ * Sprząta po przerwanej operacji: przywraca liczniki odwołań tablic
+ * istniejących przed operacją oraz zwalnia utworzone przez nią tablice,
+ * bloki i pamięć areny.
+ * @param[in] guard : strażnik przerwanej operacji
+ */
+void MemoryGuardAbort(MemoryGuard *guard);
+
+/**
+ * Zwraca strażnika operacji wykonywanej przez bieżący wątek.
+ * @return strażnik albo NULL
+ */
+MemoryGuard *MemoryCurrentGuard(void);
+
+/**
+ * Ustawia strażnika bieżącego wątku, np. na czas wykonywania przez wątek
+ * puli zadania utworzonego pod strażnikiem.
+ * @param[in] guard : strażnik albo NULL
+ * @return poprzedni strażnik bieżącego wątku
+ */
+MemoryGuard *MemorySwapGuard(MemoryGuard *guard);
+
+/**
+ * Wstrzymuje przerywanie operacji w bieżącym wątku, np. dopóki inne wątki
+ * wykonują zadania korzystające z jego stosu. Wywołania można zagnieżdżać.
+ */
+void MemoryHoldAborts(void);
+
+/**
+ * Cofa jedno wywołanie funkcji MemoryHoldAborts.
+ */
+void MemoryAllowAborts(void);
+
+/**
+ * Zapamiętuje w strażniku bieżącego wątku nową tablicę jednomianów.
+ * @param[in] arr : tablica jednomianów
+ */
+void MemoryTrackArray(const Mono *arr);
+
+/**
+ * Usuwa zwalnianą tablicę jednomianów ze strażnika bieżącego wątku.
+ * @param[in] arr : tablica jednomianów
+ */
+void MemoryUntrackArray(const Mono *arr);
+
+/**
+ * Zapamiętuje w strażniku bieżącego wątku zmianę licznika odwołań tablicy
+ * jednomianów, jeśli tablica istniała przed operacją.
+ * @param[in] arr : tablica jednomianów
+ * @param[in] delta : zmiana licznika odwołań
+ */
+void MemoryTrackRefs(const Mono *arr, int delta);
+
+#endif
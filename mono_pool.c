@@ -0,0 +1,418 @@
+/** @file
+  Implementacja puli pamięci na tablice jednomianów.
+  Każdy blok poprzedzony jest nagłówkiem wskazującym płytę, z której pochodzi.
+  Płyty alokowane są funkcją mmap, dzięki czemu puste płyty można zwrócić
+  do systemu funkcją munmap. Liczniki odwołań są atomowe, a po włączeniu
+  trybu wielowątkowego przydział i zwalnianie bloków chroni blokada.
+  @author Julia Podrażka
+ */
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <sys/mman.h>
+
+#include "poly.h"
+#include "mono_pool.h"
+#include "memory_budget.h"
+
+/** Rozmiar płyty w bajtach. */
+#define SLAB_SIZE (64 * 1024)
+/** Liczba pustych płyt w klasie, po przekroczeniu której płyty są zwracane. */
+#define MAX_IDLE_SLABS 2
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Wyrównanie nagłówka płyty. */
+#define ALIGNMENT 16
+
+/** Liczby jednomianów mieszczących się w blokach kolejnych klas rozmiarów. */
+static const size_t class_capacity[] = {1, 2, 3, 4, 6, 8, 12, 16, 24, 32, 48, 64};
+
+/** Liczba klas rozmiarów. */
+#define CLASS_COUNT (sizeof(class_capacity) / sizeof(class_capacity[FIRST_IDX]))
+
+struct Slab;
+
+/**
+ * To jest struktura przechowująca nagłówek bloku. Dla bloków alokowanych
+ * bezpośrednio na stercie wskaźnik na płytę jest równy NULL. Tablice stałe
+ * mają wskaźnik na płytę równy NULL i zerową pojemność.
+ */
+typedef struct BlockHeader {
+    struct Slab *slab; ///< płyta, z której pochodzi blok
+    size_t capacity; ///< liczba jednomianów mieszczących się w bloku
+    atomic_size_t refs; ///< liczba odwołań do tablicy jednomianów
+    uint64_t tag; ///< znacznik tablicy
+    atomic_size_t terms; ///< liczba wyrazów wielomianu albo zero, jeśli nie jest znana
+} BlockHeader;
+
+/**
+ * To jest struktura przechowująca wolny blok na liście wolnych bloków.
+ * Wskaźnik na następny wolny blok zapisany jest w miejscu pierwszego
+ * jednomianu, więc nagłówek bloku pozostaje nienaruszony.
+ */
+typedef struct FreeBlock {
+    BlockHeader header; ///< nagłówek bloku
+    struct FreeBlock *next; ///< następny wolny blok klasy
+} FreeBlock;
+
+/**
+ * To jest struktura przechowująca nagłówek płyty.
+ */
+typedef struct Slab {
+    struct Slab *prev; ///< poprzednia płyta klasy
+    struct Slab *next; ///< następna płyta klasy
+    size_t class_idx; ///< indeks klasy rozmiarów płyty
+    size_t used; ///< liczba używanych bloków płyty
+    size_t carved; ///< liczba bloków wydzielonych już z płyty
+} Slab;
+
+/**
+ * To jest struktura przechowująca stan klasy rozmiarów.
+ */
+typedef struct PoolClass {
+    FreeBlock *free_list; ///< lista wolnych bloków
+    Slab *slabs; ///< lista płyt klasy
+    Slab *carve; ///< płyta, z której wydzielamy nowe bloki
+    size_t idle_slabs; ///< liczba płyt bez używanych bloków
+    MonoPoolStats stats; ///< statystyki klasy
+} PoolClass;
+
+/** Klasy rozmiarów puli. */
+static PoolClass classes[CLASS_COUNT];
+/** Statystyki tablic alokowanych bezpośrednio na stercie. */
+static MonoPoolStats large_stats;
+/** Blokada puli. */
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+/** Czy pula jest używana przez wiele wątków. */
+static bool locking = false;
+
+/**
+ * Zakłada blokadę puli, jeśli włączony jest tryb wielowątkowy.
+ */
+static void Lock(void) {
+
+    if (locking) pthread_mutex_lock(&pool_lock);
+
+}
+
+/**
+ * Zwalnia blokadę puli, jeśli włączony jest tryb wielowątkowy.
+ */
+static void Unlock(void) {
+
+    if (locking) pthread_mutex_unlock(&pool_lock);
+
+}
+
+/**
+ * Zwraca rozmiar nagłówka płyty zaokrąglony do wyrównania.
+ * @return rozmiar nagłówka płyty w bajtach
+ */
+static size_t SlabHeaderSize(void) {
+
+    return (sizeof(Slab) + ALIGNMENT - ONE_ELEMENT) & ~(size_t) (ALIGNMENT - ONE_ELEMENT);
+
+}
+
+/**
+ * Zwraca rozmiar bloku klasy o indeksie @p class_idx razem z nagłówkiem.
+ * @param[in] class_idx : indeks klasy
+ * @return rozmiar bloku w bajtach
+ */
+static size_t SlotSize(size_t class_idx) {
+
+    return sizeof(BlockHeader) + class_capacity[class_idx] * sizeof(Mono);
+
+}
+
+/**
+ * Zwraca indeks najmniejszej klasy, w której mieści się @p count jednomianów,
+ * lub CLASS_COUNT, jeśli tablica jest za duża na każdą z klas.
+ * @param[in] count : liczba jednomianów
+ * @return indeks klasy
+ */
+static size_t ClassFor(size_t count) {
+
+    size_t class_idx = FIRST_IDX;
+    while (class_idx < CLASS_COUNT && class_capacity[class_idx] < count)
+        class_idx++;
+    return class_idx;
+
+}
+
+/**
+ * Aktualizuje statystyki po przydzieleniu bloku.
+ * @param[in] stats : statystyki
+ */
+static void CountAlloc(MonoPoolStats *stats) {
+
+    stats -> allocs++;
+    stats -> in_use++;
+    if (stats -> in_use > stats -> peak_in_use)
+        stats -> peak_in_use = stats -> in_use;
+
+}
+
+/**
+ * Tworzy nową płytę klasy i dołącza ją do listy płyt.
+ * @param[in] class_idx : indeks klasy
+ * @return nowa płyta
+ */
+static Slab *NewSlab(size_t class_idx) {
+
+    void *memory = mmap(NULL, SLAB_SIZE, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) exit(1);
+    Slab *slab = (Slab *) memory;
+    PoolClass *pool_class = &classes[class_idx];
+    slab -> prev = NULL;
+    slab -> next = pool_class -> slabs;
+    if (pool_class -> slabs != NULL) pool_class -> slabs -> prev = slab;
+    pool_class -> slabs = slab;
+    slab -> class_idx = class_idx;
+    slab -> used = FIRST_IDX;
+    slab -> carved = FIRST_IDX;
+    pool_class -> idle_slabs++;
+    pool_class -> stats.slabs++;
+    return slab;
+
+}
+
+/**
+ * Zwraca do systemu puste płyty klasy i usuwa ich bloki z listy wolnych bloków.
+ * @param[in] pool_class : klasa rozmiarów
+ */
+static void TrimClass(PoolClass *pool_class) {
+
+    FreeBlock **link = &pool_class -> free_list;
+    while (*link != NULL) {
+        if ((*link) -> header.slab -> used == FIRST_IDX) *link = (*link) -> next;
+        else link = &(*link) -> next;
+    }
+    Slab *slab = pool_class -> slabs;
+    while (slab != NULL) {
+        Slab *next = slab -> next;
+        if (slab -> used == FIRST_IDX) {
+            if (slab -> prev != NULL) slab -> prev -> next = slab -> next;
+            else pool_class -> slabs = slab -> next;
+            if (slab -> next != NULL) slab -> next -> prev = slab -> prev;
+            if (pool_class -> carve == slab) pool_class -> carve = NULL;
+            munmap(slab, SLAB_SIZE);
+            pool_class -> stats.slabs--;
+            pool_class -> stats.released_slabs++;
+        }
+        slab = next;
+    }
+    pool_class -> idle_slabs = FIRST_IDX;
+
+}
+
+Mono *MonoArrAlloc(size_t count) {
+
+    assert(count > FIRST_IDX);
+
+    size_t class_idx = ClassFor(count);
+    MemoryCharge(sizeof(BlockHeader) + (class_idx == CLASS_COUNT ? count
+                                         : class_capacity[class_idx]) * sizeof(Mono));
+    if (class_idx == CLASS_COUNT) {
+        BlockHeader *header =
+                (BlockHeader *) malloc(sizeof(BlockHeader) + count * sizeof(Mono));
+        CHECK_PTR(header);
+        header -> slab = NULL;
+        header -> capacity = count;
+        atomic_init(&header -> refs, ONE_ELEMENT);
+        header -> tag = FIRST_IDX;
+        atomic_init(&header -> terms, FIRST_IDX);
+        Lock();
+        CountAlloc(&large_stats);
+        Unlock();
+        MemoryTrackArray((Mono *) (header + ONE_ELEMENT));
+        return (Mono *) (header + ONE_ELEMENT);
+    }
+
+    Lock();
+    PoolClass *pool_class = &classes[class_idx];
+    BlockHeader *header;
+    if (pool_class -> free_list != NULL) {
+        header = &pool_class -> free_list -> header;
+        pool_class -> free_list = pool_class -> free_list -> next;
+    } else {
+        size_t slot_size = SlotSize(class_idx);
+        size_t slots = (SLAB_SIZE - SlabHeaderSize()) / slot_size;
+        if (pool_class -> carve == NULL || pool_class -> carve -> carved == slots)
+            pool_class -> carve = NewSlab(class_idx);
+        Slab *slab = pool_class -> carve;
+        header = (BlockHeader *) ((unsigned char *) slab + SlabHeaderSize() +
+                                  slab -> carved * slot_size);
+        header -> slab = slab;
+        header -> capacity = class_capacity[class_idx];
+        slab -> carved++;
+    }
+    if (header -> slab -> used == FIRST_IDX) pool_class -> idle_slabs--;
+    header -> slab -> used++;
+    CountAlloc(&pool_class -> stats);
+    Unlock();
+    atomic_init(&header -> refs, ONE_ELEMENT);
+    header -> tag = FIRST_IDX;
+    atomic_init(&header -> terms, FIRST_IDX);
+    MemoryTrackArray((Mono *) (header + ONE_ELEMENT));
+    return (Mono *) (header + ONE_ELEMENT);
+
+}
+
+void MonoArrFree(Mono *arr) {
+
+    if (arr == NULL) return;
+
+    BlockHeader *header = ((BlockHeader *) arr) - ONE_ELEMENT;
+    MemoryUntrackArray(arr);
+    MemoryUncharge(MonoArrBytes(arr, FIRST_IDX));
+    Lock();
+    if (header -> slab == NULL) {
+        large_stats.frees++;
+        large_stats.in_use--;
+        Unlock();
+        free(header);
+        return;
+    }
+
+    Slab *slab = header -> slab;
+    PoolClass *pool_class = &classes[slab -> class_idx];
+    FreeBlock *block = (FreeBlock *) header;
+    block -> next = pool_class -> free_list;
+    pool_class -> free_list = block;
+    pool_class -> stats.frees++;
+    pool_class -> stats.in_use--;
+    slab -> used--;
+    if (slab -> used == FIRST_IDX) {
+        pool_class -> idle_slabs++;
+        if (pool_class -> idle_slabs > MAX_IDLE_SLABS) TrimClass(pool_class);
+    }
+    Unlock();
+
+}
+
+size_t MonoArrHeaderSize(void) {
+
+    return sizeof(BlockHeader);
+
+}
+
+Mono *MonoArrInitStatic(void *memory) {
+
+    BlockHeader *header = (BlockHeader *) memory;
+    header -> slab = NULL;
+    header -> capacity = FIRST_IDX;
+    atomic_init(&header -> refs, ONE_ELEMENT);
+    header -> tag = FIRST_IDX;
+    atomic_init(&header -> terms, FIRST_IDX);
+    return (Mono *) (header + ONE_ELEMENT);
+
+}
+
+size_t MonoArrBytes(const Mono *arr, size_t size) {
+
+    const BlockHeader *header = ((const BlockHeader *) arr) - ONE_ELEMENT;
+    size_t capacity = header -> capacity == FIRST_IDX ? size : header -> capacity;
+    return sizeof(BlockHeader) + capacity * sizeof(Mono);
+
+}
+
+bool MonoArrIsStatic(const Mono *arr) {
+
+    return (((const BlockHeader *) arr) - ONE_ELEMENT) -> capacity == FIRST_IDX;
+
+}
+
+void MonoArrRetain(Mono *arr) {
+
+    // Nagłówek tablicy stałej może leżeć w pamięci tylko do odczytu.
+    BlockHeader *header = ((BlockHeader *) arr) - ONE_ELEMENT;
+    if (header -> capacity == FIRST_IDX) return;
+    atomic_fetch_add_explicit(&header -> refs, ONE_ELEMENT, memory_order_relaxed);
+    MemoryTrackRefs(arr, ONE_ELEMENT);
+
+}
+
+bool MonoArrRelease(Mono *arr) {
+
+    BlockHeader *header = ((BlockHeader *) arr) - ONE_ELEMENT;
+    if (header -> capacity == FIRST_IDX) return false;
+    MemoryTrackRefs(arr, -ONE_ELEMENT);
+    size_t refs = atomic_fetch_sub_explicit(&header -> refs, ONE_ELEMENT,
+                                            memory_order_acq_rel);
+    assert(refs > FIRST_IDX);
+    return refs == ONE_ELEMENT;
+
+}
+
+bool MonoArrIsShared(const Mono *arr) {
+
+    BlockHeader *header = ((BlockHeader *) arr) - ONE_ELEMENT;
+    return header -> capacity == FIRST_IDX ||
+           atomic_load_explicit(&header -> refs, memory_order_acquire) > ONE_ELEMENT;
+
+}
+
+uint64_t MonoArrGetTag(const Mono *arr) {
+
+    return (((const BlockHeader *) arr) - ONE_ELEMENT) -> tag;
+
+}
+
+void MonoArrSetTag(Mono *arr, uint64_t tag) {
+
+    (((BlockHeader *) arr) - ONE_ELEMENT) -> tag = tag;
+
+}
+
+size_t MonoArrGetTerms(const Mono *arr) {
+
+    return atomic_load_explicit(&(((const BlockHeader *) arr) - ONE_ELEMENT) -> terms,
+                                memory_order_relaxed);
+
+}
+
+void MonoArrSetTerms(Mono *arr, size_t terms) {
+
+    atomic_store_explicit(&(((BlockHeader *) arr) - ONE_ELEMENT) -> terms, terms,
+                          memory_order_relaxed);
+
+}
+
+void MonoPoolEnableLocking(void) {
+
+    locking = true;
+
+}
+
+void MonoPoolTrim(void) {
+
+    Lock();
+    for (size_t i = FIRST_IDX; i < CLASS_COUNT; i++) {
+        if (classes[i].idle_slabs > FIRST_IDX) TrimClass(&classes[i]);
+    }
+    Unlock();
+
+}
+
+size_t MonoPoolClassCount(void) {
+
+    return CLASS_COUNT;
+
+}
+
+MonoPoolStats MonoPoolGetStats(size_t class_idx) {
+
+    assert(class_idx <= CLASS_COUNT);
+
+    Lock();
+    MonoPoolStats stats = class_idx == CLASS_COUNT ? large_stats
+                                                   : classes[class_idx].stats;
+    Unlock();
+    if (class_idx < CLASS_COUNT) stats.capacity = class_capacity[class_idx];
+    return stats;
+
+}
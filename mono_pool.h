@@ -0,0 +1,164 @@
+/** @file
+  Interfejs puli pamięci na tablice jednomianów.
+  Tablice o niewielkiej liczbie jednomianów przydzielane są z płyt (ang. slab)
+  podzielonych na klasy rozmiarów, a zwolnione tablice trafiają na listę
+  wolnych bloków swojej klasy. Większe tablice alokowane są bezpośrednio na
+  stercie. Każda tablica ma licznik odwołań, dzięki któremu wielomiany mogą
+  współdzielić poddrzewa, także między wątkami. Przydzielone tablice są
+  doliczane do licznika używanej pamięci, a ich tworzenie i zmiany
+  liczników odwołań zapamiętuje strażnik budżetu pamięci bieżącego wątku.
+  @author Julia Podrażka
+ */
+#ifndef MONO_POOL_H
+#define MONO_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "poly.h"
+
+/**
+ * To jest struktura przechowująca statystyki jednej klasy rozmiarów puli.
+ */
+typedef struct MonoPoolStats {
+    size_t capacity; ///< liczba jednomianów mieszczących się w bloku klasy
+    size_t allocs; ///< liczba przydzielonych bloków
+    size_t frees; ///< liczba zwolnionych bloków
+    size_t in_use; ///< liczba aktualnie używanych bloków
+    size_t peak_in_use; ///< maksymalna liczba jednocześnie używanych bloków
+    size_t slabs; ///< liczba płyt należących do klasy
+    size_t released_slabs; ///< liczba płyt zwróconych do systemu
+} MonoPoolStats;
+
+/**
+ * Przydziela tablicę mieszczącą @p count jednomianów. Licznik odwołań
+ * nowej tablicy wynosi jeden.
+ * @param[in] count : liczba jednomianów, większa od zera
+ * @return tablica jednomianów
+ */
+Mono *MonoArrAlloc(size_t count);
+
+/**
+ * Zwalnia tablicę jednomianów przydzieloną funkcją MonoArrAlloc.
+ * Nie zwalnia jednomianów znajdujących się w tablicy.
+ * @param[in] arr : tablica jednomianów lub NULL
+ */
+void MonoArrFree(Mono *arr);
+
+/**
+ * Zwraca liczbę bajtów nagłówka poprzedzającego każdą tablicę jednomianów.
+ * @return rozmiar nagłówka w bajtach
+ */
+size_t MonoArrHeaderSize(void);
+
+/**
+ * Zwraca liczbę bajtów zajmowanych przez tablicę jednomianów razem
+ * z nagłówkiem. Dla tablicy z puli jest to rozmiar całego bloku.
+ * @param[in] arr : tablica jednomianów
+ * @param[in] size : liczba jednomianów, używana tylko dla tablicy stałej
+ * @return liczba bajtów
+ */
+size_t MonoArrBytes(const Mono *arr, size_t size);
+
+/**
+ * Zapisuje w pamięci @p memory nagłówek tablicy stałej, czyli tablicy spoza
+ * puli, która nie jest nigdy zwalniana ani modyfikowana, np. tablicy
+ * w pliku odwzorowanym w pamięci tylko do odczytu. Zmiana licznika
+ * odwołań takiej tablicy nic nie robi, a sama tablica jest zawsze
+ * traktowana jak współdzielona.
+ * @param[out] memory : pamięć o rozmiarze co najmniej MonoArrHeaderSize()
+ * bajtów, a za nią miejsce na jednomiany
+ * @return tablica jednomianów następująca po nagłówku
+ */
+Mono *MonoArrInitStatic(void *memory);
+
+/**
+ * Sprawdza, czy tablica jednomianów jest tablicą stałą.
+ * @param[in] arr : tablica jednomianów
+ * @return Czy tablica jest stała?
+ */
+bool MonoArrIsStatic(const Mono *arr);
+
+/**
+ * Zwiększa licznik odwołań tablicy jednomianów.
+ * @param[in] arr : tablica jednomianów
+ */
+void MonoArrRetain(Mono *arr);
+
+/**
+ * Zmniejsza licznik odwołań tablicy jednomianów. Jeśli było to ostatnie
+ * odwołanie, to wywołujący powinien usunąć jednomiany i zwolnić tablicę
+ * funkcją MonoArrFree.
+ * @param[in] arr : tablica jednomianów
+ * @return Czy było to ostatnie odwołanie do tablicy?
+ */
+bool MonoArrRelease(Mono *arr);
+
+/**
+ * Sprawdza, czy do tablicy jednomianów istnieje więcej niż jedno odwołanie.
+ * @param[in] arr : tablica jednomianów
+ * @return Czy tablica jest współdzielona?
+ */
+bool MonoArrIsShared(const Mono *arr);
+
+/**
+ * Zwraca znacznik tablicy jednomianów, czyli słowo w nagłówku tablicy
+ * do dyspozycji modułów współdzielących wielomiany. Nowa tablica ma
+ * znacznik równy zeru.
+ * @param[in] arr : tablica jednomianów
+ * @return znacznik tablicy
+ */
+uint64_t MonoArrGetTag(const Mono *arr);
+
+/**
+ * Ustawia znacznik tablicy jednomianów.
+ * @param[in] arr : tablica jednomianów
+ * @param[in] tag : znacznik
+ */
+void MonoArrSetTag(Mono *arr, uint64_t tag);
+
+/**
+ * Zwraca zapamiętaną w nagłówku tablicy liczbę wyrazów wielomianu, którego
+ * jednomiany przechowuje tablica. Nowa tablica ma tę liczbę równą zeru,
+ * co oznacza, że nie jest ona znana.
+ * @param[in] arr : tablica jednomianów
+ * @return liczba wyrazów albo zero
+ */
+size_t MonoArrGetTerms(const Mono *arr);
+
+/**
+ * Zapamiętuje w nagłówku tablicy liczbę wyrazów wielomianu. Tablice
+ * są niezmienne, więc wynik można zapamiętać raz na zawsze. Wywołujący
+ * nie może zapisywać do nagłówka tablicy stałej leżącej w pamięci tylko
+ * do odczytu.
+ * @param[in] arr : tablica jednomianów
+ * @param[in] terms : liczba wyrazów
+ */
+void MonoArrSetTerms(Mono *arr, size_t terms);
+
+/**
+ * Włącza blokadę chroniącą pulę przed jednoczesnym użyciem przez wiele
+ * wątków. Należy ją wywołać przed uruchomieniem wątków.
+ */
+void MonoPoolEnableLocking(void);
+
+/**
+ * Zwraca do systemu wszystkie płyty, w których nie ma używanych bloków.
+ */
+void MonoPoolTrim(void);
+
+/**
+ * Zwraca liczbę klas rozmiarów puli. Statystyki tablic alokowanych
+ * bezpośrednio na stercie są dostępne pod indeksem równym tej liczbie.
+ * @return liczba klas rozmiarów
+ */
+size_t MonoPoolClassCount(void);
+
+/**
+ * Zwraca statystyki klasy rozmiarów o indeksie @p class_idx.
+ * @param[in] class_idx : indeks klasy, nie większy niż MonoPoolClassCount()
+ * @return statystyki klasy
+ */
+MonoPoolStats MonoPoolGetStats(size_t class_idx);
+
+#endif
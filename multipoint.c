@@ -0,0 +1,515 @@
+/** @file
+  Implementacja obliczania wartości wielomianu jednej zmiennej w wielu
+  punktach przy pomocy drzewa iloczynów i drzewa reszt.
+  Iloczyny @f$\prod_{lo \le i < hi} (x - x_i)@f$ są unormowane, więc
+  przechowujemy tylko ich @f$hi - lo@f$ najniższych współczynników,
+  a współczynnik wiodący równy jeden jest domyślny. Dzięki temu iloczyny
+  węzłów jednego poziomu drzewa zajmują rozłączne fragmenty jednej tablicy
+  o długości równej liczbie punktów. Mnożenie wielomianów wykonujemy
+  algorytmem Karacuby, a dzielenie z resztą przy pomocy odwrotności szeregu
+  potęgowego wyliczanej metodą Newtona. Wartości w liściach drzewa liczymy
+  schematem Hornera jednocześnie w kilku punktach przy pomocy rozkazów
+  wektorowych, jeśli procesor je obsługuje.
+  @author Julia Podrażka
+ */
+#include <string.h>
+#if defined(__GNUC__) && defined(__x86_64__)
+#include <immintrin.h>
+/** Czy kompilator obsługuje wersje wektorowe schematu Hornera. */
+#define HORNER_SIMD
+#endif
+
+#include "poly.h"
+#include "arena.h"
+#include "thread_pool.h"
+#include "multipoint.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Dwa elementy. */
+#define TWO 2
+/** Długość, poniżej której mnożymy wielomiany algorytmem szkolnym. */
+#define KARATSUBA_THRESHOLD 32
+/** Długość, poniżej której dzielimy wielomiany algorytmem szkolnym. */
+#define NEWTON_THRESHOLD 64
+/** Maksymalna liczba punktów liścia drzewa. */
+#define LEAF_POINTS 16
+/** Liczba punktów węzła, od której jego poddrzewa są liczone równolegle. */
+#define PARALLEL_POINTS 512
+/** Liczba 64-bitowych pól rejestru AVX2. */
+#define AVX2_LANES 4
+/** Liczba 64-bitowych pól rejestru AVX-512. */
+#define AVX512_LANES 8
+/** Liczba rejestrów wektorowych liczonych na przemian. */
+#define SIMD_REGISTERS 4
+/** Liczba bitów połowy słowa 64-bitowego. */
+#define HALF_BITS 32
+
+/**
+ * To jest struktura przechowująca poddrzewo drzewa iloczynów lub reszt.
+ */
+typedef struct TreeJob {
+    uint64_t **levels; ///< iloczyny węzłów kolejnych poziomów drzewa
+    const uint64_t *xs; ///< punkty
+    uint64_t *values; ///< wartości wielomianu w punktach
+    const uint64_t *rem; ///< reszta z dzielenia przez iloczyn węzła
+    size_t depth; ///< poziom węzła
+    size_t lo; ///< indeks pierwszego punktu węzła
+    size_t hi; ///< indeks za ostatnim punktem węzła
+} TreeJob;
+
+/**
+ * Mnoży wielomiany algorytmem szkolnym.
+ * @param[in] a : współczynniki wielomianu @f$a@f$
+ * @param[in] la : liczba współczynników @f$a@f$
+ * @param[in] b : współczynniki wielomianu @f$b@f$
+ * @param[in] lb : liczba współczynników @f$b@f$
+ * @param[out] out : @f$la + lb - 1@f$ współczynników iloczynu
+ */
+static void SchoolMul(const uint64_t *a, size_t la, const uint64_t *b,
+                      size_t lb, uint64_t *out) {
+
+    memset(out, FIRST_IDX, (la + lb - ONE_ELEMENT) * sizeof(uint64_t));
+    for (size_t i = FIRST_IDX; i < la; i++) {
+        for (size_t j = FIRST_IDX; j < lb; j++) out[i + j] += a[i] * b[j];
+    }
+
+}
+
+/**
+ * Mnoży algorytmem Karacuby wielomiany o tej samej liczbie współczynników.
+ * @param[in] a : współczynniki wielomianu @f$a@f$
+ * @param[in] b : współczynniki wielomianu @f$b@f$
+ * @param[in] n : liczba współczynników obu wielomianów
+ * @param[out] out : @f$2n - 1@f$ współczynników iloczynu
+ */
+static void KaratsubaMul(const uint64_t *a, const uint64_t *b, size_t n,
+                         uint64_t *out) {
+
+    if (n < KARATSUBA_THRESHOLD) {
+        SchoolMul(a, n, b, n, out);
+        return;
+    }
+
+    ArenaMark mark = ArenaGetMark();
+    size_t low = n / TWO;
+    size_t high = n - low;
+    uint64_t *sum_a = (uint64_t *) ArenaAlloc(high * sizeof(uint64_t));
+    uint64_t *sum_b = (uint64_t *) ArenaAlloc(high * sizeof(uint64_t));
+    uint64_t *middle = (uint64_t *) ArenaAlloc((TWO * high - ONE_ELEMENT) *
+                                               sizeof(uint64_t));
+    uint64_t *z0 = (uint64_t *) ArenaAlloc((TWO * low - ONE_ELEMENT) *
+                                           sizeof(uint64_t));
+    uint64_t *z2 = (uint64_t *) ArenaAlloc((TWO * high - ONE_ELEMENT) *
+                                           sizeof(uint64_t));
+    for (size_t i = FIRST_IDX; i < high; i++) {
+        sum_a[i] = a[low + i] + (i < low ? a[i] : FIRST_IDX);
+        sum_b[i] = b[low + i] + (i < low ? b[i] : FIRST_IDX);
+    }
+    KaratsubaMul(a, b, low, z0);
+    KaratsubaMul(a + low, b + low, high, z2);
+    KaratsubaMul(sum_a, sum_b, high, middle);
+
+    memset(out, FIRST_IDX, (TWO * n - ONE_ELEMENT) * sizeof(uint64_t));
+    for (size_t i = FIRST_IDX; i < TWO * low - ONE_ELEMENT; i++) {
+        out[i] += z0[i];
+        middle[i] -= z0[i];
+    }
+    for (size_t i = FIRST_IDX; i < TWO * high - ONE_ELEMENT; i++) {
+        out[TWO * low + i] += z2[i];
+        middle[i] -= z2[i];
+    }
+    for (size_t i = FIRST_IDX; i < TWO * high - ONE_ELEMENT; i++)
+        out[low + i] += middle[i];
+    ArenaReset(mark);
+
+}
+
+/**
+ * Mnoży wielomiany. Dłuższy wielomian dzielimy na fragmenty o długości
+ * krótszego i każdy fragment mnożymy algorytmem Karacuby.
+ * @param[in] a : współczynniki wielomianu @f$a@f$
+ * @param[in] la : liczba współczynników @f$a@f$, większa od zera
+ * @param[in] b : współczynniki wielomianu @f$b@f$
+ * @param[in] lb : liczba współczynników @f$b@f$, większa od zera
+ * @param[out] out : @f$la + lb - 1@f$ współczynników iloczynu
+ */
+static void DenseMul(const uint64_t *a, size_t la, const uint64_t *b,
+                     size_t lb, uint64_t *out) {
+
+    if (la < lb) {
+        DenseMul(b, lb, a, la, out);
+        return;
+    }
+    if (lb < KARATSUBA_THRESHOLD) {
+        SchoolMul(a, la, b, lb, out);
+        return;
+    }
+
+    ArenaMark mark = ArenaGetMark();
+    uint64_t *part = (uint64_t *) ArenaAlloc((TWO * lb - ONE_ELEMENT) *
+                                             sizeof(uint64_t));
+    memset(out, FIRST_IDX, (la + lb - ONE_ELEMENT) * sizeof(uint64_t));
+    for (size_t offset = FIRST_IDX; offset < la; offset += lb) {
+        size_t length = la - offset < lb ? la - offset : lb;
+        if (length == lb) KaratsubaMul(a + offset, b, lb, part);
+        else DenseMul(b, lb, a + offset, length, part);
+        for (size_t i = FIRST_IDX; i < length + lb - ONE_ELEMENT; i++)
+            out[offset + i] += part[i];
+    }
+    ArenaReset(mark);
+
+}
+
+/**
+ * Wylicza odwrotność szeregu potęgowego @f$f@f$ o wyrazie wolnym równym
+ * jeden metodą Newtona: @f$g \leftarrow g (2 - f g)@f$, podwajając
+ * w każdym kroku liczbę poprawnych współczynników.
+ * @param[in] f : współczynniki szeregu
+ * @param[in] lf : liczba znanych współczynników szeregu
+ * @param[in] k : liczba wyliczanych współczynników odwrotności
+ * @param[out] g : @p k współczynników odwrotności
+ */
+static void InverseSeries(const uint64_t *f, size_t lf, size_t k, uint64_t *g) {
+
+    ArenaMark mark = ArenaGetMark();
+    uint64_t *product = (uint64_t *) ArenaAlloc(TWO * k * sizeof(uint64_t));
+    uint64_t *correction = (uint64_t *) ArenaAlloc(k * sizeof(uint64_t));
+    g[FIRST_IDX] = ONE_ELEMENT;
+    size_t known = ONE_ELEMENT;
+    while (known < k) {
+        size_t next = TWO * known < k ? TWO * known : k;
+        DenseMul(f, lf < next ? lf : next, g, known, product);
+        for (size_t i = FIRST_IDX; i < next; i++) {
+            bool in_product = i < (lf < next ? lf : next) + known - ONE_ELEMENT;
+            correction[i] = in_product ? -product[i] : FIRST_IDX;
+        }
+        correction[FIRST_IDX] += TWO;
+        DenseMul(g, known, correction, next, product);
+        memcpy(g, product, next * sizeof(uint64_t));
+        known = next;
+    }
+    ArenaReset(mark);
+
+}
+
+/**
+ * Wylicza resztę z dzielenia wielomianu @f$a@f$ przez wielomian unormowany
+ * @f$x^m + d(x)@f$.
+ * @param[in] a : współczynniki dzielnej
+ * @param[in] la : liczba współczynników dzielnej
+ * @param[in] d : @p m najniższych współczynników dzielnika
+ * @param[in] m : stopień dzielnika, większy od zera
+ * @param[out] out : @p m współczynników reszty
+ */
+static void DenseRem(const uint64_t *a, size_t la, const uint64_t *d, size_t m,
+                     uint64_t *out) {
+
+    if (la <= m) {
+        memcpy(out, a, la * sizeof(uint64_t));
+        memset(out + la, FIRST_IDX, (m - la) * sizeof(uint64_t));
+        return;
+    }
+
+    ArenaMark mark = ArenaGetMark();
+    size_t k = la - m;
+    if (k < NEWTON_THRESHOLD || m < NEWTON_THRESHOLD) {
+        uint64_t *rest = (uint64_t *) ArenaAlloc(la * sizeof(uint64_t));
+        memcpy(rest, a, la * sizeof(uint64_t));
+        for (size_t i = la - ONE_ELEMENT; i >= m; i--) {
+            uint64_t c = rest[i];
+            for (size_t j = FIRST_IDX; j < m; j++) rest[i - m + j] -= c * d[j];
+        }
+        memcpy(out, rest, m * sizeof(uint64_t));
+        ArenaReset(mark);
+        return;
+    }
+
+    // Iloraz odwróconych wielomianów jest ilorazem ich szeregów potęgowych
+    // obciętym do k współczynników.
+    size_t rev_length = m + ONE_ELEMENT < k ? m + ONE_ELEMENT : k;
+    uint64_t *rev_d = (uint64_t *) ArenaAlloc(rev_length * sizeof(uint64_t));
+    rev_d[FIRST_IDX] = ONE_ELEMENT;
+    for (size_t i = ONE_ELEMENT; i < rev_length; i++) rev_d[i] = d[m - i];
+    uint64_t *inverse = (uint64_t *) ArenaAlloc(k * sizeof(uint64_t));
+    InverseSeries(rev_d, rev_length, k, inverse);
+    uint64_t *rev_a = (uint64_t *) ArenaAlloc(k * sizeof(uint64_t));
+    for (size_t i = FIRST_IDX; i < k; i++) rev_a[i] = a[la - ONE_ELEMENT - i];
+    uint64_t *product = (uint64_t *) ArenaAlloc((TWO * k + m) * sizeof(uint64_t));
+    DenseMul(rev_a, k, inverse, k, product);
+    uint64_t *quotient = (uint64_t *) ArenaAlloc(k * sizeof(uint64_t));
+    for (size_t i = FIRST_IDX; i < k; i++)
+        quotient[i] = product[k - ONE_ELEMENT - i];
+    // Składnik x^m dzielnika nie wpływa na m najniższych współczynników.
+    DenseMul(quotient, k, d, m, product);
+    for (size_t i = FIRST_IDX; i < m; i++) out[i] = a[i] - product[i];
+    ArenaReset(mark);
+
+}
+
+/**
+ * Wylicza schematem Hornera wartość wielomianu w punkcie.
+ * @param[in] coeffs : współczynniki wielomianu
+ * @param[in] len : liczba współczynników
+ * @param[in] x : punkt
+ * @return wartość wielomianu
+ */
+static uint64_t DenseHorner(const uint64_t *coeffs, size_t len, uint64_t x) {
+
+    uint64_t value = FIRST_IDX;
+    for (size_t i = len; i > FIRST_IDX; i--) value = value * x + coeffs[i - ONE_ELEMENT];
+    return value;
+
+}
+
+#ifdef HORNER_SIMD
+/**
+ * Mnoży modulo @f$2^{64}@f$ pola rejestrów AVX2. Rozkazy AVX2 mnożą tylko
+ * liczby 32-bitowe, więc iloczyn składamy z iloczynów połówek:
+ * @f$a b = a_l b_l + 2^{32} (a_h b_l + a_l b_h) \bmod 2^{64}@f$.
+ * @param[in] a : pierwszy czynnik
+ * @param[in] b : drugi czynnik
+ * @param[in] b_high : starsze połówki pól drugiego czynnika
+ * @return iloczyn
+ */
+__attribute__((target("avx2")))
+static inline __m256i MulAvx2(__m256i a, __m256i b, __m256i b_high) {
+
+    __m256i low = _mm256_mul_epu32(a, b);
+    __m256i cross = _mm256_add_epi64(
+            _mm256_mul_epu32(_mm256_srli_epi64(a, HALF_BITS), b),
+            _mm256_mul_epu32(a, b_high));
+    return _mm256_add_epi64(low, _mm256_slli_epi64(cross, HALF_BITS));
+
+}
+
+/**
+ * Wylicza schematem Hornera wartości wielomianu w punktach, po cztery
+ * punkty w rejestrze AVX2. Kilka rejestrów liczymy na przemian, żeby
+ * ukryć opóźnienie mnożenia. Pozostałe punkty liczy funkcja DenseHorner.
+ * @param[in] coeffs : współczynniki wielomianu
+ * @param[in] len : liczba współczynników
+ * @param[in] count : liczba punktów
+ * @param[in] xs : punkty
+ * @param[out] values : wartości wielomianu w punktach
+ */
+__attribute__((target("avx2")))
+static void HornerAvx2(const uint64_t *coeffs, size_t len, size_t count,
+                       const uint64_t *xs, uint64_t *values) {
+
+    size_t i = FIRST_IDX;
+    for (; i + SIMD_REGISTERS * AVX2_LANES <= count; i += SIMD_REGISTERS * AVX2_LANES) {
+        __m256i x[SIMD_REGISTERS], x_high[SIMD_REGISTERS], value[SIMD_REGISTERS];
+        for (size_t r = FIRST_IDX; r < SIMD_REGISTERS; r++) {
+            x[r] = _mm256_loadu_si256((const __m256i *) (xs + i + r * AVX2_LANES));
+            x_high[r] = _mm256_srli_epi64(x[r], HALF_BITS);
+            value[r] = _mm256_setzero_si256();
+        }
+        for (size_t k = len; k > FIRST_IDX; k--) {
+            __m256i coeff = _mm256_set1_epi64x((long long) coeffs[k - ONE_ELEMENT]);
+            for (size_t r = FIRST_IDX; r < SIMD_REGISTERS; r++) {
+                value[r] = _mm256_add_epi64(MulAvx2(value[r], x[r], x_high[r]),
+                                            coeff);
+            }
+        }
+        for (size_t r = FIRST_IDX; r < SIMD_REGISTERS; r++)
+            _mm256_storeu_si256((__m256i *) (values + i + r * AVX2_LANES), value[r]);
+    }
+    for (; i < count; i++) values[i] = DenseHorner(coeffs, len, xs[i]);
+
+}
+
+/**
+ * Wylicza schematem Hornera wartości wielomianu w punktach, po osiem
+ * punktów w rejestrze AVX-512. Kilka rejestrów liczymy na przemian, żeby
+ * ukryć opóźnienie mnożenia. Pozostałe punkty liczy funkcja DenseHorner.
+ * @param[in] coeffs : współczynniki wielomianu
+ * @param[in] len : liczba współczynników
+ * @param[in] count : liczba punktów
+ * @param[in] xs : punkty
+ * @param[out] values : wartości wielomianu w punktach
+ */
+__attribute__((target("avx512f,avx512dq")))
+static void HornerAvx512(const uint64_t *coeffs, size_t len, size_t count,
+                         const uint64_t *xs, uint64_t *values) {
+
+    size_t i = FIRST_IDX;
+    for (; i + SIMD_REGISTERS * AVX512_LANES <= count;
+         i += SIMD_REGISTERS * AVX512_LANES) {
+        __m512i x[SIMD_REGISTERS], value[SIMD_REGISTERS];
+        for (size_t r = FIRST_IDX; r < SIMD_REGISTERS; r++) {
+            x[r] = _mm512_loadu_si512((const void *) (xs + i + r * AVX512_LANES));
+            value[r] = _mm512_setzero_si512();
+        }
+        for (size_t k = len; k > FIRST_IDX; k--) {
+            __m512i coeff = _mm512_set1_epi64((long long) coeffs[k - ONE_ELEMENT]);
+            for (size_t r = FIRST_IDX; r < SIMD_REGISTERS; r++)
+                value[r] = _mm512_add_epi64(_mm512_mullo_epi64(value[r], x[r]), coeff);
+        }
+        for (size_t r = FIRST_IDX; r < SIMD_REGISTERS; r++)
+            _mm512_storeu_si512((void *) (values + i + r * AVX512_LANES), value[r]);
+    }
+    // Pozostałe punkty, których jest mniej niż pól we wszystkich rejestrach,
+    // liczy wersja AVX2.
+    HornerAvx2(coeffs, len, count - i, xs + i, values + i);
+
+}
+#endif
+
+size_t HornerBatchLanes(void) {
+
+#ifdef HORNER_SIMD
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq"))
+        return AVX512_LANES;
+    if (__builtin_cpu_supports("avx2")) return AVX2_LANES;
+#endif
+    return ONE_ELEMENT;
+
+}
+
+void HornerBatch(const uint64_t *coeffs, size_t len, size_t count,
+                 const uint64_t *xs, uint64_t *values) {
+
+    switch (HornerBatchLanes()) {
+#ifdef HORNER_SIMD
+        case AVX512_LANES:
+            HornerAvx512(coeffs, len, count, xs, values);
+            break;
+        case AVX2_LANES:
+            HornerAvx2(coeffs, len, count, xs, values);
+            break;
+#endif
+        default:
+            for (size_t i = FIRST_IDX; i < count; i++)
+                values[i] = DenseHorner(coeffs, len, xs[i]);
+    }
+
+}
+
+/**
+ * Wylicza iloczyny węzłów poddrzewa drzewa iloczynów.
+ * @param[in] arg : poddrzewo
+ */
+static void BuildProducts(void *arg) {
+
+    TreeJob *job = (TreeJob *) arg;
+    size_t lo = job -> lo;
+    size_t hi = job -> hi;
+    uint64_t *product = job -> levels[job -> depth] + lo;
+    if (hi - lo <= LEAF_POINTS) {
+        // Mnożymy kolejno przez x - x_j; współczynnik przy x^j jest równy jeden.
+        for (size_t j = FIRST_IDX; j < hi - lo; j++) {
+            uint64_t x = job -> xs[lo + j];
+            product[j] = (j > FIRST_IDX ? product[j - ONE_ELEMENT] : FIRST_IDX) - x;
+            for (size_t t = j - (j > FIRST_IDX); t > FIRST_IDX; t--)
+                product[t] = product[t - ONE_ELEMENT] - x * product[t];
+            if (j > FIRST_IDX) product[FIRST_IDX] = -x * product[FIRST_IDX];
+        }
+        return;
+    }
+
+    size_t mid = lo + (hi - lo) / TWO;
+    TreeJob left = *job;
+    left.depth++;
+    left.hi = mid;
+    TreeJob right = left;
+    right.lo = mid;
+    right.hi = hi;
+    if (hi - lo >= PARALLEL_POINTS) {
+        Task task;
+        TaskSpawn(&task, BuildProducts, &right);
+        BuildProducts(&left);
+        TaskWait(&task);
+    } else {
+        BuildProducts(&left);
+        BuildProducts(&right);
+    }
+
+    ArenaMark mark = ArenaGetMark();
+    size_t left_deg = mid - lo;
+    size_t right_deg = hi - mid;
+    uint64_t *left_poly = (uint64_t *) ArenaAlloc((left_deg + ONE_ELEMENT) *
+                                                  sizeof(uint64_t));
+    uint64_t *right_poly = (uint64_t *) ArenaAlloc((right_deg + ONE_ELEMENT) *
+                                                   sizeof(uint64_t));
+    uint64_t *full = (uint64_t *) ArenaAlloc((hi - lo + ONE_ELEMENT) *
+                                             sizeof(uint64_t));
+    memcpy(left_poly, job -> levels[left.depth] + lo, left_deg * sizeof(uint64_t));
+    left_poly[left_deg] = ONE_ELEMENT;
+    memcpy(right_poly, job -> levels[right.depth] + mid, right_deg * sizeof(uint64_t));
+    right_poly[right_deg] = ONE_ELEMENT;
+    DenseMul(left_poly, left_deg + ONE_ELEMENT, right_poly, right_deg + ONE_ELEMENT,
+             full);
+    memcpy(product, full, (hi - lo) * sizeof(uint64_t));
+    ArenaReset(mark);
+
+}
+
+/**
+ * Schodzi drzewem reszt: dzieli resztę węzła przez iloczyny jego synów,
+ * a w liściach wylicza wartości schematem Hornera.
+ * @param[in] arg : poddrzewo z resztą z dzielenia przez iloczyn węzła
+ */
+static void Descend(void *arg) {
+
+    TreeJob *job = (TreeJob *) arg;
+    size_t lo = job -> lo;
+    size_t hi = job -> hi;
+    if (hi - lo <= LEAF_POINTS) {
+        HornerBatch(job -> rem, hi - lo, hi - lo, job -> xs + lo, job -> values + lo);
+        return;
+    }
+
+    ArenaMark mark = ArenaGetMark();
+    size_t mid = lo + (hi - lo) / TWO;
+    TreeJob left = *job;
+    left.depth++;
+    left.hi = mid;
+    TreeJob right = left;
+    right.lo = mid;
+    right.hi = hi;
+    uint64_t *left_rem = (uint64_t *) ArenaAlloc((mid - lo) * sizeof(uint64_t));
+    uint64_t *right_rem = (uint64_t *) ArenaAlloc((hi - mid) * sizeof(uint64_t));
+    DenseRem(job -> rem, hi - lo, job -> levels[left.depth] + lo, mid - lo, left_rem);
+    DenseRem(job -> rem, hi - lo, job -> levels[right.depth] + mid, hi - mid,
+             right_rem);
+    left.rem = left_rem;
+    right.rem = right_rem;
+    if (hi - lo >= PARALLEL_POINTS) {
+        Task task;
+        TaskSpawn(&task, Descend, &right);
+        Descend(&left);
+        TaskWait(&task);
+    } else {
+        Descend(&left);
+        Descend(&right);
+    }
+    ArenaReset(mark);
+
+}
+
+void MultipointEval(const uint64_t *coeffs, size_t len, size_t count,
+                    const uint64_t *xs, uint64_t *values) {
+
+    assert(len > FIRST_IDX && count > FIRST_IDX);
+
+    ArenaMark mark = ArenaGetMark();
+    size_t depths = ONE_ELEMENT;
+    for (size_t n = count; n > LEAF_POINTS; n = (n + ONE_ELEMENT) / TWO) depths++;
+    uint64_t **levels = (uint64_t **) ArenaAlloc(depths * sizeof(uint64_t *));
+    for (size_t d = FIRST_IDX; d < depths; d++)
+        levels[d] = (uint64_t *) ArenaAlloc(count * sizeof(uint64_t));
+
+    TreeJob root = (TreeJob) {.levels = levels, .xs = xs, .values = values,
+                              .rem = NULL, .depth = FIRST_IDX,
+                              .lo = FIRST_IDX, .hi = count};
+    BuildProducts(&root);
+    uint64_t *rem = (uint64_t *) ArenaAlloc(count * sizeof(uint64_t));
+    DenseRem(coeffs, len, levels[FIRST_IDX], count, rem);
+    root.rem = rem;
+    Descend(&root);
+    ArenaReset(mark);
+
+}
@@ -0,0 +1,52 @@
+/** @file
+  Interfejs obliczania wartości wielomianu jednej zmiennej w wielu punktach
+  jednocześnie. Wielomian zapisany jest gęsto, jako tablica współczynników
+  przy kolejnych potęgach zmiennej. Wszystkie obliczenia są wykonywane
+  modulo @f$2^{64}@f$, tak jak obliczenia na współczynnikach wielomianów.
+  @author Julia Podrażka
+ */
+#ifndef MULTIPOINT_H
+#define MULTIPOINT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * Wylicza wartości wielomianu w punktach @p xs przy pomocy drzewa
+ * iloczynów @f$\prod (x - x_i)@f$ i drzewa reszt z dzielenia przez nie.
+ * Wartość w punkcie @f$x_i@f$ jest resztą z dzielenia wielomianu przez
+ * @f$x - x_i@f$, a dzielenie przez wielomian unormowany jest poprawne
+ * modulo @f$2^{64}@f$, więc wyniki są identyczne z wynikami schematu
+ * Hornera.
+ * @param[in] coeffs : współczynniki przy kolejnych potęgach zmiennej
+ * @param[in] len : liczba współczynników, większa od zera
+ * @param[in] count : liczba punktów, większa od zera
+ * @param[in] xs : punkty
+ * @param[out] values : wartości wielomianu w punktach
+ */
+void MultipointEval(const uint64_t *coeffs, size_t len, size_t count,
+                    const uint64_t *xs, uint64_t *values);
+
+/**
+ * Wylicza schematem Hornera wartości wielomianu w punktach @p xs.
+ * Na procesorach obsługujących rozkazy AVX2 lub AVX-512 wartości są liczone
+ * jednocześnie w kilku punktach, po jednym w każdym polu rejestru
+ * wektorowego; w pozostałych przypadkach punkt po punkcie. Wybór wersji
+ * następuje w czasie działania programu, a wyniki są zawsze te same.
+ * @param[in] coeffs : współczynniki przy kolejnych potęgach zmiennej
+ * @param[in] len : liczba współczynników
+ * @param[in] count : liczba punktów
+ * @param[in] xs : punkty
+ * @param[out] values : wartości wielomianu w punktach
+ */
+void HornerBatch(const uint64_t *coeffs, size_t len, size_t count,
+                 const uint64_t *xs, uint64_t *values);
+
+/**
+ * Zwraca liczbę punktów liczonych jednocześnie przez funkcję HornerBatch
+ * na tym procesorze.
+ * @return liczba pól rejestru wektorowego albo jeden
+ */
+size_t HornerBatchLanes(void);
+
+#endif
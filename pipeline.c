@@ -0,0 +1,218 @@
+/** @file
+  Implementacja potokowego wykonywania komend kalkulatora.
+  Paczki instrukcji i strony odroczonego wypisywania przechodzą między
+  wątkami przez kolejki, a opróżnione paczki i strony wracają osobnymi
+  kolejkami do ponownego użycia. Powroty nigdy nie czekają na miejsce
+  w kolejce, więc wątki nie mogą się zakleszczyć.
+  @author Julia Podrażka
+ */
+#include <stdlib.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "poly.h"
+#include "stack.h"
+#include "reader.h"
+#include "writer.h"
+#include "program.h"
+#include "arena.h"
+#include "mono_pool.h"
+#include "spsc_queue.h"
+#include "pipeline.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Liczba miejsc w kolejkach między wątkami. */
+#define QUEUE_SIZE 8
+/** Liczba instrukcji, po której paczka jest przekazywana do wykonania. */
+#define BATCH_INSTRUCTIONS 128
+/** Liczba znaków wierszy, po której paczka jest przekazywana do wykonania. */
+#define BATCH_BYTES (256 * 1024)
+
+/**
+ * To jest struktura przechowująca kolejki łączące wątki potoku.
+ */
+typedef struct Pipeline {
+    SpscQueue programs; ///< paczki instrukcji do wykonania
+    SpscQueue spare_programs; ///< wykonane paczki do ponownego użycia
+    SpscQueue pages; ///< strony do wypisania
+    SpscQueue spare_pages; ///< wypisane strony do ponownego użycia
+} Pipeline;
+
+/**
+ * Zwraca pustą paczkę instrukcji, w miarę możliwości wykonaną już
+ * wcześniej, żeby nie przydzielać od nowa tablic instrukcji i literałów.
+ * @param[in] pipeline : potok
+ * @return pusta paczka instrukcji
+ */
+static Program *TakeProgram(Pipeline *pipeline) {
+
+    void *item;
+    if (SpscQueueTryPop(&pipeline -> spare_programs, &item)) return (Program *) item;
+    Program *program = (Program *) malloc(sizeof(Program));
+    CHECK_PTR(program);
+    *program = ProgramInit();
+    return program;
+
+}
+
+/**
+ * Zwalnia paczkę instrukcji razem z jej pamięcią.
+ * @param[in] program : paczka instrukcji
+ */
+static void FreeProgram(Program *program) {
+
+    ProgramFree(program);
+    free(program);
+
+}
+
+/**
+ * Zwalnia stronę odroczonego wypisywania razem z jej pamięcią.
+ * @param[in] page : strona
+ */
+static void FreePage(WriterPage *page) {
+
+    WriterPageFree(page);
+    free(page);
+
+}
+
+/**
+ * Funkcja wątku parsującego. Kompiluje kolejne wiersze standardowego
+ * wejścia i przekazuje paczki instrukcji do wykonania. Paczka jest
+ * przekazywana, gdy jest duża albo gdy kolejny wiersz nie został jeszcze
+ * wczytany, więc przy pracy interaktywnej wyniki nie są opóźniane.
+ * Na końcu wejścia przekazuje NULL.
+ * @param[in] arg : potok
+ * @return NULL
+ */
+static void *ParseLines(void *arg) {
+
+    Pipeline *pipeline = (Pipeline *) arg;
+    Reader reader;
+    ReaderInit(&reader, STDIN_FILENO);
+
+    Program *program = NULL;
+    size_t bytes = FIRST_IDX;
+    size_t line_number = ONE_ELEMENT;
+    size_t line;
+    char *char_arr = ReadLine(&reader, &line);
+    while (char_arr != NULL) {
+        if (program == NULL) program = TakeProgram(pipeline);
+        ProgramCompileLine(program, &reader, char_arr, line, line_number);
+        bytes += line;
+        if (program -> code_count >= BATCH_INSTRUCTIONS || bytes >= BATCH_BYTES ||
+            !ReaderHasLine(&reader)) {
+            SpscQueuePush(&pipeline -> programs, program);
+            program = NULL;
+            bytes = FIRST_IDX;
+        }
+        char_arr = ReadLine(&reader, &line);
+        line_number++;
+    }
+    if (program != NULL) SpscQueuePush(&pipeline -> programs, program);
+    SpscQueuePush(&pipeline -> programs, NULL);
+
+    ReaderFree(&reader);
+    ArenaReleaseSpare();
+    return NULL;
+
+}
+
+/**
+ * Przekazuje wątkowi wypisującemu znaki i zapisy zebrane przez wątek
+ * wykonujący instrukcje.
+ * @param[in] writer : stan odroczonego wypisywania
+ * @param[in] arg : potok
+ */
+static void HandOffPage(Writer *writer, void *arg) {
+
+    Pipeline *pipeline = (Pipeline *) arg;
+    void *item;
+    WriterPage *page;
+    if (SpscQueueTryPop(&pipeline -> spare_pages, &item)) page = (WriterPage *) item;
+    else {
+        page = (WriterPage *) malloc(sizeof(WriterPage));
+        CHECK_PTR(page);
+        WriterPageInit(page);
+    }
+    WriterSwapPage(writer, page);
+    SpscQueuePush(&pipeline -> pages, page);
+
+}
+
+/**
+ * Funkcja wątku wypisującego. Wypisuje kolejne strony na standardowe
+ * wyjście, aż dostanie NULL.
+ * @param[in] arg : potok
+ * @return NULL
+ */
+static void *WriteOutput(void *arg) {
+
+    Pipeline *pipeline = (Pipeline *) arg;
+    Writer *writer = StdoutWriter();
+    WriterPage *page;
+    while ((page = (WriterPage *) SpscQueuePop(&pipeline -> pages)) != NULL) {
+        WriterReplay(writer, page);
+        if (!SpscQueueTryPush(&pipeline -> spare_pages, page)) FreePage(page);
+    }
+    WriterFlush(writer);
+
+    ArenaReleaseSpare();
+    return NULL;
+
+}
+
+void PipelineRun(void) {
+
+    Pipeline pipeline;
+    SpscQueueInit(&pipeline.programs, QUEUE_SIZE);
+    SpscQueueInit(&pipeline.spare_programs, QUEUE_SIZE);
+    SpscQueueInit(&pipeline.pages, QUEUE_SIZE);
+    SpscQueueInit(&pipeline.spare_pages, QUEUE_SIZE);
+    // Wielomiany powstają w wątku parsującym, a są usuwane także w wątku
+    // wypisującym.
+    MonoPoolEnableLocking();
+    // Wątek wypisujący zaczyna od wypisywania na standardowe wyjście, więc
+    // przygotowujemy je przed jego uruchomieniem.
+    StdoutWriter();
+
+    pthread_t parser, printer;
+    if (pthread_create(&parser, NULL, ParseLines, &pipeline) != 0 ||
+        pthread_create(&printer, NULL, WriteOutput, &pipeline) != 0) exit(1);
+
+    Writer writer;
+    WriterInitDeferred(&writer, HandOffPage, &pipeline);
+    StdoutRedirect(&writer);
+    stack s = InitStack();
+    Program *program;
+    while ((program = (Program *) SpscQueuePop(&pipeline.programs)) != NULL) {
+        ProgramRunAndClear(program, &s);
+        // Wyniki paczki przekazujemy od razu, żeby przy pracy interaktywnej
+        // nie czekały na kolejne wiersze.
+        WriterFlush(&writer);
+        if (!SpscQueueTryPush(&pipeline.spare_programs, program))
+            FreeProgram(program);
+    }
+    RemoveStack(&s);
+    WriterFlush(&writer);
+    SpscQueuePush(&pipeline.pages, NULL);
+    pthread_join(parser, NULL);
+    pthread_join(printer, NULL);
+    StdoutRedirect(NULL);
+    WriterFree(&writer);
+
+    void *item;
+    while (SpscQueueTryPop(&pipeline.spare_programs, &item))
+        FreeProgram((Program *) item);
+    while (SpscQueueTryPop(&pipeline.spare_pages, &item))
+        FreePage((WriterPage *) item);
+    SpscQueueFree(&pipeline.programs);
+    SpscQueueFree(&pipeline.spare_programs);
+    SpscQueueFree(&pipeline.pages);
+    SpscQueueFree(&pipeline.spare_pages);
+
+}
@@ -0,0 +1,20 @@
+/** @file
+  Interfejs potokowego wykonywania komend kalkulatora.
+  Wejście jest przetwarzane przez trzy wątki połączone ograniczonymi
+  kolejkami: wątek parsujący kompiluje kolejne wiersze do paczek
+  instrukcji, wątek główny wykonuje je na stosie, a wątek wypisujący
+  wypisuje wyniki. Wynik na standardowym wyjściu i błędy na standardowym
+  wyjściu błędów są takie same, jak przy wykonywaniu komend po kolei.
+  @author Julia Podrażka
+ */
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+/**
+ * Wczytuje, kompiluje i wykonuje komendy ze standardowego wejścia
+ * potokiem trzech wątków. Bieżący wątek wykonuje instrukcje, więc może
+ * korzystać z puli wątków.
+ */
+void PipelineRun(void);
+
+#endif
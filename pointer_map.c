@@ -0,0 +1,144 @@
+/** @file
+  Implementacja tablicy mieszającej odwzorowującej wskaźniki na liczby.
+  @author Julia Podrażka
+ */
+#include <stdlib.h>
+
+#include "poly.h"
+#include "pointer_map.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Początkowy rozmiar tablicy. */
+#define INITIAL_CAPACITY 64
+/** Stała mnożenia przy mieszaniu wskaźników. */
+#define HASH_MUL 0x9e3779b97f4a7c15ULL
+/** Liczba bitów skrótu. */
+#define HASH_BITS 64
+/** Liczba najmłodszych bitów wskaźnika, które są zwykle zerami. */
+#define ALIGNMENT_BITS 4
+
+/** Znacznik usuniętego wpisu. */
+static const char TOMBSTONE;
+
+/**
+ * Wylicza miejsce, od którego zaczyna się szukanie klucza.
+ * @param[in] map : tablica o niezerowym rozmiarze
+ * @param[in] key : klucz
+ * @return indeks miejsca
+ */
+static size_t Slot(const PointerMap *map, const void *key) {
+
+    uint64_t hash = ((uint64_t) (uintptr_t) key >> ALIGNMENT_BITS) * HASH_MUL;
+    return (size_t) (hash >> (HASH_BITS / 2)) & (map -> capacity - ONE_ELEMENT);
+
+}
+
+/**
+ * Wyszukuje miejsce klucza.
+ * @param[in] map : tablica
+ * @param[in] key : klucz
+ * @return indeks miejsca klucza albo rozmiar tablicy, jeśli klucza nie ma
+ */
+static size_t FindSlot(const PointerMap *map, const void *key) {
+
+    if (map -> capacity == FIRST_IDX) return map -> capacity;
+    for (size_t i = Slot(map, key); map -> keys[i] != NULL;
+         i = (i + ONE_ELEMENT) & (map -> capacity - ONE_ELEMENT)) {
+        if (map -> keys[i] == key) return i;
+    }
+    return map -> capacity;
+
+}
+
+/**
+ * Przenosi wpisy do nowej tablicy tak, żeby wpisy i znaczniki zajmowały
+ * co najwyżej połowę miejsc po dodaniu kolejnego wpisu.
+ * @param[in] map : tablica
+ */
+static void Rehash(PointerMap *map) {
+
+    size_t capacity = map -> capacity == FIRST_IDX ? INITIAL_CAPACITY
+                                                    : map -> capacity;
+    while (2 * (map -> count + ONE_ELEMENT) > capacity) capacity *= 2;
+    PointerMap rehashed = (PointerMap) {.capacity = capacity, .count = map -> count,
+                                        .filled = map -> count};
+    rehashed.keys = (const void **) calloc(capacity, sizeof(const void *));
+    CHECK_PTR(rehashed.keys);
+    rehashed.values = (int64_t *) malloc(capacity * sizeof(int64_t));
+    CHECK_PTR(rehashed.values);
+    for (size_t i = FIRST_IDX; i < map -> capacity; i++) {
+        if (map -> keys[i] == NULL || map -> keys[i] == &TOMBSTONE) continue;
+        size_t slot = Slot(&rehashed, map -> keys[i]);
+        while (rehashed.keys[slot] != NULL) slot = (slot + ONE_ELEMENT) & (capacity - ONE_ELEMENT);
+        rehashed.keys[slot] = map -> keys[i];
+        rehashed.values[slot] = map -> values[i];
+    }
+    PointerMapFree(map);
+    *map = rehashed;
+
+}
+
+PointerMap PointerMapInit(void) {
+
+    return (PointerMap) {.keys = NULL, .values = NULL, .capacity = FIRST_IDX,
+                         .count = FIRST_IDX, .filled = FIRST_IDX};
+
+}
+
+void PointerMapFree(PointerMap *map) {
+
+    free(map -> keys);
+    free(map -> values);
+    *map = PointerMapInit();
+
+}
+
+bool PointerMapFind(const PointerMap *map, const void *key, int64_t *value) {
+
+    size_t slot = FindSlot(map, key);
+    if (slot == map -> capacity) return false;
+    *value = map -> values[slot];
+    return true;
+
+}
+
+void PointerMapSet(PointerMap *map, const void *key, int64_t value) {
+
+    size_t slot = FindSlot(map, key);
+    if (slot != map -> capacity) {
+        map -> values[slot] = value;
+        return;
+    }
+    if (2 * (map -> filled + ONE_ELEMENT) > map -> capacity) Rehash(map);
+    slot = Slot(map, key);
+    while (map -> keys[slot] != NULL && map -> keys[slot] != &TOMBSTONE)
+        slot = (slot + ONE_ELEMENT) & (map -> capacity - ONE_ELEMENT);
+    if (map -> keys[slot] == NULL) map -> filled++;
+    map -> keys[slot] = key;
+    map -> values[slot] = value;
+    map -> count++;
+
+}
+
+bool PointerMapErase(PointerMap *map, const void *key) {
+
+    size_t slot = FindSlot(map, key);
+    if (slot == map -> capacity) return false;
+    map -> keys[slot] = &TOMBSTONE;
+    map -> count--;
+    return true;
+
+}
+
+bool PointerMapEntry(const PointerMap *map, size_t idx, const void **key,
+                     int64_t *value) {
+
+    if (map -> keys[idx] == NULL || map -> keys[idx] == &TOMBSTONE) return false;
+    *key = map -> keys[idx];
+    *value = map -> values[idx];
+    return true;
+
+}
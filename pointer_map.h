@@ -0,0 +1,76 @@
+/** @file
+  Interfejs tablicy mieszającej odwzorowującej wskaźniki na liczby.
+  Wpisy przechowywane są w tablicy z adresowaniem otwartym, a usunięte
+  wpisy zostawiają znacznik, więc usuwanie nie przesuwa innych wpisów.
+  Pamięć tablicy przydzielana jest bezpośrednio funkcjami biblioteki
+  standardowej, więc tablicy można używać wewnątrz rozliczania pamięci.
+  @author Julia Podrażka
+ */
+#ifndef POINTER_MAP_H
+#define POINTER_MAP_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * To jest struktura przechowująca tablicę mieszającą.
+ */
+typedef struct PointerMap {
+    const void **keys; ///< klucze, NULL dla wolnego miejsca
+    int64_t *values; ///< wartości
+    size_t capacity; ///< rozmiar tablicy, będący potęgą dwójki lub zerem
+    size_t count; ///< liczba wpisów
+    size_t filled; ///< liczba wpisów i znaczników usuniętych wpisów
+} PointerMap;
+
+/**
+ * Tworzy pustą tablicę mieszającą.
+ * @return pusta tablica
+ */
+PointerMap PointerMapInit(void);
+
+/**
+ * Usuwa tablicę mieszającą z pamięci.
+ * @param[in] map : tablica
+ */
+void PointerMapFree(PointerMap *map);
+
+/**
+ * Wyszukuje wartość klucza.
+ * @param[in] map : tablica
+ * @param[in] key : klucz różny od NULL
+ * @param[out] value : wartość klucza, jeśli został znaleziony
+ * @return Czy klucz jest w tablicy?
+ */
+bool PointerMapFind(const PointerMap *map, const void *key, int64_t *value);
+
+/**
+ * Ustawia wartość klucza, dodając go do tablicy, jeśli go w niej nie ma.
+ * @param[in] map : tablica
+ * @param[in] key : klucz różny od NULL
+ * @param[in] value : wartość
+ */
+void PointerMapSet(PointerMap *map, const void *key, int64_t value);
+
+/**
+ * Usuwa klucz z tablicy.
+ * @param[in] map : tablica
+ * @param[in] key : klucz różny od NULL
+ * @return Czy klucz był w tablicy?
+ */
+bool PointerMapErase(PointerMap *map, const void *key);
+
+/**
+ * Odczytuje wpis z miejsca @p idx tablicy. Przejście po miejscach od zera
+ * do `capacity - 1` odwiedza wszystkie wpisy.
+ * @param[in] map : tablica
+ * @param[in] idx : indeks miejsca
+ * @param[out] key : klucz wpisu
+ * @param[out] value : wartość wpisu
+ * @return Czy w miejscu @p idx jest wpis?
+ */
+bool PointerMapEntry(const PointerMap *map, size_t idx, const void **key,
+                     int64_t *value);
+
+#endif
@@ -11,8 +11,20 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <stdint.h>
+#include <pthread.h>
 
 #include "poly.h"
+#include "arena.h"
+#include "mono_pool.h"
+#include "intern.h"
+#include "thread_pool.h"
+#include "multipoint.h"
+#include "memory_budget.h"
+#include "pointer_map.h"
+#include "trace.h"
 
 /** Pierwszy indeks w tablicy. */
 #define FIRST_IDX 0
@@ -45,48 +57,79 @@
 #define PARITY 0
 /** Początkowy rozmiar tablicy. */
 #define ARR_SIZE 2
+/** Liczba iloczynów jednomianów, od której mnożymy wielomiany przy pomocy kopca. */
+#define HEAP_MUL_THRESHOLD 64
+/** Iloczyn liczb współczynników stałych, od którego mnożymy równolegle. */
+#define PARALLEL_MUL_WORK (1 << 14)
+/** Liczba fragmentów iloczynu przypadających na wątek przy mnożeniu równoległym. */
+#define MUL_CHUNKS_PER_THREAD 4
+/** Liczba próbkowanych jednomianów drugiego czynnika na jednomian pierwszego. */
+#define MUL_SAMPLES_PER_ROW 16
+/** Maksymalna łączna liczba współczynników stałych potęg zapamiętanych
+ * w jednym wywołaniu funkcji PolyCompose. */
+#define POWER_CACHE_MAX_TERMS (1 << 20)
+/** Maksymalny stosunek stopnia do liczby jednomianów, przy którym złożenie
+ * liczymy schematem Hornera. */
+#define HORNER_MAX_SPREAD 2
+/** Minimalna liczba punktów i współczynników, dla której wartości wielomianu
+ * liczymy drzewem reszt, jeśli schemat Hornera liczy jeden punkt naraz.
+ * Przy liczeniu wielu punktów naraz próg mnożymy przez kwadrat ich liczby,
+ * co uzasadnia komentarz w funkcji UseMultipoint. */
+#define MULTIPOINT_MIN_POINTS 4096
+/** Maksymalny stosunek stopnia wielomianu do liczby punktów, przy którym
+ * wartości wielomianu liczymy drzewem reszt. */
+#define MULTIPOINT_MAX_SPREAD 4
 
 void PolyDestroy(Poly *p) {
 
     assert(p != NULL);
 
-    if (!PolyIsCoeff(p)) {
+    // Tablica jednomianów może być współdzielona z innymi wielomianami,
+    // więc usuwamy ją dopiero po zwolnieniu ostatniego odwołania.
+    if (PolyIsCoeff(p)) return;
+    bool last = InternIsShared(p -> arr) ? InternRelease(p)
+                                         : MonoArrRelease(p -> arr);
+    if (last) {
         for (size_t i = FIRST_IDX; i < p -> size; i++) {
             MonoDestroy(&(p -> arr[i]));
         }
-        free(p -> arr);
+        MonoArrFree(p -> arr);
     }
 
 }
 
 /**
  * Zwraca wielomian, którego tablica jednomianów to @p mono_arr z
- * usuniętymi wielomianami zerowymi
+ * usuniętymi wielomianami zerowymi. Przejmuje na własność zawartość tablicy
+ * @p mono_arr, ale nie samą tablicę, która zwykle pochodzi z areny.
+ * Tablica jednomianów wyniku jest przydzielana z puli w dokładnym rozmiarze.
  * @param[in] current_idx : rozmiar tablicy @p mono_arr
  * @param[in] mono_arr : tablica jednomianów
  * @return wielomian z tablicą jednomianów @p mono_arr bez zerowych wielomianów
  */
-static Poly DeletePolyZero(size_t current_idx, Mono **mono_arr) {
+static Poly DeletePolyZero(size_t current_idx, Mono *mono_arr) {
 
-    Mono *final_arr = (Mono *) malloc(current_idx * sizeof(Mono));
-    CHECK_PTR(final_arr);
-    int new_size = FIRST_IDX - ONE_ELEMENT;
+    TRACE_PROBE(delete_zero__start, current_idx);
+    uint64_t start = TraceBegin();
+    size_t new_size = FIRST_IDX;
     for (size_t i = FIRST_IDX; i < current_idx; i++) {
-        if (!PolyIsZero(&(*mono_arr)[i].p)) {
-            new_size++;
-            final_arr[new_size] = (*mono_arr)[i];
-        } else MonoDestroy(&(*mono_arr)[i]);
-    }
-    free(*mono_arr);
-    int first_size = FIRST_IDX - ONE_ELEMENT;
-    if (new_size == first_size) {
-        free(final_arr);
-        return PolyZero();
+        if (!PolyIsZero(&mono_arr[i].p)) new_size++;
+    }
+    Poly new_poly = PolyZero();
+    if (new_size == FIRST_IDX) {
+        for (size_t i = FIRST_IDX; i < current_idx; i++) MonoDestroy(&mono_arr[i]);
+    } else {
+        Mono *final_arr = MonoArrAlloc(new_size);
+        size_t final_idx = FIRST_IDX;
+        for (size_t i = FIRST_IDX; i < current_idx; i++) {
+            if (!PolyIsZero(&mono_arr[i].p)) final_arr[final_idx++] = mono_arr[i];
+            else MonoDestroy(&mono_arr[i]);
+        }
+        new_poly = InternPoly((Poly) {.size = new_size, .arr = final_arr});
     }
-    new_size += ONE_ELEMENT;
-    final_arr = realloc(final_arr, new_size * sizeof(Mono));
-    CHECK_PTR(final_arr);
-    return (Poly) {.size = new_size, .arr = final_arr};
+    TraceEnd(TRACE_DELETE_ZERO, start, current_idx);
+    TRACE_PROBE(delete_zero__done, current_idx, new_size);
+    return new_poly;
 
 }
 
@@ -98,9 +141,10 @@ static Poly DeletePolyZero(size_t current_idx, Mono **mono_arr) {
  */
 static Poly PolyCloneAndMultiplyByScalar(const Poly *p, poly_coeff_t scalar) {
 
+    if (scalar == CLONE) return PolyClone(p);
     if (!PolyIsCoeff(p)) {
-        Mono *new_monos = (Mono *) malloc(p -> size * sizeof(Mono));
-        CHECK_PTR(new_monos);
+        ArenaMark mark = ArenaGetMark();
+        Mono *new_monos = (Mono *) ArenaAlloc(p -> size * sizeof(Mono));
         for (size_t i = FIRST_IDX; i < p -> size; i++) {
             Mono mono = p -> arr[i];
             Poly new_poly = PolyCloneAndMultiplyByScalar(&mono.p, scalar);
@@ -108,17 +152,22 @@ static Poly PolyCloneAndMultiplyByScalar(const Poly *p, poly_coeff_t scalar) {
                 new_monos[i] = (Mono) {.p = new_poly, .exp = mono.exp};
             } else new_monos[i] = (Mono) {.p = new_poly, .exp = EXP_ZERO};
         }
-        return DeletePolyZero(p -> size, &new_monos);
+        Poly new_poly = DeletePolyZero(p -> size, new_monos);
+        ArenaReset(mark);
+        return new_poly;
     } else return PolyFromCoeff(scalar * (p -> coeff));
 
 }
 
 Poly PolyClone(const Poly *p) {
 
-    return PolyCloneAndMultiplyByScalar(p, CLONE);
+    if (!PolyIsCoeff(p)) MonoArrRetain(p -> arr);
+    return *p;
 
 }
 
+static Poly AddPolys(const Poly *p, const Poly *q);
+
 /**
  * Dodaje wielomian stały do wielomianu niestałego
  * @param[in] p : wielomian stały @f$p@f$
@@ -129,7 +178,9 @@ static Poly AddPolyAndCoeff(const Poly *p, const Poly *q) {
 
     Mono new_mono = MonoFromPoly(p, EXP_ZERO);
     Poly new_poly = (Poly) {.size = ONE_ELEMENT, .arr = &new_mono};
-    return PolyAdd(q, &new_poly);
+    // Tablica new_mono leży na stosie, więc omijamy pamięć podręczną wyników,
+    // która odczytuje nagłówki tablic jednomianów.
+    return AddPolys(q, &new_poly);
 
 }
 
@@ -151,7 +202,13 @@ static void CopyRemainingMonos(size_t counter, const Poly *p,
 
 }
 
-Poly PolyAdd(const Poly *p, const Poly *q) {
+/**
+ * Dodaje dwa wielomiany bez korzystania z pamięci podręcznej wyników.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p + q@f$
+ */
+static Poly AddPolys(const Poly *p, const Poly *q) {
 
     if (PolyIsCoeff(p) && PolyIsCoeff(q))
         return PolyFromCoeff(p->coeff + q->coeff);
@@ -161,9 +218,9 @@ Poly PolyAdd(const Poly *p, const Poly *q) {
         size_t p_counter = FIRST_IDX;
         size_t q_counter = FIRST_IDX;
         size_t current_mono_arr_size = p -> size + q -> size;
+        ArenaMark mark = ArenaGetMark();
         Mono *mono_arr =
-                (Mono *) malloc(current_mono_arr_size * sizeof(Mono));
-        CHECK_PTR(mono_arr);
+                (Mono *) ArenaAlloc(current_mono_arr_size * sizeof(Mono));
         size_t current_idx = FIRST_IDX;
         while(p_counter < p -> size && q_counter < q -> size) {
             Mono p_mono = p -> arr[p_counter];
@@ -189,11 +246,23 @@ Poly PolyAdd(const Poly *p, const Poly *q) {
         }
         CopyRemainingMonos(p_counter, p, &mono_arr, &current_idx);
         CopyRemainingMonos(q_counter, q, &mono_arr, &current_idx);
-        return DeletePolyZero(current_idx, &mono_arr);
+        Poly new_poly = DeletePolyZero(current_idx, mono_arr);
+        ArenaReset(mark);
+        return new_poly;
     }
 
 }
 
+Poly PolyAdd(const Poly *p, const Poly *q) {
+
+    Poly result;
+    if (InternMemoFind(INTERN_ADD, p, q, &result)) return result;
+    result = AddPolys(p, q);
+    InternMemoStore(INTERN_ADD, p, q, &result);
+    return result;
+
+}
+
 /**
  * Porównuje wykładniki jednomianów
  * @param[in] arr1 : pierwsza tablica jednomianów do porównania
@@ -210,93 +279,41 @@ static int CompareMonos(const void *arr1, const void *arr2) {
 
 }
 
-/**
- * Tworzy jednomian o współczynniku @p new_poly i zapisuje go do tablicy @p
- * final_arr, jeśli jest niezerowy.
- * @param[in] new_poly : wielomian @f$p@f$
- * @param[in] final_arr : tablica jednomianów
- * @param[in] final_arr_counter : rozmiar tablicy jednomianów
- * @param[in] i : indeks tablicy @p mono_arr
- * @param[in] mono_arr : tablica jednomianów
- */
-static void AddPolyToArray(Poly new_poly, Mono **final_arr, int *final_arr_counter,
-                           size_t i, Mono *mono_arr) {
-
-    if (!PolyIsZero(&new_poly)) {
-        (*final_arr)[*final_arr_counter] = MonoFromPoly(&new_poly, mono_arr[i].exp);
-    } else {
-        PolyDestroy(&new_poly);
-        (*final_arr_counter)--;
-    }
-    MonoDestroy(&mono_arr[i]);
-
-}
-
-/**
- * Zapisuje jednomian z tablicy @p monos do tablicy @p final_arr, jeśli
- * współczynnik jednomianu jest niezerowy.
- * @param[in] monos : tablica jednomianów
- * @param[in] i : indeks tablicy @p monos
- * @param[in] final_arr : tablica jednomianów
- * @param[in] final_arr_counter : rozmiar tablicy jednomianów
- */
-static void AddMonoToArray(Mono *monos, size_t i, Mono **final_arr,
-                           int *final_arr_counter) {
-
-    if (PolyIsZero(&monos[i].p)) {
-        MonoDestroy(&monos[i]);
-        (*final_arr_counter)--;
-    } else (*final_arr)[*final_arr_counter] = monos[i];
-
-}
-
 /**
  * Sumuje listę jednomianów i tworzy z nich wielomian. Przejmuje na własność
- * pamięć wskazywaną przez @p monos i jej zawartość.
+ * zawartość tablicy @p monos, ale nie samą tablicę, którą może dowolnie
+ * modyfikować. Jednomiany są sortowane, a jednomiany o równych wykładnikach
+ * sumowane w miejscu.
  * @param[in] count : liczba jednomianów
  * @param[in] monos : tablica jednomianów
  * @return wielomian będący sumą jednomianów
  */
 static Poly AddMonos(size_t count, Mono *monos) {
 
-    Mono *final_arr = (Mono *) malloc(count * sizeof(Mono));
-    CHECK_PTR(final_arr);
-
+    TRACE_PROBE(sort__start, count);
+    uint64_t start = TraceBegin();
     qsort(monos, count, sizeof(Mono), CompareMonos);
+    TraceEnd(TRACE_SORT, start, count);
+    TRACE_PROBE(sort__done, count);
 
-    size_t i = FIRST_IDX;
-    int final_arr_counter = FIRST_IDX;
-    while (i < count) {
-        // Porównujemy wykładniki sąsiednich jednomianów, jeśli takie istnieją
-        // i tablica final_arr jest pusta.
-        if (i != count - ONE_ELEMENT && final_arr_counter == FIRST_IDX &&
-            monos[i].exp == monos[i + ONE_ELEMENT].exp) {
-            Poly new_poly =
-                    PolyAdd(&monos[i].p, &monos[i + ONE_ELEMENT].p);
-            AddPolyToArray(new_poly, &final_arr, &final_arr_counter, i, monos);
-            MonoDestroy(&monos[i + ONE_ELEMENT]);
-            i++;
-        } else if (final_arr_counter == FIRST_IDX)
-            AddMonoToArray(monos, i, &final_arr, &final_arr_counter);
-        else if (monos[i].exp == final_arr[final_arr_counter - ONE_ELEMENT].exp) {
-            final_arr_counter--;
-            Poly new_poly =
-                    PolyAdd(&monos[i].p, &final_arr[final_arr_counter].p);
-            MonoDestroy(&final_arr[final_arr_counter]);
-            AddPolyToArray(new_poly, &final_arr, &final_arr_counter, i, monos);
-        } else AddMonoToArray(monos, i, &final_arr, &final_arr_counter);
-        i++;
-        final_arr_counter++;
+    TRACE_PROBE(merge__start, count);
+    start = TraceBegin();
+    size_t merged = FIRST_IDX;
+    for (size_t i = FIRST_IDX; i < count; i++) {
+        // Po posortowaniu jednomiany o równych wykładnikach sąsiadują ze sobą,
+        // więc dodajemy je do ostatniego zapisanego jednomianu.
+        if (merged != FIRST_IDX &&
+            monos[merged - ONE_ELEMENT].exp == monos[i].exp) {
+            Poly new_poly = PolyAdd(&monos[merged - ONE_ELEMENT].p, &monos[i].p);
+            MonoDestroy(&monos[merged - ONE_ELEMENT]);
+            MonoDestroy(&monos[i]);
+            monos[merged - ONE_ELEMENT].p = new_poly;
+        } else monos[merged++] = monos[i];
     }
+    TraceEnd(TRACE_MERGE, start, count);
+    TRACE_PROBE(merge__done, count, merged);
 
-    free(monos);
-    if (final_arr_counter == FIRST_IDX) {
-        free(final_arr);
-        return PolyZero();
-    }
-    final_arr = realloc(final_arr, final_arr_counter * sizeof(Mono));
-    CHECK_PTR(final_arr);
-    return (Poly) {.size = final_arr_counter, .arr = final_arr};
+    return DeletePolyZero(merged, monos);
 
 }
 
@@ -306,7 +323,9 @@ Poly PolyOwnMonos(size_t count, Mono *monos) {
         if (monos != NULL) free(monos);
         return PolyZero();
     }
-    return AddMonos(count, monos);
+    Poly new_poly = AddMonos(count, monos);
+    free(monos);
+    return new_poly;
 
 }
 
@@ -322,15 +341,17 @@ static Poly CopyAddMonos(size_t count, const Mono monos[], bool clone) {
 
     if (count == FIRST_IDX || monos == NULL) return PolyZero();
 
-    Mono *mono_arr = (Mono *) malloc(count * sizeof(Mono));
-    CHECK_PTR(mono_arr);
+    ArenaMark mark = ArenaGetMark();
+    Mono *mono_arr = (Mono *) ArenaAlloc(count * sizeof(Mono));
 
     for (size_t i = FIRST_IDX; i < count; i++) {
         if (clone) mono_arr[i] = MonoClone(&monos[i]);
         else mono_arr[i] = monos[i];
     }
 
-    return AddMonos(count, mono_arr);
+    Poly new_poly = AddMonos(count, mono_arr);
+    ArenaReset(mark);
+    return new_poly;
 
 }
 
@@ -346,17 +367,360 @@ Poly PolyAddMonos(size_t count, const Mono monos[]) {
 
 }
 
-Poly PolyMul(const Poly *p, const Poly *q) {
+Poly PolyFromSortedMonos(size_t count, const Mono monos[]) {
+
+    if (count == FIRST_IDX) return PolyZero();
+    Mono *mono_arr = MonoArrAlloc(count);
+    for (size_t i = FIRST_IDX; i < count; i++) mono_arr[i] = monos[i];
+    return InternPoly((Poly) {.size = count, .arr = mono_arr});
+
+}
+
+/**
+ * Realokuje tablicę @p mono_arr przydzieloną z areny, jeśli jest taka potrzeba
+ * @param[in] mono_arr : tablica jednomianów
+ * @param[in] current_size : aktualny rozmiar tablicy @p mono_arr
+ * @param[in] current_idx : aktualny indeks tablicy @p mono_arr
+ */
+static void ArrayRealloc(Mono **mono_arr, size_t *current_size, size_t current_idx) {
+
+    if (current_idx >= *current_size) {
+        *mono_arr = ArenaRealloc(*mono_arr, (*current_size) * sizeof(Mono),
+                                 (*current_size) * ARR_SIZE * sizeof(Mono));
+        *current_size = (*current_size) * ARR_SIZE;
+    }
+
+}
+
+/**
+ * Dodaje jednomian @p mono do tablicy @p mono_arr pod indeksem @p mono_arr_idx
+ * @param[in] mono_arr : tablica jednomianów
+ * @param[in] mono_arr_size : rozmiar tablicy @p mono_arr
+ * @param[in] mono_arr_idx : indeks tablicy @p mono_arr
+ * @param[in] mono : jednomian
+ */
+static void AddMonoToDynamicArray(Mono **mono_arr, size_t *mono_arr_size,
+                           size_t *mono_arr_idx, Mono mono) {
+
+    ArrayRealloc(mono_arr, mono_arr_size, *mono_arr_idx);
+    (*mono_arr)[*mono_arr_idx] = mono;
+    (*mono_arr_idx)++;
+
+}
+
+/**
+ * To jest struktura przechowująca element kopca używanego przy mnożeniu
+ * wielomianów. Reprezentuje iloczyn jednomianu o indeksie @p i z krótszego
+ * wielomianu i jednomianu o indeksie @p j z dłuższego wielomianu.
+ */
+typedef struct HeapEntry {
+    poly_exp_t exp; ///< suma wykładników jednomianów
+    size_t i; ///< indeks jednomianu w krótszym wielomianie
+    size_t j; ///< indeks jednomianu w dłuższym wielomianie
+} HeapEntry;
+
+/**
+ * Sprawdza, czy element kopca powinien zostać zdjęty przed innym. Iloczyny
+ * o równych wykładnikach zdejmowane są w kolejności rosnących indeksów
+ * @p i, więc kolejność ich sumowania nie zależy od kształtu kopca.
+ * @param[in] a : pierwszy element kopca
+ * @param[in] b : drugi element kopca
+ * @return Czy element @p a poprzedza element @p b?
+ */
+static bool HeapBefore(HeapEntry a, HeapEntry b) {
+
+    return a.exp > b.exp || (a.exp == b.exp && a.i < b.i);
+
+}
+
+/**
+ * Przesuwa element kopca o indeksie @p idx w dół, aż kopiec będzie
+ * poprawnym kopcem względem kolejności HeapBefore.
+ * @param[in] heap : tablica z kopcem
+ * @param[in] heap_size : liczba elementów kopca
+ * @param[in] idx : indeks przesuwanego elementu
+ */
+static void HeapSiftDown(HeapEntry *heap, size_t heap_size, size_t idx) {
+
+    HeapEntry entry = heap[idx];
+    while (TWO * idx + ONE_ELEMENT < heap_size) {
+        size_t child = TWO * idx + ONE_ELEMENT;
+        if (child + ONE_ELEMENT < heap_size &&
+            HeapBefore(heap[child + ONE_ELEMENT], heap[child])) child++;
+        if (!HeapBefore(heap[child], entry)) break;
+        heap[idx] = heap[child];
+        idx = child;
+    }
+    heap[idx] = entry;
+
+}
+
+/**
+ * Zwraca indeks pierwszego jednomianu wielomianu @p p o wykładniku nie
+ * większym niż @p exp.
+ * @param[in] p : wielomian niestały
+ * @param[in] exp : wykładnik
+ * @return indeks jednomianu lub rozmiar wielomianu, jeśli takiego nie ma
+ */
+static size_t FirstMonoAtMost(const Poly *p, long long exp) {
+
+    size_t low = FIRST_IDX;
+    size_t high = p -> size;
+    while (low < high) {
+        size_t middle = low + (high - low) / TWO;
+        if (MonoGetExp(&p -> arr[middle]) > exp) low = middle + ONE_ELEMENT;
+        else high = middle;
+    }
+    return low;
+
+}
+
+/**
+ * Mnoży dwa wielomiany niestałe scalając iloczyny jednomianów przy pomocy
+ * kopca (algorytm Johnsona), ale wylicza tylko jednomiany iloczynu
+ * o wykładnikach z przedziału od @p low do @p high. Iloczyny powstają
+ * w kolejności malejących wykładników, więc jednomiany o równych wykładnikach
+ * są sumowane od razu, a kopiec ma rozmiar krótszego z wielomianów.
+ * Wynikowe jednomiany zapisywane są w tablicy przydzielonej z areny.
+ * @param[in] p : wielomian niestały @f$p@f$
+ * @param[in] q : wielomian niestały @f$q@f$
+ * @param[in] low : najmniejszy wyliczany wykładnik
+ * @param[in] high : największy wyliczany wykładnik
+ * @param[out] count : liczba wyliczonych jednomianów
+ * @return tablica jednomianów posortowanych malejąco po wykładnikach
+ */
+static Mono *HeapMulRange(const Poly *p, const Poly *q, long long low,
+                          long long high, size_t *count) {
+
+    const Poly *shorter = p -> size <= q -> size ? p : q;
+    const Poly *longer = p -> size <= q -> size ? q : p;
+
+    size_t heap_size = FIRST_IDX;
+    HeapEntry *heap = (HeapEntry *) ArenaAlloc(shorter -> size * sizeof(HeapEntry));
+    // Każdy wiersz (jednomian krótszego wielomianu razy dłuższy wielomian)
+    // jest posortowany malejąco, więc wystarczy trzymać w kopcu jego czoło.
+    for (size_t i = FIRST_IDX; i < shorter -> size; i++) {
+        poly_exp_t exp_i = MonoGetExp(&shorter -> arr[i]);
+        size_t j = FirstMonoAtMost(longer, high - exp_i);
+        if (j < longer -> size &&
+            (long long) exp_i + MonoGetExp(&longer -> arr[j]) >= low) {
+            heap[heap_size++] = (HeapEntry) {
+                    .exp = exp_i + MonoGetExp(&longer -> arr[j]), .i = i, .j = j};
+        }
+    }
+    for (size_t i = heap_size / TWO; i > FIRST_IDX; i--)
+        HeapSiftDown(heap, heap_size, i - ONE_ELEMENT);
+
+    size_t mono_arr_size = longer -> size;
+    size_t mono_arr_idx = FIRST_IDX;
+    Mono *mono_arr = (Mono *) ArenaAlloc(mono_arr_size * sizeof(Mono));
+
+    while (heap_size > FIRST_IDX) {
+        poly_exp_t exp = heap[FIRST_IDX].exp;
+        Poly sum = PolyZero();
+        // Zdejmujemy z kopca wszystkie iloczyny o tym samym wykładniku.
+        while (heap_size > FIRST_IDX && heap[FIRST_IDX].exp == exp) {
+            HeapEntry top = heap[FIRST_IDX];
+            Poly poly_mul = PolyMul(&shorter -> arr[top.i].p,
+                                    &longer -> arr[top.j].p);
+            if (PolyIsZero(&sum)) {
+                PolyDestroy(&sum);
+                sum = poly_mul;
+            } else if (!PolyIsZero(&poly_mul)) {
+                Poly add = PolyAdd(&sum, &poly_mul);
+                PolyDestroy(&sum);
+                PolyDestroy(&poly_mul);
+                sum = add;
+            } else PolyDestroy(&poly_mul);
+            if (top.j + ONE_ELEMENT < longer -> size &&
+                (long long) MonoGetExp(&shorter -> arr[top.i]) +
+                MonoGetExp(&longer -> arr[top.j + ONE_ELEMENT]) >= low) {
+                top.j++;
+                top.exp = MonoGetExp(&shorter -> arr[top.i]) +
+                          MonoGetExp(&longer -> arr[top.j]);
+                heap[FIRST_IDX] = top;
+            } else {
+                heap_size--;
+                heap[FIRST_IDX] = heap[heap_size];
+            }
+            HeapSiftDown(heap, heap_size, FIRST_IDX);
+        }
+        if (!PolyIsZero(&sum)) {
+            AddMonoToDynamicArray(&mono_arr, &mono_arr_size, &mono_arr_idx,
+                                  MonoFromPoly(&sum, exp));
+        } else PolyDestroy(&sum);
+    }
+    *count = mono_arr_idx;
+    return mono_arr;
+
+}
+
+/**
+ * Mnoży dwa wielomiany niestałe przy pomocy kopca.
+ * @param[in] p : wielomian niestały @f$p@f$
+ * @param[in] q : wielomian niestały @f$q@f$
+ * @return @f$p * q@f$
+ */
+static Poly HeapMul(const Poly *p, const Poly *q) {
+
+    ArenaMark mark = ArenaGetMark();
+    size_t count;
+    Mono *mono_arr = HeapMulRange(p, q, LLONG_MIN, LLONG_MAX, &count);
+    Poly new_poly = DeletePolyZero(count, mono_arr);
+    ArenaReset(mark);
+    return new_poly;
+
+}
+
+/**
+ * To jest struktura przechowująca fragment iloczynu wyliczany przez jedno
+ * zadanie puli wątków: jednomiany o wykładnikach z przedziału od @p low
+ * do @p high.
+ */
+typedef struct MulChunk {
+    const Poly *p; ///< wielomian @f$p@f$
+    const Poly *q; ///< wielomian @f$q@f$
+    long long low; ///< najmniejszy wyliczany wykładnik
+    long long high; ///< największy wyliczany wykładnik
+    Mono *monos; ///< wyliczone jednomiany
+    size_t count; ///< liczba wyliczonych jednomianów
+} MulChunk;
+
+/**
+ * Wylicza fragment iloczynu o indeksie @p idx.
+ * @param[in] arg : tablica fragmentów iloczynu
+ * @param[in] idx : indeks fragmentu
+ */
+static void MulChunkTask(void *arg, size_t idx) {
+
+    MulChunk *chunk = &((MulChunk *) arg)[idx];
+    ArenaMark mark = ArenaGetMark();
+    Mono *monos = HeapMulRange(chunk -> p, chunk -> q, chunk -> low,
+                               chunk -> high, &chunk -> count);
+    if (chunk -> count > FIRST_IDX) {
+        chunk -> monos = (Mono *) MemoryAlloc(chunk -> count * sizeof(Mono));
+        CHECK_PTR(chunk -> monos);
+        memcpy(chunk -> monos, monos, chunk -> count * sizeof(Mono));
+    }
+    ArenaReset(mark);
+
+}
+
+/**
+ * Porównuje liczby malejąco, do sortowania funkcją qsort.
+ * @param[in] a : pierwsza liczba
+ * @param[in] b : druga liczba
+ * @return -1, 0 lub 1
+ */
+static int CompareExpsDesc(const void *a, const void *b) {
+
+    long long x = *(const long long *) a;
+    long long y = *(const long long *) b;
+    return (x < y) - (x > y);
+
+}
+
+/**
+ * Liczy współczynniki stałe w wielomianie, czyli szacowany rozmiar
+ * wielomianu.
+ * @param[in] p : wielomian
+ * @return liczba współczynników stałych
+ */
+static size_t TermCount(const Poly *p) {
+
+    if (PolyIsCoeff(p)) return ONE_ELEMENT;
+    size_t count = FIRST_IDX;
+    for (size_t i = FIRST_IDX; i < p -> size; i++) count += TermCount(&p -> arr[i].p);
+    return count;
+
+}
+
+/**
+ * Mnoży dwa wielomiany niestałe równolegle. Przedział wykładników iloczynu
+ * jest dzielony na fragmenty o podobnej liczbie iloczynów jednomianów,
+ * oszacowanej na próbce sum wykładników. Fragmenty są wyliczane przez pulę
+ * wątków, a ponieważ nie zachodzą na siebie, wystarczy je połączyć
+ * w kolejności. Wynik jest identyczny z wynikiem funkcji HeapMul.
+ * @param[in] p : wielomian niestały @f$p@f$
+ * @param[in] q : wielomian niestały @f$q@f$
+ * @return @f$p * q@f$
+ */
+static Poly ParallelMul(const Poly *p, const Poly *q) {
+
+    size_t step = q -> size / MUL_SAMPLES_PER_ROW + ONE_ELEMENT;
+    size_t sample_count = FIRST_IDX;
+    long long *samples = (long long *) MemoryAlloc(
+            p -> size * (q -> size / step + ONE_ELEMENT) * sizeof(long long));
+    CHECK_PTR(samples);
+    for (size_t i = FIRST_IDX; i < p -> size; i++) {
+        for (size_t j = FIRST_IDX; j < q -> size; j += step) {
+            samples[sample_count++] = (long long) MonoGetExp(&p -> arr[i]) +
+                                      MonoGetExp(&q -> arr[j]);
+        }
+    }
+    qsort(samples, sample_count, sizeof(long long), CompareExpsDesc);
+
+    size_t chunk_count = ThreadPoolThreads() * MUL_CHUNKS_PER_THREAD;
+    MulChunk *chunks = (MulChunk *) MemoryCalloc(chunk_count, sizeof(MulChunk));
+    CHECK_PTR(chunks);
+    // Granice fragmentów to kwantyle próbki, bez powtórzeń.
+    size_t used = FIRST_IDX;
+    long long high = LLONG_MAX;
+    for (size_t c = ONE_ELEMENT; c <= chunk_count; c++) {
+        long long low = c == chunk_count ? LLONG_MIN
+                                         : samples[c * sample_count / chunk_count];
+        if (low >= high) continue;
+        chunks[used++] = (MulChunk) {.p = p, .q = q, .low = low + (c != chunk_count),
+                                     .high = high};
+        high = low;
+    }
+    MemoryFree(samples);
+
+    ParallelFor(used, MulChunkTask, chunks);
+
+    size_t total = FIRST_IDX;
+    for (size_t c = FIRST_IDX; c < used; c++) total += chunks[c].count;
+    ArenaMark mark = ArenaGetMark();
+    Mono *mono_arr = (Mono *) ArenaAlloc(total * sizeof(Mono));
+    size_t mono_arr_idx = FIRST_IDX;
+    for (size_t c = FIRST_IDX; c < used; c++) {
+        if (chunks[c].count > FIRST_IDX) {
+            memcpy(mono_arr + mono_arr_idx, chunks[c].monos,
+                   chunks[c].count * sizeof(Mono));
+            mono_arr_idx += chunks[c].count;
+            MemoryFree(chunks[c].monos);
+        }
+    }
+    MemoryFree(chunks);
+    Poly new_poly = DeletePolyZero(total, mono_arr);
+    ArenaReset(mark);
+    return new_poly;
+
+}
+
+/**
+ * Mnoży dwa wielomiany bez korzystania z pamięci podręcznej wyników.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] q : wielomian @f$q@f$
+ * @return @f$p * q@f$
+ */
+static Poly MulPolys(const Poly *p, const Poly *q) {
 
     if (PolyIsZero(p) || PolyIsZero(q)) return PolyZero();
 
     if (PolyIsCoeff(p)) return PolyCloneAndMultiplyByScalar(q, p->coeff);
     else if (PolyIsCoeff(q)) return PolyCloneAndMultiplyByScalar(p, q->coeff);
+    else if (p -> size * q -> size >= HEAP_MUL_THRESHOLD) {
+        if (ThreadPoolThreads() > ONE_ELEMENT &&
+            TermCount(p) * TermCount(q) >= PARALLEL_MUL_WORK)
+            return ParallelMul(p, q);
+        return HeapMul(p, q);
+    }
     else {
         size_t mono_arr_size = p -> size * q -> size;
         size_t current_idx = FIRST_IDX;
-        Mono *mono_arr = (Mono *) malloc(mono_arr_size * sizeof(Mono));
-        CHECK_PTR(mono_arr);
+        ArenaMark mark = ArenaGetMark();
+        Mono *mono_arr = (Mono *) ArenaAlloc(mono_arr_size * sizeof(Mono));
         for (size_t i = FIRST_IDX; i < p -> size; i++) {
             for (size_t k = FIRST_IDX; k < q -> size; k++) {
                 Mono mono_p = p -> arr[i];
@@ -371,12 +735,34 @@ Poly PolyMul(const Poly *p, const Poly *q) {
                 current_idx++;
             }
         }
-        Poly new_poly = PolyOwnMonos(mono_arr_size, mono_arr);
+        Poly new_poly = AddMonos(mono_arr_size, mono_arr);
+        ArenaReset(mark);
         return new_poly;
     }
 
 }
 
+Poly PolyMul(const Poly *p, const Poly *q) {
+
+    Poly result;
+    if (InternMemoFind(INTERN_MUL, p, q, &result)) return result;
+    // Śledzimy tylko mnożenia wielomianów niestałych, bo mnożenia
+    // współczynników są zbyt krótkie i zbyt liczne.
+    if (PolyIsCoeff(p) || PolyIsCoeff(q)) result = MulPolys(p, q);
+    else {
+        size_t level = TraceEnterLevel();
+        TRACE_PROBE(mul__start, level, p -> size, q -> size);
+        uint64_t start = TraceBegin();
+        result = MulPolys(p, q);
+        TraceEnd(TRACE_MUL, start, level);
+        TRACE_PROBE(mul__done, level);
+        TraceLeaveLevel(level);
+    }
+    InternMemoStore(INTERN_MUL, p, q, &result);
+    return result;
+
+}
+
 bool AllExpZero(const Poly *p) {
 
     if (!PolyIsCoeff(p)) {
@@ -414,82 +800,392 @@ static poly_coeff_t FastPow(poly_coeff_t x, poly_exp_t exp) {
 }
 
 /**
- * Wykonuje szybkie potęgowanie wielomianu @p p.
- * @param[in] p : wielomian
- * @param[in] exp : potęga
- * @return wielomian @p p podniesiony do potęgi @p exp
+ * To jest struktura przechowująca zapamiętaną potęgę wielomianu.
+ */
+typedef struct PowerEntry {
+    poly_exp_t exp; ///< wykładnik potęgi
+    size_t terms; ///< liczba współczynników stałych potęgi
+    Poly power; ///< potęga wielomianu
+} PowerEntry;
+
+/**
+ * To jest struktura przechowująca zapamiętane potęgi jednego wielomianu,
+ * posortowane rosnąco po wykładnikach.
+ */
+typedef struct PowerCache {
+    PowerEntry *entries; ///< zapamiętane potęgi
+    size_t count; ///< liczba zapamiętanych potęg
+    size_t capacity; ///< rozmiar tablicy @p entries
+} PowerCache;
+
+/**
+ * To jest struktura przechowująca tablicę potęg wielomianów podstawianych
+ * w jednym wywołaniu funkcji PolyCompose. Tablica jest współdzielona przez
+ * wszystkie gałęzie rekurencji i wątki, więc chroni ją blokada. Łączny rozmiar
+ * zapamiętanych potęg jest ograniczony przez POWER_CACHE_MAX_TERMS.
+ */
+typedef struct PowerTable {
+    const Poly *q; ///< tablica podstawianych wielomianów
+    PowerCache *caches; ///< potęgi kolejnych wielomianów z tablicy @p q
+    size_t terms; ///< łączna liczba współczynników stałych potęg
+    pthread_mutex_t lock; ///< blokada tablicy potęg
+} PowerTable;
+
+/**
+ * Szuka zapamiętanej potęgi. Wymaga założonej blokady tablicy potęg.
+ * @param[in] cache : zapamiętane potęgi wielomianu
+ * @param[in] exp : wykładnik potęgi
+ * @return zapamiętana potęga lub NULL, jeśli potęgi nie zapamiętano
+ */
+static PowerEntry *PowerFind(PowerCache *cache, poly_exp_t exp) {
+
+    size_t low = FIRST_IDX;
+    size_t high = cache -> count;
+    while (low < high) {
+        size_t middle = low + (high - low) / TWO;
+        if (cache -> entries[middle].exp < exp) low = middle + ONE_ELEMENT;
+        else high = middle;
+    }
+    if (low < cache -> count && cache -> entries[low].exp == exp)
+        return &cache -> entries[low];
+    return NULL;
+
+}
+
+/**
+ * Usuwa z tablicy potęg największą zapamiętaną potęgę. Wymaga założonej
+ * blokady tablicy potęg.
+ * @param[in] table : tablica potęg
+ * @param[in] k : liczba podstawianych wielomianów
+ */
+static void PowerEvictLargest(PowerTable *table, size_t k) {
+
+    PowerCache *victim_cache = NULL;
+    size_t victim = FIRST_IDX;
+    for (size_t idx = FIRST_IDX; idx < k; idx++) {
+        PowerCache *cache = &table -> caches[idx];
+        for (size_t i = FIRST_IDX; i < cache -> count; i++) {
+            if (victim_cache == NULL ||
+                cache -> entries[i].terms > victim_cache -> entries[victim].terms) {
+                victim_cache = cache;
+                victim = i;
+            }
+        }
+    }
+    table -> terms -= victim_cache -> entries[victim].terms;
+    PolyDestroy(&victim_cache -> entries[victim].power);
+    victim_cache -> count--;
+    memmove(victim_cache -> entries + victim, victim_cache -> entries + victim + ONE_ELEMENT,
+            (victim_cache -> count - victim) * sizeof(PowerEntry));
+
+}
+
+/**
+ * Zapamiętuje potęgę wielomianu, jeśli mieści się w ograniczeniu rozmiaru,
+ * usuwając w razie potrzeby największe zapamiętane potęgi.
+ * @param[in] table : tablica potęg
+ * @param[in] k : liczba podstawianych wielomianów
+ * @param[in] idx : indeks wielomianu
+ * @param[in] exp : wykładnik potęgi
+ * @param[in] power : potęga, nie jest przejmowana na własność
  */
-static Poly FastPolyPow(Poly p, poly_exp_t exp) {
+static void PowerStore(PowerTable *table, size_t k, size_t idx, poly_exp_t exp,
+                       const Poly *power) {
+
+    size_t terms = TermCount(power);
+    if (terms > POWER_CACHE_MAX_TERMS) return;
+
+    // Operacji nie można przerwać, dopóki trzymamy blokadę tablicy potęg.
+    MemoryHoldAborts();
+    pthread_mutex_lock(&table -> lock);
+    PowerCache *cache = &table -> caches[idx];
+    // Inny wątek mógł w międzyczasie wyliczyć tę samą potęgę.
+    if (PowerFind(cache, exp) == NULL) {
+        while (table -> terms + terms > POWER_CACHE_MAX_TERMS)
+            PowerEvictLargest(table, k);
+        if (cache -> count == cache -> capacity) {
+            cache -> capacity = cache -> capacity * TWO + ONE_ELEMENT;
+            cache -> entries = (PowerEntry *) MemoryRealloc(
+                    cache -> entries, cache -> capacity * sizeof(PowerEntry));
+            CHECK_PTR(cache -> entries);
+        }
+        size_t pos = cache -> count;
+        while (pos > FIRST_IDX && cache -> entries[pos - ONE_ELEMENT].exp > exp) {
+            cache -> entries[pos] = cache -> entries[pos - ONE_ELEMENT];
+            pos--;
+        }
+        cache -> entries[pos] = (PowerEntry) {.exp = exp, .terms = terms,
+                                              .power = PolyClone(power)};
+        cache -> count++;
+        table -> terms += terms;
+    }
+    pthread_mutex_unlock(&table -> lock);
+    MemoryAllowAborts();
+
+}
 
-    if (exp == FIRST_IDX) return PolyFromCoeff(ONE_ELEMENT);
+/**
+ * Zwraca potęgę wielomianu @p q[idx] o wykładniku @p exp. Potęgę bierze
+ * z tablicy potęg, a jeśli jej tam nie ma, to wylicza ją jednym mnożeniem
+ * z największej zapamiętanej potęgi o mniejszym wykładniku, o ile zapamiętano
+ * też brakujący czynnik. W przeciwnym przypadku dzieli wykładnik na połowy.
+ * Wyliczone potęgi są zapamiętywane.
+ * @param[in] table : tablica potęg
+ * @param[in] k : liczba podstawianych wielomianów
+ * @param[in] idx : indeks wielomianu
+ * @param[in] exp : wykładnik potęgi
+ * @return @f$q_{idx}^{exp}@f$
+ */
+static Poly PowerGet(PowerTable *table, size_t k, size_t idx, poly_exp_t exp) {
+
+    const Poly *q = &table -> q[idx];
+    if (exp == EXP_ZERO) return PolyFromCoeff(ONE_ELEMENT);
+    if (exp == EXP_ONE) return PolyClone(q);
     // Jeśli nasz wielomian jest tożsamościowo równy wielomianowi stałemu,
     // to zwracamy wielomian stały ze stałą podniesioną do potęgi exp.
-    else if (AllExpZero(&p)) return PolyFromCoeff(FastPow(GetCoeff(&p), exp));
-    else if (exp % TWO == PARITY) {
-        Poly y = FastPolyPow(p, exp / TWO);
-        Poly mul = PolyMul(&y, &y);
-        PolyDestroy(&y);
-        return mul;
-    } else {
-        Poly y = FastPolyPow(p, exp - ONE_ELEMENT);
-        Poly mul = PolyMul(&p, &y);
-        PolyDestroy(&y);
-        return mul;
+    if (AllExpZero(q)) return PolyFromCoeff(FastPow(GetCoeff(q), exp));
+
+    Poly left = PolyZero();
+    Poly right = PolyZero();
+    bool found = false;
+    pthread_mutex_lock(&table -> lock);
+    PowerCache *cache = &table -> caches[idx];
+    PowerEntry *entry = PowerFind(cache, exp);
+    if (entry != NULL) {
+        Poly power = PolyClone(&entry -> power);
+        pthread_mutex_unlock(&table -> lock);
+        return power;
+    }
+    for (size_t i = cache -> count; i > FIRST_IDX && !found; i--) {
+        PowerEntry *lower = &cache -> entries[i - ONE_ELEMENT];
+        if (lower -> exp >= exp) continue;
+        PowerEntry *rest = PowerFind(cache, exp - lower -> exp);
+        if (rest == NULL && exp - lower -> exp != EXP_ONE) continue;
+        left = PolyClone(&lower -> power);
+        right = rest != NULL ? PolyClone(&rest -> power) : PolyClone(q);
+        found = true;
+    }
+    pthread_mutex_unlock(&table -> lock);
+
+    if (!found) {
+        left = PowerGet(table, k, idx, exp / TWO);
+        right = PowerGet(table, k, idx, exp - exp / TWO);
     }
+    Poly power = PolyMul(&left, &right);
+    PolyDestroy(&left);
+    PolyDestroy(&right);
+    PowerStore(table, k, idx, exp, &power);
+    return power;
 
 }
 
 /**
- * Funkcja pomocnicza do funkcji PolyCompose.
+ * To jest struktura przechowująca zadanie złożenia wielomianów: składniki
+ * wyniku pochodzące z kolejnych jednomianów wielomianu @p p.
+ */
+typedef struct ComposeJob {
+    const Poly *p; ///< wielomian @f$p@f$
+    size_t k; ///< rozmiar tablicy wielomianów
+    PowerTable *powers; ///< tablica potęg podstawianych wielomianów
+    size_t idx; ///< aktualny indeks stojący przy @f$x_i@f$
+    Poly *parts; ///< składniki wyniku
+} ComposeJob;
+
+/**
+ * To jest struktura przechowująca jedną rundę sumowania drzewiastego:
+ * składnik o indeksie @f$2 \cdot i \cdot stride@f$ jest zastępowany sumą
+ * jego i składnika o indeksie większym o @p stride.
+ */
+typedef struct SumRound {
+    Poly *parts; ///< składniki sumy
+    size_t count; ///< liczba składników
+    size_t stride; ///< odległość sumowanych składników
+} SumRound;
+
+static Poly PolyComposeHelper(const Poly *p, size_t k, PowerTable *powers,
+                              size_t idx);
+
+/**
+ * Wylicza składnik złożenia pochodzący z jednomianu o indeksie @p i.
+ * @param[in] arg : zadanie złożenia wielomianów
+ * @param[in] i : indeks jednomianu
+ */
+static void ComposeMonoTask(void *arg, size_t i) {
+
+    ComposeJob *job = (ComposeJob *) arg;
+    Mono current_mono = (job -> p -> arr)[i];
+    if (job -> idx < job -> k) {
+        Poly pow_poly = PowerGet(job -> powers, job -> k, job -> idx,
+                                 MonoGetExp(&current_mono));
+        Poly new_compose = PolyComposeHelper(&current_mono.p, job -> k, job -> powers,
+                                             (job -> idx + ONE_ELEMENT));
+        job -> parts[i] = PolyMul(&pow_poly, &new_compose);
+        PolyDestroy(&pow_poly);
+        PolyDestroy(&new_compose);
+    // Przypadek 0^0, wtedy mnożymy następne zagłebione wielomiany przez 1.
+    } else if (current_mono.exp == EXP_ZERO) {
+        job -> parts[i] = PolyComposeHelper(&current_mono.p, job -> k, job -> powers,
+                                            (job -> idx + ONE_ELEMENT));
+    } else job -> parts[i] = PolyZero();
+
+}
+
+/**
+ * Sumuje parę składników w jednej rundzie sumowania drzewiastego.
+ * @param[in] arg : runda sumowania
+ * @param[in] i : indeks pary
+ */
+static void AddPairTask(void *arg, size_t i) {
+
+    SumRound *round = (SumRound *) arg;
+    size_t left = TWO * i * round -> stride;
+    size_t right = left + round -> stride;
+    if (right < round -> count) {
+        Poly sum = PolyAdd(&round -> parts[left], &round -> parts[right]);
+        PolyDestroy(&round -> parts[left]);
+        PolyDestroy(&round -> parts[right]);
+        round -> parts[left] = sum;
+    }
+
+}
+
+/**
+ * Sumuje składniki drzewiasto: w każdej rundzie równolegle dodaje pary
+ * sąsiednich sum częściowych. Przejmuje składniki na własność.
+ * @param[in] parts : składniki
+ * @param[in] count : liczba składników
+ * @return suma składników
+ */
+static Poly SumParts(Poly *parts, size_t count) {
+
+    if (count == FIRST_IDX) return PolyZero();
+    SumRound round = (SumRound) {.parts = parts, .count = count};
+    for (round.stride = ONE_ELEMENT; round.stride < count; round.stride *= TWO) {
+        size_t pairs = (count + TWO * round.stride - ONE_ELEMENT) /
+                       (TWO * round.stride);
+        ParallelFor(pairs, AddPairTask, &round);
+    }
+    return parts[FIRST_IDX];
+
+}
+
+/**
+ * Składa współczynnik jednomianu o indeksie @p i z kolejnymi wielomianami.
+ * @param[in] arg : zadanie złożenia wielomianów
+ * @param[in] i : indeks jednomianu
+ */
+static void ComposeCoeffTask(void *arg, size_t i) {
+
+    ComposeJob *job = (ComposeJob *) arg;
+    job -> parts[i] = PolyComposeHelper(&job -> p -> arr[i].p, job -> k,
+                                        job -> powers, job -> idx + ONE_ELEMENT);
+
+}
+
+/**
+ * Sprawdza, czy wykładniki wielomianu są na tyle gęste, że złożenie lepiej
+ * wyliczyć schematem Hornera. Przy gęstych wykładnikach potrzebne są prawie
+ * wszystkie potęgi, a schemat Hornera mnoży tylko przez potęgi o wykładnikach
+ * równych różnicom kolejnych wykładników.
+ * @param[in] p : wielomian niestały
+ * @return Czy użyć schematu Hornera?
+ */
+static bool UseHorner(const Poly *p) {
+
+    return p -> size > ONE_ELEMENT &&
+           (size_t) MonoGetExp(&p -> arr[FIRST_IDX]) <= HORNER_MAX_SPREAD * p -> size;
+
+}
+
+/**
+ * Składa wielomian schematem Hornera:
+ * @f$(\ldots(C_0 q^{e_0 - e_1} + C_1) q^{e_1 - e_2} + \ldots) q^{e_{n-1}}@f$,
+ * gdzie @f$C_i@f$ to złożone współczynniki, wyliczane równolegle.
+ * @param[in] p : wielomian niestały @f$p@f$
+ * @param[in] k : rozmiar tablicy wielomianów
+ * @param[in] powers : tablica potęg podstawianych wielomianów
+ * @param[in] idx : aktualny indeks stojący przy @f$x_i@f$, mniejszy od @p k
+ * @return wielomian będący złożeniem wielomianów
+ */
+static Poly ComposeHorner(const Poly *p, size_t k, PowerTable *powers,
+                          size_t idx) {
+
+    ArenaMark mark = ArenaGetMark();
+    ComposeJob job = (ComposeJob) {
+            .p = p, .k = k, .powers = powers, .idx = idx,
+            .parts = (Poly *) ArenaAlloc(p -> size * sizeof(Poly))};
+    ParallelFor(p -> size, ComposeCoeffTask, &job);
+
+    Poly final = job.parts[FIRST_IDX];
+    for (size_t i = ONE_ELEMENT; i <= p -> size; i++) {
+        poly_exp_t gap = i < p -> size ? MonoGetExp(&p -> arr[i - ONE_ELEMENT]) -
+                                         MonoGetExp(&p -> arr[i])
+                                       : MonoGetExp(&p -> arr[i - ONE_ELEMENT]);
+        if (gap != EXP_ZERO) {
+            Poly pow_poly = PowerGet(powers, k, idx, gap);
+            Poly mul = PolyMul(&final, &pow_poly);
+            PolyDestroy(&pow_poly);
+            PolyDestroy(&final);
+            final = mul;
+        }
+        if (i < p -> size) {
+            Poly add = PolyAdd(&final, &job.parts[i]);
+            PolyDestroy(&final);
+            PolyDestroy(&job.parts[i]);
+            final = add;
+        }
+    }
+    ArenaReset(mark);
+    return final;
+
+}
+
+/**
+ * Funkcja pomocnicza do funkcji PolyCompose. Przy gęstych wykładnikach
+ * używa schematu Hornera, a w przeciwnym przypadku składniki pochodzące
+ * z kolejnych jednomianów wielomianu @p p są wyliczane równolegle
+ * i sumowane drzewiasto.
  * @param[in] p : wielomian @f$p@f$
  * @param[in] k : rozmiar tablicy wielomianów
- * @param[in] q : tablica wielomianów
+ * @param[in] powers : tablica potęg podstawianych wielomianów
  * @param[in] idx : aktualny indeks stojący przy @f$x_i@f$
  * @return wielomian będący złożeniem wielomianów
  */
-static Poly PolyComposeHelper(const Poly *p, size_t k, const Poly q[],
+static Poly PolyComposeHelper(const Poly *p, size_t k, PowerTable *powers,
                               size_t idx) {
 
     if (PolyIsCoeff(p)) return PolyFromCoeff(p -> coeff);
     if (AllExpZero(p)) return PolyFromCoeff(GetCoeff(p));
-    Poly final = PolyZero();
-    for (size_t i = FIRST_IDX; i < p -> size; i++) {
-        Mono current_mono = (p -> arr)[i];
-        if (idx < k) {
-            Poly pow_poly;
-            // Jeśli podnosimy wielomian do potęgi pierwszej, to nie musimy
-            // klonować jednomianu, zamiast tego przepisujemy go z tablicy q.
-            if (MonoGetExp(&current_mono) == EXP_ONE) pow_poly = q[idx];
-            else pow_poly = FastPolyPow(q[idx], MonoGetExp(&current_mono));
-            Poly new_compose = PolyComposeHelper(&current_mono.p, k, q,
-                                            (idx + ONE_ELEMENT));
-            Poly mul = PolyMul(&pow_poly, &new_compose);
-            // Jeśli podnosiliśmy wielomian do potęgi pierwszej, to nie
-            // usuwamy tego wielomianu, bo został on przepisany.
-            if (MonoGetExp(&current_mono) != EXP_ONE) PolyDestroy(&pow_poly);
-            PolyDestroy(&new_compose);
-            Poly add = PolyAdd(&final, &mul);
-            PolyDestroy(&final);
-            final = add;
-            PolyDestroy(&mul);
-        // Przypadek 0^0, wtedy mnożymy następne zagłebione wielomiany przez 1.
-        } else if (current_mono.exp == EXP_ZERO) {
-            Poly new_compose = PolyComposeHelper(&current_mono.p, k, q,
-                                                 (idx + ONE_ELEMENT));
-            Poly add = PolyAdd(&final, &new_compose);
-            PolyDestroy(&new_compose);
-            PolyDestroy(&final);
-            final = add;
-        }
-    }
-    if (!PolyIsCoeff(&final)) return DeletePolyZero(final.size, &final.arr);
+    if (idx < k && UseHorner(p)) return ComposeHorner(p, k, powers, idx);
+    ArenaMark mark = ArenaGetMark();
+    ComposeJob job = (ComposeJob) {
+            .p = p, .k = k, .powers = powers, .idx = idx,
+            .parts = (Poly *) ArenaAlloc(p -> size * sizeof(Poly))};
+    ParallelFor(p -> size, ComposeMonoTask, &job);
+    Poly final = SumParts(job.parts, p -> size);
+    ArenaReset(mark);
     return final;
 
 }
 
 Poly PolyCompose(const Poly *p, size_t k, const Poly q[]) {
 
-    return PolyComposeHelper(p, k, q, FIRST_IDX);
+    PowerTable powers = (PowerTable) {.q = q, .terms = FIRST_IDX};
+    powers.caches = (PowerCache *) MemoryCalloc(k > FIRST_IDX ? k : ONE_ELEMENT,
+                                                sizeof(PowerCache));
+    CHECK_PTR(powers.caches);
+    pthread_mutex_init(&powers.lock, NULL);
+
+    Poly final = PolyComposeHelper(p, k, &powers, FIRST_IDX);
+
+    for (size_t idx = FIRST_IDX; idx < k; idx++) {
+        for (size_t i = FIRST_IDX; i < powers.caches[idx].count; i++)
+            PolyDestroy(&powers.caches[idx].entries[i].power);
+        MemoryFree(powers.caches[idx].entries);
+    }
+    MemoryFree(powers.caches);
+    pthread_mutex_destroy(&powers.lock);
+    return final;
 
 }
 
@@ -499,6 +1195,21 @@ Poly PolyNeg(const Poly *p) {
 
 }
 
+void PolyNegInPlace(Poly *p) {
+
+    if (PolyIsCoeff(p)) p -> coeff = NEG * (p -> coeff);
+    else if (MonoArrIsShared(p -> arr) || InternIsShared(p -> arr)) {
+        // Współdzielonej tablicy nie możemy zmienić, więc ją kopiujemy.
+        Poly neg_poly = PolyNeg(p);
+        PolyDestroy(p);
+        *p = neg_poly;
+    } else {
+        for (size_t i = FIRST_IDX; i < p -> size; i++)
+            PolyNegInPlace(&p -> arr[i].p);
+    }
+
+}
+
 Poly PolySub(const Poly *p, const Poly *q) {
 
     Poly neg_poly = PolyNeg(q);
@@ -573,9 +1284,63 @@ poly_exp_t PolyDeg(const Poly *p) {
 
 }
 
+size_t PolyTerms(const Poly *p) {
+
+    if (PolyIsCoeff(p)) return PolyIsZero(p) ? FIRST_IDX : ONE_ELEMENT;
+
+    size_t terms = MonoArrGetTerms(p -> arr);
+    if (terms != FIRST_IDX) return terms;
+    for (size_t i = FIRST_IDX; i < p -> size; i++) terms += PolyTerms(&p -> arr[i].p);
+    // Nagłówek tablicy stałej może leżeć w pamięci tylko do odczytu.
+    if (!MonoArrIsStatic(p -> arr)) MonoArrSetTerms(p -> arr, terms);
+    return terms;
+
+}
+
+/**
+ * Zlicza węzły wielomianu, których jeszcze nie odwiedzono, i wylicza
+ * jego głębokość.
+ * @param[in] p : wielomian
+ * @param[in] visited : odwiedzone tablice jednomianów wraz z ich głębokością
+ * @param[in] footprint : dotychczasowa liczba węzłów i bajtów
+ * @return głębokość wielomianu @p p
+ */
+static size_t FootprintHelper(const Poly *p, PointerMap *visited,
+                              PolyFootprint *footprint) {
+
+    if (PolyIsCoeff(p)) return FIRST_IDX;
+    int64_t depth = FIRST_IDX;
+    if (PointerMapFind(visited, p -> arr, &depth)) return (size_t) depth;
+
+    for (size_t i = FIRST_IDX; i < p -> size; i++) {
+        size_t child = FootprintHelper(&p -> arr[i].p, visited, footprint);
+        if ((int64_t) child > depth) depth = (int64_t) child;
+    }
+    footprint -> nodes++;
+    footprint -> bytes += MonoArrBytes(p -> arr, p -> size);
+    PointerMapSet(visited, p -> arr, depth + ONE_ELEMENT);
+    return (size_t) depth + ONE_ELEMENT;
+
+}
+
+PolyFootprint PolyGetFootprint(const Poly *p) {
+
+    PolyFootprint footprint = (PolyFootprint) {.nodes = FIRST_IDX, .depth = FIRST_IDX,
+                                               .bytes = FIRST_IDX};
+    PointerMap visited = PointerMapInit();
+    footprint.depth = FootprintHelper(p, &visited, &footprint);
+    PointerMapFree(&visited);
+    return footprint;
+
+}
+
 bool PolyIsEq(const Poly *p, const Poly *q) {
 
     if (!PolyIsCoeff(p) && !PolyIsCoeff(q)) {
+        if (p -> arr == q -> arr) return true;
+        // Równe wielomiany w postaci kanonicznej mają tę samą tablicę.
+        if (InternIsCanonical(p -> arr) && InternIsCanonical(q -> arr))
+            return false;
         if (p -> size != q -> size) return false;
         bool is_eq = true;
         for (size_t i = FIRST_IDX; i < p -> size; i++) {
@@ -596,43 +1361,51 @@ bool PolyIsEq(const Poly *p, const Poly *q) {
 }
 
 /**
- * Realokuje tablicę @p mono_arr, jeśli jest taka potrzeba
- * @param[in] mono_arr : tablica jednomianów
- * @param[in] current_size : aktualny rozmiar tablicy @p mono_arr
- * @param[in] current_idx : aktualny indeks tablicy @p mono_arr
+ * Sprawdza, czy wszystkie współczynniki jednomianów wielomianu są stałe.
+ * @param[in] p : wielomian niestały
+ * @return Czy wszystkie współczynniki są stałe?
  */
-static void ArrayRealloc(Mono **mono_arr, size_t *current_size, size_t current_idx) {
+static bool AllCoeffsConstant(const Poly *p) {
 
-    if (current_idx >= *current_size) {
-        *current_size = (*current_size) * ARR_SIZE;
-        *mono_arr = realloc(*mono_arr,(*current_size) * sizeof(Mono));
-        CHECK_PTR(mono_arr);
+    for (size_t i = FIRST_IDX; i < p -> size; i++) {
+        if (!PolyIsCoeff(&p -> arr[i].p)) return false;
     }
+    return true;
 
 }
 
 /**
- * Dodaje jednomian @p mono do tablicy @p mono_arr pod indeksem @p mono_arr_idx
- * @param[in] mono_arr : tablica jednomianów
- * @param[in] mono_arr_size : rozmiar tablicy @p mono_arr
- * @param[in] mono_arr_idx : indeks tablicy @p mono_arr
- * @param[in] mono : jednomian
+ * Wylicza schematem Hornera wartość wielomianu o stałych współczynnikach.
+ * Między kolejnymi jednomianami mnoży przez @f$x@f$ podniesione do różnicy
+ * wykładników, więc potęgowania są krótsze niż przy liczeniu każdej potęgi
+ * osobno. Obliczenia są modulo @f$2^{64}@f$, tak jak przy liczeniu potęg
+ * osobno, więc wynik jest identyczny.
+ * @param[in] p : wielomian niestały o stałych współczynnikach
+ * @param[in] x : wartość argumentu
+ * @return wartość wielomianu
  */
-static void AddMonoToDynamicArray(Mono **mono_arr, size_t *mono_arr_size,
-                           size_t *mono_arr_idx, Mono mono) {
+static poly_coeff_t HornerAt(const Poly *p, poly_coeff_t x) {
 
-    ArrayRealloc(mono_arr, mono_arr_size, *mono_arr_idx);
-    (*mono_arr)[*mono_arr_idx] = mono;
-    (*mono_arr_idx)++;
+    uint64_t value = FIRST_IDX;
+    for (size_t i = FIRST_IDX; i < p -> size; i++) {
+        if (i > FIRST_IDX) {
+            value *= (uint64_t) FastPow(x, MonoGetExp(&p -> arr[i - ONE_ELEMENT]) -
+                                           MonoGetExp(&p -> arr[i]));
+        }
+        value += (uint64_t) p -> arr[i].p.coeff;
+    }
+    value *= (uint64_t) FastPow(x, MonoGetExp(&p -> arr[p -> size - ONE_ELEMENT]));
+    return (poly_coeff_t) value;
 
 }
 
 Poly PolyAt(const Poly *p, poly_coeff_t x) {
 
     if (PolyIsCoeff(p)) return PolyFromCoeff(p -> coeff);
+    if (AllCoeffsConstant(p)) return PolyFromCoeff(HornerAt(p, x));
 
-    Mono *mono_arr = (Mono *) malloc(ARR_SIZE * sizeof(Mono));
-    CHECK_PTR(mono_arr);
+    ArenaMark mark = ArenaGetMark();
+    Mono *mono_arr = (Mono *) ArenaAlloc(ARR_SIZE * sizeof(Mono));
     size_t mono_arr_size = ARR_SIZE;
     size_t mono_arr_idx = FIRST_IDX;
 
@@ -645,19 +1418,22 @@ Poly PolyAt(const Poly *p, poly_coeff_t x) {
             Poly new_poly = PolyFromCoeff(new_coeff * current_mono.p.coeff);
             AddMonoToDynamicArray(&mono_arr, &mono_arr_size, &mono_arr_idx,
                             MonoFromPoly(&new_poly, EXP_ZERO));
-            free(new_poly.arr);
         } else {
-            Poly new_poly = PolyCloneAndMultiplyByScalar(&current_mono.p, new_coeff);
-            for (size_t k = FIRST_IDX; k < new_poly.size; k++) {
-                AddMonoToDynamicArray(&mono_arr, &mono_arr_size, &mono_arr_idx,
-                                      new_poly.arr[k]);
+            // Przepisujemy przemnożone jednomiany współczynnika od razu do
+            // tablicy, bez tworzenia pośredniego wielomianu.
+            for (size_t k = FIRST_IDX; k < current_mono.p.size; k++) {
+                Mono mono = current_mono.p.arr[k];
+                Poly new_poly = PolyCloneAndMultiplyByScalar(&mono.p, new_coeff);
+                if (!PolyIsZero(&new_poly)) {
+                    AddMonoToDynamicArray(&mono_arr, &mono_arr_size, &mono_arr_idx,
+                                          MonoFromPoly(&new_poly, mono.exp));
+                } else PolyDestroy(&new_poly);
             }
-            free(new_poly.arr);
         }
     }
 
-    Poly final_poly = PolyAddMonos(mono_arr_idx, mono_arr);
-    free(mono_arr);
+    Poly final_poly = AddMonos(mono_arr_idx, mono_arr);
+    ArenaReset(mark);
     if (AllExpZero(&final_poly)) {
         Poly new_poly = PolyFromCoeff(GetCoeff(&final_poly));
         PolyDestroy(&final_poly);
@@ -665,4 +1441,82 @@ Poly PolyAt(const Poly *p, poly_coeff_t x) {
     }
     return final_poly;
 
-}
\ No newline at end of file
+}
+
+/**
+ * To jest struktura przechowująca zadanie obliczenia wartości wielomianu
+ * w wielu punktach.
+ */
+typedef struct AtManyJob {
+    const Poly *p; ///< wielomian
+    const poly_coeff_t *xs; ///< punkty
+    Poly *results; ///< wartości wielomianu w punktach
+} AtManyJob;
+
+/**
+ * Wylicza wartość wielomianu w punkcie o indeksie @p i.
+ * @param[in] arg : zadanie obliczenia wartości w wielu punktach
+ * @param[in] i : indeks punktu
+ */
+static void AtPointTask(void *arg, size_t i) {
+
+    AtManyJob *job = (AtManyJob *) arg;
+    job -> results[i] = PolyAt(job -> p, job -> xs[i]);
+
+}
+
+/**
+ * Sprawdza, czy wartości wielomianu w @p count punktach opłaca się liczyć
+ * drzewem reszt zamiast schematem Hornera. Drzewo reszt ma mniejszą
+ * złożoność, ale dużą stałą, więc wygrywa dopiero przy wielu punktach
+ * i dużym stopniu, tym później, im więcej punktów naraz liczy schemat
+ * Hornera.
+ * @param[in] p : wielomian niestały o stałych współczynnikach
+ * @param[in] count : liczba punktów
+ * @return Czy użyć drzewa reszt?
+ */
+static bool UseMultipoint(const Poly *p, size_t count) {
+
+    size_t deg = (size_t) MonoGetExp(&p -> arr[FIRST_IDX]);
+    size_t lanes = HornerBatchLanes();
+    // Dla n punktów i stopnia n schemat Hornera wykonuje n^2 / lanes mnożeń,
+    // a drzewo reszt około c * n * log^2 n, więc z samego rachunku próg
+    // rósłby liniowo z liczbą pól. Zmierzone progi rosły jednak szybciej:
+    // około 4 tys. punktów dla jednego pola, 50 tys. dla czterech (AVX2)
+    // i ponad 150 tys. dla ośmiu (AVX-512), bo przy większych n rośnie
+    // czynnik log^2 n, a tablice drzewa przestają mieścić się w pamięci
+    // podręcznej. Kwadrat liczby pól (65 tys. i 262 tys.) to najprostsze
+    // ograniczenie tych pomiarów z góry.
+    size_t threshold = MULTIPOINT_MIN_POINTS * lanes * lanes;
+    return count >= threshold && deg >= threshold &&
+           deg <= MULTIPOINT_MAX_SPREAD * count;
+
+}
+
+void PolyAtMany(const Poly *p, size_t count, const poly_coeff_t *xs,
+                Poly *results) {
+
+    if (count == FIRST_IDX) return;
+    if (PolyIsCoeff(p) || !AllCoeffsConstant(p) || !UseHorner(p)) {
+        AtManyJob job = (AtManyJob) {.p = p, .xs = xs, .results = results};
+        ParallelFor(count, AtPointTask, &job);
+        return;
+    }
+
+    // Gęsty wielomian o stałych współczynnikach zapisujemy jako tablicę
+    // współczynników przy kolejnych potęgach zmiennej.
+    ArenaMark mark = ArenaGetMark();
+    size_t len = (size_t) MonoGetExp(&p -> arr[FIRST_IDX]) + ONE_ELEMENT;
+    uint64_t *coeffs = (uint64_t *) ArenaAlloc(len * sizeof(uint64_t));
+    memset(coeffs, FIRST_IDX, len * sizeof(uint64_t));
+    for (size_t i = FIRST_IDX; i < p -> size; i++)
+        coeffs[MonoGetExp(&p -> arr[i])] = (uint64_t) p -> arr[i].p.coeff;
+    uint64_t *values = (uint64_t *) ArenaAlloc(count * sizeof(uint64_t));
+    if (UseMultipoint(p, count))
+        MultipointEval(coeffs, len, count, (const uint64_t *) xs, values);
+    else HornerBatch(coeffs, len, count, (const uint64_t *) xs, values);
+    for (size_t i = FIRST_IDX; i < count; i++)
+        results[i] = PolyFromCoeff((poly_coeff_t) values[i]);
+    ArenaReset(mark);
+
+}
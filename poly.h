@@ -135,14 +135,16 @@ static inline void MonoDestroy(Mono *m) {
 }
 
 /**
- * Robi pełną, głęboką kopię wielomianu.
+ * Robi kopię wielomianu. Kopia współdzieli tablicę jednomianów z oryginałem
+ * i zwiększa jej licznik odwołań, więc działa w czasie stałym. Operacje
+ * zmieniające wielomian w miejscu kopiują współdzielone tablice.
  * @param[in] p : wielomian
  * @return skopiowany wielomian
  */
 Poly PolyClone(const Poly *p);
 
 /**
- * Robi pełną, głęboką kopię jednomianu.
+ * Robi kopię jednomianu, współdzieląc jego współczynnik z oryginałem.
  * @param[in] m : jednomian
  * @return skopiowany jednomian
  */
@@ -190,6 +192,17 @@ Poly PolyCloneMonos(size_t count, const Mono monos[]);
  */
 Poly PolyAddMonos(size_t count, const Mono monos[]);
 
+/**
+ * Tworzy wielomian z jednomianów o niezerowych współczynnikach i ściśle
+ * malejących wykładnikach. Nie sortuje jednomianów ani nie sprawdza, czy ich
+ * współczynniki są zerowe, więc działa w czasie liniowym względem @p count.
+ * Przejmuje na własność zawartość tablicy @p monos.
+ * @param[in] count : liczba jednomianów
+ * @param[in] monos : tablica jednomianów
+ * @return wielomian złożony z jednomianów
+ */
+Poly PolyFromSortedMonos(size_t count, const Mono monos[]);
+
 /**
  * Mnoży dwa wielomiany.
  * @param[in] p : wielomian @f$p@f$
@@ -230,6 +243,13 @@ Poly PolyCompose(const Poly *p, size_t k, const Poly q[]);
  */
 Poly PolyNeg(const Poly *p);
 
+/**
+ * Zamienia wielomian @p p na przeciwny. Tablice jednomianów, do których nie
+ * ma innych odwołań, są zmieniane w miejscu, a współdzielone są kopiowane.
+ * @param[in,out] p : wielomian @f$p@f$, po wywołaniu @f$-p@f$
+ */
+void PolyNegInPlace(Poly *p);
+
 /**
  * Odejmuje wielomian od wielomianu.
  * @param[in] p : wielomian @f$p@f$
@@ -257,6 +277,35 @@ poly_exp_t PolyDegBy(const Poly *p, size_t var_idx);
  */
 poly_exp_t PolyDeg(const Poly *p);
 
+/**
+ * Zwraca liczbę wyrazów wielomianu po rozwinięciu go do sumy jednomianów
+ * wielu zmiennych, czyli liczbę niezerowych współczynników liczbowych.
+ * Wynik dla każdej tablicy jednomianów jest liczony raz i zapamiętywany
+ * w jej nagłówku, więc kolejne wywołania dla tego samego wielomianu
+ * lub wielomianów z nim współdzielonych są natychmiastowe.
+ * @param[in] p : wielomian
+ * @return liczba wyrazów wielomianu @p p
+ */
+size_t PolyTerms(const Poly *p);
+
+/**
+ * To jest struktura przechowująca rozmiar wielomianu w pamięci.
+ */
+typedef struct PolyFootprint {
+    size_t nodes; ///< liczba różnych tablic jednomianów
+    size_t depth; ///< głębokość, czyli zero dla współczynnika
+    size_t bytes; ///< liczba bajtów tablic jednomianów razem z nagłówkami
+} PolyFootprint;
+
+/**
+ * Wylicza rozmiar wielomianu w pamięci. Tablice jednomianów współdzielone
+ * przez kilka poddrzew są liczone raz, a głębokość wielomianu niestałego
+ * jest o jeden większa od największej głębokości jego współczynników.
+ * @param[in] p : wielomian
+ * @return rozmiar wielomianu @p p
+ */
+PolyFootprint PolyGetFootprint(const Poly *p);
+
 /**
  * Sprawdza równość dwóch wielomianów.
  * @param[in] p : wielomian @f$p@f$
@@ -278,4 +327,20 @@ bool PolyIsEq(const Poly *p, const Poly *q);
  */
 Poly PolyAt(const Poly *p, poly_coeff_t x);
 
+/**
+ * Wylicza wartości wielomianu w punktach @p xs, tak jak funkcja PolyAt
+ * wywołana dla każdego z punktów. Jeśli wszystkie współczynniki są stałe,
+ * to wartości są liczone schematem Hornera w kilku punktach naraz, a przy
+ * bardzo wielu punktach przy pomocy drzewa reszt z dzielenia przez
+ * iloczyny @f$\prod (x - a_i)@f$.
+ * Wywołujący powinien usunąć wielomiany wynikowe.
+ * @param[in] p : wielomian @f$p@f$
+ * @param[in] count : liczba punktów
+ * @param[in] xs : punkty @f$a_0, a_1, \ldots, a_{count - 1}@f$
+ * @param[out] results : tablica na @p count wielomianów
+ * @f$p(a_i, x_0, x_1, ...)@f$
+ */
+void PolyAtMany(const Poly *p, size_t count, const poly_coeff_t *xs,
+                Poly *results);
+
 #endif /* __POLY_H__ */
\ No newline at end of file
@@ -0,0 +1,450 @@
+/** @file
+  Mikrobenchmarki operacji na wielomianach rzadkich wielu zmiennych.
+  Wielomiany generowane są losowo z zadanego ziarna, więc kolejne
+  uruchomienia mierzą te same dane. Dla każdej operacji i każdej kombinacji
+  parametrów generatora program mierzy czas operacji i wypisuje wyniki na
+  standardowe wyjście w formacie JSON.
+  @author Julia Podrażka
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/resource.h>
+
+#include "poly.h"
+#include "mono_pool.h"
+#include "thread_pool.h"
+#include "writer.h"
+#include "make_poly.h"
+#include "cli_common.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Dwa elementy w tablicy. */
+#define TWO_ELEMENTS 2
+/** Kod ascii znaku zerowego. */
+#define NULL_CHAR 0
+/** Baza konwertowania liczb. */
+#define BASE 10
+/** Znak oddzielający wartości na liście. */
+#define SEPARATOR ","
+/** Maksymalna liczba wartości parametru w przeglądzie. */
+#define MAX_VALUES 16
+/** Maksymalna liczba zmiennych wielomianu. */
+#define MAX_VARS 16
+/** Maksymalny stopień wielomianu składanego w benchmarku złożenia. */
+#define COMPOSE_DEGREE 4
+/** Liczba jednomianów wielomianów podstawianych w benchmarku złożenia. */
+#define COMPOSE_TERMS 2
+/** Liczba nanosekund w sekundzie. */
+#define NANOSECONDS 1000000000.0
+/** Liczba nanosekund w milisekundzie. */
+#define MILLISECOND 1000000.0
+/** Domyślne ziarno generatora. */
+#define DEFAULT_SEED 42
+/** Domyślny minimalny czas pomiaru w milisekundach. */
+#define DEFAULT_MIN_TIME 100
+/** Maksymalna liczba wątków. */
+#define MAX_THREADS 1024
+
+/**
+ * To jest struktura przechowująca parametry generatora wielomianów.
+ */
+typedef struct GenParams {
+    size_t vars; ///< liczba zmiennych
+    size_t terms; ///< liczba losowanych wyrazów
+    size_t degree; ///< maksymalny wykładnik zmiennej
+    size_t depth; ///< liczba zmiennych o niezerowym wykładniku w wyrazie
+    size_t coeff; ///< współczynniki są z przedziału [-coeff, coeff]
+} GenParams;
+
+/**
+ * To jest struktura przechowująca dane wejściowe mierzonej operacji.
+ */
+typedef struct BenchInput {
+    Poly p; ///< pierwszy argument
+    Poly q; ///< drugi argument
+    Poly args[MAX_VARS]; ///< wielomiany podstawiane przy złożeniu
+    size_t vars; ///< liczba podstawianych wielomianów
+    poly_coeff_t x; ///< punkt, w którym liczona jest wartość
+    char *text; ///< tekst wielomianu @p p zakończony znakiem zerowym
+} BenchInput;
+
+/**
+ * To jest struktura opisująca mierzoną operację.
+ */
+typedef struct BenchOp {
+    const char *name; ///< nazwa operacji
+    /** Wykonuje operację i zwraca jej wynik. */
+    Poly (*run)(const BenchInput *input);
+    size_t max_degree; ///< maksymalny stopień argumentu albo 0
+} BenchOp;
+
+/**
+ * Generuje losowy wielomian rzadki. Każdy wyraz ma losowy niezerowy
+ * współczynnik i losowe wykładniki co najwyżej @p depth zmiennych. Wyrazy
+ * o tych samych wykładnikach są sumowane.
+ * @param[in,out] state : stan generatora
+ * @param[in] params : parametry generatora
+ * @return wielomian
+ */
+static Poly GeneratePoly(uint64_t *state, const GenParams *params) {
+
+    Mono *monos = (Mono *) malloc(params -> terms * sizeof(Mono));
+    CHECK_PTR(monos);
+    poly_exp_t exps[MAX_VARS];
+    for (size_t i = FIRST_IDX; i < params -> terms; i++) {
+        memset(exps, FIRST_IDX, sizeof(exps));
+        for (size_t j = FIRST_IDX; j < params -> depth; j++) {
+            size_t var = RandomUpTo(state, params -> vars - ONE_ELEMENT);
+            exps[var] = (poly_exp_t) RandomUpTo(state, params -> degree);
+        }
+        poly_coeff_t coeff = (poly_coeff_t) RandomUpTo(state, params -> coeff -
+                                                              ONE_ELEMENT) + ONE_ELEMENT;
+        if (NextRandom(state) & ONE_ELEMENT) coeff = -coeff;
+
+        Poly p = PolyFromCoeff(coeff);
+        for (size_t var = params -> vars - ONE_ELEMENT; var > FIRST_IDX; var--) {
+            Mono mono = MonoFromPoly(&p, exps[var]);
+            p = PolyAddMonos(ONE_ELEMENT, &mono);
+        }
+        monos[i] = MonoFromPoly(&p, exps[FIRST_IDX]);
+    }
+    Poly p = PolyAddMonos(params -> terms, monos);
+    free(monos);
+    return p;
+
+}
+
+/**
+ * Zlicza niezerowe współczynniki stałe wielomianu.
+ * @param[in] p : wielomian
+ * @return liczba wyrazów wielomianu
+ */
+static size_t CountTerms(const Poly *p) {
+
+    if (PolyIsCoeff(p)) return PolyIsZero(p) ? FIRST_IDX : ONE_ELEMENT;
+    size_t terms = FIRST_IDX;
+    for (size_t i = FIRST_IDX; i < p -> size; i++) terms += CountTerms(&p -> arr[i].p);
+    return terms;
+
+}
+
+/**
+ * Zamienia wielomian na tekst w formacie komendy PRINT.
+ * @param[in] p : wielomian
+ * @return tekst zakończony znakiem zerowym
+ */
+static char *PolyToText(const Poly *p) {
+
+    FILE *file = tmpfile();
+    CHECK_PTR(file);
+    Writer writer;
+    WriterInit(&writer, fileno(file), false);
+    WritePoly(&writer, p);
+    WriterFree(&writer);
+    off_t length = lseek(fileno(file), FIRST_IDX, SEEK_END);
+    char *text = (char *) malloc((size_t) length + ONE_ELEMENT);
+    CHECK_PTR(text);
+    if (pread(fileno(file), text, (size_t) length, FIRST_IDX) != length) exit(1);
+    text[length] = NULL_CHAR;
+    fclose(file);
+    return text;
+
+}
+
+/**
+ * Zwraca łączną liczbę tablic jednomianów przydzielonych przez pulę.
+ * @return liczba przydzielonych tablic
+ */
+static size_t CountAllocs(void) {
+
+    size_t allocs = FIRST_IDX;
+    for (size_t i = FIRST_IDX; i <= MonoPoolClassCount(); i++)
+        allocs += MonoPoolGetStats(i).allocs;
+    return allocs;
+
+}
+
+/**
+ * Zwraca czas zegara monotonicznego.
+ * @return czas w nanosekundach
+ */
+static double Now(void) {
+
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double) time.tv_sec * NANOSECONDS + (double) time.tv_nsec;
+
+}
+
+/**
+ * Dodaje argumenty.
+ * @param[in] input : dane wejściowe
+ * @return @f$p + q@f$
+ */
+static Poly RunAdd(const BenchInput *input) {
+
+    return PolyAdd(&input -> p, &input -> q);
+
+}
+
+/**
+ * Mnoży argumenty.
+ * @param[in] input : dane wejściowe
+ * @return @f$p * q@f$
+ */
+static Poly RunMul(const BenchInput *input) {
+
+    return PolyMul(&input -> p, &input -> q);
+
+}
+
+/**
+ * Składa pierwszy argument z wielomianami podstawianymi.
+ * @param[in] input : dane wejściowe
+ * @return złożenie
+ */
+static Poly RunCompose(const BenchInput *input) {
+
+    return PolyCompose(&input -> p, input -> vars, input -> args);
+
+}
+
+/**
+ * Wylicza wartość pierwszego argumentu w punkcie.
+ * @param[in] input : dane wejściowe
+ * @return @f$p(x, x_0, x_1, ...)@f$
+ */
+static Poly RunAt(const BenchInput *input) {
+
+    return PolyAt(&input -> p, input -> x);
+
+}
+
+/**
+ * Parsuje tekst pierwszego argumentu.
+ * @param[in] input : dane wejściowe
+ * @return wczytany wielomian
+ */
+static Poly RunParse(const BenchInput *input) {
+
+    Poly p;
+    if (!MakePoly(input -> text, &p)) exit(1);
+    return p;
+
+}
+
+/** Mierzone operacje. */
+static const BenchOp OPS[] = {
+    {.name = "add", .run = RunAdd, .max_degree = FIRST_IDX},
+    {.name = "mul", .run = RunMul, .max_degree = FIRST_IDX},
+    {.name = "compose", .run = RunCompose, .max_degree = COMPOSE_DEGREE},
+    {.name = "at", .run = RunAt, .max_degree = FIRST_IDX},
+    {.name = "parse", .run = RunParse, .max_degree = FIRST_IDX}
+};
+
+/** Liczba mierzonych operacji. */
+#define OP_COUNT (sizeof(OPS) / sizeof(OPS[FIRST_IDX]))
+
+/**
+ * Wykonuje operację @p count razy.
+ * @param[in] op : operacja
+ * @param[in] input : dane wejściowe
+ * @param[in] count : liczba powtórzeń
+ * @return czas wykonania w nanosekundach
+ */
+static double TimeOp(const BenchOp *op, const BenchInput *input, size_t count) {
+
+    double start = Now();
+    for (size_t i = FIRST_IDX; i < count; i++) {
+        Poly result = op -> run(input);
+        PolyDestroy(&result);
+    }
+    return Now() - start;
+
+}
+
+/**
+ * Mierzy operację dla danych wygenerowanych z parametrów @p params
+ * i wypisuje wynik jako obiekt JSON. Liczba powtórzeń jest podwajana, aż
+ * pomiar trwa co najmniej @p min_time nanosekund.
+ * @param[in] op : operacja
+ * @param[in] params : parametry generatora
+ * @param[in] seed : ziarno generatora
+ * @param[in] min_time : minimalny czas pomiaru w nanosekundach
+ * @param[in] is_first : czy jest to pierwszy wypisywany wynik
+ */
+static void RunCase(const BenchOp *op, GenParams params, uint64_t seed,
+                    double min_time, bool is_first) {
+
+    if (op -> max_degree > FIRST_IDX && params.degree > op -> max_degree)
+        params.degree = op -> max_degree;
+    uint64_t state = seed;
+    BenchInput input;
+    input.p = GeneratePoly(&state, &params);
+    input.q = GeneratePoly(&state, &params);
+    GenParams arg_params = (GenParams) {.vars = params.vars, .terms = COMPOSE_TERMS,
+                                        .degree = TWO_ELEMENTS, .depth = ONE_ELEMENT,
+                                        .coeff = params.coeff};
+    input.vars = params.vars;
+    for (size_t i = FIRST_IDX; i < params.vars; i++)
+        input.args[i] = GeneratePoly(&state, &arg_params);
+    // Parzysty punkt przy dużych wykładnikach daje zero modulo 2^64.
+    input.x = (poly_coeff_t) (RandomUpTo(&state, params.coeff) | ONE_ELEMENT);
+    input.text = PolyToText(&input.p);
+
+    Poly result = op -> run(&input);
+    size_t result_terms = CountTerms(&result);
+    PolyDestroy(&result);
+    size_t input_terms = CountTerms(&input.p);
+    if (op -> run == RunAdd || op -> run == RunMul) input_terms += CountTerms(&input.q);
+
+    size_t count = ONE_ELEMENT;
+    size_t allocs = CountAllocs();
+    double elapsed = TimeOp(op, &input, count);
+    while (elapsed < min_time) {
+        count *= TWO_ELEMENTS;
+        allocs = CountAllocs();
+        elapsed = TimeOp(op, &input, count);
+    }
+    allocs = CountAllocs() - allocs;
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+
+    printf("%s    {\"op\": \"%s\", \"vars\": %zu, \"terms\": %zu, \"degree\": %zu, "
+           "\"depth\": %zu, \"coeff\": %zu, \"input_terms\": %zu, "
+           "\"result_terms\": %zu, \"iterations\": %zu, \"ns_per_op\": %.1f, "
+           "\"terms_per_s\": %.1f, \"allocs_per_op\": %.2f, \"peak_rss_kb\": %ld}",
+           is_first ? "" : ",\n", op -> name, params.vars, params.terms,
+           params.degree, params.depth, params.coeff, input_terms, result_terms,
+           count, elapsed / (double) count,
+           (double) input_terms * (double) count * NANOSECONDS / elapsed,
+           (double) allocs / (double) count, usage.ru_maxrss);
+
+    PolyDestroy(&input.p);
+    PolyDestroy(&input.q);
+    for (size_t i = FIRST_IDX; i < params.vars; i++) PolyDestroy(&input.args[i]);
+    free(input.text);
+
+}
+
+/**
+ * Odczytuje wartość opcji będącej listą dodatnich liczb oddzielonych
+ * przecinkami.
+ * @param[in] arg : argument programu
+ * @param[in] option : nazwa opcji razem ze znakiem równości
+ * @param[in] max : maksymalna wartość
+ * @param[out] values : wartości
+ * @param[out] count : liczba wartości
+ * @return Czy argument jest poprawną opcją @p option?
+ */
+static bool ParseList(const char *arg, const char *option, size_t max,
+                      size_t values[], size_t *count) {
+
+    size_t length = strlen(option);
+    if (strncmp(arg, option, length) != 0) return false;
+    const char *value = arg + length;
+    size_t parsed_count = FIRST_IDX;
+    while (parsed_count < MAX_VALUES && isdigit(*value)) {
+        char *end;
+        unsigned long long parsed = strtoull(value, &end, BASE);
+        if (parsed == FIRST_IDX || parsed > max) return false;
+        values[parsed_count++] = (size_t) parsed;
+        if (*end == NULL_CHAR) {
+            *count = parsed_count;
+            return true;
+        }
+        if (*end != *SEPARATOR) return false;
+        value = end + ONE_ELEMENT;
+    }
+    return false;
+
+}
+
+/**
+ * Funkcja wykonująca benchmarki. Parametry generatora podawane są jako
+ * listy wartości, a mierzone są wszystkie ich kombinacje. Obsługiwane opcje:
+ * - `--vars=LISTA`, `--terms=LISTA`, `--degree=LISTA`, `--depth=LISTA`,
+ *   `--coeff=LISTA` ustawiają wartości parametrów generatora; głębokość
+ *   większa od liczby zmiennych jest do niej zmniejszana,
+ * - `--ops=NAZWY` wybiera operacje spośród add, mul, compose, at i parse,
+ * - `--seed=N` ustawia ziarno generatora,
+ * - `--min-time=MS` ustawia minimalny czas pomiaru w milisekundach,
+ * - `--threads=N` wykonuje obliczenia przy pomocy @p N wątków.
+ * @param[in] argc : liczba argumentów
+ * @param[in] argv : argumenty
+ * @return kod wyjścia programu
+ */
+int main(int argc, char *argv[]) {
+
+    size_t vars[MAX_VALUES] = {1, 3}, vars_count = TWO_ELEMENTS;
+    size_t terms[MAX_VALUES] = {16, 128, 1024}, terms_count = 3;
+    size_t degrees[MAX_VALUES] = {1000}, degree_count = ONE_ELEMENT;
+    size_t depths[MAX_VALUES] = {2}, depth_count = ONE_ELEMENT;
+    size_t coeffs[MAX_VALUES] = {1000}, coeff_count = ONE_ELEMENT;
+    size_t seed = DEFAULT_SEED, min_time = DEFAULT_MIN_TIME, threads = ONE_ELEMENT;
+    bool selected[OP_COUNT];
+    for (size_t i = FIRST_IDX; i < OP_COUNT; i++) selected[i] = true;
+
+    for (int i = ONE_ELEMENT; i < argc; i++) {
+        if (ParseList(argv[i], "--vars=", MAX_VARS, vars, &vars_count) ||
+            ParseList(argv[i], "--terms=", SIZE_MAX, terms, &terms_count) ||
+            ParseList(argv[i], "--degree=", INT32_MAX, degrees, &degree_count) ||
+            ParseList(argv[i], "--depth=", MAX_VARS, depths, &depth_count) ||
+            ParseList(argv[i], "--coeff=", INT32_MAX, coeffs, &coeff_count) ||
+            ParseCount(argv[i], "--seed=", SIZE_MAX, &seed) ||
+            ParseCount(argv[i], "--min-time=", SIZE_MAX, &min_time) ||
+            ParseCount(argv[i], "--threads=", MAX_THREADS, &threads)) continue;
+        if (strncmp(argv[i], "--ops=", strlen("--ops=")) == 0) {
+            char *names = strdup(argv[i] + strlen("--ops="));
+            CHECK_PTR(names);
+            for (size_t j = FIRST_IDX; j < OP_COUNT; j++) selected[j] = false;
+            bool is_correct = true;
+            for (char *name = strtok(names, SEPARATOR); name != NULL;
+                 name = strtok(NULL, SEPARATOR)) {
+                size_t j = FIRST_IDX;
+                while (j < OP_COUNT && strcmp(OPS[j].name, name) != 0) j++;
+                if (j == OP_COUNT) is_correct = false;
+                else selected[j] = true;
+            }
+            free(names);
+            if (is_correct) continue;
+        }
+        fprintf(stderr, "UNKNOWN OPTION %s\n", argv[i]);
+        return 1;
+    }
+
+    ThreadPoolStart(threads);
+    printf("{\"seed\": %zu, \"threads\": %zu, \"min_time_ms\": %zu, \"results\": [\n",
+           seed, threads, min_time);
+    bool is_first = true;
+    for (size_t o = FIRST_IDX; o < OP_COUNT; o++) {
+        if (!selected[o]) continue;
+        for (size_t a = FIRST_IDX; a < vars_count; a++)
+            for (size_t b = FIRST_IDX; b < terms_count; b++)
+                for (size_t c = FIRST_IDX; c < degree_count; c++)
+                    for (size_t d = FIRST_IDX; d < depth_count; d++)
+                        for (size_t e = FIRST_IDX; e < coeff_count; e++) {
+                            GenParams params = (GenParams) {
+                                    .vars = vars[a], .terms = terms[b],
+                                    .degree = degrees[c],
+                                    .depth = depths[d] < vars[a] ? depths[d] : vars[a],
+                                    .coeff = coeffs[e]};
+                            RunCase(&OPS[o], params, seed,
+                                    (double) min_time * MILLISECOND, is_first);
+                            is_first = false;
+                            fflush(stdout);
+                        }
+    }
+    printf("\n]}\n");
+    ThreadPoolStop();
+    return 0;
+
+}
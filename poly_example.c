@@ -3,10 +3,24 @@
 #endif
 
 #include "poly.h"
+#include "flat_poly.h"
+#include "multipoint.h"
+#include "intern.h"
+#include "thread_pool.h"
+#include "stack.h"
+#include "snapshot.h"
+#include "library.h"
+#include "make_poly.h"
+#include "program.h"
+#include "writer.h"
+#include <unistd.h>
 #include <assert.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
 
 #define CHECK_PTR(p)  \
   do {                \
@@ -240,6 +254,51 @@ static bool SimpleMulTest(void) {
     return res;
 }
 
+static bool LargeMulTest(void) {
+    bool res = true;
+    res &= TestMul(P(C(1), 0, C(1), 1, C(1), 2, C(1), 3,
+                     C(1), 4, C(1), 5, C(1), 6, C(1), 7),
+                   P(C(1), 0, C(1), 1, C(1), 2, C(1), 3,
+                     C(1), 4, C(1), 5, C(1), 6, C(1), 7),
+                   P(C(1), 0, C(2), 1, C(3), 2, C(4), 3, C(5), 4,
+                     C(6), 5, C(7), 6, C(8), 7, C(7), 8, C(6), 9,
+                     C(5), 10, C(4), 11, C(3), 12, C(2), 13, C(1), 14));
+    res &= TestMul(P(C(1), 0, C(1), 1, C(1), 2, C(1), 3,
+                     C(1), 4, C(1), 5, C(1), 6, C(1), 7),
+                   P(C(1), 0, C(-1), 1, C(1), 8, C(-1), 9,
+                     C(1), 16, C(-1), 17, C(1), 24, C(-1), 25),
+                   P(C(1), 0, C(-1), 32));
+    return res;
+}
+
+static Poly DenseTestPoly(size_t n, poly_coeff_t shift) {
+    Mono *outer = calloc(n, sizeof(Mono));
+    CHECK_PTR(outer);
+    for (size_t i = 0; i < n; i++) {
+        Mono *inner = calloc(n, sizeof(Mono));
+        CHECK_PTR(inner);
+        for (size_t j = 0; j < n; j++)
+            inner[j] = M(C((poly_coeff_t) (i * j) % 7 - shift), (poly_exp_t) (2 * j));
+        outer[i] = M(PolyOwnMonos(n, inner), (poly_exp_t) (3 * i));
+    }
+    return PolyOwnMonos(n, outer);
+}
+
+static bool ParallelMulTest(void) {
+    Poly a = DenseTestPoly(40, 3);
+    Poly b = DenseTestPoly(30, 2);
+    Poly serial = PolyMul(&a, &b);
+    ThreadPoolStart(4);
+    Poly parallel = PolyMul(&a, &b);
+    ThreadPoolStop();
+    bool res = PolyIsEq(&serial, &parallel);
+    PolyDestroy(&a);
+    PolyDestroy(&b);
+    PolyDestroy(&serial);
+    PolyDestroy(&parallel);
+    return res;
+}
+
 static bool SimpleNegTest(void) {
     Poly a = P(P(C(1), 0, C(2), 2), 0, P(C(1), 1), 1, C(1), 2);
     Poly b = PolyNeg(&a);
@@ -318,6 +377,375 @@ static bool OverflowTest(void) {
     return res;
 }
 
+static bool AtManyTest(void) {
+    size_t n = 300;
+    Mono *monos = calloc(n, sizeof(Mono));
+    CHECK_PTR(monos);
+    for (size_t i = 0; i < n; i++)
+        monos[i] = M(C((poly_coeff_t) (i * 0x9E3779B97F4A7C15UL)), (poly_exp_t) i);
+    Poly dense = PolyOwnMonos(n, monos);
+    Poly nested = POLY_P;
+    poly_coeff_t xs[200];
+    for (size_t i = 0; i < 200; i++)
+        xs[i] = (poly_coeff_t) (i * 0xD1B54A32D192ED03UL) + (poly_coeff_t) i % 5;
+    Poly results[200];
+    bool res = true;
+    PolyAtMany(&dense, 200, xs, results);
+    for (size_t i = 0; i < 200; i++) {
+        res &= TestAt(PolyClone(&dense), xs[i], results[i]);
+    }
+    PolyAtMany(&nested, 3, xs, results);
+    for (size_t i = 0; i < 3; i++) {
+        res &= TestAt(PolyClone(&nested), xs[i], results[i]);
+    }
+    PolyDestroy(&dense);
+    PolyDestroy(&nested);
+    return res;
+}
+
+static bool MultipointTest(void) {
+    // PolyAtMany używa drzewa reszt dopiero od tysięcy punktów, więc
+    // porównujemy je bezpośrednio ze schematem Hornera, także dla rozmiarów
+    // niebędących potęgami dwójki i dla powtarzających się punktów.
+    size_t sizes[][2] = {{1, 1}, {1, 5}, {7, 1}, {2, 2}, {300, 200},
+                         {513, 1000}, {2000, 1537}};
+    uint64_t *coeffs = malloc(2000 * sizeof(uint64_t));
+    uint64_t *xs = malloc(2000 * sizeof(uint64_t));
+    uint64_t *tree = malloc(2000 * sizeof(uint64_t));
+    uint64_t *horner = malloc(2000 * sizeof(uint64_t));
+    CHECK_PTR(coeffs);
+    CHECK_PTR(xs);
+    CHECK_PTR(tree);
+    CHECK_PTR(horner);
+    for (size_t i = 0; i < 2000; i++) {
+        coeffs[i] = i * 0x9E3779B97F4A7C15UL + 1;
+        xs[i] = i % 7 == 0 ? i % 3 : i * 0xD1B54A32D192ED03UL;
+    }
+    bool res = true;
+    for (size_t t = 0; t < sizeof(sizes) / sizeof(sizes[0]); t++) {
+        size_t len = sizes[t][0], count = sizes[t][1];
+        MultipointEval(coeffs, len, count, xs, tree);
+        HornerBatch(coeffs, len, count, xs, horner);
+        res &= memcmp(tree, horner, count * sizeof(uint64_t)) == 0;
+    }
+    Mono monos[300];
+    for (size_t i = 0; i < 300; i++)
+        monos[i] = M(C((poly_coeff_t) coeffs[i]), (poly_exp_t) i);
+    Poly p = PolyAddMonos(300, monos);
+    MultipointEval(coeffs, 300, 200, xs, tree);
+    for (size_t i = 0; i < 200; i++)
+        res &= TestAt(PolyClone(&p), (poly_coeff_t) xs[i], C((poly_coeff_t) tree[i]));
+    PolyDestroy(&p);
+    free(coeffs);
+    free(xs);
+    free(tree);
+    free(horner);
+    return res;
+}
+
+static bool TestFlatOp(Poly a, Poly b,
+                       Poly (*op)(const Poly *, const Poly *),
+                       FlatPoly *(*flat_op)(const FlatPoly *, const FlatPoly *)) {
+    FlatPoly *fa = FlatPolyFromPoly(&a);
+    FlatPoly *fb = FlatPolyFromPoly(&b);
+    FlatPoly *fc = flat_op(fa, fb);
+    Poly c = op(&a, &b);
+    Poly d = FlatPolyToPoly(fc);
+    FlatPoly *fd = FlatPolyFromPoly(&c);
+    bool is_eq = PolyIsEq(&c, &d) && FlatPolyIsEq(fc, fd);
+    FlatPolyDestroy(fa);
+    FlatPolyDestroy(fb);
+    FlatPolyDestroy(fc);
+    FlatPolyDestroy(fd);
+    PolyDestroy(&a);
+    PolyDestroy(&b);
+    PolyDestroy(&c);
+    PolyDestroy(&d);
+    return is_eq;
+}
+
+static bool FlatPolyTest(void) {
+    bool res = true;
+    res &= TestFlatOp(P(P(C(1), 2), 0, C(2), 1), C(3), PolyAdd, FlatPolyAdd);
+    res &= TestFlatOp(P(C(1), 1), P(C(-1), 1), PolyAdd, FlatPolyAdd);
+    res &= TestFlatOp(P(P(C(1), 0, C(1), 1), 1), P(P(C(1), 0, C(-1), 1), 1),
+                      PolyMul, FlatPolyMul);
+    res &= TestFlatOp(P(C(1L << 32), 1), C(1L << 32), PolyMul, FlatPolyMul);
+    Poly p = P(P(C(1), 4), 0, P(C(1), 2), 2, C(1), 3);
+    FlatPoly *fp = FlatPolyFromPoly(&p);
+    FlatPoly *at = FlatPolyAt(fp, 2);
+    Poly expected = P(C(8), 0, C(4), 2, C(1), 4);
+    FlatPoly *fe = FlatPolyFromPoly(&expected);
+    res &= FlatPolyIsEq(at, fe);
+    res &= FlatPolyDeg(fp) == PolyDeg(&p);
+    res &= FlatPolyDegBy(fp, 1) == PolyDegBy(&p, 1);
+    FlatPoly *clone = FlatPolyClone(fp);
+    Poly back = FlatPolyToPoly(clone);
+    res &= PolyIsEq(&back, &p);
+    FlatPolyDestroy(fp);
+    FlatPolyDestroy(at);
+    FlatPolyDestroy(fe);
+    FlatPolyDestroy(clone);
+    PolyDestroy(&p);
+    PolyDestroy(&expected);
+    PolyDestroy(&back);
+    return res;
+}
+
+static bool InternTest(void) {
+    bool res = true;
+    InternEnable();
+    Poly p = P(P(C(1), 1, C(2), 3), 2, C(1), 0);
+    Poly q = P(P(C(1), 1, C(2), 3), 2, C(1), 0);
+    res &= p.arr == q.arr;
+    res &= p.arr[1].p.arr == q.arr[1].p.arr;
+    Poly r = P(P(C(1), 0), 1);
+    Poly s = P(C(1), 1);
+    res &= r.arr != s.arr;
+    res &= PolyIsEq(&r, &s);
+    res &= !PolyIsEq(&p, &s);
+    Poly mul1 = PolyMul(&p, &q);
+    Poly mul2 = PolyMul(&q, &p);
+    res &= mul1.arr == mul2.arr;
+    PolyNegInPlace(&mul2);
+    res &= mul1.arr != mul2.arr;
+    Poly sum = PolyAdd(&mul1, &mul2);
+    res &= PolyIsZero(&sum);
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    PolyDestroy(&r);
+    PolyDestroy(&s);
+    PolyDestroy(&mul1);
+    PolyDestroy(&mul2);
+    PolyDestroy(&sum);
+    InternClear();
+    return res;
+}
+
+static bool SnapshotTest(void) {
+    const char *path = "poly_example_snapshot.bin";
+    stack s = InitStack();
+    Push(&s, POLY_P);
+    Push(&s, C(-9223372036854775807L - 1));
+    Push(&s, P(P(P(C(1), 0), 0), 0, P(C(2), 1L << 30), 1));
+    bool res = SnapshotSave(&s, path);
+    stack t = InitStack();
+    res &= SnapshotLoad(&t, path);
+    res &= NumberOfElements(&t) == NumberOfElements(&s);
+    while (res && !IsEmpty(&s)) {
+        Poly p = Pop(&s);
+        Poly q = Pop(&t);
+        res &= PolyIsEq(&p, &q);
+        PolyDestroy(&p);
+        PolyDestroy(&q);
+    }
+    res &= !SnapshotLoad(&t, "poly_example_missing.bin");
+    res &= IsEmpty(&t);
+    remove(path);
+    RemoveStack(&s);
+    RemoveStack(&t);
+    return res;
+}
+
+static bool LibraryTest(void) {
+    const char *path = "poly_example_library.lib";
+    char *names[] = {"a", "b", "chain"};
+    Poly chain = C(1);
+    for (size_t i = 0; i < 2000; i++)
+        chain = PolyAddMonos(2, (Mono[]) {M(chain, 1), M(C(1), 0)});
+    stack s = InitStack();
+    Push(&s, POLY_P);
+    Push(&s, P(P(C(3), 1, C(-4), 0), 3, C(5), 0));
+    Push(&s, chain);
+    bool res = LibrarySave(&s, 3, names, path) && LibraryOpen(path);
+    Poly p;
+    res &= LibraryFind("chain", &p) && PolyIsEq(&p, &chain);
+    LibraryClose();
+    RemoveStack(&s);
+
+    // Biblioteka ze zmienionym dowolnym bajtem musi zostać odrzucona albo
+    // dawać się bezpiecznie odczytać.
+    s = InitStack();
+    Push(&s, POLY_P);
+    Push(&s, P(P(C(3), 1, C(-4), 0), 3, C(5), 0));
+    res &= LibrarySave(&s, 2, names, path);
+    FILE *file = fopen(path, "rb");
+    char bytes[4096];
+    size_t size = file == NULL ? 0 : fread(bytes, 1, sizeof(bytes), file);
+    if (file != NULL) fclose(file);
+    res &= size > 0 && size < sizeof(bytes);
+    for (size_t i = 0; res && i < size; i++) {
+        bytes[i] ^= (char) 0xA5;
+        file = fopen(path, "wb");
+        res &= file != NULL && fwrite(bytes, 1, size, file) == size;
+        if (file != NULL) fclose(file);
+        bytes[i] ^= (char) 0xA5;
+        if (!res || !LibraryOpen(path)) continue;
+        for (size_t j = 0; j < 2; j++) {
+            if (!LibraryFind(names[j], &p)) continue;
+            Poly q = PolyMul(&p, &p);
+            PolyDestroy(&q);
+        }
+        LibraryClose();
+    }
+    remove(path);
+    RemoveStack(&s);
+    return res;
+}
+
+static bool ParseTest(const char *line, Poly expected) {
+    Poly p;
+    bool res = MakePoly(line, &p) && PolyIsEq(&p, &expected);
+    if (res) PolyDestroy(&p);
+    PolyDestroy(&expected);
+    return res;
+}
+
+static double ParseChain(size_t depth, bool *res) {
+    char *line = malloc(4 * depth + 2);
+    assert(line);
+    memset(line, '(', depth);
+    line[depth] = '1';
+    for (size_t i = 0; i < depth; i++) memcpy(line + depth + 1 + 3 * i, ",1)", 3);
+    line[4 * depth + 1] = '\0';
+    clock_t start = clock();
+    Poly p;
+    *res &= MakePoly(line, &p);
+    double time = (double) (clock() - start) / CLOCKS_PER_SEC;
+    if (*res) {
+        const Poly *q = &p;
+        for (size_t i = 0; *res && i < depth; i++) {
+            *res &= !PolyIsCoeff(q) && q->size == 1 && q->arr[0].exp == 1;
+            if (*res) q = &q->arr[0].p;
+        }
+        *res &= PolyIsCoeff(q) && q->coeff == 1;
+        PolyDestroy(&p);
+    }
+    free(line);
+    return time;
+}
+
+static bool MakePolyTest(void) {
+    bool res = ParseTest("((1,2)+(0,5)+(2,1),3)\n",
+                         P(P(C(1), 2, C(2), 1), 3));
+    res &= ParseTest("((1,1)+(2,3)+(1,1),1)", P(P(C(2), 1, C(2), 3), 1));
+    res &= ParseTest("(((0,4),2),1)", C(0));
+    res &= ParseTest("((1,1)+(-1,1),2)+(3,0)", P(C(3), 0));
+
+    Poly chain = C(1);
+    char line[4 * 2000 + 2];
+    for (size_t i = 0; i < 2000; i++) {
+        chain = PolyAddMonos(1, (Mono[]) {M(chain, 1)});
+        line[i] = '(';
+        memcpy(line + 2001 + 3 * i, ",1)", 3);
+    }
+    line[2000] = '1';
+    line[4 * 2000 + 1] = '\0';
+    res &= ParseTest(line, chain);
+
+    // Głęboki łańcuch jednomianów musi być parsowany w czasie liniowym:
+    // ośmiokrotnie dłuższy wiersz nie może być parsowany 64 razy dłużej.
+    double small = ParseChain(10000, &res);
+    double large = ParseChain(80000, &res);
+    res &= large < 24 * small + 0.05;
+    return res;
+}
+
+static bool ProgramTest(void) {
+    const char script[] = "(1,2)\n# komentarz\n3\nMUL\n";
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    bool res = write(fds[1], script, sizeof(script) - 1) == sizeof(script) - 1;
+    close(fds[1]);
+    Program program = ProgramInit();
+    ProgramCompile(&program, fds[0]);
+    close(fds[0]);
+    res &= program.code_count == 3 && program.literal_count == 2;
+    res &= program.code[2].opcode == OP_MUL && program.code[2].line_number == 4;
+
+    stack s = InitStack();
+    ProgramRun(&program, &s, NULL);
+    Poly p = Top(&s);
+    Poly expected = P(C(3), 2);
+    res &= NumberOfElements(&s) == 1 && PolyIsEq(&p, &expected);
+    PolyDestroy(&expected);
+    RemoveStack(&s);
+
+    Poly inputs[] = {P(C(2), 1), C(5)};
+    s = InitStack();
+    ProgramRun(&program, &s, inputs);
+    p = Top(&s);
+    expected = P(C(10), 1);
+    res &= NumberOfElements(&s) == 1 && PolyIsEq(&p, &expected);
+    PolyDestroy(&expected);
+    PolyDestroy(&inputs[0]);
+    RemoveStack(&s);
+    ProgramFree(&program);
+    return res;
+}
+
+static void KeepPage(Writer *writer, void *arg) {
+    WriterSwapPage(writer, (WriterPage *) arg);
+}
+
+static bool DeferredWriterTest(void) {
+    WriterPage page;
+    WriterPageInit(&page);
+    Writer deferred;
+    WriterInitDeferred(&deferred, KeepPage, &page);
+    Poly p = P(P(C(1), 1), 2);
+    WriteChars(&deferred, "0\n", 2);
+    WritePoly(&deferred, &p);
+    PolyDestroy(&p);
+    WriteEndLine(&deferred);
+    WriterFlush(&deferred);
+    bool res = page.used == 3 && page.record_count == 1;
+
+    int fds[2];
+    if (pipe(fds) != 0) return false;
+    Writer out;
+    WriterInit(&out, fds[1], false);
+    WriterReplay(&out, &page);
+    WriterFree(&out);
+    close(fds[1]);
+    const char expected[] = "0\n((1,1),2)\n";
+    char buffer[sizeof(expected)];
+    res &= read(fds[0], buffer, sizeof(buffer)) == sizeof(expected) - 1 &&
+           memcmp(buffer, expected, sizeof(expected) - 1) == 0;
+    close(fds[0]);
+    WriterPageFree(&page);
+    WriterFree(&deferred);
+    return res;
+}
+
+static bool PolyTermsTest(void) {
+    Poly zero = PolyZero();
+    Poly coeff = C(3);
+    Poly p = P(P(C(1), 1, C(2), 3), 2, C(5), 0);
+    Poly q = PolyClone(&p);
+    bool res = PolyTerms(&zero) == 0 && PolyTerms(&coeff) == 1 &&
+               PolyTerms(&p) == 3 && PolyTerms(&q) == 3;
+    PolyNegInPlace(&q);
+    res &= PolyTerms(&q) == 3;
+    PolyDestroy(&p);
+    PolyDestroy(&q);
+    return res;
+}
+
+static bool PolyFootprintTest(void) {
+    Poly coeff = C(3);
+    Poly inner = P(C(1), 1, C(2), 3);
+    Poly shared = PolyClone(&inner);
+    Poly p = P(inner, 2, shared, 0);
+    PolyFootprint coeff_size = PolyGetFootprint(&coeff);
+    PolyFootprint p_size = PolyGetFootprint(&p);
+    bool res = coeff_size.nodes == 0 && coeff_size.depth == 0 &&
+               coeff_size.bytes == 0;
+    res &= p_size.nodes == 2 && p_size.depth == 2 && p_size.bytes > 0;
+    PolyDestroy(&p);
+    return res;
+}
+
 /*int main() {
     Mono *monos = calloc(2, sizeof (Mono));
     assert(monos);
@@ -339,6 +767,8 @@ static bool OverflowTest(void) {
     assert(SimpleAddTest());
     assert(SimpleAddMonosTest());
     assert(SimpleMulTest());
+    assert(LargeMulTest());
+    assert(ParallelMulTest());
     assert(SimpleNegTest());
     assert(SimpleSubTest());
     assert(SimpleDegByTest());
@@ -346,4 +776,15 @@ static bool OverflowTest(void) {
     assert(SimpleIsEqTest());
     assert(SimpleAtTest());
     assert(OverflowTest());
+    assert(AtManyTest());
+    assert(MultipointTest());
+    assert(FlatPolyTest());
+    assert(InternTest());
+    assert(SnapshotTest());
+    assert(LibraryTest());
+    assert(MakePolyTest());
+    assert(ProgramTest());
+    assert(DeferredWriterTest());
+    assert(PolyTermsTest());
+    assert(PolyFootprintTest());
 }*/
\ No newline at end of file
@@ -0,0 +1,1017 @@
+/** @file
+  Implementacja kompilowania skryptów kalkulatora do ciągu instrukcji
+  i wykonywania ich na stosie wielomianów. Instrukcje wykonywane są przez
+  funkcje z tablicy indeksowanej kodem operacji, więc wykonanie instrukcji
+  nie wymaga porównywania napisów ani parsowania argumentów.
+  @author Julia Podrażka
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <setjmp.h>
+
+#include "poly.h"
+#include "intern.h"
+#include "memory_budget.h"
+#include "writer.h"
+#include "snapshot.h"
+#include "library.h"
+#include "make_poly.h"
+#include "make_command.h"
+#include "stats.h"
+#include "trace.h"
+#include "program.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Początkowy rozmiar tablicy. */
+#define SIZE 2
+/** Kod ascii znaku zerowego. */
+#define NULL_CHAR 0
+/** Kod ascii znaku hash. */
+#define COMMENT 35
+/** Kod ascii znaku nowej linii. */
+#define NEWLINE 10
+/** Kod ascii znaku otwierającego nawiasu. */
+#define OPEN_BRACKET 40
+/** Kod ascii znaku minusa. */
+#define MINUS 45
+
+/**
+ * Wypisuje na standardowe wyjście błędów błąd za małej liczby wielomianów
+ * na stosie.
+ * @param[in] line_number : numer wiersza
+ */
+static void PrintStackUnderflow(size_t line_number) {
+
+    WriteError(StdoutWriter(), line_number, ERROR_STACK_UNDERFLOW);
+
+}
+
+/**
+ * Wkłada na stos kopię literału.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecutePush(stack *s, const Instruction *instruction,
+                        const Poly literals[]) {
+
+    Push(s, PolyClone(&literals[instruction -> slot]));
+
+}
+
+/**
+ * Wykonuje komendę ZERO.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteZero(stack *s, const Instruction *instruction,
+                        const Poly literals[]) {
+
+    (void) instruction;
+    (void) literals;
+    Push(s, PolyZero());
+
+}
+
+/**
+ * Wykonuje komendy IS_COEFF i IS_ZERO.
+ * @param[in] s : stos wielomianów
+ * @param[in] line_number : numer wiersza
+ * @param[in] op : funkcja będąca albo AllExpZero albo PolyIsZero
+ */
+static void ExecuteTest(stack *s, size_t line_number, bool (*op)(const Poly *)) {
+
+    if (IsEmpty(s)) PrintStackUnderflow(line_number);
+    else {
+        Poly p = Top(s);
+        WriteChar(StdoutWriter(), op(&p) ? '1' : '0');
+        WriteEndLine(StdoutWriter());
+    }
+
+}
+
+/**
+ * Wykonuje komendę IS_COEFF.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteIsCoeff(stack *s, const Instruction *instruction,
+                           const Poly literals[]) {
+
+    (void) literals;
+    ExecuteTest(s, instruction -> line_number, AllExpZero);
+
+}
+
+/**
+ * Wykonuje komendę IS_ZERO.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteIsZero(stack *s, const Instruction *instruction,
+                          const Poly literals[]) {
+
+    (void) literals;
+    ExecuteTest(s, instruction -> line_number, PolyIsZero);
+
+}
+
+/**
+ * Wykonuje komendę CLONE.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteClone(stack *s, const Instruction *instruction,
+                         const Poly literals[]) {
+
+    (void) literals;
+    if (IsEmpty(s)) PrintStackUnderflow(instruction -> line_number);
+    else {
+        Poly p = Top(s);
+        Push(s, PolyClone(&p));
+    }
+
+}
+
+/**
+ * Wykonuje komendy ADD, MUL i SUB.
+ * @param[in] s : stos wielomianów
+ * @param[in] line_number : numer wiersza
+ * @param[in] op : funkcja dwuargumentowa będąca albo PolyAdd albo PolySub albo PolyMul
+ */
+static void ExecuteTwoArgumentFunction(stack *s, size_t line_number,
+                                       Poly (*op)(const Poly *, const Poly *)) {
+
+    if (!AreTwoElements(s)) PrintStackUnderflow(line_number);
+    else {
+        // Argumenty zdejmujemy dopiero po wyliczeniu wyniku, żeby przerwana
+        // operacja zostawiła stos bez zmian.
+        Poly p1 = Top(s);
+        Poly p2 = SecondTop(s);
+        Poly result = op(&p1, &p2);
+        Pop(s);
+        Pop(s);
+        Push(s, result);
+        PolyDestroy(&p1);
+        PolyDestroy(&p2);
+    }
+
+}
+
+/**
+ * Wykonuje komendę ADD.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteAdd(stack *s, const Instruction *instruction,
+                       const Poly literals[]) {
+
+    (void) literals;
+    ExecuteTwoArgumentFunction(s, instruction -> line_number, PolyAdd);
+
+}
+
+/**
+ * Wykonuje komendę MUL.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteMul(stack *s, const Instruction *instruction,
+                       const Poly literals[]) {
+
+    (void) literals;
+    ExecuteTwoArgumentFunction(s, instruction -> line_number, PolyMul);
+
+}
+
+/**
+ * Wykonuje komendę SUB.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteSub(stack *s, const Instruction *instruction,
+                       const Poly literals[]) {
+
+    (void) literals;
+    ExecuteTwoArgumentFunction(s, instruction -> line_number, PolySub);
+
+}
+
+/**
+ * Wykonuje komendę NEG.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteNeg(stack *s, const Instruction *instruction,
+                       const Poly literals[]) {
+
+    (void) literals;
+    if (IsEmpty(s)) PrintStackUnderflow(instruction -> line_number);
+    else {
+        Poly p = Pop(s);
+        PolyNegInPlace(&p);
+        Push(s, p);
+    }
+
+}
+
+/**
+ * Wykonuje komendę IS_EQ.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteIsEq(stack *s, const Instruction *instruction,
+                        const Poly literals[]) {
+
+    (void) literals;
+    if (!AreTwoElements(s)) PrintStackUnderflow(instruction -> line_number);
+    else {
+        Poly p1 = Top(s);
+        Poly p2 = SecondTop(s);
+        WriteChar(StdoutWriter(), PolyIsEq(&p1, &p2) ? '1' : '0');
+        WriteEndLine(StdoutWriter());
+    }
+
+}
+
+/**
+ * Wykonuje komendę DEG.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteDeg(stack *s, const Instruction *instruction,
+                       const Poly literals[]) {
+
+    (void) literals;
+    if (IsEmpty(s)) PrintStackUnderflow(instruction -> line_number);
+    else {
+        Poly p = Top(s);
+        WriteInteger(StdoutWriter(), PolyDeg(&p));
+        WriteEndLine(StdoutWriter());
+    }
+
+}
+
+/**
+ * Wykonuje komendę PRINT.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecutePrint(stack *s, const Instruction *instruction,
+                         const Poly literals[]) {
+
+    (void) literals;
+    if (IsEmpty(s)) PrintStackUnderflow(instruction -> line_number);
+    else {
+        Poly p = Top(s);
+        TRACE_PROBE(output__start, instruction -> line_number);
+        uint64_t start = TraceBegin();
+        WritePoly(StdoutWriter(), &p);
+        WriteEndLine(StdoutWriter());
+        TraceEnd(TRACE_OUTPUT, start, instruction -> line_number);
+        TRACE_PROBE(output__done, instruction -> line_number);
+    }
+
+}
+
+/**
+ * Wykonuje komendę POP.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecutePop(stack *s, const Instruction *instruction,
+                       const Poly literals[]) {
+
+    (void) literals;
+    if (IsEmpty(s)) PrintStackUnderflow(instruction -> line_number);
+    else {
+        Poly p = Pop(s);
+        PolyDestroy(&p);
+    }
+
+}
+
+/**
+ * Wykonuje komendę AT.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteAt(stack *s, const Instruction *instruction,
+                      const Poly literals[]) {
+
+    (void) literals;
+    if (IsEmpty(s)) PrintStackUnderflow(instruction -> line_number);
+    else {
+        Poly p = Top(s);
+        Poly result = PolyAt(&p, instruction -> value);
+        Pop(s);
+        Push(s, result);
+        PolyDestroy(&p);
+    }
+
+}
+
+/**
+ * Wykonuje komendę AT_MANY. Wylicza wartości wielomianu z wierzchołka stosu
+ * we wszystkich punktach i wypisuje je w jednym wierszu, oddzielone
+ * spacjami. Stos nie jest zmieniany.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteAtMany(stack *s, const Instruction *instruction,
+                          const Poly literals[]) {
+
+    (void) literals;
+    if (IsEmpty(s)) {
+        PrintStackUnderflow(instruction -> line_number);
+        return;
+    }
+
+    size_t count = instruction -> point_count;
+    Poly p = Top(s);
+    Poly *results = (Poly *) MemoryAlloc(count * sizeof(Poly));
+    PolyAtMany(&p, count, instruction -> points, results);
+    for (size_t k = FIRST_IDX; k < count; k++) {
+        if (k != FIRST_IDX) WriteChar(StdoutWriter(), ' ');
+        WritePoly(StdoutWriter(), &results[k]);
+        PolyDestroy(&results[k]);
+    }
+    WriteEndLine(StdoutWriter());
+    MemoryFree(results);
+
+}
+
+/**
+ * Wykonuje komendę DEG_BY.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteDegBy(stack *s, const Instruction *instruction,
+                         const Poly literals[]) {
+
+    (void) literals;
+    if (IsEmpty(s)) PrintStackUnderflow(instruction -> line_number);
+    else {
+        Poly p = Top(s);
+        WriteInteger(StdoutWriter(), PolyDegBy(&p, instruction -> count));
+        WriteEndLine(StdoutWriter());
+    }
+
+}
+
+/**
+ * Wykonuje komendę COMPOSE.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteCompose(stack *s, const Instruction *instruction,
+                           const Poly literals[]) {
+
+    (void) literals;
+    unsigned long long int value = instruction -> count;
+    if (IsEmpty(s) || NumberOfElements(s) - ONE_ELEMENT < value) {
+        PrintStackUnderflow(instruction -> line_number);
+        return;
+    }
+
+    // Podstawiane wielomiany leżą na stosie pod wielomianem p w kolejności
+    // argumentów, więc przekazujemy je bez kopiowania.
+    Poly p = Top(s);
+    Poly result = PolyCompose(&p, value, &s -> poly_stack[s -> top - ONE_ELEMENT - value]);
+    for (size_t k = FIRST_IDX; k <= value; k++) {
+        Poly q = Pop(s);
+        PolyDestroy(&q);
+    }
+    Push(s, result);
+
+}
+
+/**
+ * Wykonuje komendę SAVE.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteSave(stack *s, const Instruction *instruction,
+                        const Poly literals[]) {
+
+    (void) literals;
+    if (!SnapshotSave(s, instruction -> words[FIRST_IDX]))
+        WriteError(StdoutWriter(), instruction -> line_number, ERROR_SAVE);
+
+}
+
+/**
+ * Wykonuje komendę LOAD.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteLoad(stack *s, const Instruction *instruction,
+                        const Poly literals[]) {
+
+    (void) literals;
+    if (!SnapshotLoad(s, instruction -> words[FIRST_IDX]))
+        WriteError(StdoutWriter(), instruction -> line_number, ERROR_LOAD);
+
+}
+
+/**
+ * Wykonuje komendę SAVE_LIBRARY.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteSaveLibrary(stack *s, const Instruction *instruction,
+                               const Poly literals[]) {
+
+    (void) literals;
+    size_t count = instruction -> word_count - ONE_ELEMENT;
+    if (NumberOfElements(s) < count) PrintStackUnderflow(instruction -> line_number);
+    else if (!LibrarySave(s, count, instruction -> words + ONE_ELEMENT,
+                          instruction -> words[FIRST_IDX]))
+        WriteError(StdoutWriter(), instruction -> line_number, ERROR_SAVE_LIBRARY);
+
+}
+
+/**
+ * Wykonuje komendę LOAD_NAMED, wkładając na stos wielomian z biblioteki
+ * bez kopiowania.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteLoadNamed(stack *s, const Instruction *instruction,
+                             const Poly literals[]) {
+
+    (void) literals;
+    Push(s, instruction -> poly);
+
+}
+
+/**
+ * Wykonuje komendę STATS.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteStats(stack *s, const Instruction *instruction,
+                         const Poly literals[]) {
+
+    (void) s;
+    (void) instruction;
+    (void) literals;
+    StatsWrite(StdoutWriter());
+
+}
+
+/**
+ * Wykonuje komendę SIZE, wypisując liczbę węzłów, głębokość i liczbę bajtów
+ * wielomianu z wierzchołka stosu, oddzielone spacjami.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteSize(stack *s, const Instruction *instruction,
+                        const Poly literals[]) {
+
+    (void) literals;
+    if (IsEmpty(s)) PrintStackUnderflow(instruction -> line_number);
+    else {
+        Poly p = Top(s);
+        PolyFootprint footprint = PolyGetFootprint(&p);
+        WriteInteger(StdoutWriter(), (long long int) footprint.nodes);
+        WriteChar(StdoutWriter(), ' ');
+        WriteInteger(StdoutWriter(), (long long int) footprint.depth);
+        WriteChar(StdoutWriter(), ' ');
+        WriteInteger(StdoutWriter(), (long long int) footprint.bytes);
+        WriteEndLine(StdoutWriter());
+    }
+
+}
+
+/**
+ * Wypisuje na standardowe wyjście błędów błąd wiersza.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteError(stack *s, const Instruction *instruction,
+                         const Poly literals[]) {
+
+    (void) s;
+    (void) literals;
+    WriteError(StdoutWriter(), instruction -> line_number, instruction -> error);
+
+}
+
+/** Funkcje wykonujące instrukcje, indeksowane kodem operacji. */
+static void (*const EXECUTE[OP_COUNT])(stack *, const Instruction *,
+                                       const Poly []) = {
+    [OP_PUSH] = ExecutePush,
+    [OP_ZERO] = ExecuteZero,
+    [OP_IS_COEFF] = ExecuteIsCoeff,
+    [OP_IS_ZERO] = ExecuteIsZero,
+    [OP_CLONE] = ExecuteClone,
+    [OP_ADD] = ExecuteAdd,
+    [OP_MUL] = ExecuteMul,
+    [OP_NEG] = ExecuteNeg,
+    [OP_SUB] = ExecuteSub,
+    [OP_IS_EQ] = ExecuteIsEq,
+    [OP_DEG] = ExecuteDeg,
+    [OP_PRINT] = ExecutePrint,
+    [OP_POP] = ExecutePop,
+    [OP_AT] = ExecuteAt,
+    [OP_AT_MANY] = ExecuteAtMany,
+    [OP_DEG_BY] = ExecuteDegBy,
+    [OP_COMPOSE] = ExecuteCompose,
+    [OP_SAVE] = ExecuteSave,
+    [OP_LOAD] = ExecuteLoad,
+    [OP_SAVE_LIBRARY] = ExecuteSaveLibrary,
+    [OP_LOAD_NAMED] = ExecuteLoadNamed,
+    [OP_STATS] = ExecuteStats,
+    [OP_SIZE] = ExecuteSize,
+    [OP_ERROR] = ExecuteError
+};
+
+/**
+ * To jest struktura opisująca, ile wielomianów ze szczytu stosu czyta
+ * instrukcja i ile z nich zdejmuje, jeśli się powiedzie.
+ */
+typedef struct StackEffect {
+    size_t reads; ///< liczba czytanych wielomianów
+    size_t pops; ///< liczba zdejmowanych wielomianów
+} StackEffect;
+
+/** Działanie instrukcji na stosie, indeksowane kodem operacji. Instrukcje
+ * nieczytające stosu mają działanie zerowe. */
+static const StackEffect EFFECT[OP_COUNT] = {
+    [OP_IS_COEFF] = {ONE_ELEMENT, FIRST_IDX},
+    [OP_IS_ZERO] = {ONE_ELEMENT, FIRST_IDX},
+    [OP_CLONE] = {ONE_ELEMENT, FIRST_IDX},
+    [OP_ADD] = {SIZE, SIZE},
+    [OP_MUL] = {SIZE, SIZE},
+    [OP_NEG] = {ONE_ELEMENT, ONE_ELEMENT},
+    [OP_SUB] = {SIZE, SIZE},
+    [OP_IS_EQ] = {SIZE, FIRST_IDX},
+    [OP_DEG] = {ONE_ELEMENT, FIRST_IDX},
+    [OP_PRINT] = {ONE_ELEMENT, FIRST_IDX},
+    [OP_POP] = {ONE_ELEMENT, ONE_ELEMENT},
+    [OP_AT] = {ONE_ELEMENT, ONE_ELEMENT},
+    [OP_AT_MANY] = {ONE_ELEMENT, FIRST_IDX},
+    [OP_DEG_BY] = {ONE_ELEMENT, FIRST_IDX},
+    [OP_SIZE] = {ONE_ELEMENT, FIRST_IDX}
+};
+
+/** Instrukcje wykonywane pod strażnikiem budżetu pamięci, indeksowane kodem
+ * operacji. Są to instrukcje, których wynik może być dużo większy od
+ * argumentów. */
+static const bool GUARDED[OP_COUNT] = {
+    [OP_ADD] = true,
+    [OP_MUL] = true,
+    [OP_SUB] = true,
+    [OP_AT] = true,
+    [OP_AT_MANY] = true,
+    [OP_COMPOSE] = true
+};
+
+/** Liczby wielomianów, o które instrukcje powiększają stos, indeksowane
+ * kodem operacji. Instrukcje, których tu nie ma, nie powiększają stosu albo,
+ * jak LOAD, same sprawdzają ograniczenie stosu. */
+static const size_t GROWTH[OP_COUNT] = {
+    [OP_PUSH] = ONE_ELEMENT,
+    [OP_ZERO] = ONE_ELEMENT,
+    [OP_CLONE] = ONE_ELEMENT,
+    [OP_LOAD_NAMED] = ONE_ELEMENT
+};
+
+/**
+ * Wykonuje instrukcję, jeśli nie przekroczy ona ograniczenia stosu.
+ * W przeciwnym razie wypisuje błąd, a stos pozostaje bez zmian.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+static void ExecuteChecked(stack *s, const Instruction *instruction,
+                           const Poly literals[]) {
+
+    if (GROWTH[instruction -> opcode] > StackRoom(s))
+        WriteError(StdoutWriter(), instruction -> line_number, ERROR_STACK_LIMIT);
+    else EXECUTE[instruction -> opcode](s, instruction, literals);
+
+}
+
+/**
+ * Zwraca działanie instrukcji na stosie @p s, uwzględniając instrukcje,
+ * których działanie zależy od argumentów lub od stosu.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @return działanie instrukcji
+ */
+static StackEffect Effect(stack *s, const Instruction *instruction) {
+
+    switch (instruction -> opcode) {
+        case OP_COMPOSE:
+            // Liczba argumentów może przekraczać zakres size_t, a wtedy
+            // instrukcja i tak kończy się błędem.
+            if (instruction -> count >= NumberOfElements(s))
+                return (StackEffect) {NumberOfElements(s) + ONE_ELEMENT, FIRST_IDX};
+            return (StackEffect) {instruction -> count + ONE_ELEMENT,
+                                  instruction -> count + ONE_ELEMENT};
+        case OP_SAVE:
+            return (StackEffect) {NumberOfElements(s), FIRST_IDX};
+        case OP_SAVE_LIBRARY:
+            return (StackEffect) {instruction -> word_count - ONE_ELEMENT, FIRST_IDX};
+        default:
+            return EFFECT[instruction -> opcode];
+    }
+
+}
+
+/**
+ * Zlicza wyrazy wielomianów leżących na szczycie stosu.
+ * @param[in] s : stos wielomianów
+ * @param[in] count : liczba wielomianów ze szczytu stosu
+ * @return łączna liczba wyrazów
+ */
+static size_t StackTerms(const stack *s, size_t count) {
+
+    size_t terms = FIRST_IDX;
+    for (size_t i = s -> top - count; i < s -> top; i++)
+        terms += PolyTerms(&s -> poly_stack[i]);
+    return terms;
+
+}
+
+/**
+ * Wykonuje instrukcję pod strażnikiem budżetu pamięci. Jeśli instrukcja
+ * przekroczy budżet, to jest przerywana, stos pozostaje bez zmian,
+ * a wypisywany jest błąd wiersza.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja, dla której na stosie jest dość wielomianów
+ * @param[in] literals : wartości literałów
+ * @param[in] effect : działanie instrukcji na stosie
+ * @return Czy instrukcja została wykonana?
+ */
+static bool ExecuteGuarded(stack *s, const Instruction *instruction,
+                           const Poly literals[], StackEffect effect) {
+
+    size_t first_result = NumberOfElements(s) - effect.pops;
+    MemoryGuard guard;
+    if (setjmp(guard.env) != FIRST_IDX) {
+        MemoryGuardAbort(&guard);
+        // Przerwana operacja nie wróciła z wywołań mnożenia.
+        TraceLeaveLevel(FIRST_IDX);
+        WriteError(StdoutWriter(), instruction -> line_number, ERROR_MEMORY);
+        return false;
+    }
+    MemoryGuardBegin(&guard);
+    EXECUTE[instruction -> opcode](s, instruction, literals);
+    MemoryGuardEnd(&guard);
+    // Pod strażnikiem nowe węzły nie trafiają do tablicy unikalnych węzłów,
+    // więc dodajemy do niej wyniki dopiero teraz.
+    if (InternEnabled()) {
+        for (size_t i = first_result; i < s -> top; i++)
+            s -> poly_stack[i] = InternPoly(s -> poly_stack[i]);
+    }
+    return true;
+
+}
+
+/** Instrukcje o stałym koszcie, których czas mierzony jest tylko w próbce
+ * wykonań, indeksowane kodem operacji. */
+static const bool SAMPLED[OP_COUNT] = {
+    [OP_PUSH] = true,
+    [OP_ZERO] = true,
+    [OP_IS_COEFF] = true,
+    [OP_IS_ZERO] = true,
+    [OP_DEG] = true,
+    [OP_POP] = true
+};
+
+/**
+ * Sprawdza, czy mierzyć czas wykonania instrukcji. Koszt odczytu zegara
+ * przeważa tylko przy instrukcjach o stałym koszcie, więc tylko one są
+ * mierzone w próbce wykonań, chyba że włączono śledzenie. Pozostałe
+ * instrukcje i parsowanie literałów mogą trwać dowolnie długo, więc są
+ * mierzone zawsze, żeby żadne długie wykonanie nie ominęło największego
+ * i łącznego czasu. Wykonanie spoza próbki jest od razu zliczane.
+ * @param[in] kind : kod operacji albo STATS_PARSE
+ * @return Czy mierzyć czas wykonania i zapisać go funkcją StatsRecord?
+ */
+static bool IsTimed(size_t kind) {
+
+    return kind >= OP_COUNT || !SAMPLED[kind] || TraceEnabled() || StatsSample(kind);
+
+}
+
+/**
+ * Wykonuje instrukcję na stosie @p s i zapisuje jej statystyki. Czas
+ * wykonania liczony jest od podanej chwili, więc przy wykonywaniu ciągu
+ * mierzonych instrukcji koniec jednej instrukcji jest początkiem następnej
+ * i zegar odczytywany jest raz na instrukcję. Wykonania, których czas nie
+ * jest mierzony, są tylko zliczane, bez odczytu zegara i liczenia wyrazów.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ * @param[in] start : chwila rozpoczęcia w nanosekundach albo zero, jeśli
+ * nie jest znana
+ * @return chwila zakończenia w nanosekundach albo zero, jeśli czas
+ * wykonania nie był mierzony
+ */
+static uint64_t ExecuteMeasured(stack *s, const Instruction *instruction,
+                                const Poly literals[], uint64_t start) {
+
+    // Instrukcje spoza próbki nie są wykonywane pod strażnikiem, więc nie
+    // potrzebują też działania na stosie.
+    if (!IsTimed(instruction -> opcode)) {
+        TRACE_PROBE(line__start, instruction -> opcode, instruction -> line_number);
+        ExecuteChecked(s, instruction, literals);
+        TRACE_PROBE(line__done, instruction -> opcode, instruction -> line_number);
+        return FIRST_IDX;
+    }
+
+    // Instrukcja, dla której brakuje wielomianów na stosie, kończy się
+    // błędem i nie ma ani wejścia, ani wyniku.
+    StackEffect effect = Effect(s, instruction);
+    size_t depth = NumberOfElements(s);
+    bool is_underflow = effect.reads > depth;
+    size_t in_terms = is_underflow ? FIRST_IDX : StackTerms(s, effect.reads);
+    if (start == FIRST_IDX) start = StatsNow();
+    bool is_done = true;
+    TRACE_PROBE(line__start, instruction -> opcode, instruction -> line_number);
+    if (GUARDED[instruction -> opcode] && !is_underflow && MemoryLimited())
+        is_done = ExecuteGuarded(s, instruction, literals, effect);
+    else ExecuteChecked(s, instruction, literals);
+    TRACE_PROBE(line__done, instruction -> opcode, instruction -> line_number);
+    uint64_t end = StatsNow();
+    size_t out_terms = FIRST_IDX;
+    if (!is_underflow && is_done && NumberOfElements(s) + effect.pops > depth)
+        out_terms = StackTerms(s, NumberOfElements(s) + effect.pops - depth);
+    StatsRecord(instruction -> opcode, end - start, in_terms, out_terms);
+    TraceRecord(TRACE_LINE, StatsName(instruction -> opcode), start, end,
+                instruction -> line_number);
+    return end;
+
+}
+
+void ExecuteInstruction(stack *s, const Instruction *instruction,
+                        const Poly literals[]) {
+
+    ExecuteMeasured(s, instruction, literals, FIRST_IDX);
+
+}
+
+void InstructionFree(Instruction *instruction) {
+
+    switch (instruction -> opcode) {
+        case OP_AT_MANY:
+            free(instruction -> points);
+            break;
+        case OP_SAVE:
+        case OP_LOAD:
+        case OP_SAVE_LIBRARY:
+            free(instruction -> words[FIRST_IDX]);
+            free(instruction -> words);
+            break;
+        default:
+            break;
+    }
+
+}
+
+Program ProgramInit(void) {
+
+    Program program = (Program) {.code_count = FIRST_IDX, .code_size = SIZE,
+                                 .literal_count = FIRST_IDX,
+                                 .literal_size = SIZE};
+    program.code = (Instruction *) malloc(program.code_size * sizeof(Instruction));
+    CHECK_PTR(program.code);
+    program.literals = (Poly *) malloc(program.literal_size * sizeof(Poly));
+    CHECK_PTR(program.literals);
+    return program;
+
+}
+
+/**
+ * Dopisuje na koniec programu nową instrukcję.
+ * @param[in] program : program
+ * @param[in] line_number : numer wiersza, z którego pochodzi instrukcja
+ * @return wskaźnik na nową instrukcję
+ */
+static Instruction *AddInstruction(Program *program, size_t line_number) {
+
+    if (program -> code_count == program -> code_size) {
+        program -> code_size *= SIZE;
+        program -> code = (Instruction *) realloc(program -> code,
+                                                  program -> code_size *
+                                                  sizeof(Instruction));
+        CHECK_PTR(program -> code);
+    }
+    Instruction *instruction = &program -> code[program -> code_count++];
+    instruction -> line_number = line_number;
+    return instruction;
+
+}
+
+/**
+ * Dopisuje na koniec programu instrukcję wkładającą na stos nowy literał.
+ * @param[in] program : program
+ * @param[in] p : wielomian, który program przejmuje na własność
+ * @param[in] line_number : numer wiersza, z którego pochodzi wielomian
+ */
+static void AddLiteral(Program *program, Poly p, size_t line_number) {
+
+    if (program -> literal_count == program -> literal_size) {
+        program -> literal_size *= SIZE;
+        program -> literals = (Poly *) realloc(program -> literals,
+                                               program -> literal_size *
+                                               sizeof(Poly));
+        CHECK_PTR(program -> literals);
+    }
+    Instruction *instruction = AddInstruction(program, line_number);
+    instruction -> opcode = OP_PUSH;
+    instruction -> slot = program -> literal_count;
+    program -> literals[program -> literal_count++] = p;
+
+}
+
+/**
+ * Dopisuje na koniec programu instrukcję wypisującą błąd.
+ * @param[in] program : program
+ * @param[in] error : treść błędu
+ * @param[in] line_number : numer wiersza
+ */
+static void AddError(Program *program, const char *error, size_t line_number) {
+
+    Instruction *instruction = AddInstruction(program, line_number);
+    instruction -> opcode = OP_ERROR;
+    instruction -> error = error;
+
+}
+
+/**
+ * Zwraca treść błędu wiersza ze znakiem zerowym w zależności od początku
+ * wiersza.
+ * @param[in] char_arr : tablica ze znakami z wiersza
+ * @return treść błędu
+ */
+static const char *NullError(const char *char_arr) {
+
+    if ((int) char_arr[FIRST_IDX] == NULL_CHAR || !isalpha(char_arr[FIRST_IDX]))
+        return ERROR_WRONG_POLY;
+    if ((strncmp(char_arr, "AT", 2) == 0 && isspace(char_arr[2])) ||
+        (strncmp(char_arr, "AT_MANY", 7) == 0 && isspace(char_arr[7])))
+        return ERROR_AT;
+    if (strncmp(char_arr, "DEG_BY", 6) == 0 && isspace(char_arr[6]))
+        return ERROR_DEG_BY;
+    if (strncmp(char_arr, "COMPOSE", 7) == 0 && isspace(char_arr[7]))
+        return ERROR_COMPOSE;
+    if (strncmp(char_arr, "SAVE_LIBRARY", 12) == 0 && isspace(char_arr[12]))
+        return ERROR_SAVE_LIBRARY;
+    if (strncmp(char_arr, "LOAD_NAMED", 10) == 0 && isspace(char_arr[10]))
+        return ERROR_LOAD_NAMED;
+    if (strncmp(char_arr, "SAVE", 4) == 0 && isspace(char_arr[4]))
+        return ERROR_SAVE;
+    if (strncmp(char_arr, "LOAD", 4) == 0 && isspace(char_arr[4]))
+        return ERROR_LOAD;
+    return ERROR_WRONG_COMMAND;
+
+}
+
+void ProgramCompileLine(Program *program, Reader *reader, char *line,
+                        size_t length, size_t line_number) {
+
+    // Sprawdza, czy wczytano znak zerowy, jeśli tak, to dodaje instrukcję
+    // wypisującą odpowiedni błąd.
+    if (memchr(line, NULL_CHAR, length) != NULL)
+        AddError(program, NullError(line), line_number);
+    else if (line[FIRST_IDX] == COMMENT || line[FIRST_IDX] == NEWLINE) return;
+    else if (isalpha(line[FIRST_IDX])) {
+        // Komendy dzielone są funkcją strtok, więc parsujemy je z kopii
+        // wiersza bez znaku nowej linii, zakończonej znakiem zerowym.
+        char *command = ReaderCopyLine(reader, line, length);
+        if (command[length - ONE_ELEMENT] == NEWLINE) length--;
+        CompileCommand(command, length, line_number,
+                       AddInstruction(program, line_number));
+    } else if (isdigit(line[FIRST_IDX]) || line[FIRST_IDX] == OPEN_BRACKET ||
+               line[FIRST_IDX] == MINUS) {
+        Poly p;
+        bool is_timed = IsTimed(STATS_PARSE);
+        TRACE_PROBE(parse__start, line_number);
+        uint64_t start = is_timed ? StatsNow() : FIRST_IDX;
+        bool is_correct = MakePoly(line, &p);
+        TRACE_PROBE(parse__done, line_number, is_correct);
+        if (is_timed) {
+            uint64_t end = StatsNow();
+            StatsRecord(STATS_PARSE, end - start, FIRST_IDX,
+                        is_correct ? PolyTerms(&p) : FIRST_IDX);
+            TraceRecord(TRACE_PARSE, StatsName(STATS_PARSE), start, end, line_number);
+        }
+        if (is_correct) AddLiteral(program, p, line_number);
+        else AddError(program, ERROR_WRONG_POLY, line_number);
+    } else AddError(program, ERROR_WRONG_POLY, line_number);
+
+}
+
+void ProgramCompile(Program *program, int fd) {
+
+    Reader reader;
+    ReaderInit(&reader, fd);
+    size_t line_number = ONE_ELEMENT;
+    size_t length;
+    char *line;
+    while ((line = ReadLine(&reader, &length)) != NULL)
+        ProgramCompileLine(program, &reader, line, length, line_number++);
+    ReaderFree(&reader);
+
+}
+
+void ProgramRun(const Program *program, stack *s, const Poly literals[]) {
+
+    if (literals == NULL) literals = program -> literals;
+    const Instruction *end = program -> code + program -> code_count;
+    uint64_t clock = FIRST_IDX;
+    for (const Instruction *instruction = program -> code; instruction < end;
+         instruction++)
+        clock = ExecuteMeasured(s, instruction, literals, clock);
+    StatsPoll();
+
+}
+
+void ProgramRunAndClear(Program *program, stack *s) {
+
+    uint64_t clock = FIRST_IDX;
+    for (size_t i = FIRST_IDX; i < program -> code_count; i++) {
+        Instruction *instruction = &program -> code[i];
+        if (instruction -> opcode == OP_PUSH) {
+            // Każdy literał wkładany jest na stos co najwyżej raz, więc
+            // przekazujemy go bez klonowania.
+            bool is_timed = IsTimed(OP_PUSH);
+            if (is_timed && clock == FIRST_IDX) clock = StatsNow();
+            TRACE_PROBE(line__start, instruction -> opcode, instruction -> line_number);
+            bool is_pushed = StackRoom(s) > FIRST_IDX;
+            if (is_pushed) Push(s, program -> literals[instruction -> slot]);
+            else {
+                WriteError(StdoutWriter(), instruction -> line_number, ERROR_STACK_LIMIT);
+                PolyDestroy(&program -> literals[instruction -> slot]);
+            }
+            program -> literals[instruction -> slot] = PolyZero();
+            TRACE_PROBE(line__done, instruction -> opcode, instruction -> line_number);
+            if (is_timed) {
+                uint64_t end = StatsNow();
+                Poly top = is_pushed ? Top(s) : PolyZero();
+                StatsRecord(OP_PUSH, end - clock, FIRST_IDX, PolyTerms(&top));
+                TraceRecord(TRACE_LINE, StatsName(OP_PUSH), clock, end,
+                            instruction -> line_number);
+                clock = end;
+            } else clock = FIRST_IDX;
+        } else clock = ExecuteMeasured(s, instruction, program -> literals, clock);
+        InstructionFree(instruction);
+    }
+    StatsPoll();
+    program -> code_count = FIRST_IDX;
+    program -> literal_count = FIRST_IDX;
+
+}
+
+void ProgramClear(Program *program) {
+
+    for (size_t i = FIRST_IDX; i < program -> code_count; i++)
+        InstructionFree(&program -> code[i]);
+    for (size_t i = FIRST_IDX; i < program -> literal_count; i++)
+        PolyDestroy(&program -> literals[i]);
+    program -> code_count = FIRST_IDX;
+    program -> literal_count = FIRST_IDX;
+
+}
+
+void ProgramFree(Program *program) {
+
+    ProgramClear(program);
+    free(program -> code);
+    free(program -> literals);
+    program -> code = NULL;
+    program -> literals = NULL;
+
+}
@@ -0,0 +1,201 @@
+/** @file
+  Interfejs kompilowania skryptów kalkulatora do ciągu instrukcji
+  i wykonywania ich na stosie wielomianów.
+
+  Każdy wiersz skryptu kompilowany jest co najwyżej do jednej instrukcji:
+  komenda do instrukcji z rozpoznanym kodem operacji i wczytanymi
+  argumentami, wielomian do instrukcji wkładającej na stos literał,
+  a błędny wiersz do instrukcji wypisującej błąd. Wielomiany ze skryptu
+  przechowywane są w tablicy literałów i numerowane w kolejności
+  wystąpienia w skrypcie. Skompilowany program można wykonywać wielokrotnie,
+  podając za każdym razem inne wartości literałów.
+  @author Julia Podrażka
+ */
+#ifndef PROGRAM_H
+#define PROGRAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "poly.h"
+#include "stack.h"
+#include "reader.h"
+
+/** Treść błędu nieznanej komendy. */
+#define ERROR_WRONG_COMMAND "WRONG COMMAND"
+/** Treść błędu niepoprawnego wielomianu. */
+#define ERROR_WRONG_POLY "WRONG POLY"
+/** Treść błędu za małej liczby wielomianów na stosie. */
+#define ERROR_STACK_UNDERFLOW "STACK UNDERFLOW"
+/** Treść błędu argumentu komendy AT i AT_MANY. */
+#define ERROR_AT "AT WRONG VALUE"
+/** Treść błędu argumentu komendy DEG_BY. */
+#define ERROR_DEG_BY "DEG BY WRONG VARIABLE"
+/** Treść błędu argumentu komendy COMPOSE. */
+#define ERROR_COMPOSE "COMPOSE WRONG PARAMETER"
+/** Treść błędu komendy SAVE. */
+#define ERROR_SAVE "SAVE WRONG FILE"
+/** Treść błędu komendy LOAD. */
+#define ERROR_LOAD "LOAD WRONG FILE"
+/** Treść błędu komendy SAVE_LIBRARY. */
+#define ERROR_SAVE_LIBRARY "SAVE LIBRARY WRONG PARAMETER"
+/** Treść błędu komendy LOAD_NAMED. */
+#define ERROR_LOAD_NAMED "LOAD NAMED WRONG NAME"
+/** Treść błędu operacji przekraczającej budżet pamięci. */
+#define ERROR_MEMORY "MEMORY BUDGET EXCEEDED"
+/** Treść błędu instrukcji, która przekroczyłaby ograniczenie stosu. */
+#define ERROR_STACK_LIMIT "STACK LIMIT EXCEEDED"
+
+/**
+ * To są kody operacji instrukcji.
+ */
+typedef enum Opcode {
+    OP_PUSH, ///< włożenie literału na stos
+    OP_ZERO, ///< komenda ZERO
+    OP_IS_COEFF, ///< komenda IS_COEFF
+    OP_IS_ZERO, ///< komenda IS_ZERO
+    OP_CLONE, ///< komenda CLONE
+    OP_ADD, ///< komenda ADD
+    OP_MUL, ///< komenda MUL
+    OP_NEG, ///< komenda NEG
+    OP_SUB, ///< komenda SUB
+    OP_IS_EQ, ///< komenda IS_EQ
+    OP_DEG, ///< komenda DEG
+    OP_PRINT, ///< komenda PRINT
+    OP_POP, ///< komenda POP
+    OP_AT, ///< komenda AT
+    OP_AT_MANY, ///< komenda AT_MANY
+    OP_DEG_BY, ///< komenda DEG_BY
+    OP_COMPOSE, ///< komenda COMPOSE
+    OP_SAVE, ///< komenda SAVE
+    OP_LOAD, ///< komenda LOAD
+    OP_SAVE_LIBRARY, ///< komenda SAVE_LIBRARY
+    OP_LOAD_NAMED, ///< komenda LOAD_NAMED
+    OP_STATS, ///< komenda STATS
+    OP_SIZE, ///< komenda SIZE
+    OP_ERROR, ///< wypisanie błędu wiersza
+    OP_COUNT ///< liczba kodów operacji
+} Opcode;
+
+/**
+ * To jest struktura przechowująca instrukcję wraz z argumentami.
+ */
+typedef struct Instruction {
+    Opcode opcode; ///< kod operacji
+    size_t line_number; ///< numer wiersza, z którego pochodzi instrukcja
+    /**
+     * To jest unia przechowująca argument instrukcji, zależny od kodu operacji.
+     */
+    union {
+        size_t slot; ///< indeks literału dla OP_PUSH
+        poly_coeff_t value; ///< punkt dla OP_AT
+        unsigned long long int count; ///< argument OP_DEG_BY i OP_COMPOSE
+        const char *error; ///< treść błędu dla OP_ERROR
+        Poly poly; ///< wielomian z biblioteki dla OP_LOAD_NAMED
+        /** Punkty dla OP_AT_MANY. */
+        struct {
+            size_t point_count; ///< liczba punktów
+            poly_coeff_t *points; ///< punkty
+        };
+        /**
+         * Słowa dla OP_SAVE, OP_LOAD i OP_SAVE_LIBRARY: ścieżka pliku
+         * i nazwy wielomianów, zapisane w jednym bloku pamięci
+         * zaczynającym się od pierwszego słowa.
+         */
+        struct {
+            size_t word_count; ///< liczba słów
+            char **words; ///< słowa
+        };
+    };
+} Instruction;
+
+/**
+ * To jest struktura przechowująca skompilowany program.
+ */
+typedef struct Program {
+    Instruction *code; ///< instrukcje
+    size_t code_count; ///< liczba instrukcji
+    size_t code_size; ///< rozmiar tablicy instrukcji
+    Poly *literals; ///< wielomiany ze skryptu
+    size_t literal_count; ///< liczba literałów
+    size_t literal_size; ///< rozmiar tablicy literałów
+} Program;
+
+/**
+ * Wykonuje instrukcję na stosie @p s i zapisuje w statystykach czas jej
+ * wykonania oraz liczby wyrazów wielomianów, które przeczytała ze stosu
+ * i na niego włożyła.
+ * @param[in] s : stos wielomianów
+ * @param[in] instruction : instrukcja
+ * @param[in] literals : wartości literałów
+ */
+void ExecuteInstruction(stack *s, const Instruction *instruction,
+                        const Poly literals[]);
+
+/**
+ * Zwalnia pamięć argumentów instrukcji.
+ * @param[in] instruction : instrukcja
+ */
+void InstructionFree(Instruction *instruction);
+
+/**
+ * Tworzy pusty program.
+ * @return program bez instrukcji i literałów
+ */
+Program ProgramInit(void);
+
+/**
+ * Kompiluje wiersz skryptu i dopisuje jego instrukcję na koniec programu.
+ * Komentarze i puste wiersze nie dają żadnej instrukcji.
+ * @param[in] program : program
+ * @param[in] reader : stan wczytywania, z którego pochodzi wiersz, używany
+ * do kopiowania wierszy z komendami
+ * @param[in] line : wiersz zakończony znakiem nowej linii lub znakiem zerowym
+ * @param[in] length : długość wiersza wraz ze znakiem nowej linii
+ * @param[in] line_number : numer wiersza
+ */
+void ProgramCompileLine(Program *program, Reader *reader, char *line,
+                        size_t length, size_t line_number);
+
+/**
+ * Kompiluje cały skrypt wczytywany z deskryptora pliku @p fd.
+ * @param[in] program : program
+ * @param[in] fd : deskryptor pliku
+ */
+void ProgramCompile(Program *program, int fd);
+
+/**
+ * Wykonuje wszystkie instrukcje programu na stosie @p s. Literały są
+ * klonowane, więc program można wykonywać wielokrotnie. Na końcu wypisuje
+ * statystyki, jeśli zażądano ich sygnałem, jak StatsPoll.
+ * @param[in] program : program
+ * @param[in] s : stos wielomianów
+ * @param[in] literals : wartości literałów albo NULL, jeśli mają zostać
+ * użyte wielomiany ze skryptu
+ */
+void ProgramRun(const Program *program, stack *s, const Poly literals[]);
+
+/**
+ * Wykonuje jednokrotnie wszystkie instrukcje programu na stosie @p s,
+ * przenosząc literały na stos bez klonowania, a następnie usuwa instrukcje
+ * i literały jak ProgramClear. Na końcu wypisuje statystyki, jeśli
+ * zażądano ich sygnałem, jak StatsPoll.
+ * @param[in] program : program
+ * @param[in] s : stos wielomianów
+ */
+void ProgramRunAndClear(Program *program, stack *s);
+
+/**
+ * Usuwa wszystkie instrukcje i literały programu, zachowując zaalokowane
+ * tablice do ponownego użycia.
+ * @param[in] program : program
+ */
+void ProgramClear(Program *program);
+
+/**
+ * Usuwa program z pamięci.
+ * @param[in] program : program
+ */
+void ProgramFree(Program *program);
+
+#endif
@@ -0,0 +1,180 @@
+/** @file
+  Implementacja wczytywania wejścia kalkulatora wierszami.
+  @author Julia Podrażka
+ */
+/** Pozwala korzystać z funkcji madvise. */
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "poly.h"
+#include "reader.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Mnożnik rozmiaru tablicy przy powiększaniu. */
+#define SIZE 2
+/** Rozmiar bloku wczytywanego jednym wywołaniem funkcji read. */
+#define BLOCK_SIZE (1 << 20)
+/** Kod ascii znaku zerowego. */
+#define NULL_CHAR 0
+/** Kod ascii znaku nowej linii. */
+#define NEWLINE 10
+
+/**
+ * Próbuje odwzorować w pamięci nieprzeczytaną część pliku, jeśli
+ * deskryptor wskazuje na zwykły plik.
+ * @param[in] reader : stan wczytywania
+ * @return Czy plik został odwzorowany?
+ */
+static bool MapFile(Reader *reader) {
+
+    struct stat info;
+    if (fstat(reader -> fd, &info) != FIRST_IDX || !S_ISREG(info.st_mode))
+        return false;
+    off_t offset = lseek(reader -> fd, FIRST_IDX, SEEK_CUR);
+    if (offset < FIRST_IDX || offset >= info.st_size) return false;
+
+    void *map = mmap(NULL, (size_t) info.st_size, PROT_READ, MAP_PRIVATE,
+                     reader -> fd, FIRST_IDX);
+    if (map == MAP_FAILED) return false;
+    madvise(map, (size_t) info.st_size, MADV_SEQUENTIAL);
+
+    reader -> map = (char *) map;
+    reader -> map_size = (size_t) info.st_size;
+    reader -> buffer = reader -> map;
+    reader -> start = (size_t) offset;
+    reader -> scanned = (size_t) offset;
+    reader -> end = (size_t) info.st_size;
+    reader -> capacity = (size_t) info.st_size;
+    reader -> eof = true;
+    return true;
+
+}
+
+void ReaderInit(Reader *reader, int fd) {
+
+    *reader = (Reader) {.fd = fd, .map = NULL, .map_size = FIRST_IDX,
+                        .buffer = NULL, .start = FIRST_IDX,
+                        .scanned = FIRST_IDX, .end = FIRST_IDX,
+                        .capacity = FIRST_IDX, .eof = false, .line = NULL,
+                        .line_size = FIRST_IDX, .line_limit = FIRST_IDX};
+    if (MapFile(reader)) return;
+
+    reader -> capacity = BLOCK_SIZE;
+    reader -> buffer = (char *) malloc(reader -> capacity);
+    CHECK_PTR(reader -> buffer);
+
+}
+
+void ReaderLimitLine(Reader *reader, size_t limit) {
+
+    reader -> line_limit = limit;
+
+}
+
+void ReaderFree(Reader *reader) {
+
+    if (reader -> map != NULL) munmap(reader -> map, reader -> map_size);
+    else free(reader -> buffer);
+    free(reader -> line);
+    reader -> map = NULL;
+    reader -> buffer = NULL;
+    reader -> line = NULL;
+
+}
+
+/**
+ * Przesuwa niezwrócone znaki na początek bufora, w razie potrzeby
+ * powiększa bufor i wczytuje kolejny blok. Ustawia koniec pliku, jeśli nie
+ * udało się wczytać żadnego znaku albo wiersz przekroczył limit długości.
+ * @param[in] reader : stan wczytywania
+ */
+static void Refill(Reader *reader) {
+
+    if (reader -> start > FIRST_IDX) {
+        memmove(reader -> buffer, reader -> buffer + reader -> start,
+                reader -> end - reader -> start);
+        reader -> scanned -= reader -> start;
+        reader -> end -= reader -> start;
+        reader -> start = FIRST_IDX;
+    }
+    if (reader -> end == reader -> capacity) {
+        if (reader -> line_limit > FIRST_IDX && reader -> capacity > reader -> line_limit) {
+            // Wiersz jest dłuższy niż limit, więc przestajemy wczytywać.
+            reader -> eof = true;
+            return;
+        }
+        // Wiersz nie mieści się w buforze.
+        reader -> capacity *= SIZE;
+        reader -> buffer = (char *) realloc(reader -> buffer, reader -> capacity);
+        CHECK_PTR(reader -> buffer);
+    }
+
+    ssize_t count;
+    do {
+        count = read(reader -> fd, reader -> buffer + reader -> end,
+                     reader -> capacity - reader -> end);
+    } while (count < FIRST_IDX && errno == EINTR);
+    if (count <= FIRST_IDX) reader -> eof = true;
+    else reader -> end += (size_t) count;
+
+}
+
+char *ReaderCopyLine(Reader *reader, const char *line, size_t length) {
+
+    if (length + ONE_ELEMENT > reader -> line_size) {
+        reader -> line_size = length + ONE_ELEMENT;
+        free(reader -> line);
+        reader -> line = (char *) malloc(reader -> line_size);
+        CHECK_PTR(reader -> line);
+    }
+    memmove(reader -> line, line, length);
+    reader -> line[length] = NULL_CHAR;
+    return reader -> line;
+
+}
+
+bool ReaderHasLine(Reader *reader) {
+
+    if (reader -> eof) return true;
+    if (memchr(reader -> buffer + reader -> scanned, NEWLINE,
+               reader -> end - reader -> scanned) != NULL) return true;
+    reader -> scanned = reader -> end;
+    return false;
+
+}
+
+char *ReadLine(Reader *reader, size_t *length) {
+
+    while (true) {
+        char *newline = (char *) memchr(reader -> buffer + reader -> scanned, NEWLINE,
+                                        reader -> end - reader -> scanned);
+        if (newline != NULL) {
+            char *line = reader -> buffer + reader -> start;
+            *length = newline + ONE_ELEMENT - line;
+            reader -> start += *length;
+            reader -> scanned = reader -> start;
+            return line;
+        }
+        reader -> scanned = reader -> end;
+        if (reader -> eof) break;
+        Refill(reader);
+    }
+
+    if (reader -> start == reader -> end) return NULL;
+    // Ostatni wiersz bez znaku nowej linii kopiujemy, żeby zakończyć go
+    // znakiem zerowym.
+    *length = reader -> end - reader -> start;
+    char *line = ReaderCopyLine(reader, reader -> buffer + reader -> start, *length);
+    reader -> start = reader -> end;
+    return line;
+
+}
@@ -0,0 +1,85 @@
+/** @file
+  Interfejs wczytywania wejścia kalkulatora wierszami.
+  Jeśli wejście jest zwykłym plikiem, to jest ono odwzorowywane w pamięci,
+  a w przeciwnym przypadku wczytywane dużymi blokami. Wiersze nie są
+  kopiowane: zwracany jest wskaźnik na początek wiersza w odwzorowaniu
+  lub w buforze bloków i jego długość.
+  @author Julia Podrażka
+ */
+#ifndef READER_H
+#define READER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * To jest struktura przechowująca stan wczytywania z deskryptora pliku.
+ */
+typedef struct Reader {
+    int fd; ///< deskryptor pliku, z którego wczytujemy
+    char *map; ///< odwzorowanie pliku w pamięci albo NULL
+    size_t map_size; ///< rozmiar odwzorowania
+    char *buffer; ///< wczytane, a jeszcze niezwrócone znaki
+    size_t start; ///< indeks początku kolejnego wiersza
+    size_t scanned; ///< indeks, do którego szukano już końca wiersza
+    size_t end; ///< indeks za ostatnim wczytanym znakiem
+    size_t capacity; ///< rozmiar bufora
+    bool eof; ///< czy wczytano już cały plik
+    char *line; ///< kopia wiersza zakończona znakiem zerowym
+    size_t line_size; ///< rozmiar tablicy kopii wiersza
+    size_t line_limit; ///< maksymalna długość wiersza albo 0, gdy jej nie ma
+} Reader;
+
+/**
+ * Inicjuje wczytywanie z deskryptora pliku @p fd.
+ * @param[out] reader : stan wczytywania
+ * @param[in] fd : deskryptor pliku
+ */
+void ReaderInit(Reader *reader, int fd);
+
+/**
+ * Ogranicza długość wczytywanych wierszy, a tym samym pamięć bufora.
+ * Wiersz dłuższy niż @p limit może zostać obcięty i wtedy jest ostatnim
+ * zwróconym wierszem, ale jego długość pozostaje większa od @p limit.
+ * @param[in] reader : stan wczytywania
+ * @param[in] limit : maksymalna długość wiersza
+ */
+void ReaderLimitLine(Reader *reader, size_t limit);
+
+/**
+ * Zwalnia pamięć i odwzorowanie używane przy wczytywaniu.
+ * @param[in] reader : stan wczytywania
+ */
+void ReaderFree(Reader *reader);
+
+/**
+ * Zwraca kolejny wiersz razem ze znakiem nowej linii, jeśli go ma. Wiersz
+ * bez znaku nowej linii, czyli ostatni wiersz pliku, jest kopiowany i
+ * zakończony znakiem zerowym, więc za każdym wierszem jest znak nowej linii
+ * lub znak zerowy. Wiersz jest ważny do kolejnego wywołania funkcji.
+ * @param[in] reader : stan wczytywania
+ * @param[out] length : liczba znaków wiersza
+ * @return początek wiersza albo NULL, jeśli wczytano już cały plik
+ */
+char *ReadLine(Reader *reader, size_t *length);
+
+/**
+ * Sprawdza, czy funkcja ReadLine zwróci wynik bez czekania na kolejny
+ * blok wejścia, czyli czy w buforze jest cały wiersz albo wczytano już
+ * cały plik.
+ * @param[in] reader : stan wczytywania
+ * @return Czy kolejny wiersz jest już dostępny?
+ */
+bool ReaderHasLine(Reader *reader);
+
+/**
+ * Kopiuje wiersz do tablicy, którą można modyfikować, i kończy go znakiem
+ * zerowym. Kopia jest ważna do kolejnego wywołania funkcji ReadLine.
+ * @param[in] reader : stan wczytywania
+ * @param[in] line : wiersz zwrócony przez funkcję ReadLine
+ * @param[in] length : liczba znaków wiersza
+ * @return kopia wiersza
+ */
+char *ReaderCopyLine(Reader *reader, const char *line, size_t length);
+
+#endif
@@ -0,0 +1,260 @@
+/** @file
+  Implementacja serwera kalkulatora działającego na gnieździe domeny Uniksa.
+  Wątki sesji czekają na połączenia funkcją accept na wspólnym gnieździe
+  nasłuchującym, a wątek główny czeka na sygnał zakończenia. Po sygnale
+  wątek główny zamyka gniazda wszystkich trwających sesji, więc nawet
+  aktywny klient nie opóźnia zakończenia serwera dłużej niż wykonanie
+  bieżącego wiersza.
+  @author Julia Podrażka
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include "poly.h"
+#include "stack.h"
+#include "reader.h"
+#include "writer.h"
+#include "program.h"
+#include "arena.h"
+#include "mono_pool.h"
+#include "stats.h"
+#include "memory_budget.h"
+#include "server.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Błąd wiersza dłuższego niż ograniczenie sesji. */
+#define ERROR_LINE_LIMIT "LINE TOO LONG"
+
+/**
+ * To jest struktura przechowująca stan serwera wspólny dla wątków sesji.
+ */
+typedef struct Server {
+    int listen_fd; ///< gniazdo nasłuchujące
+    ServerLimits limits; ///< ograniczenia zasobów sesji
+    atomic_bool stopping; ///< czy serwer kończy działanie
+    pthread_mutex_t lock; ///< blokada tablicy gniazd sesji
+    int *session_fds; ///< gniazda trwających sesji, -1 dla wolnych miejsc
+    size_t sessions; ///< liczba miejsc w tablicy gniazd sesji
+} Server;
+
+/**
+ * Zapisuje gniazdo nowej sesji w tablicy trwających sesji, jeśli serwer
+ * nie kończy jeszcze działania.
+ * @param[in] server : serwer
+ * @param[in] fd : gniazdo połączenia
+ * @return Czy sesję można obsłużyć?
+ */
+static bool AddSession(Server *server, int fd) {
+
+    pthread_mutex_lock(&server -> lock);
+    bool is_added = !atomic_load(&server -> stopping);
+    for (size_t i = FIRST_IDX; is_added && i < server -> sessions; i++) {
+        if (server -> session_fds[i] < FIRST_IDX) {
+            server -> session_fds[i] = fd;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&server -> lock);
+    return is_added;
+
+}
+
+/**
+ * Usuwa gniazdo zakończonej sesji z tablicy trwających sesji. Należy ją
+ * wywołać przed zamknięciem gniazda, bo jego numer może zostać użyty
+ * ponownie.
+ * @param[in] server : serwer
+ * @param[in] fd : gniazdo połączenia
+ */
+static void RemoveSession(Server *server, int fd) {
+
+    pthread_mutex_lock(&server -> lock);
+    for (size_t i = FIRST_IDX; i < server -> sessions; i++) {
+        if (server -> session_fds[i] == fd) server -> session_fds[i] = -ONE_ELEMENT;
+    }
+    pthread_mutex_unlock(&server -> lock);
+
+}
+
+/**
+ * Przerywa trwające sesje: zamyka ich połączenia w obu kierunkach, co budzi
+ * wątki czekające na klienta i kończy ich sesje.
+ * @param[in] server : serwer, który kończy działanie
+ */
+static void StopSessions(Server *server) {
+
+    pthread_mutex_lock(&server -> lock);
+    for (size_t i = FIRST_IDX; i < server -> sessions; i++) {
+        if (server -> session_fds[i] >= FIRST_IDX)
+            shutdown(server -> session_fds[i], SHUT_RDWR);
+    }
+    pthread_mutex_unlock(&server -> lock);
+
+}
+
+/**
+ * Obsługuje sesję: wykonuje kolejne wiersze komend na nowym stosie
+ * i odsyła wyniki. Wyniki są wysyłane, gdy w buforze wejścia nie ma już
+ * całego wiersza, więc klient dostaje odpowiedź na każdą wysłaną porcję
+ * komend. Komendy wykonywane są z ograniczeniem stosu i z kontem pamięci
+ * sesji, więc komenda, która by je przekroczyła, kończy się błędem zamiast
+ * zająć całą pamięć procesu. Sesja kończy się, gdy klient zamknie
+ * połączenie, przestanie odbierać wyniki, nie odezwie się przez zadany czas,
+ * przyśle za długi wiersz albo serwer zacznie kończyć działanie.
+ * @param[in] fd : gniazdo połączenia
+ * @param[in] server : serwer
+ * @param[in] program : pusty program wątku sesji
+ */
+static void RunSession(int fd, Server *server, Program *program) {
+
+    const ServerLimits *limits = &server -> limits;
+    struct timeval timeout = (struct timeval) {.tv_sec = (time_t) limits -> idle_seconds};
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    Reader reader;
+    ReaderInit(&reader, fd);
+    ReaderLimitLine(&reader, limits -> line_length);
+    Writer writer;
+    WriterInit(&writer, fd, false);
+    writer.inline_errors = true;
+    StdoutRedirect(&writer);
+
+    stack s = InitStack();
+    s.limit = limits -> stack_size;
+    MemoryAccount account = MemoryAccountInit(limits -> memory);
+    MemorySetAccount(&account);
+    size_t line_number = ONE_ELEMENT;
+    size_t line;
+    char *char_arr = ReadLine(&reader, &line);
+    while (char_arr != NULL && !writer.failed && !atomic_load(&server -> stopping)) {
+        if (line > limits -> line_length) {
+            WriteError(&writer, line_number, ERROR_LINE_LIMIT);
+            break;
+        }
+        ProgramCompileLine(program, &reader, char_arr, line, line_number);
+        ProgramRunAndClear(program, &s);
+        if (!ReaderHasLine(&reader)) WriterFlush(&writer);
+        char_arr = ReadLine(&reader, &line);
+        line_number++;
+    }
+
+    RemoveStack(&s);
+    MemorySetAccount(NULL);
+    StdoutRedirect(NULL);
+    WriterFree(&writer);
+    ReaderFree(&reader);
+
+}
+
+/**
+ * Funkcja wątku sesji. Przyjmuje kolejne połączenia i obsługuje je, aż
+ * serwer zacznie kończyć działanie.
+ * @param[in] arg : serwer
+ * @return NULL
+ */
+static void *ServeSessions(void *arg) {
+
+    Server *server = (Server *) arg;
+    Program program = ProgramInit();
+    while (true) {
+        int fd = accept(server -> listen_fd, NULL, NULL);
+        if (fd >= FIRST_IDX) {
+            if (AddSession(server, fd)) {
+                RunSession(fd, server, &program);
+                RemoveSession(server, fd);
+            }
+            close(fd);
+        } else if (atomic_load(&server -> stopping)) break;
+    }
+    ProgramFree(&program);
+
+    ArenaReleaseSpare();
+    return NULL;
+
+}
+
+/**
+ * Tworzy gniazdo nasłuchujące o ścieżce @p path. Istniejące gniazdo o tej
+ * ścieżce, pozostałe na przykład po przerwanym serwerze, jest usuwane.
+ * @param[in] path : ścieżka gniazda
+ * @return gniazdo albo -1, jeśli nie udało się go utworzyć
+ */
+static int Listen(const char *path) {
+
+    struct sockaddr_un address = (struct sockaddr_un) {.sun_family = AF_UNIX};
+    if (strlen(path) >= sizeof(address.sun_path)) return -ONE_ELEMENT;
+    strcpy(address.sun_path, path);
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, FIRST_IDX);
+    if (fd < FIRST_IDX) return -ONE_ELEMENT;
+
+    struct stat info;
+    if (stat(path, &info) == FIRST_IDX && S_ISSOCK(info.st_mode)) unlink(path);
+    if (bind(fd, (struct sockaddr *) &address, sizeof(address)) != FIRST_IDX ||
+        listen(fd, SOMAXCONN) != FIRST_IDX) {
+        close(fd);
+        return -ONE_ELEMENT;
+    }
+    return fd;
+
+}
+
+bool ServerRun(const char *path, size_t sessions, const ServerLimits *limits) {
+
+    Server server;
+    server.listen_fd = Listen(path);
+    if (server.listen_fd < FIRST_IDX) return false;
+    server.limits = *limits;
+    atomic_init(&server.stopping, false);
+    pthread_mutex_init(&server.lock, NULL);
+    server.sessions = sessions;
+    server.session_fds = (int *) malloc(sessions * sizeof(int));
+    CHECK_PTR(server.session_fds);
+    for (size_t i = FIRST_IDX; i < sessions; i++) server.session_fds[i] = -ONE_ELEMENT;
+
+    // Sygnały zakończenia i żądania statystyk odbiera tylko wątek główny,
+    // bo wątki sesji mogą długo czekać na klientów, a zapis do zamkniętego
+    // połączenia ma jedynie kończyć sesję.
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    if (StatsDumpEnabled()) sigaddset(&signals, SIGUSR1);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    signal(SIGPIPE, SIG_IGN);
+    MonoPoolEnableLocking();
+
+    pthread_t *workers = (pthread_t *) malloc(sessions * sizeof(pthread_t));
+    CHECK_PTR(workers);
+    for (size_t i = FIRST_IDX; i < sessions; i++) {
+        if (pthread_create(&workers[i], NULL, ServeSessions, &server) != 0) exit(1);
+    }
+
+    int signal_number;
+    while (sigwait(&signals, &signal_number) == FIRST_IDX && signal_number == SIGUSR1)
+        StatsDump();
+    atomic_store(&server.stopping, true);
+    // Budzi wątki czekające w funkcji accept.
+    shutdown(server.listen_fd, SHUT_RDWR);
+    StopSessions(&server);
+    for (size_t i = FIRST_IDX; i < sessions; i++) pthread_join(workers[i], NULL);
+    free(workers);
+    free(server.session_fds);
+    pthread_mutex_destroy(&server.lock);
+    close(server.listen_fd);
+    unlink(path);
+    pthread_sigmask(SIG_UNBLOCK, &signals, NULL);
+    return true;
+
+}
@@ -0,0 +1,42 @@
+/** @file
+  Interfejs serwera kalkulatora działającego na gnieździe domeny Uniksa.
+  Każde połączenie jest osobną sesją z własnym stosem wielomianów: klient
+  wysyła wiersze komend, a serwer odsyła wyniki i błędy w formacie
+  `ERROR numer treść` tym samym połączeniem, gdy tylko przetworzy wszystkie
+  wiersze, które do tej pory otrzymał. Sesje obsługuje stała liczba
+  wątków, a każda sesja ma ograniczenia zasobów.
+  @author Julia Podrażka
+ */
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/**
+ * To jest struktura przechowująca ograniczenia zasobów sesji. Komenda, która
+ * przekroczyłaby ograniczenie stosu lub pamięci, dostaje błąd i nie zmienia
+ * stosu. Sesja, która przyśle za długi wiersz, dostaje błąd i jest kończona.
+ */
+typedef struct ServerLimits {
+    size_t stack_size; ///< maksymalna liczba wielomianów na stosie
+    size_t line_length; ///< maksymalna długość wiersza komendy
+    size_t memory; ///< maksymalna liczba bajtów pamięci wielomianów sesji
+    size_t idle_seconds; ///< czas oczekiwania na klienta w sekundach
+} ServerLimits;
+
+/**
+ * Nasłuchuje na gnieździe o ścieżce @p path i obsługuje sesje, aż proces
+ * dostanie sygnał SIGINT lub SIGTERM. Następnie przestaje przyjmować
+ * połączenia, zamyka połączenia trwających sesji, czeka, aż dokończą
+ * wykonywane wiersze, i usuwa gniazdo.
+ * Jeśli włączono wypisywanie statystyk, to po sygnale SIGUSR1 wypisuje je
+ * od razu, nie czekając na sesje.
+ * @param[in] path : ścieżka gniazda
+ * @param[in] sessions : liczba jednocześnie obsługiwanych sesji
+ * @param[in] limits : ograniczenia zasobów sesji
+ * @return Czy udało się utworzyć gniazdo?
+ */
+bool ServerRun(const char *path, size_t sessions, const ServerLimits *limits);
+
+#endif
@@ -0,0 +1,451 @@
+/** @file
+  Implementacja zapisywania stosu wielomianów do pliku binarnego i
+  wczytywania go z powrotem. Wielomiany przechodzone są bez rekurencji, przy
+  pomocy stosu węzłów, więc głębokość zagnieżdżenia nie jest ograniczona.
+  Przy wczytywaniu tablice jednomianów wypełniane są bezpośrednio, bez
+  sortowania i dodawania jednomianów, a poprawność kolejności wykładników
+  jest tylko sprawdzana.
+  @author Julia Podrażka
+ */
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "poly.h"
+#include "mono_pool.h"
+#include "intern.h"
+#include "writer.h"
+#include "snapshot.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Mnożnik rozmiaru tablicy przy powiększaniu. */
+#define SIZE 2
+/** Początkowy rozmiar stosu węzłów. */
+#define FRAMES_SIZE 16
+/** Bajty rozpoczynające plik. */
+#define MAGIC "UPOLYSNP"
+/** Liczba bajtów rozpoczynających plik. */
+#define MAGIC_SIZE 8
+/** Wersja formatu pliku. */
+#define VERSION 1
+/** Liczba bajtów sumy kontrolnej. */
+#define CHECKSUM_SIZE 8
+/** Początkowa wartość sumy kontrolnej FNV-1a. */
+#define FNV_OFFSET 14695981039346656037ULL
+/** Mnożnik sumy kontrolnej FNV-1a. */
+#define FNV_PRIME 1099511628211ULL
+/** Maksymalna liczba bajtów liczby 64-bitowej. */
+#define MAX_VARINT 10
+/** Liczba bitów liczby zapisywanych w jednym bajcie. */
+#define VARINT_BITS 7
+/** Maska bitów liczby w bajcie. */
+#define VARINT_MASK 0x7F
+/** Bit oznaczający, że liczba ma kolejne bajty. */
+#define VARINT_MORE 0x80
+/** Liczba bitów w bajcie. */
+#define BYTE_BITS 8
+/** Najmniejsza liczba bajtów zapisanego jednomianu. */
+#define MIN_MONO_BYTES 2
+/** Uprawnienia tworzonego pliku. */
+#define FILE_MODE 0644
+/** Końcówka nazwy pliku tymczasowego; znaki X zastępuje funkcja mkstemp. */
+#define TMP_SUFFIX ".tmp.XXXXXX"
+
+/**
+ * Dopisuje bajty do sumy kontrolnej FNV-1a.
+ * @param[in] hash : dotychczasowa suma kontrolna
+ * @param[in] bytes : bajty
+ * @param[in] count : liczba bajtów
+ * @return nowa suma kontrolna
+ */
+static uint64_t Checksum(uint64_t hash, const uint8_t *bytes, size_t count) {
+
+    for (size_t i = FIRST_IDX; i < count; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+
+}
+
+/**
+ * Przeplata liczby ujemne z nieujemnymi, tak żeby liczby o małej wartości
+ * bezwzględnej miały krótki zapis.
+ * @param[in] coeff : współczynnik
+ * @return liczba nieujemna odpowiadająca współczynnikowi
+ */
+static uint64_t ZigZag(poly_coeff_t coeff) {
+
+    return ((uint64_t) coeff << ONE_ELEMENT) ^ (uint64_t) (coeff < FIRST_IDX ? -1 : 0);
+
+}
+
+/**
+ * Odwraca funkcję ZigZag.
+ * @param[in] value : liczba nieujemna
+ * @return współczynnik
+ */
+static poly_coeff_t UnZigZag(uint64_t value) {
+
+    return (poly_coeff_t) ((value >> ONE_ELEMENT) ^ (FIRST_IDX - (value & ONE_ELEMENT)));
+
+}
+
+/**
+ * To jest struktura przechowująca węzeł, którego jednomiany są zapisywane.
+ */
+typedef struct SaveFrame {
+    const Poly *p; ///< wielomian
+    size_t idx; ///< indeks kolejnego jednomianu
+} SaveFrame;
+
+/**
+ * To jest struktura przechowująca stan zapisywania pliku.
+ */
+typedef struct SaveState {
+    Writer writer; ///< stan wypisywania do pliku
+    uint64_t checksum; ///< suma kontrolna zapisanych bajtów
+    SaveFrame *frames; ///< stos węzłów
+    size_t frame_size; ///< rozmiar stosu węzłów
+} SaveState;
+
+/**
+ * Zapisuje liczbę w kodowaniu o zmiennej długości.
+ * @param[in] state : stan zapisywania
+ * @param[in] value : liczba
+ */
+static void SaveVarint(SaveState *state, uint64_t value) {
+
+    uint8_t bytes[MAX_VARINT];
+    size_t count = FIRST_IDX;
+    while (value > VARINT_MASK) {
+        bytes[count++] = (uint8_t) ((value & VARINT_MASK) | VARINT_MORE);
+        value >>= VARINT_BITS;
+    }
+    bytes[count++] = (uint8_t) value;
+    state -> checksum = Checksum(state -> checksum, bytes, count);
+    WriteChars(&state -> writer, (const char *) bytes, count);
+
+}
+
+/**
+ * Zapisuje wielomian w kolejności: węzeł, a po nim jego jednomiany.
+ * @param[in] state : stan zapisywania
+ * @param[in] p : wielomian
+ */
+static void SavePoly(SaveState *state, const Poly *p) {
+
+    size_t depth = FIRST_IDX;
+    const Poly *next = p;
+    while (true) {
+        if (next != NULL) {
+            if (PolyIsCoeff(next)) {
+                SaveVarint(state, FIRST_IDX);
+                SaveVarint(state, ZigZag(next -> coeff));
+            } else {
+                SaveVarint(state, next -> size);
+                if (depth == state -> frame_size) {
+                    state -> frame_size *= SIZE;
+                    state -> frames = (SaveFrame *) realloc(
+                            state -> frames, state -> frame_size * sizeof(SaveFrame));
+                    CHECK_PTR(state -> frames);
+                }
+                state -> frames[depth++] = (SaveFrame) {.p = next, .idx = FIRST_IDX};
+            }
+            next = NULL;
+        }
+        if (depth == FIRST_IDX) return;
+
+        SaveFrame *frame = &state -> frames[depth - ONE_ELEMENT];
+        if (frame -> idx == frame -> p -> size) {
+            depth--;
+            continue;
+        }
+        const Mono *mono = &frame -> p -> arr[frame -> idx];
+        if (frame -> idx == FIRST_IDX) SaveVarint(state, MonoGetExp(mono));
+        else SaveVarint(state, MonoGetExp(mono - ONE_ELEMENT) - MonoGetExp(mono) - ONE_ELEMENT);
+        frame -> idx++;
+        next = &mono -> p;
+    }
+
+}
+
+bool SnapshotSave(stack *s, const char *path) {
+
+    // Plik zapisujemy obok docelowego i podmieniamy go dopiero po zapisaniu
+    // całości na dysk, więc nieudany zapis nie niszczy poprzedniego pliku.
+    // Unikalna nazwa pozwala zapisywać ten sam plik z kilku sesji naraz.
+    char *tmp_path = (char *) malloc(strlen(path) + sizeof(TMP_SUFFIX));
+    CHECK_PTR(tmp_path);
+    strcpy(tmp_path, path);
+    strcat(tmp_path, TMP_SUFFIX);
+    int fd = mkstemp(tmp_path);
+    if (fd < FIRST_IDX) {
+        free(tmp_path);
+        return false;
+    }
+
+    SaveState state;
+    WriterInit(&state.writer, fd, false);
+    state.checksum = FNV_OFFSET;
+    state.frame_size = FRAMES_SIZE;
+    state.frames = (SaveFrame *) malloc(state.frame_size * sizeof(SaveFrame));
+    CHECK_PTR(state.frames);
+
+    state.checksum = Checksum(state.checksum, (const uint8_t *) MAGIC, MAGIC_SIZE);
+    WriteChars(&state.writer, MAGIC, MAGIC_SIZE);
+    SaveVarint(&state, VERSION);
+    SaveVarint(&state, NumberOfElements(s));
+    for (size_t i = FIRST_IDX; i < NumberOfElements(s); i++)
+        SavePoly(&state, &s -> poly_stack[i]);
+
+    uint8_t checksum[CHECKSUM_SIZE];
+    for (size_t i = FIRST_IDX; i < CHECKSUM_SIZE; i++)
+        checksum[i] = (uint8_t) (state.checksum >> (i * BYTE_BITS));
+    WriteChars(&state.writer, (const char *) checksum, CHECKSUM_SIZE);
+
+    WriterFlush(&state.writer);
+    bool saved = !state.writer.failed && fchmod(fd, FILE_MODE) == FIRST_IDX &&
+                 fsync(fd) == FIRST_IDX;
+    WriterFree(&state.writer);
+    free(state.frames);
+    if (close(fd) != FIRST_IDX) saved = false;
+    if (saved) saved = rename(tmp_path, path) == FIRST_IDX;
+    if (!saved) unlink(tmp_path);
+    free(tmp_path);
+    return saved;
+
+}
+
+/**
+ * To jest struktura przechowująca węzeł, którego jednomiany są wczytywane.
+ */
+typedef struct LoadFrame {
+    Mono *arr; ///< tablica jednomianów
+    size_t size; ///< liczba jednomianów
+    size_t filled; ///< liczba wczytanych jednomianów
+} LoadFrame;
+
+/**
+ * To jest struktura przechowująca stan wczytywania pliku.
+ */
+typedef struct LoadState {
+    const uint8_t *pos; ///< aktualna pozycja w pliku
+    const uint8_t *end; ///< koniec zawartości pliku bez sumy kontrolnej
+    LoadFrame *frames; ///< stos węzłów
+    size_t frame_size; ///< rozmiar stosu węzłów
+} LoadState;
+
+/**
+ * Wczytuje liczbę zapisaną w kodowaniu o zmiennej długości.
+ * @param[in] state : stan wczytywania
+ * @param[out] value : liczba
+ * @return Czy liczba jest poprawna i mieści się w 64 bitach?
+ */
+static bool LoadVarint(LoadState *state, uint64_t *value) {
+
+    uint64_t result = FIRST_IDX;
+    for (size_t i = FIRST_IDX; i < MAX_VARINT && state -> pos < state -> end; i++) {
+        uint8_t byte = *state -> pos++;
+        uint64_t bits = byte & VARINT_MASK;
+        // Ostatni bajt może zawierać tylko najwyższy bit liczby.
+        if (i == MAX_VARINT - ONE_ELEMENT && bits > ONE_ELEMENT) return false;
+        result |= bits << (i * VARINT_BITS);
+        if ((byte & VARINT_MORE) == FIRST_IDX) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+
+}
+
+/**
+ * Wczytuje wykładnik kolejnego jednomianu węzła. Sprawdza, czy wykładniki
+ * są ściśle malejące i mieszczą się w typie poly_exp_t.
+ * @param[in] state : stan wczytywania
+ * @param[in] frame : węzeł
+ * @return Czy wykładnik jest poprawny?
+ */
+static bool LoadExp(LoadState *state, LoadFrame *frame) {
+
+    uint64_t value;
+    if (!LoadVarint(state, &value)) return false;
+    if (frame -> filled == FIRST_IDX) {
+        if (value > INT_MAX) return false;
+        frame -> arr[FIRST_IDX].exp = (poly_exp_t) value;
+    } else {
+        poly_exp_t previous = frame -> arr[frame -> filled - ONE_ELEMENT].exp;
+        if (value >= (uint64_t) previous) return false;
+        frame -> arr[frame -> filled].exp = previous - ONE_ELEMENT - (poly_exp_t) value;
+    }
+    return true;
+
+}
+
+/**
+ * Usuwa częściowo wczytane węzły ze stosu węzłów.
+ * @param[in] state : stan wczytywania
+ * @param[in] depth : liczba węzłów na stosie
+ */
+static void DestroyFrames(LoadState *state, size_t depth) {
+
+    for (size_t i = FIRST_IDX; i < depth; i++) {
+        LoadFrame *frame = &state -> frames[i];
+        for (size_t j = FIRST_IDX; j < frame -> filled; j++)
+            MonoDestroy(&frame -> arr[j]);
+        MonoArrFree(frame -> arr);
+    }
+
+}
+
+/**
+ * Wczytuje wielomian zapisany funkcją SavePoly.
+ * @param[in] state : stan wczytywania
+ * @param[out] result : wczytany wielomian
+ * @return Czy wielomian jest poprawny?
+ */
+static bool LoadPoly(LoadState *state, Poly *result) {
+
+    size_t depth = FIRST_IDX;
+    while (true) {
+        uint64_t size;
+        if (!LoadVarint(state, &size)) {
+            DestroyFrames(state, depth);
+            return false;
+        }
+        if (size > FIRST_IDX) {
+            // Każdy jednomian zajmuje co najmniej dwa bajty, więc nie
+            // przydzielamy więcej pamięci, niż pozwala na to rozmiar pliku.
+            if (size > (uint64_t) (state -> end - state -> pos) / MIN_MONO_BYTES) {
+                DestroyFrames(state, depth);
+                return false;
+            }
+            if (depth == state -> frame_size) {
+                state -> frame_size *= SIZE;
+                state -> frames = (LoadFrame *) realloc(
+                        state -> frames, state -> frame_size * sizeof(LoadFrame));
+                CHECK_PTR(state -> frames);
+            }
+            LoadFrame *frame = &state -> frames[depth++];
+            *frame = (LoadFrame) {.arr = MonoArrAlloc(size), .size = size,
+                                  .filled = FIRST_IDX};
+            if (!LoadExp(state, frame)) {
+                DestroyFrames(state, depth);
+                return false;
+            }
+            continue;
+        }
+
+        uint64_t value;
+        if (!LoadVarint(state, &value)) {
+            DestroyFrames(state, depth);
+            return false;
+        }
+        Poly p = PolyFromCoeff(UnZigZag(value));
+
+        // Wczytany wielomian jest współczynnikiem kolejnego jednomianu
+        // węzła z wierzchołka stosu. Kończymy węzły, aż trafimy na węzeł,
+        // który ma jeszcze niewczytane jednomiany.
+        while (true) {
+            if (depth == FIRST_IDX) {
+                *result = p;
+                return true;
+            }
+            LoadFrame *frame = &state -> frames[depth - ONE_ELEMENT];
+            // Wczytane węzły nie mają zerowych współczynników, więc zerem
+            // może być tylko współczynnik stały.
+            if (PolyIsCoeff(&p) && p.coeff == FIRST_IDX) {
+                DestroyFrames(state, depth);
+                return false;
+            }
+            frame -> arr[frame -> filled++].p = p;
+            if (frame -> filled < frame -> size) {
+                if (!LoadExp(state, frame)) {
+                    DestroyFrames(state, depth);
+                    return false;
+                }
+                break;
+            }
+            p = InternPoly((Poly) {.size = frame -> size, .arr = frame -> arr});
+            depth--;
+        }
+    }
+
+}
+
+/**
+ * Wczytuje wielomiany z zawartości pliku, której suma kontrolna została
+ * już sprawdzona.
+ * @param[in] s : stos wielomianów
+ * @param[in] state : stan wczytywania
+ * @return Czy zawartość pliku jest poprawna?
+ */
+static bool LoadPolys(stack *s, LoadState *state) {
+
+    uint64_t version, count;
+    if (!LoadVarint(state, &version) || version != VERSION ||
+        !LoadVarint(state, &count) || count > (uint64_t) StackRoom(s) ||
+        count > (uint64_t) (state -> end - state -> pos) / MIN_MONO_BYTES)
+        return false;
+
+    Poly *polys = (Poly *) malloc((count + ONE_ELEMENT) * sizeof(Poly));
+    CHECK_PTR(polys);
+    size_t loaded = FIRST_IDX;
+    while (loaded < count && LoadPoly(state, &polys[loaded])) loaded++;
+
+    bool is_correct = loaded == count && state -> pos == state -> end;
+    for (size_t i = FIRST_IDX; i < loaded; i++) {
+        if (is_correct) Push(s, polys[i]);
+        else PolyDestroy(&polys[i]);
+    }
+    free(polys);
+    return is_correct;
+
+}
+
+bool SnapshotLoad(stack *s, const char *path) {
+
+    int fd = open(path, O_RDONLY);
+    if (fd < FIRST_IDX) return false;
+    struct stat info;
+    if (fstat(fd, &info) != FIRST_IDX || !S_ISREG(info.st_mode) ||
+        info.st_size < MAGIC_SIZE + CHECKSUM_SIZE) {
+        close(fd);
+        return false;
+    }
+    size_t file_size = (size_t) info.st_size;
+    void *map = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, FIRST_IDX);
+    close(fd);
+    if (map == MAP_FAILED) return false;
+
+    const uint8_t *bytes = (const uint8_t *) map;
+    size_t content_size = file_size - CHECKSUM_SIZE;
+    uint64_t checksum = FIRST_IDX;
+    for (size_t i = FIRST_IDX; i < CHECKSUM_SIZE; i++)
+        checksum |= (uint64_t) bytes[content_size + i] << (i * BYTE_BITS);
+
+    bool loaded = false;
+    if (memcmp(bytes, MAGIC, MAGIC_SIZE) == FIRST_IDX &&
+        Checksum(FNV_OFFSET, bytes, content_size) == checksum) {
+        LoadState state = (LoadState) {.pos = bytes + MAGIC_SIZE,
+                                       .end = bytes + content_size,
+                                       .frame_size = FRAMES_SIZE};
+        state.frames = (LoadFrame *) malloc(state.frame_size * sizeof(LoadFrame));
+        CHECK_PTR(state.frames);
+        loaded = LoadPolys(s, &state);
+        free(state.frames);
+    }
+    munmap(map, file_size);
+    return loaded;
+
+}
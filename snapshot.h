@@ -0,0 +1,54 @@
+/** @file
+  Interfejs zapisywania stosu wielomianów do pliku binarnego i wczytywania
+  go z powrotem.
+
+  Plik składa się z:
+  - ośmiu bajtów @c UPOLYSNP,
+  - numeru wersji formatu,
+  - liczby wielomianów,
+  - wielomianów od dna do wierzchołka stosu,
+  - ośmiu bajtów sumy kontrolnej FNV-1a wszystkich poprzednich bajtów,
+    zapisanej od najmniej znaczącego bajtu.
+
+  Liczby zapisywane są w kodowaniu o zmiennej długości, po siedem bitów
+  w bajcie, zaczynając od najmniej znaczących. Wielomian stały zapisywany
+  jest jako zero i współczynnik, w którym liczby ujemne przeplatane są
+  z nieujemnymi (0, -1, 1, -2, ... zapisywane jako 0, 1, 2, 3, ...).
+  Pozostałe wielomiany zapisywane są jako liczba jednomianów i kolejne
+  jednomiany od najwyższego wykładnika. Jednomian to wykładnik i jego
+  współczynnik; wykładnik każdego jednomianu poza pierwszym zapisywany jest
+  jako różnica z poprzednim wykładnikiem pomniejszona o jeden.
+  @author Julia Podrażka
+ */
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <stdbool.h>
+
+#include "stack.h"
+
+/**
+ * Zapisuje wszystkie wielomiany ze stosu do pliku @p path, zastępując jego
+ * zawartość. Wielomiany zapisywane są do pliku tymczasowego, który po
+ * zapisaniu na dysk zastępuje plik @p path, więc jeśli zapis się nie uda,
+ * to poprzednia zawartość pliku pozostaje nienaruszona. Stos nie jest
+ * zmieniany.
+ * @param[in] s : stos wielomianów
+ * @param[in] path : ścieżka pliku
+ * @return Czy udało się zapisać plik?
+ */
+bool SnapshotSave(stack *s, const char *path);
+
+/**
+ * Wczytuje wielomiany z pliku @p path i wkłada je na stos w kolejności,
+ * w jakiej zostały zapisane, czyli wierzchołek zapisanego stosu staje się
+ * wierzchołkiem stosu. Jeśli plik nie istnieje, jest w innej wersji formatu,
+ * ma niepoprawną sumę kontrolną, niepoprawną zawartość albo więcej wielomianów,
+ * niż pozwala ograniczenie stosu, to stos nie jest zmieniany.
+ * @param[in] s : stos wielomianów
+ * @param[in] path : ścieżka pliku
+ * @return Czy udało się wczytać plik?
+ */
+bool SnapshotLoad(stack *s, const char *path);
+
+#endif
@@ -0,0 +1,153 @@
+/** @file
+  Implementacja ograniczonej kolejki wskaźników dla jednego wątku
+  wkładającego i jednego wątku zdejmującego.
+  @author Julia Podrażka
+ */
+#include <stdlib.h>
+#include <sched.h>
+
+#include "poly.h"
+#include "spsc_queue.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Liczba prób przed uśpieniem czekającego wątku. */
+#define SPINS 64
+
+void SpscQueueInit(SpscQueue *queue, size_t capacity) {
+
+    assert(capacity > FIRST_IDX && (capacity & (capacity - ONE_ELEMENT)) == FIRST_IDX);
+    queue -> slots = (void **) malloc(capacity * sizeof(void *));
+    CHECK_PTR(queue -> slots);
+    queue -> capacity = capacity;
+    atomic_init(&queue -> head, FIRST_IDX);
+    atomic_init(&queue -> tail, FIRST_IDX);
+    atomic_init(&queue -> consumer_waiting, false);
+    atomic_init(&queue -> producer_waiting, false);
+    pthread_mutex_init(&queue -> lock, NULL);
+    pthread_cond_init(&queue -> wake, NULL);
+
+}
+
+void SpscQueueFree(SpscQueue *queue) {
+
+    pthread_mutex_destroy(&queue -> lock);
+    pthread_cond_destroy(&queue -> wake);
+    free(queue -> slots);
+    queue -> slots = NULL;
+
+}
+
+/**
+ * Budzi drugi wątek, jeśli zgłosił on, że zasypia. Wywoływana po zmianie
+ * indeksu kolejki, który zgłaszający wątek sprawdza po zgłoszeniu.
+ * @param[in] queue : kolejka
+ * @param[in] waiting : flaga zasypiania drugiego wątku
+ * @param[in] locked : czy wywołujący wątek trzyma już blokadę usypiania
+ */
+static void WakeWaiting(SpscQueue *queue, atomic_bool *waiting, bool locked) {
+
+    if (!atomic_load(waiting)) return;
+    if (!locked) pthread_mutex_lock(&queue -> lock);
+    pthread_cond_broadcast(&queue -> wake);
+    if (!locked) pthread_mutex_unlock(&queue -> lock);
+
+}
+
+/**
+ * Próbuje włożyć element na koniec kolejki, bez budzenia drugiego wątku.
+ * Indeks drugiego wątku czytany jest z pełnym uporządkowaniem, tak jak
+ * flagi zasypiania, więc wątek zgłaszający zaśnięcie i wątek zmieniający
+ * indeks nie mogą się nawzajem przeoczyć.
+ * @param[in] queue : kolejka
+ * @param[in] item : element
+ * @return Czy w kolejce było miejsce?
+ */
+static bool TryPush(SpscQueue *queue, void *item) {
+
+    size_t tail = atomic_load_explicit(&queue -> tail, memory_order_relaxed);
+    if (tail - atomic_load(&queue -> head) == queue -> capacity) return false;
+    queue -> slots[tail & (queue -> capacity - ONE_ELEMENT)] = item;
+    atomic_store(&queue -> tail, tail + ONE_ELEMENT);
+    return true;
+
+}
+
+/**
+ * Próbuje zdjąć element z początku kolejki, bez budzenia drugiego wątku.
+ * @param[in] queue : kolejka
+ * @param[out] item : zdjęty element
+ * @return Czy kolejka była niepusta?
+ */
+static bool TryPop(SpscQueue *queue, void **item) {
+
+    size_t head = atomic_load_explicit(&queue -> head, memory_order_relaxed);
+    if (atomic_load(&queue -> tail) == head) return false;
+    *item = queue -> slots[head & (queue -> capacity - ONE_ELEMENT)];
+    atomic_store(&queue -> head, head + ONE_ELEMENT);
+    return true;
+
+}
+
+bool SpscQueueTryPush(SpscQueue *queue, void *item) {
+
+    if (!TryPush(queue, item)) return false;
+    WakeWaiting(queue, &queue -> consumer_waiting, false);
+    return true;
+
+}
+
+bool SpscQueueTryPop(SpscQueue *queue, void **item) {
+
+    if (!TryPop(queue, item)) return false;
+    WakeWaiting(queue, &queue -> producer_waiting, false);
+    return true;
+
+}
+
+/**
+ * Czeka, aż operacja na kolejce się powiedzie: najpierw ponawia ją kilka
+ * razy, a potem zasypia na zmiennej warunkowej.
+ * @param[in] queue : kolejka
+ * @param[in] push : czy operacją jest włożenie elementu
+ * @param[in,out] item : wkładany lub zdjęty element
+ */
+static void Wait(SpscQueue *queue, bool push, void **item) {
+
+    atomic_bool *waiting = push ? &queue -> producer_waiting : &queue -> consumer_waiting;
+    atomic_bool *other = push ? &queue -> consumer_waiting : &queue -> producer_waiting;
+    for (size_t i = FIRST_IDX; i < SPINS; i++) {
+        if (push ? TryPush(queue, *item) : TryPop(queue, item)) {
+            WakeWaiting(queue, other, false);
+            return;
+        }
+        sched_yield();
+    }
+
+    pthread_mutex_lock(&queue -> lock);
+    // Wątek najpierw zgłasza, że zasypia, a dopiero potem ponawia operację,
+    // więc drugi wątek, zmieniając później indeks, zobaczy zgłoszenie.
+    atomic_store(waiting, true);
+    while (!(push ? TryPush(queue, *item) : TryPop(queue, item)))
+        pthread_cond_wait(&queue -> wake, &queue -> lock);
+    atomic_store(waiting, false);
+    WakeWaiting(queue, other, true);
+    pthread_mutex_unlock(&queue -> lock);
+
+}
+
+void SpscQueuePush(SpscQueue *queue, void *item) {
+
+    if (!SpscQueueTryPush(queue, item)) Wait(queue, true, &item);
+
+}
+
+void *SpscQueuePop(SpscQueue *queue) {
+
+    void *item;
+    if (!SpscQueueTryPop(queue, &item)) Wait(queue, false, &item);
+    return item;
+
+}
@@ -0,0 +1,78 @@
+/** @file
+  Interfejs ograniczonej kolejki wskaźników dla jednego wątku wkładającego
+  i jednego wątku zdejmującego.
+  Elementy przechowywane są w tablicy cyklicznej, a indeksy początku i końca
+  kolejki są zmiennymi atomowymi, więc wkładanie i zdejmowanie nie zakłada
+  żadnej blokady. Blokada i zmienna warunkowa używane są tylko do uśpienia
+  wątku, który czeka na element pustej kolejki lub na miejsce w pełnej
+  kolejce.
+  @author Julia Podrażka
+ */
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+/**
+ * To jest struktura przechowująca kolejkę.
+ */
+typedef struct SpscQueue {
+    void **slots; ///< tablica cykliczna elementów
+    size_t capacity; ///< rozmiar tablicy, będący potęgą dwójki
+    atomic_size_t head; ///< liczba zdjętych elementów
+    atomic_size_t tail; ///< liczba włożonych elementów
+    atomic_bool consumer_waiting; ///< czy wątek zdejmujący zasypia
+    atomic_bool producer_waiting; ///< czy wątek wkładający zasypia
+    pthread_mutex_t lock; ///< blokada usypiania
+    pthread_cond_t wake; ///< zmienna warunkowa budząca uśpiony wątek
+} SpscQueue;
+
+/**
+ * Inicjuje pustą kolejkę.
+ * @param[out] queue : kolejka
+ * @param[in] capacity : liczba miejsc w kolejce, będąca potęgą dwójki
+ */
+void SpscQueueInit(SpscQueue *queue, size_t capacity);
+
+/**
+ * Zwalnia pamięć kolejki. Elementy pozostałe w kolejce nie są zwalniane.
+ * @param[in] queue : kolejka
+ */
+void SpscQueueFree(SpscQueue *queue);
+
+/**
+ * Próbuje włożyć element na koniec kolejki.
+ * @param[in] queue : kolejka
+ * @param[in] item : element
+ * @return Czy w kolejce było miejsce?
+ */
+bool SpscQueueTryPush(SpscQueue *queue, void *item);
+
+/**
+ * Próbuje zdjąć element z początku kolejki.
+ * @param[in] queue : kolejka
+ * @param[out] item : zdjęty element
+ * @return Czy kolejka była niepusta?
+ */
+bool SpscQueueTryPop(SpscQueue *queue, void **item);
+
+/**
+ * Wkłada element na koniec kolejki, czekając na miejsce, jeśli kolejka
+ * jest pełna.
+ * @param[in] queue : kolejka
+ * @param[in] item : element
+ */
+void SpscQueuePush(SpscQueue *queue, void *item);
+
+/**
+ * Zdejmuje element z początku kolejki, czekając na niego, jeśli kolejka
+ * jest pusta.
+ * @param[in] queue : kolejka
+ * @return zdjęty element
+ */
+void *SpscQueuePop(SpscQueue *queue);
+
+#endif
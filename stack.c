@@ -1,11 +1,15 @@
 /** @file
   Implementacja klasy obsługującej stos wielomianów rzadkich wielu zmiennych.
+  Pamięć stosu jest rozliczana, ale powiększanie stosu nigdy nie przerywa
+  operacji, bo przerwanie mogłoby zostawić stos bez zdjętych argumentów.
   @author Julia Podrażka
  */
 #include <stdlib.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 #include "stack.h"
+#include "memory_budget.h"
 
 /** Początkowy rozmiar tablicy. */
 #define ARR_SIZE 2
@@ -18,9 +22,9 @@
 
 stack InitStack() {
 
-    Poly *poly_stack = (Poly *) malloc(ARR_SIZE * sizeof(Poly));
-    CHECK_PTR(poly_stack);
-    return (stack) {.poly_stack = poly_stack, .top = FIRST_IDX, .size = ARR_SIZE};
+    Poly *poly_stack = (Poly *) MemoryAlloc(ARR_SIZE * sizeof(Poly));
+    return (stack) {.poly_stack = poly_stack, .top = FIRST_IDX, .size = ARR_SIZE,
+                    .limit = SIZE_MAX};
 
 }
 
@@ -42,6 +46,12 @@ size_t NumberOfElements(stack *s) {
 
 }
 
+size_t StackRoom(stack *s) {
+
+    return (*s).top < (*s).limit ? (*s).limit - (*s).top : FIRST_IDX;
+
+}
+
 /**
  * Realokuje pamięć przeznaczoną na stos.
  * @param[in] s : stos
@@ -50,8 +60,9 @@ static void ReallocPolyStack(stack *s) {
 
     if ((*s).top == (*s).size) {
         (*s).size = (*s).size * ARR_SIZE;
-        (*s).poly_stack = realloc((*s).poly_stack, (*s).size * sizeof(Poly));
-        CHECK_PTR((*s).poly_stack);
+        MemoryHoldAborts();
+        (*s).poly_stack = MemoryRealloc((*s).poly_stack, (*s).size * sizeof(Poly));
+        MemoryAllowAborts();
     }
 
 }
@@ -86,6 +97,6 @@ Poly SecondTop(stack *s) {
 void RemoveStack(stack *s) {
 
     for (size_t i = FIRST_IDX; i < (*s).top; i++) PolyDestroy(&(*s).poly_stack[i]);
-    free((*s).poly_stack);
+    MemoryFree((*s).poly_stack);
 
 }
\ No newline at end of file
@@ -14,6 +14,7 @@ typedef struct stack {
     Poly *poly_stack; ///< tablica wielomianów
     size_t top; ///< indeks, na który wkładamy następny wielomian
     size_t size; ///< rozmiar tablicy poly_stack
+    size_t limit; ///< maksymalna liczba wielomianów na stosie
 } stack;
 
 /**
@@ -43,6 +44,14 @@ bool AreTwoElements(stack *s);
  */
 size_t NumberOfElements(stack *s);
 
+/**
+ * Zwraca liczbę wielomianów, które można jeszcze włożyć na stos @p s bez
+ * przekroczenia jego ograniczenia.
+ * @param[in] s : stos
+ * @return liczba wolnych miejsc
+ */
+size_t StackRoom(stack *s);
+
 /**
  * Wstawia wielomian na stos.
  * @param[in] s : stos
@@ -0,0 +1,355 @@
+/** @file
+  Implementacja statystyk wykonywania komend kalkulatora.
+  Bloki statystyk wątków tworzone są przy pierwszym zapisie i połączone
+  w listę, która nie jest nigdy skracana, więc statystyki zakończonych
+  wątków, np. wątku parsującego potoku, pozostają w sumach. Liczniki
+  zmienia tylko wątek będący właścicielem bloku, a odczytywane są
+  atomowo przez wątek wypisujący statystyki.
+  @author Julia Podrażka
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "memory_budget.h"
+#include "stats.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Liczba nanosekund w sekundzie. */
+#define NANOSECONDS 1000000000ULL
+/** Indeks najstarszego bitu licznika czasu. */
+#define HIGHEST_BIT 63
+/** Początkowy stan generatora wybierającego próbkę. */
+#define SAMPLE_SEED 0x9e3779b97f4a7c15ULL
+/** Pierwsze przesunięcie generatora xorshift64. */
+#define XORSHIFT_A 13
+/** Drugie przesunięcie generatora xorshift64. */
+#define XORSHIFT_B 7
+/** Trzecie przesunięcie generatora xorshift64. */
+#define XORSHIFT_C 17
+
+/**
+ * To jest struktura przechowująca statystyki jednego rodzaju instrukcji.
+ */
+typedef struct StatsEntry {
+    atomic_uint_least64_t count; ///< liczba wykonań
+    atomic_uint_least64_t timed; ///< liczba zmierzonych wykonań
+    atomic_uint_least64_t total_ns; ///< łączny czas wykonań
+    atomic_uint_least64_t max_ns; ///< największy czas wykonania
+    atomic_uint_least64_t in_terms; ///< łączna liczba wyrazów wejściowych
+    atomic_uint_least64_t out_terms; ///< łączna liczba wyrazów wynikowych
+    atomic_uint_least64_t histogram[STATS_BUCKETS]; ///< histogram czasów
+} StatsEntry;
+
+/**
+ * To jest struktura przechowująca statystyki jednego rodzaju instrukcji
+ * zsumowane z bloków wszystkich wątków.
+ */
+typedef struct StatsSum {
+    uint64_t count; ///< liczba wykonań
+    uint64_t timed; ///< liczba zmierzonych wykonań
+    uint64_t total_ns; ///< łączny czas wykonań
+    uint64_t max_ns; ///< największy czas wykonania
+    uint64_t in_terms; ///< łączna liczba wyrazów wejściowych
+    uint64_t out_terms; ///< łączna liczba wyrazów wynikowych
+    uint64_t histogram[STATS_BUCKETS]; ///< histogram czasów
+} StatsSum;
+
+/**
+ * To jest struktura przechowująca statystyki jednego wątku.
+ */
+typedef struct StatsBlock {
+    StatsEntry entries[STATS_KINDS]; ///< statystyki rodzajów instrukcji
+    struct StatsBlock *next; ///< blok kolejnego wątku
+} StatsBlock;
+
+/** Nazwy rodzajów statystyk. */
+static const char *const NAMES[STATS_KINDS] = {
+    [OP_PUSH] = "PUSH",
+    [OP_ZERO] = "ZERO",
+    [OP_IS_COEFF] = "IS_COEFF",
+    [OP_IS_ZERO] = "IS_ZERO",
+    [OP_CLONE] = "CLONE",
+    [OP_ADD] = "ADD",
+    [OP_MUL] = "MUL",
+    [OP_NEG] = "NEG",
+    [OP_SUB] = "SUB",
+    [OP_IS_EQ] = "IS_EQ",
+    [OP_DEG] = "DEG",
+    [OP_PRINT] = "PRINT",
+    [OP_POP] = "POP",
+    [OP_AT] = "AT",
+    [OP_AT_MANY] = "AT_MANY",
+    [OP_DEG_BY] = "DEG_BY",
+    [OP_COMPOSE] = "COMPOSE",
+    [OP_SAVE] = "SAVE",
+    [OP_LOAD] = "LOAD",
+    [OP_SAVE_LIBRARY] = "SAVE_LIBRARY",
+    [OP_LOAD_NAMED] = "LOAD_NAMED",
+    [OP_STATS] = "STATS",
+    [OP_SIZE] = "SIZE",
+    [OP_ERROR] = "ERROR",
+    [STATS_PARSE] = "PARSE"
+};
+
+/** Blok statystyk bieżącego wątku. */
+static _Thread_local StatsBlock *own = NULL;
+/** Liczby wykonań każdego rodzaju w bieżącym wątku, które zostaną pominięte
+ * w próbce przed kolejnym zmierzonym wykonaniem. */
+static _Thread_local uint32_t skips[STATS_KINDS];
+/** Stan generatora liczb losowych bieżącego wątku wybierającego próbkę. */
+static _Thread_local uint64_t sample_state = SAMPLE_SEED;
+/** Lista bloków statystyk wszystkich wątków. */
+static StatsBlock *blocks = NULL;
+/** Blokada listy bloków. */
+static pthread_mutex_t blocks_lock = PTHREAD_MUTEX_INITIALIZER;
+/** Czy włączono wypisywanie statystyk. */
+static bool dump_enabled = false;
+/** Czy proces dostał sygnał SIGUSR1. */
+static volatile sig_atomic_t dump_requested = false;
+
+uint64_t StatsNow(void) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * NANOSECONDS + (uint64_t) now.tv_nsec;
+
+}
+
+const char *StatsName(size_t kind) {
+
+    return NAMES[kind];
+
+}
+
+/**
+ * Tworzy blok statystyk bieżącego wątku i dołącza go do listy bloków.
+ * @return blok statystyk
+ */
+static StatsBlock *NewBlock(void) {
+
+    StatsBlock *block = (StatsBlock *) calloc(ONE_ELEMENT, sizeof(StatsBlock));
+    CHECK_PTR(block);
+    pthread_mutex_lock(&blocks_lock);
+    block -> next = blocks;
+    blocks = block;
+    pthread_mutex_unlock(&blocks_lock);
+    return block;
+
+}
+
+/**
+ * Dodaje wartość do licznika. Licznik zmienia tylko jeden wątek, więc
+ * wystarczy osobny odczyt i zapis.
+ * @param[in] counter : licznik
+ * @param[in] value : wartość
+ */
+static void Add(atomic_uint_least64_t *counter, uint64_t value) {
+
+    atomic_store_explicit(counter,
+                          atomic_load_explicit(counter, memory_order_relaxed) + value,
+                          memory_order_relaxed);
+
+}
+
+/**
+ * Zwraca przedział histogramu dla czasu wykonania.
+ * @param[in] elapsed : czas w nanosekundach
+ * @return indeks przedziału
+ */
+static size_t Bucket(uint64_t elapsed) {
+
+    if (elapsed <= ONE_ELEMENT) return FIRST_IDX;
+    size_t bucket = (size_t) (HIGHEST_BIT - __builtin_clzll(elapsed));
+    return bucket < STATS_BUCKETS ? bucket : STATS_BUCKETS - ONE_ELEMENT;
+
+}
+
+bool StatsSample(size_t kind) {
+
+    if (skips[kind] > FIRST_IDX) {
+        skips[kind]--;
+        if (own == NULL) own = NewBlock();
+        Add(&own -> entries[kind].count, ONE_ELEMENT);
+        return false;
+    }
+    // Odstęp jest losowy z przedziału [1, 2 * STATS_SAMPLE_PERIOD - 1].
+    sample_state ^= sample_state << XORSHIFT_A;
+    sample_state ^= sample_state >> XORSHIFT_B;
+    sample_state ^= sample_state << XORSHIFT_C;
+    skips[kind] = (uint32_t) (sample_state % (2 * STATS_SAMPLE_PERIOD - ONE_ELEMENT));
+    return true;
+
+}
+
+void StatsRecord(size_t kind, uint64_t elapsed, size_t in_terms, size_t out_terms) {
+
+    if (own == NULL) own = NewBlock();
+    StatsEntry *entry = &own -> entries[kind];
+    Add(&entry -> count, ONE_ELEMENT);
+    Add(&entry -> timed, ONE_ELEMENT);
+    Add(&entry -> total_ns, elapsed);
+    if (elapsed > atomic_load_explicit(&entry -> max_ns, memory_order_relaxed))
+        atomic_store_explicit(&entry -> max_ns, elapsed, memory_order_relaxed);
+    Add(&entry -> in_terms, in_terms);
+    Add(&entry -> out_terms, out_terms);
+    Add(&entry -> histogram[Bucket(elapsed)], ONE_ELEMENT);
+
+}
+
+/**
+ * Wypisuje napis zakończony znakiem zerowym.
+ * @param[in] writer : stan wypisywania
+ * @param[in] text : napis
+ */
+static void WriteText(Writer *writer, const char *text) {
+
+    WriteChars(writer, text, strlen(text));
+
+}
+
+/**
+ * Wypisuje pole obiektu JSON z liczbą.
+ * @param[in] writer : stan wypisywania
+ * @param[in] name : nazwa pola
+ * @param[in] value : wartość pola
+ */
+static void WriteField(Writer *writer, const char *name, uint64_t value) {
+
+    WriteText(writer, ",\"");
+    WriteText(writer, name);
+    WriteText(writer, "\":");
+    WriteInteger(writer, (long long int) value);
+
+}
+
+/**
+ * Sumuje statystyki jednego rodzaju instrukcji z bloków wszystkich wątków.
+ * Wywołujący musi trzymać blokadę listy bloków.
+ * @param[in] kind : rodzaj statystyk
+ * @return zsumowane statystyki
+ */
+static StatsSum Sum(size_t kind) {
+
+    StatsSum sum;
+    memset(&sum, FIRST_IDX, sizeof(StatsSum));
+    for (StatsBlock *block = blocks; block != NULL; block = block -> next) {
+        StatsEntry *entry = &block -> entries[kind];
+        sum.count += atomic_load_explicit(&entry -> count, memory_order_relaxed);
+        sum.timed += atomic_load_explicit(&entry -> timed, memory_order_relaxed);
+        sum.total_ns += atomic_load_explicit(&entry -> total_ns, memory_order_relaxed);
+        uint64_t max_ns = atomic_load_explicit(&entry -> max_ns, memory_order_relaxed);
+        if (max_ns > sum.max_ns) sum.max_ns = max_ns;
+        sum.in_terms += atomic_load_explicit(&entry -> in_terms, memory_order_relaxed);
+        sum.out_terms += atomic_load_explicit(&entry -> out_terms, memory_order_relaxed);
+        for (size_t i = FIRST_IDX; i < STATS_BUCKETS; i++)
+            sum.histogram[i] += atomic_load_explicit(&entry -> histogram[i],
+                                                     memory_order_relaxed);
+    }
+    return sum;
+
+}
+
+/**
+ * Wypisuje obiekt JSON ze statystykami jednego rodzaju instrukcji.
+ * @param[in] writer : stan wypisywania
+ * @param[in] kind : rodzaj statystyk
+ * @param[in] sum : zsumowane statystyki
+ */
+static void WriteEntry(Writer *writer, size_t kind, const StatsSum *sum) {
+
+    WriteText(writer, "{\"command\":\"");
+    WriteText(writer, NAMES[kind]);
+    WriteChar(writer, '"');
+    WriteField(writer, "count", sum -> count);
+    WriteField(writer, "timed", sum -> timed);
+    WriteField(writer, "total_ns", sum -> total_ns);
+    WriteField(writer, "max_ns", sum -> max_ns);
+    WriteField(writer, "in_terms", sum -> in_terms);
+    WriteField(writer, "out_terms", sum -> out_terms);
+    WriteText(writer, ",\"histogram_ns_log2\":[");
+    size_t last = STATS_BUCKETS;
+    while (last > FIRST_IDX && sum -> histogram[last - ONE_ELEMENT] == FIRST_IDX) last--;
+    for (size_t i = FIRST_IDX; i < last; i++) {
+        if (i != FIRST_IDX) WriteChar(writer, ',');
+        WriteInteger(writer, (long long int) sum -> histogram[i]);
+    }
+    WriteText(writer, "]}");
+
+}
+
+void StatsWrite(Writer *writer) {
+
+    WriteText(writer, "{\"commands\":[");
+    bool first = true;
+    pthread_mutex_lock(&blocks_lock);
+    for (size_t kind = FIRST_IDX; kind < STATS_KINDS; kind++) {
+        StatsSum sum = Sum(kind);
+        if (sum.count == FIRST_IDX) continue;
+        if (!first) WriteChar(writer, ',');
+        first = false;
+        WriteEntry(writer, kind, &sum);
+    }
+    pthread_mutex_unlock(&blocks_lock);
+    WriteText(writer, "],\"memory\":{\"in_use\":");
+    WriteInteger(writer, (long long int) MemoryInUse());
+    WriteField(writer, "peak", MemoryPeak());
+    WriteField(writer, "budget", MemoryBudget());
+    WriteText(writer, "}}");
+    WriteEndLine(writer);
+
+}
+
+void StatsDump(void) {
+
+    Writer writer;
+    WriterInit(&writer, STDERR_FILENO, false);
+    StatsWrite(&writer);
+    WriterFlush(&writer);
+    WriterFree(&writer);
+
+}
+
+/**
+ * Obsługuje sygnał SIGUSR1, zapamiętując, że należy wypisać statystyki.
+ * @param[in] signal_number : numer sygnału
+ */
+static void RequestDump(int signal_number) {
+
+    (void) signal_number;
+    dump_requested = true;
+
+}
+
+void StatsEnableDump(void) {
+
+    dump_enabled = true;
+    struct sigaction action;
+    memset(&action, FIRST_IDX, sizeof(action));
+    action.sa_handler = RequestDump;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &action, NULL);
+
+}
+
+bool StatsDumpEnabled(void) {
+
+    return dump_enabled;
+
+}
+
+void StatsPoll(void) {
+
+    if (!dump_requested) return;
+    dump_requested = false;
+    StatsDump();
+
+}
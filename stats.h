@@ -0,0 +1,114 @@
+/** @file
+  Interfejs statystyk wykonywania komend kalkulatora.
+  Dla każdego rodzaju instrukcji i dla parsowania literałów zliczane są
+  wykonania, łączny i największy czas wykonania, histogram czasów
+  w skali logarytmicznej oraz liczby wyrazów wielomianów wejściowych
+  i wynikowych. Odczyt zegara kosztuje więcej niż wykonanie komendy
+  o stałym koszcie, takiej jak ZERO czy POP, więc dla tych komend czas
+  i wyrazy mogą być mierzone tylko dla próbki wykonań: pierwszego
+  wykonania każdego rodzaju w wątku i dalej średnio co
+  STATS_SAMPLE_PERIOD-tego, w losowych odstępach, żeby próbka nie zależała
+  od okresowości skryptu. Pozostałe wykonania są tylko zliczane. Komendy,
+  których koszt zależy od argumentów, i parsowanie literałów są mierzone
+  zawsze. Każdy wątek zapisuje statystyki we własnym bloku, więc
+  zapis nie wymaga blokad ani operacji atomowych typu odczyt-zapis,
+  a statystyki są sumowane z bloków wszystkich wątków dopiero przy
+  wypisywaniu.
+  @author Julia Podrażka
+ */
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "program.h"
+#include "writer.h"
+
+/** Rodzaj statystyk parsowania literałów, następny po kodach operacji. */
+#define STATS_PARSE OP_COUNT
+/** Liczba rodzajów statystyk. */
+#define STATS_KINDS (OP_COUNT + 1)
+/** Liczba przedziałów histogramu czasów. */
+#define STATS_BUCKETS 40
+/** Średni odstęp między mierzonymi wykonaniami w próbce. */
+#define STATS_SAMPLE_PERIOD 64
+
+/**
+ * Zwraca czas zegara monotonicznego.
+ * @return czas w nanosekundach
+ */
+uint64_t StatsNow(void);
+
+/**
+ * Zwraca nazwę rodzaju statystyk, np. nazwę komendy.
+ * @param[in] kind : kod operacji albo STATS_PARSE
+ * @return nazwa rodzaju statystyk
+ */
+const char *StatsName(size_t kind);
+
+/**
+ * Sprawdza, czy kolejne wykonanie instrukcji lub parsowanie literału
+ * należy do próbki, dla której mierzony jest czas. Wykonanie spoza próbki
+ * jest od razu zapisywane w statystykach wątku, a wykonanie z próbki należy
+ * zapisać po zmierzeniu funkcją StatsRecord.
+ * @param[in] kind : kod operacji albo STATS_PARSE
+ * @return Czy wykonanie należy do próbki?
+ */
+bool StatsSample(size_t kind);
+
+/**
+ * Zapisuje w statystykach wątku jedno zmierzone wykonanie instrukcji lub
+ * parsowanie literału.
+ * @param[in] kind : kod operacji albo STATS_PARSE
+ * @param[in] elapsed : czas wykonania w nanosekundach
+ * @param[in] in_terms : liczba wyrazów wielomianów wejściowych
+ * @param[in] out_terms : liczba wyrazów wielomianów wynikowych
+ */
+void StatsRecord(size_t kind, uint64_t elapsed, size_t in_terms, size_t out_terms);
+
+/**
+ * Wypisuje zsumowane statystyki wszystkich wątków w jednym wierszu
+ * w formacie JSON:
+ * `{"commands":[{"command":"ADD","count":…,"timed":…,"total_ns":…,
+ * "max_ns":…,"in_terms":…,"out_terms":…,"histogram_ns_log2":[…]},…],
+ * "memory":{"in_use":…,"peak":…,"budget":…}}`.
+ * Pole `count` liczy wszystkie wykonania, a pozostałe pola rodzaju dotyczą
+ * tylko `timed` zmierzonych wykonań.
+ * Pomijane są rodzaje, które nie zostały ani razu wykonane. Element
+ * histogramu o indeksie @f$i > 0@f$ liczy wykonania trwające od @f$2^i@f$
+ * do @f$2^{i+1} - 1@f$ nanosekund, a element o indeksie zero wykonania
+ * krótsze niż dwie nanosekundy; histogram kończy się na ostatnim
+ * niezerowym elemencie. Obiekt `memory` zawiera liczbę bajtów używanej
+ * pamięci, jej największą wartość i budżet pamięci, równy zeru, jeśli
+ * pamięć nie jest ograniczona.
+ * @param[in] writer : stan wypisywania
+ */
+void StatsWrite(Writer *writer);
+
+/**
+ * Wypisuje statystyki, tak jak StatsWrite, na standardowe wyjście błędów.
+ */
+void StatsDump(void);
+
+/**
+ * Włącza wypisywanie statystyk na standardowe wyjście błędów po sygnale
+ * SIGUSR1. Statystyki wypisuje wątek wykonujący instrukcje, gdy skończy
+ * wykonywać bieżący ciąg instrukcji i wywoła StatsPoll.
+ */
+void StatsEnableDump(void);
+
+/**
+ * Sprawdza, czy włączono wypisywanie statystyk.
+ * @return Czy wywołano StatsEnableDump?
+ */
+bool StatsDumpEnabled(void);
+
+/**
+ * Wypisuje statystyki, jeśli od poprzedniego wywołania proces dostał
+ * sygnał SIGUSR1.
+ */
+void StatsPoll(void);
+
+#endif
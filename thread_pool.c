@@ -0,0 +1,299 @@
+/** @file
+  Implementacja puli wątków z podkradaniem zadań.
+  Kolejki zadań mają stały rozmiar i są chronione blokadami, osobnymi dla
+  każdego wątku. Zadanie, które nie mieści się w kolejce, jest wykonywane
+  od razu. Bezczynne wątki zasypiają na zmiennej warunkowej, gdy nie ma
+  żadnych oczekujących zadań.
+  @author Julia Podrażka
+ */
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "poly.h"
+#include "arena.h"
+#include "mono_pool.h"
+#include "memory_budget.h"
+#include "thread_pool.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Dwa elementy. */
+#define TWO 2
+/** Liczba zadań mieszczących się w kolejce wątku. */
+#define DEQUE_SIZE 1024
+/** Indeks wątku spoza puli. */
+#define NO_WORKER SIZE_MAX
+
+/**
+ * To jest struktura przechowująca stan wątku puli.
+ */
+typedef struct Worker {
+    pthread_mutex_t lock; ///< blokada kolejki zadań
+    Task *deque[DEQUE_SIZE]; ///< cykliczna kolejka zadań
+    size_t top; ///< indeks najstarszego zadania, podkradanego przez inne wątki
+    size_t bottom; ///< indeks za najnowszym zadaniem
+    pthread_t thread; ///< wątek
+} Worker;
+
+/**
+ * To jest struktura przechowująca zakres indeksów funkcji ParallelFor.
+ */
+typedef struct ForRange {
+    void (*function)(void *arg, size_t idx); ///< wywoływana funkcja
+    void *arg; ///< argument funkcji
+    size_t begin; ///< pierwszy indeks zakresu
+    size_t end; ///< indeks za zakresem
+} ForRange;
+
+/** Wątki puli. */
+static Worker *workers = NULL;
+/** Liczba wątków puli razem z wątkiem głównym. */
+static size_t worker_count = ONE_ELEMENT;
+/** Indeks bieżącego wątku w puli. */
+static _Thread_local size_t current_worker = NO_WORKER;
+/** Liczba zadań czekających w kolejkach. */
+static atomic_size_t pending = FIRST_IDX;
+/** Liczba uśpionych wątków. */
+static atomic_size_t sleepers = FIRST_IDX;
+/** Czy pula jest zatrzymywana. */
+static atomic_bool stopping = false;
+/** Blokada usypiania wątków. */
+static pthread_mutex_t sleep_lock = PTHREAD_MUTEX_INITIALIZER;
+/** Zmienna warunkowa budząca wątki. */
+static pthread_cond_t wake = PTHREAD_COND_INITIALIZER;
+
+/**
+ * Dokłada zadanie na koniec kolejki wątku.
+ * @param[in] worker : wątek
+ * @param[in] task : zadanie
+ * @return Czy zadanie zmieściło się w kolejce?
+ */
+static bool Push(Worker *worker, Task *task) {
+
+    pthread_mutex_lock(&worker -> lock);
+    bool fits = worker -> bottom - worker -> top < DEQUE_SIZE;
+    if (fits) {
+        worker -> deque[worker -> bottom % DEQUE_SIZE] = task;
+        worker -> bottom++;
+    }
+    pthread_mutex_unlock(&worker -> lock);
+    return fits;
+
+}
+
+/**
+ * Zdejmuje zadanie z kolejki wątku, od końca albo od początku.
+ * @param[in] worker : wątek
+ * @param[in] newest : czy zdjąć najnowsze zadanie
+ * @return zadanie lub NULL, jeśli kolejka jest pusta
+ */
+static Task *Take(Worker *worker, bool newest) {
+
+    Task *task = NULL;
+    pthread_mutex_lock(&worker -> lock);
+    if (worker -> bottom != worker -> top) {
+        if (newest) task = worker -> deque[--worker -> bottom % DEQUE_SIZE];
+        else task = worker -> deque[worker -> top++ % DEQUE_SIZE];
+    }
+    pthread_mutex_unlock(&worker -> lock);
+    return task;
+
+}
+
+/**
+ * Szuka zadania dla wątku: najpierw w jego kolejce, potem w kolejkach
+ * pozostałych wątków.
+ * @param[in] self : indeks wątku
+ * @return zadanie lub NULL, jeśli nie ma zadań
+ */
+static Task *FindTask(size_t self) {
+
+    if (atomic_load(&pending) == FIRST_IDX) return NULL;
+    Task *task = Take(&workers[self], true);
+    for (size_t k = ONE_ELEMENT; task == NULL && k < worker_count; k++)
+        task = Take(&workers[(self + k) % worker_count], false);
+    if (task != NULL) atomic_fetch_sub(&pending, ONE_ELEMENT);
+    return task;
+
+}
+
+/**
+ * Wykonuje zadanie zdjęte z kolejki i oznacza je jako wykonane. Zadanie
+ * działa pod strażnikiem wątku, który je utworzył, ale nie może przerwać
+ * operacji, bo jego ramki stosu nie należą do tego wątku.
+ * @param[in] task : zadanie
+ */
+static void RunTask(Task *task) {
+
+    MemoryGuard *outer = MemorySwapGuard(task -> guard);
+    MemoryHoldAborts();
+    task -> function(task -> arg);
+    MemoryAllowAborts();
+    MemorySwapGuard(outer);
+    atomic_store_explicit(&task -> done, true, memory_order_release);
+
+}
+
+/**
+ * Wykonuje zadanie od razu w wątku, który je tworzy, i oznacza je jako
+ * wykonane.
+ * @param[in] task : zadanie
+ */
+static void RunInline(Task *task) {
+
+    task -> function(task -> arg);
+    atomic_store_explicit(&task -> done, true, memory_order_release);
+
+}
+
+/**
+ * Pętla wątku puli.
+ * @param[in] arg : indeks wątku
+ * @return NULL
+ */
+static void *WorkerMain(void *arg) {
+
+    current_worker = (size_t) (uintptr_t) arg;
+    while (true) {
+        Task *task = FindTask(current_worker);
+        if (task != NULL) {
+            RunTask(task);
+            continue;
+        }
+        pthread_mutex_lock(&sleep_lock);
+        // Wątek najpierw zgłasza, że zasypia, a dopiero potem sprawdza
+        // liczbę zadań, więc nie przegapi zadania dodanego w międzyczasie.
+        atomic_fetch_add(&sleepers, ONE_ELEMENT);
+        while (atomic_load(&pending) == FIRST_IDX && !atomic_load(&stopping))
+            pthread_cond_wait(&wake, &sleep_lock);
+        atomic_fetch_sub(&sleepers, ONE_ELEMENT);
+        bool stop = atomic_load(&stopping) && atomic_load(&pending) == FIRST_IDX;
+        pthread_mutex_unlock(&sleep_lock);
+        if (stop) break;
+    }
+    ArenaReleaseSpare();
+    return NULL;
+
+}
+
+void ThreadPoolStart(size_t threads) {
+
+    current_worker = FIRST_IDX;
+    if (threads <= ONE_ELEMENT) return;
+
+    workers = (Worker *) calloc(threads, sizeof(Worker));
+    CHECK_PTR(workers);
+    worker_count = threads;
+    for (size_t i = FIRST_IDX; i < threads; i++)
+        pthread_mutex_init(&workers[i].lock, NULL);
+    MonoPoolEnableLocking();
+    for (size_t i = ONE_ELEMENT; i < threads; i++) {
+        if (pthread_create(&workers[i].thread, NULL, WorkerMain,
+                           (void *) (uintptr_t) i) != 0) exit(1);
+    }
+
+}
+
+void ThreadPoolStop(void) {
+
+    if (workers == NULL) return;
+
+    pthread_mutex_lock(&sleep_lock);
+    atomic_store(&stopping, true);
+    pthread_cond_broadcast(&wake);
+    pthread_mutex_unlock(&sleep_lock);
+    for (size_t i = ONE_ELEMENT; i < worker_count; i++)
+        pthread_join(workers[i].thread, NULL);
+    for (size_t i = FIRST_IDX; i < worker_count; i++)
+        pthread_mutex_destroy(&workers[i].lock);
+    free(workers);
+    workers = NULL;
+    worker_count = ONE_ELEMENT;
+    atomic_store(&stopping, false);
+
+}
+
+size_t ThreadPoolThreads(void) {
+
+    return worker_count;
+
+}
+
+void TaskSpawn(Task *task, TaskFunction function, void *arg) {
+
+    task -> function = function;
+    task -> arg = arg;
+    atomic_init(&task -> done, false);
+    task -> guard = MemoryCurrentGuard();
+    task -> queued = false;
+    if (workers == NULL || current_worker == NO_WORKER) {
+        RunInline(task);
+        return;
+    }
+
+    // Licznik zwiększamy przed dołożeniem zadania, żeby nie spadł poniżej
+    // zera, gdy inny wątek od razu je podkradnie.
+    atomic_fetch_add(&pending, ONE_ELEMENT);
+    MemoryHoldAborts();
+    if (!Push(&workers[current_worker], task)) {
+        MemoryAllowAborts();
+        atomic_fetch_sub(&pending, ONE_ELEMENT);
+        RunInline(task);
+        return;
+    }
+    task -> queued = true;
+    if (atomic_load(&sleepers) > FIRST_IDX) {
+        pthread_mutex_lock(&sleep_lock);
+        pthread_cond_signal(&wake);
+        pthread_mutex_unlock(&sleep_lock);
+    }
+
+}
+
+void TaskWait(Task *task) {
+
+    while (!atomic_load_explicit(&task -> done, memory_order_acquire)) {
+        Task *other = FindTask(current_worker);
+        if (other != NULL) RunTask(other);
+        else sched_yield();
+    }
+    if (task -> queued) MemoryAllowAborts();
+
+}
+
+/**
+ * Wykonuje funkcję ParallelFor dla zakresu indeksów, oddając górną połowę
+ * zakresu innym wątkom.
+ * @param[in] arg : zakres indeksów
+ */
+static void RunRange(void *arg) {
+
+    ForRange *range = (ForRange *) arg;
+    if (range -> end - range -> begin > ONE_ELEMENT) {
+        size_t middle = range -> begin + (range -> end - range -> begin) / TWO;
+        ForRange upper = *range;
+        upper.begin = middle;
+        Task task;
+        TaskSpawn(&task, RunRange, &upper);
+        ForRange lower = *range;
+        lower.end = middle;
+        RunRange(&lower);
+        TaskWait(&task);
+    } else if (range -> end > range -> begin) {
+        range -> function(range -> arg, range -> begin);
+    }
+
+}
+
+void ParallelFor(size_t count, void (*function)(void *arg, size_t idx),
+                 void *arg) {
+
+    ForRange range = (ForRange) {.function = function, .arg = arg,
+                                 .begin = FIRST_IDX, .end = count};
+    RunRange(&range);
+
+}
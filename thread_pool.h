@@ -0,0 +1,81 @@
+/** @file
+  Interfejs puli wątków z podkradaniem zadań (ang. work stealing).
+  Każdy wątek puli ma własną kolejkę zadań: wątek zdejmuje zadania ze swojej
+  kolejki od końca, a bezczynne wątki podkradają je z początku kolejek innych
+  wątków. Wątek główny programu jest wątkiem puli o indeksie zero.
+  Zadania tworzą drzewo typu fork-join: wątek czekający na zakończenie
+  zadania w tym czasie wykonuje inne zadania.
+  @author Julia Podrażka
+ */
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+struct MemoryGuard;
+
+/** To jest typ funkcji wykonywanej przez zadanie. */
+typedef void (*TaskFunction)(void *arg);
+
+/**
+ * To jest struktura przechowująca zadanie. Pamięć zadania należy do
+ * wywołującego i musi pozostać poprawna do powrotu z funkcji TaskWait.
+ */
+typedef struct Task {
+    TaskFunction function; ///< funkcja zadania
+    void *arg; ///< argument funkcji zadania
+    atomic_bool done; ///< czy zadanie zostało wykonane
+    struct MemoryGuard *guard; ///< strażnik budżetu pamięci wątku tworzącego zadanie
+    bool queued; ///< czy zadanie trafiło do kolejki
+} Task;
+
+/**
+ * Uruchamia pulę wątków. Dla @p threads nie większego od jeden zadania są
+ * wykonywane od razu przez wątek, który je tworzy.
+ * @param[in] threads : liczba wątków razem z wątkiem głównym
+ */
+void ThreadPoolStart(size_t threads);
+
+/**
+ * Zatrzymuje pulę wątków i czeka na zakończenie wątków.
+ */
+void ThreadPoolStop(void);
+
+/**
+ * Zwraca liczbę wątków puli razem z wątkiem głównym.
+ * @return liczba wątków
+ */
+size_t ThreadPoolThreads(void);
+
+/**
+ * Tworzy zadanie wykonujące @p function z argumentem @p arg. Jeśli bieżący
+ * wątek nie należy do puli, to zadanie jest wykonywane od razu. Zadanie
+ * dołożone do kolejki jest wykonywane pod strażnikiem budżetu pamięci
+ * wątku, który je utworzył, a do powrotu z funkcji TaskWait ten wątek nie
+ * może przerwać swojej operacji.
+ * @param[out] task : zadanie
+ * @param[in] function : funkcja zadania
+ * @param[in] arg : argument funkcji zadania
+ */
+void TaskSpawn(Task *task, TaskFunction function, void *arg);
+
+/**
+ * Czeka na zakończenie zadania, wykonując w tym czasie inne zadania.
+ * @param[in] task : zadanie utworzone funkcją TaskSpawn
+ */
+void TaskWait(Task *task);
+
+/**
+ * Wywołuje równolegle @p function dla indeksów od 0 do @p count - 1.
+ * Zakres indeksów jest dzielony rekurencyjnie na połowy, więc bezczynne
+ * wątki podkradają duże fragmenty pracy.
+ * @param[in] count : liczba indeksów
+ * @param[in] function : funkcja wywoływana z argumentem i indeksem
+ * @param[in] arg : argument funkcji
+ */
+void ParallelFor(size_t count, void (*function)(void *arg, size_t idx),
+                 void *arg);
+
+#endif
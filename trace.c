@@ -0,0 +1,310 @@
+/** @file
+  Implementacja śledzenia wykonania kalkulatora.
+  Bufory cykliczne przydzielane są wątkom przy pierwszym zapisie
+  i połączone w listę, która nie jest nigdy skracana. Po zakończeniu wątku
+  jego bufor razem z przedziałami trafia na listę wolnych buforów, z której
+  bierze go kolejny nowy wątek, więc serwer tworzący wątek dla każdej sesji
+  ma co najwyżej tyle buforów, ile wątków działało jednocześnie. Każdy
+  przedział pamięta identyfikator wątku, który go zapisał.
+  @author Julia Podrażka
+ */
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#include "poly.h"
+#include "writer.h"
+#include "trace.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Liczba nanosekund w sekundzie. */
+#define NANOSECONDS 1000000000ULL
+/** Liczba nanosekund w mikrosekundzie. */
+#define NANOSECONDS_PER_MICRO 1000
+/** Baza zapisu liczb. */
+#define BASE 10
+/** Uprawnienia tworzonego pliku. */
+#define FILE_MODE 0644
+
+/**
+ * To jest struktura przechowująca jeden przedział.
+ */
+typedef struct TraceEvent {
+    const char *name; ///< nazwa przedziału
+    uint64_t start; ///< początek w nanosekundach
+    uint64_t duration; ///< długość w nanosekundach
+    uint64_t arg; ///< argument przedziału
+    uint32_t tid; ///< identyfikator wątku systemu
+    uint32_t kind; ///< rodzaj przedziału
+} TraceEvent;
+
+/**
+ * To jest struktura przechowująca bufor cykliczny przedziałów.
+ */
+typedef struct TraceRing {
+    TraceEvent *events; ///< przedziały
+    size_t count; ///< liczba zapisanych przedziałów, także zastąpionych
+    struct TraceRing *next; ///< kolejny bufor na liście wszystkich buforów
+    struct TraceRing *next_free; ///< kolejny bufor na liście wolnych buforów
+} TraceRing;
+
+/** Nazwy rodzajów przedziałów. */
+static const char *const NAMES[TRACE_KINDS] = {
+    [TRACE_LINE] = "LINE",
+    [TRACE_PARSE] = "PARSE",
+    [TRACE_MUL] = "PolyMul",
+    [TRACE_SORT] = "AddMonos sort",
+    [TRACE_MERGE] = "AddMonos merge",
+    [TRACE_DELETE_ZERO] = "DeletePolyZero",
+    [TRACE_OUTPUT] = "output",
+    [TRACE_WRITE] = "write"
+};
+
+/** Kategorie rodzajów przedziałów. */
+static const char *const CATEGORIES[TRACE_KINDS] = {
+    [TRACE_LINE] = "line",
+    [TRACE_PARSE] = "parse",
+    [TRACE_MUL] = "poly",
+    [TRACE_SORT] = "poly",
+    [TRACE_MERGE] = "poly",
+    [TRACE_DELETE_ZERO] = "poly",
+    [TRACE_OUTPUT] = "output",
+    [TRACE_WRITE] = "output"
+};
+
+/** Nazwy argumentów rodzajów przedziałów. */
+static const char *const ARGS[TRACE_KINDS] = {
+    [TRACE_LINE] = "line",
+    [TRACE_PARSE] = "line",
+    [TRACE_MUL] = "level",
+    [TRACE_SORT] = "monos",
+    [TRACE_MERGE] = "monos",
+    [TRACE_DELETE_ZERO] = "monos",
+    [TRACE_OUTPUT] = "line",
+    [TRACE_WRITE] = "bytes"
+};
+
+/** Czy śledzenie jest włączone. */
+static bool enabled = false;
+/** Deskryptor pliku, do którego zostaną zapisane przedziały. */
+static int trace_fd = -1;
+/** Liczba przedziałów w buforze jednego wątku. */
+static size_t capacity = TRACE_DEFAULT_EVENTS;
+/** Lista buforów wszystkich wątków. */
+static TraceRing *rings = NULL;
+/** Lista buforów zakończonych wątków. */
+static TraceRing *free_rings = NULL;
+/** Blokada list buforów. */
+static pthread_mutex_t rings_lock = PTHREAD_MUTEX_INITIALIZER;
+/** Klucz wątku, którego destruktor oddaje bufor zakończonego wątku. */
+static pthread_key_t ring_key;
+/** Bufor bieżącego wątku. */
+static _Thread_local TraceRing *own = NULL;
+/** Identyfikator wątku systemu dla bieżącego wątku. */
+static _Thread_local uint32_t own_tid = FIRST_IDX;
+/** Poziom rekurencji mnożenia w bieżącym wątku. */
+static _Thread_local size_t level = FIRST_IDX;
+
+/**
+ * Zwraca czas zegara monotonicznego.
+ * @return czas w nanosekundach
+ */
+static uint64_t Now(void) {
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t) now.tv_sec * NANOSECONDS + (uint64_t) now.tv_nsec;
+
+}
+
+/**
+ * Oddaje bufor zakończonego wątku na listę wolnych buforów.
+ * @param[in] ring : bufor wątku
+ */
+static void ReleaseRing(void *ring) {
+
+    pthread_mutex_lock(&rings_lock);
+    ((TraceRing *) ring) -> next_free = free_rings;
+    free_rings = (TraceRing *) ring;
+    pthread_mutex_unlock(&rings_lock);
+
+}
+
+/**
+ * Przydziela bieżącemu wątkowi bufor, w miarę możliwości wolny bufor
+ * zakończonego wątku.
+ * @return bufor wątku
+ */
+static TraceRing *AttachRing(void) {
+
+    pthread_mutex_lock(&rings_lock);
+    TraceRing *ring = free_rings;
+    if (ring != NULL) free_rings = ring -> next_free;
+    else {
+        ring = (TraceRing *) calloc(ONE_ELEMENT, sizeof(TraceRing));
+        CHECK_PTR(ring);
+        ring -> events = (TraceEvent *) malloc(capacity * sizeof(TraceEvent));
+        CHECK_PTR(ring -> events);
+        ring -> next = rings;
+        rings = ring;
+    }
+    pthread_mutex_unlock(&rings_lock);
+    pthread_setspecific(ring_key, ring);
+    own_tid = (uint32_t) syscall(SYS_gettid);
+    return ring;
+
+}
+
+bool TraceStart(const char *path, size_t events) {
+
+    trace_fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, FILE_MODE);
+    if (trace_fd < FIRST_IDX) return false;
+    pthread_key_create(&ring_key, ReleaseRing);
+    capacity = events;
+    enabled = true;
+    return true;
+
+}
+
+bool TraceEnabled(void) {
+
+    return enabled;
+
+}
+
+uint64_t TraceBegin(void) {
+
+    return enabled ? Now() : FIRST_IDX;
+
+}
+
+void TraceRecord(TraceKind kind, const char *name, uint64_t start, uint64_t end,
+                 uint64_t arg) {
+
+    if (!enabled) return;
+    if (own == NULL) own = AttachRing();
+    own -> events[own -> count % capacity] = (TraceEvent) {
+            .name = name, .start = start, .duration = end - start, .arg = arg,
+            .tid = own_tid, .kind = kind};
+    own -> count++;
+
+}
+
+void TraceEnd(TraceKind kind, uint64_t start, uint64_t arg) {
+
+    if (start == FIRST_IDX) return;
+    TraceRecord(kind, NAMES[kind], start, Now(), arg);
+
+}
+
+size_t TraceEnterLevel(void) {
+
+    return level++;
+
+}
+
+void TraceLeaveLevel(size_t previous) {
+
+    level = previous;
+
+}
+
+/**
+ * Wypisuje napis zakończony znakiem zerowym.
+ * @param[in] writer : stan wypisywania
+ * @param[in] text : napis
+ */
+static void WriteText(Writer *writer, const char *text) {
+
+    WriteChars(writer, text, strlen(text));
+
+}
+
+/**
+ * Wypisuje czas w mikrosekundach z częścią ułamkową, bo takiej jednostki
+ * używa format zdarzeń Chrome.
+ * @param[in] writer : stan wypisywania
+ * @param[in] ns : czas w nanosekundach
+ */
+static void WriteMicros(Writer *writer, uint64_t ns) {
+
+    WriteInteger(writer, (long long int) (ns / NANOSECONDS_PER_MICRO));
+    WriteChar(writer, '.');
+    uint64_t fraction = ns % NANOSECONDS_PER_MICRO;
+    for (uint64_t digit = NANOSECONDS_PER_MICRO / BASE; digit > FIRST_IDX; digit /= BASE)
+        WriteChar(writer, (char) ('0' + fraction / digit % BASE));
+
+}
+
+/**
+ * Wypisuje przedział jako zdarzenie Chrome typu "X".
+ * @param[in] writer : stan wypisywania
+ * @param[in] event : przedział
+ * @param[in] pid : identyfikator procesu
+ */
+static void WriteEvent(Writer *writer, const TraceEvent *event, pid_t pid) {
+
+    WriteText(writer, "{\"name\":\"");
+    WriteText(writer, event -> name);
+    WriteText(writer, "\",\"cat\":\"");
+    WriteText(writer, CATEGORIES[event -> kind]);
+    WriteText(writer, "\",\"ph\":\"X\",\"ts\":");
+    WriteMicros(writer, event -> start);
+    WriteText(writer, ",\"dur\":");
+    WriteMicros(writer, event -> duration);
+    WriteText(writer, ",\"pid\":");
+    WriteInteger(writer, (long long int) pid);
+    WriteText(writer, ",\"tid\":");
+    WriteInteger(writer, (long long int) event -> tid);
+    WriteText(writer, ",\"args\":{\"");
+    WriteText(writer, ARGS[event -> kind]);
+    WriteText(writer, "\":");
+    WriteInteger(writer, (long long int) event -> arg);
+    WriteText(writer, "}}");
+
+}
+
+void TraceStop(void) {
+
+    if (!enabled) return;
+    enabled = false;
+
+    Writer writer;
+    WriterInit(&writer, trace_fd, false);
+    pid_t pid = getpid();
+    size_t dropped = FIRST_IDX;
+    bool first = true;
+    WriteText(&writer, "{\"traceEvents\":[");
+    for (TraceRing *ring = rings; ring != NULL;) {
+        // Najstarszy zachowany przedział leży tuż za ostatnio zapisanym.
+        size_t kept = ring -> count < capacity ? ring -> count : capacity;
+        dropped += ring -> count - kept;
+        for (size_t i = ring -> count - kept; i < ring -> count; i++) {
+            if (!first) WriteText(&writer, ",\n");
+            first = false;
+            WriteEvent(&writer, &ring -> events[i % capacity], pid);
+        }
+        TraceRing *next = ring -> next;
+        free(ring -> events);
+        free(ring);
+        ring = next;
+    }
+    WriteText(&writer, "],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped_events\":");
+    WriteInteger(&writer, (long long int) dropped);
+    WriteText(&writer, "}}");
+    WriteEndLine(&writer);
+    WriterFree(&writer);
+    close(trace_fd);
+    rings = NULL;
+    free_rings = NULL;
+    own = NULL;
+    pthread_setspecific(ring_key, NULL);
+
+}
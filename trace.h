@@ -0,0 +1,116 @@
+/** @file
+  Interfejs śledzenia wykonania kalkulatora.
+  W trybie śledzenia zapisywane są przedziały czasu wykonania wierszy
+  i głównych etapów obliczeń: parsowania literałów, poziomów rekurencji
+  funkcji PolyMul, sortowania i scalania w AddMonos, usuwania zerowych
+  wielomianów w DeletePolyZero oraz wypisywania. Każdy wątek zapisuje
+  przedziały we własnym buforze cyklicznym o stałym rozmiarze, w którym
+  nowe przedziały zastępują najstarsze, więc śledzenie nie zajmuje coraz
+  więcej pamięci. Przy zakończeniu śledzenia przedziały zapisywane są do
+  pliku w formacie zdarzeń Chrome (chrome://tracing, Perfetto) z czasem
+  zegara CLOCK_MONOTONIC, identyfikatorami wątków systemu i procesu.
+
+  W tych samych miejscach umieszczone są statyczne punkty sondowania
+  (USDT, provider `calc`), do których mogą się podłączyć perf lub bpftrace,
+  np. `bpftrace -e 'usdt:./DuzyProjekt:calc:mul__start { ... }'`. Punkty
+  są dostępne, jeśli przy kompilacji jest nagłówek <sys/sdt.h>; wyłączone
+  kosztują jedną instrukcję nop i działają niezależnie od trybu śledzenia.
+  @author Julia Podrażka
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__has_include)
+#if __has_include(<sys/sdt.h>)
+#include <sys/sdt.h>
+/** Punkt sondowania @p name providera `calc` z argumentami liczbowymi. */
+#define TRACE_PROBE(name, ...) STAP_PROBEV(calc, name, __VA_ARGS__)
+#endif
+#endif
+
+#ifndef TRACE_PROBE
+/** Punkt sondowania, pusty bez nagłówka <sys/sdt.h>. */
+#define TRACE_PROBE(name, ...) ((void) 0)
+#endif
+
+/** Domyślna liczba przedziałów w buforze jednego wątku. */
+#define TRACE_DEFAULT_EVENTS (1 << 16)
+
+/**
+ * To są rodzaje śledzonych przedziałów.
+ */
+typedef enum TraceKind {
+    TRACE_LINE, ///< wykonanie wiersza, nazwane kodem operacji
+    TRACE_PARSE, ///< parsowanie literału
+    TRACE_MUL, ///< mnożenie wielomianów niestałych na jednym poziomie rekurencji
+    TRACE_SORT, ///< sortowanie jednomianów w AddMonos
+    TRACE_MERGE, ///< scalanie jednomianów w AddMonos
+    TRACE_DELETE_ZERO, ///< usuwanie zerowych wielomianów w DeletePolyZero
+    TRACE_OUTPUT, ///< wypisywanie wielomianu komendą PRINT
+    TRACE_WRITE, ///< zapis bufora wyjścia do deskryptora pliku
+    TRACE_KINDS ///< liczba rodzajów przedziałów
+} TraceKind;
+
+/**
+ * Włącza śledzenie. Należy ją wywołać przed uruchomieniem innych wątków.
+ * @param[in] path : ścieżka pliku, do którego zostaną zapisane przedziały
+ * @param[in] events : liczba przedziałów w buforze jednego wątku
+ * @return Czy udało się utworzyć plik?
+ */
+bool TraceStart(const char *path, size_t events);
+
+/**
+ * Wyłącza śledzenie i zapisuje przedziały do pliku. Należy ją wywołać po
+ * zakończeniu innych wątków.
+ */
+void TraceStop(void);
+
+/**
+ * Sprawdza, czy śledzenie jest włączone.
+ * @return Czy śledzenie jest włączone?
+ */
+bool TraceEnabled(void);
+
+/**
+ * Zwraca czas zegara monotonicznego, jeśli śledzenie jest włączone.
+ * @return czas w nanosekundach albo zero
+ */
+uint64_t TraceBegin(void);
+
+/**
+ * Zapisuje przedział zaczęty funkcją TraceBegin i kończący się teraz.
+ * @param[in] kind : rodzaj przedziału
+ * @param[in] start : wynik funkcji TraceBegin
+ * @param[in] arg : argument przedziału, zależny od rodzaju
+ */
+void TraceEnd(TraceKind kind, uint64_t start, uint64_t arg);
+
+/**
+ * Zapisuje przedział o podanej nazwie i czasach, np. zmierzonych już dla
+ * statystyk. Nazwa musi istnieć do zakończenia śledzenia.
+ * @param[in] kind : rodzaj przedziału
+ * @param[in] name : nazwa przedziału
+ * @param[in] start : początek w nanosekundach
+ * @param[in] end : koniec w nanosekundach
+ * @param[in] arg : argument przedziału, zależny od rodzaju
+ */
+void TraceRecord(TraceKind kind, const char *name, uint64_t start, uint64_t end,
+                 uint64_t arg);
+
+/**
+ * Wchodzi na kolejny poziom rekurencji mnożenia w bieżącym wątku.
+ * @return poziom, od zera dla mnożenia rozpoczętego przez wątek
+ */
+size_t TraceEnterLevel(void);
+
+/**
+ * Wraca na poziom rekurencji mnożenia, np. po przerwaniu operacji.
+ * @param[in] previous : wynik funkcji TraceEnterLevel albo zero
+ */
+void TraceLeaveLevel(size_t previous);
+
+#endif
@@ -0,0 +1,444 @@
+/** @file
+  Implementacja buforowanego wypisywania wyników kalkulatora.
+  @author Julia Podrażka
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/uio.h>
+
+#include "poly.h"
+#include "writer.h"
+#include "trace.h"
+
+/** Pierwszy indeks w tablicy. */
+#define FIRST_IDX 0
+/** Jeden element w tablicy. */
+#define ONE_ELEMENT 1
+/** Dwa elementy w tablicy. */
+#define TWO_ELEMENTS 2
+/** Rozmiar bufora wyjścia w bajtach. */
+#define BUFFER_SIZE (1 << 20)
+/** Rozmiar bufora odroczonego wypisywania w bajtach. */
+#define PAGE_SIZE (64 * 1024)
+/** Początkowy rozmiar tablicy zapisów odroczonego wypisywania. */
+#define RECORDS_SIZE 16
+/** Początkowy rozmiar stosu wypisywanych wielomianów. */
+#define FRAMES_SIZE 16
+/** Maksymalna liczba znaków liczby typu long long int razem z minusem. */
+#define MAX_DIGITS 20
+/** Baza zapisu liczb. */
+#define BASE 10
+/** Kod ascii znaku zera. */
+#define ZERO_CHAR 48
+/** Kod ascii znaku minusa. */
+#define MINUS 45
+/** Kod ascii znaku nowej linii. */
+#define NEWLINE 10
+/** Kod ascii znaku spacji. */
+#define SPACE 32
+/** Początek wiersza z błędem. */
+#define ERROR_PREFIX "ERROR "
+
+/**
+ * To jest struktura przechowująca wielomian, którego jednomiany są
+ * aktualnie wypisywane.
+ */
+typedef struct PrintFrame {
+    const Poly *p; ///< wielomian
+    size_t idx; ///< indeks aktualnie wypisywanego jednomianu
+    bool non_constant; ///< czy wiadomo już, że wielomian nie jest stały
+} PrintFrame;
+
+void WriterInit(Writer *writer, int fd, bool flush_lines) {
+
+    writer -> fd = fd;
+    writer -> buffer = (char *) malloc(BUFFER_SIZE);
+    CHECK_PTR(writer -> buffer);
+    writer -> used = FIRST_IDX;
+    writer -> capacity = BUFFER_SIZE;
+    writer -> flush_lines = flush_lines;
+    writer -> failed = false;
+    writer -> inline_errors = false;
+    writer -> frames = NULL;
+    writer -> frame_capacity = FIRST_IDX;
+    writer -> records = NULL;
+    writer -> record_count = FIRST_IDX;
+    writer -> record_capacity = FIRST_IDX;
+    writer -> hand_off = NULL;
+    writer -> hand_off_arg = NULL;
+
+}
+
+void WriterPageInit(WriterPage *page) {
+
+    page -> buffer = (char *) malloc(PAGE_SIZE);
+    CHECK_PTR(page -> buffer);
+    page -> used = FIRST_IDX;
+    page -> capacity = PAGE_SIZE;
+    page -> records = (WriterRecord *) malloc(RECORDS_SIZE * sizeof(WriterRecord));
+    CHECK_PTR(page -> records);
+    page -> record_count = FIRST_IDX;
+    page -> record_capacity = RECORDS_SIZE;
+
+}
+
+void WriterPageFree(WriterPage *page) {
+
+    for (size_t i = FIRST_IDX; i < page -> record_count; i++) {
+        if (page -> records[i].kind == RECORD_POLY)
+            PolyDestroy(&page -> records[i].poly);
+    }
+    free(page -> buffer);
+    free(page -> records);
+    page -> buffer = NULL;
+    page -> records = NULL;
+
+}
+
+void WriterSwapPage(Writer *writer, WriterPage *page) {
+
+    WriterPage taken = (WriterPage) {.buffer = writer -> buffer,
+                                     .used = writer -> used,
+                                     .capacity = writer -> capacity,
+                                     .records = writer -> records,
+                                     .record_count = writer -> record_count,
+                                     .record_capacity = writer -> record_capacity};
+    writer -> buffer = page -> buffer;
+    writer -> used = page -> used;
+    writer -> capacity = page -> capacity;
+    writer -> records = page -> records;
+    writer -> record_count = page -> record_count;
+    writer -> record_capacity = page -> record_capacity;
+    *page = taken;
+
+}
+
+void WriterInitDeferred(Writer *writer, void (*hand_off)(Writer *writer, void *arg),
+                        void *arg) {
+
+    WriterInit(writer, -ONE_ELEMENT, false);
+    // Bufor wyjścia zastępujemy buforem strony, który jest mniejszy, bo
+    // strony krążą między wątkami.
+    free(writer -> buffer);
+    WriterPage page;
+    WriterPageInit(&page);
+    WriterSwapPage(writer, &page);
+    writer -> hand_off = hand_off;
+    writer -> hand_off_arg = arg;
+
+}
+
+void WriterFree(Writer *writer) {
+
+    WriterFlush(writer);
+    if (writer -> records != NULL) {
+        WriterPage page = (WriterPage) {.buffer = NULL, .records = NULL};
+        WriterSwapPage(writer, &page);
+        WriterPageFree(&page);
+    } else free(writer -> buffer);
+    free(writer -> frames);
+    writer -> buffer = NULL;
+    writer -> frames = NULL;
+
+}
+
+/** Stan wypisywania na standardowe wyjście. */
+static Writer stdout_writer;
+/** Czy stan wypisywania na standardowe wyjście został zainicjowany. */
+static bool stdout_ready = false;
+/** Stan wypisywania zwracany w bieżącym wątku zamiast standardowego wyjścia. */
+static _Thread_local Writer *redirect = NULL;
+
+/**
+ * Opróżnia bufor standardowego wyjścia przy zakończeniu programu.
+ */
+static void FlushStdout(void) {
+
+    WriterFlush(&stdout_writer);
+
+}
+
+void StdoutRedirect(Writer *writer) {
+
+    redirect = writer;
+
+}
+
+Writer *StdoutWriter(void) {
+
+    if (redirect != NULL) return redirect;
+    if (!stdout_ready) {
+        // Na terminal wypisujemy od razu całe wiersze, tak jak robi to stdio.
+        WriterInit(&stdout_writer, STDOUT_FILENO, isatty(STDOUT_FILENO));
+        atexit(FlushStdout);
+        stdout_ready = true;
+    }
+    return &stdout_writer;
+
+}
+
+/**
+ * Wypisuje do deskryptora pliku kolejne fragmenty pamięci, ponawiając
+ * wywołanie funkcji writev po częściowym zapisie lub przerwaniu sygnałem.
+ * Przy błędzie zapisu pozostałe dane są porzucane.
+ * @param[in] writer : stan wypisywania
+ * @param[in] iov : fragmenty pamięci
+ * @param[in] count : liczba fragmentów
+ */
+static void WriteVector(Writer *writer, struct iovec *iov, int count) {
+
+    while (count > FIRST_IDX) {
+        ssize_t written = writev(writer -> fd, iov, count);
+        if (written < FIRST_IDX) {
+            if (errno == EINTR) continue;
+            writer -> failed = true;
+            return;
+        }
+        while (count > FIRST_IDX && (size_t) written >= iov -> iov_len) {
+            written -= (ssize_t) iov -> iov_len;
+            iov++;
+            count--;
+        }
+        if (count > FIRST_IDX) {
+            iov -> iov_base = (char *) iov -> iov_base + written;
+            iov -> iov_len -= (size_t) written;
+        }
+    }
+
+}
+
+void WriterFlush(Writer *writer) {
+
+    if (writer -> hand_off != NULL) {
+        if (writer -> used > FIRST_IDX || writer -> record_count > FIRST_IDX)
+            writer -> hand_off(writer, writer -> hand_off_arg);
+        return;
+    }
+    if (writer -> used == FIRST_IDX) return;
+
+    struct iovec iov = (struct iovec) {.iov_base = writer -> buffer,
+                                       .iov_len = writer -> used};
+    TRACE_PROBE(write__start, writer -> used);
+    uint64_t start = TraceBegin();
+    WriteVector(writer, &iov, ONE_ELEMENT);
+    TraceEnd(TRACE_WRITE, start, writer -> used);
+    TRACE_PROBE(write__done, writer -> used);
+    writer -> used = FIRST_IDX;
+
+}
+
+void WriteChars(Writer *writer, const char *chars, size_t count) {
+
+    if (count > writer -> capacity - writer -> used) {
+        if (writer -> hand_off != NULL) {
+            // Przy odroczonym wypisywaniu dzielimy napis na kolejne bufory.
+            size_t part = writer -> capacity - writer -> used;
+            memcpy(writer -> buffer + writer -> used, chars, part);
+            writer -> used += part;
+            WriterFlush(writer);
+            WriteChars(writer, chars + part, count - part);
+            return;
+        }
+        if (count >= writer -> capacity) {
+            // Długi napis wypisujemy razem z buforem jednym wywołaniem writev,
+            // bez kopiowania go do bufora.
+            struct iovec iov[TWO_ELEMENTS] = {
+                    {.iov_base = writer -> buffer, .iov_len = writer -> used},
+                    {.iov_base = (void *) chars, .iov_len = count}};
+            WriteVector(writer, iov, TWO_ELEMENTS);
+            writer -> used = FIRST_IDX;
+            return;
+        }
+        WriterFlush(writer);
+    }
+    memcpy(writer -> buffer + writer -> used, chars, count);
+    writer -> used += count;
+
+}
+
+void WriteChar(Writer *writer, char c) {
+
+    if (writer -> used == writer -> capacity) WriterFlush(writer);
+    writer -> buffer[writer -> used++] = c;
+
+}
+
+void WriteInteger(Writer *writer, long long int value) {
+
+    if (writer -> capacity - writer -> used < MAX_DIGITS) WriterFlush(writer);
+
+    // Cyfry zapisujemy od końca; moduł liczymy na liczbach bez znaku, żeby
+    // nie przepełnić typu dla najmniejszej liczby ujemnej.
+    char digits[MAX_DIGITS];
+    size_t start = MAX_DIGITS;
+    unsigned long long int magnitude = value < FIRST_IDX
+                                       ? FIRST_IDX - (unsigned long long int) value
+                                       : (unsigned long long int) value;
+    do {
+        digits[--start] = (char) (ZERO_CHAR + magnitude % BASE);
+        magnitude /= BASE;
+    } while (magnitude > FIRST_IDX);
+    if (value < FIRST_IDX) digits[--start] = MINUS;
+    memcpy(writer -> buffer + writer -> used, digits + start, MAX_DIGITS - start);
+    writer -> used += MAX_DIGITS - start;
+
+}
+
+void WriteEndLine(Writer *writer) {
+
+    WriteChar(writer, NEWLINE);
+    if (writer -> flush_lines) WriterFlush(writer);
+
+}
+
+/**
+ * Sprawdza, czy wielomian jest stały, czyli czy jest współczynnikiem lub
+ * ma jeden jednomian o zerowym wykładniku, którego współczynnik jest stały.
+ * Odpowiada wywołaniu funkcji AllExpZero i GetCoeff, bez rekurencji.
+ * @param[in] p : wielomian
+ * @param[out] coeff : wartość wielomianu stałego
+ * @return Czy wielomian jest stały?
+ */
+static bool ConstantValue(const Poly *p, poly_coeff_t *coeff) {
+
+    while (!PolyIsCoeff(p)) {
+        if (p -> size != ONE_ELEMENT || MonoGetExp(&p -> arr[FIRST_IDX]) != FIRST_IDX)
+            return false;
+        p = &p -> arr[FIRST_IDX].p;
+    }
+    *coeff = p -> coeff;
+    return true;
+
+}
+
+/**
+ * Dokłada wielomian na stos wypisywanych wielomianów.
+ * @param[in] writer : stan wypisywania
+ * @param[in] depth : liczba wielomianów na stosie
+ * @param[in] p : wielomian
+ * @param[in] non_constant : czy wiadomo, że wielomian nie jest stały
+ */
+static void PushFrame(Writer *writer, size_t *depth, const Poly *p,
+                      bool non_constant) {
+
+    if (*depth == writer -> frame_capacity) {
+        writer -> frame_capacity = writer -> frame_capacity == FIRST_IDX
+                                   ? FRAMES_SIZE
+                                   : TWO_ELEMENTS * writer -> frame_capacity;
+        writer -> frames = (PrintFrame *) realloc(
+                writer -> frames, writer -> frame_capacity * sizeof(PrintFrame));
+        CHECK_PTR(writer -> frames);
+    }
+    writer -> frames[(*depth)++] = (PrintFrame) {.p = p, .idx = FIRST_IDX,
+                                                 .non_constant = non_constant};
+
+}
+
+/**
+ * Dokłada zapis na koniec tablicy zapisów odroczonego wypisywania.
+ * @param[in] writer : stan odroczonego wypisywania
+ * @param[in] record : zapis bez ustawionego przesunięcia
+ */
+static void AddRecord(Writer *writer, WriterRecord record) {
+
+    if (writer -> record_count == writer -> record_capacity) {
+        writer -> record_capacity *= TWO_ELEMENTS;
+        writer -> records = (WriterRecord *) realloc(
+                writer -> records, writer -> record_capacity * sizeof(WriterRecord));
+        CHECK_PTR(writer -> records);
+    }
+    record.offset = writer -> used;
+    writer -> records[writer -> record_count++] = record;
+
+}
+
+void WriteError(Writer *writer, size_t line_number, const char *error) {
+
+    if (writer -> records != NULL)
+        AddRecord(writer, (WriterRecord) {.kind = RECORD_ERROR,
+                                          .line_number = line_number,
+                                          .error = error});
+    else if (writer -> inline_errors) {
+        WriteChars(writer, ERROR_PREFIX, strlen(ERROR_PREFIX));
+        WriteInteger(writer, (long long int) line_number);
+        WriteChar(writer, SPACE);
+        WriteChars(writer, error, strlen(error));
+        WriteEndLine(writer);
+    } else fprintf(stderr, "ERROR %zu %s\n", line_number, error);
+
+}
+
+void WriterReplay(Writer *writer, WriterPage *page) {
+
+    size_t start = FIRST_IDX;
+    for (size_t i = FIRST_IDX; i < page -> record_count; i++) {
+        WriterRecord *record = &page -> records[i];
+        WriteChars(writer, page -> buffer + start, record -> offset - start);
+        start = record -> offset;
+        if (record -> kind == RECORD_POLY) {
+            WritePoly(writer, &record -> poly);
+            PolyDestroy(&record -> poly);
+        } else {
+            // Na terminal wypisujemy wcześniejsze wiersze przed błędem, tak
+            // jak przy wypisywaniu bez odroczenia.
+            if (writer -> flush_lines) WriterFlush(writer);
+            WriteError(writer, record -> line_number, record -> error);
+        }
+    }
+    WriteChars(writer, page -> buffer + start, page -> used - start);
+    if (writer -> flush_lines) WriterFlush(writer);
+    page -> used = FIRST_IDX;
+    page -> record_count = FIRST_IDX;
+
+}
+
+void WritePoly(Writer *writer, const Poly *p) {
+
+    if (writer -> records != NULL) {
+        // Wielomian wypisze inny wątek, więc zapamiętujemy jego kopię.
+        AddRecord(writer, (WriterRecord) {.kind = RECORD_POLY,
+                                          .poly = PolyClone(p)});
+        return;
+    }
+
+    size_t depth = FIRST_IDX;
+    PushFrame(writer, &depth, p, false);
+    while (depth > FIRST_IDX) {
+        PrintFrame *frame = &writer -> frames[depth - ONE_ELEMENT];
+        poly_coeff_t coeff;
+        if (frame -> non_constant || !ConstantValue(frame -> p, &coeff)) {
+            // Jednomiany wypisujemy od najwyższego wykładnika. Jeśli wielomian
+            // nie jest stały i ma jeden jednomian o zerowym wykładniku, to
+            // jego współczynnik też nie jest stały.
+            const Poly *poly = frame -> p;
+            frame -> idx = poly -> size - ONE_ELEMENT;
+            bool child_non_constant = poly -> size == ONE_ELEMENT &&
+                                      MonoGetExp(&poly -> arr[FIRST_IDX]) == FIRST_IDX;
+            WriteChar(writer, '(');
+            PushFrame(writer, &depth, &poly -> arr[frame -> idx].p, child_non_constant);
+            continue;
+        }
+        WriteInteger(writer, coeff);
+        depth--;
+
+        // Po wypisaniu współczynnika kończymy jednomiany, aż trafimy na
+        // wielomian, który ma jeszcze niewypisane jednomiany.
+        while (depth > FIRST_IDX) {
+            frame = &writer -> frames[depth - ONE_ELEMENT];
+            WriteChar(writer, ',');
+            WriteInteger(writer, MonoGetExp(&frame -> p -> arr[frame -> idx]));
+            WriteChar(writer, ')');
+            if (frame -> idx > FIRST_IDX) {
+                frame -> idx--;
+                WriteChars(writer, "+(", TWO_ELEMENTS);
+                PushFrame(writer, &depth, &frame -> p -> arr[frame -> idx].p, false);
+                break;
+            }
+            depth--;
+        }
+    }
+
+}
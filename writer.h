@@ -0,0 +1,206 @@
+/** @file
+  Interfejs buforowanego wypisywania wyników kalkulatora.
+  Wypisywane znaki trafiają do dużego bufora, który jest opróżniany
+  funkcją write dopiero po zapełnieniu, na końcu działania programu albo,
+  gdy wyjście jest terminalem, na końcu każdego wiersza. Liczby są
+  zamieniane na cyfry bez użycia funkcji z rodziny printf, a wielomiany
+  wypisywane są bez rekurencji.
+
+  Wypisywanie może być też odroczone: znaki zbierane są w buforze, a zamiast
+  wielomianów i błędów zapamiętywane są zapisy, które inny wątek
+  wypisuje później w tej samej kolejności (patrz WriterReplay).
+  @author Julia Podrażka
+ */
+#ifndef WRITER_H
+#define WRITER_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "poly.h"
+
+struct PrintFrame;
+
+/**
+ * To są rodzaje zapisów odroczonego wypisywania.
+ */
+typedef enum WriterRecordKind {
+    RECORD_POLY, ///< wielomian wypisywany w formacie komendy PRINT
+    RECORD_ERROR ///< błąd wypisywany na standardowe wyjście błędów
+} WriterRecordKind;
+
+/**
+ * To jest struktura przechowująca zapis odroczonego wypisywania.
+ */
+typedef struct WriterRecord {
+    size_t offset; ///< liczba znaków bufora wypisywanych przed zapisem
+    WriterRecordKind kind; ///< rodzaj zapisu
+    /**
+     * To jest unia przechowująca treść zapisu, zależną od jego rodzaju.
+     */
+    union {
+        Poly poly; ///< kopia wielomianu dla RECORD_POLY
+        /** Błąd dla RECORD_ERROR. */
+        struct {
+            size_t line_number; ///< numer wiersza
+            const char *error; ///< treść błędu
+        };
+    };
+} WriterRecord;
+
+/**
+ * To jest struktura przechowująca znaki i zapisy odroczonego wypisywania,
+ * przekazywane między wątkami.
+ */
+typedef struct WriterPage {
+    char *buffer; ///< zebrane znaki
+    size_t used; ///< liczba znaków
+    size_t capacity; ///< rozmiar bufora
+    WriterRecord *records; ///< zapisy w kolejności wypisywania
+    size_t record_count; ///< liczba zapisów
+    size_t record_capacity; ///< rozmiar tablicy zapisów
+} WriterPage;
+
+/**
+ * To jest struktura przechowująca stan wypisywania do deskryptora pliku.
+ */
+typedef struct Writer {
+    int fd; ///< deskryptor pliku, do którego wypisujemy
+    char *buffer; ///< bufor wyjścia
+    size_t used; ///< liczba znaków w buforze
+    size_t capacity; ///< rozmiar bufora
+    bool flush_lines; ///< czy opróżniać bufor na końcu każdego wiersza
+    bool failed; ///< czy wystąpił błąd zapisu
+    bool inline_errors; ///< czy błędy wypisywać do deskryptora razem z wynikami
+    struct PrintFrame *frames; ///< stos wypisywanych wielomianów
+    size_t frame_capacity; ///< rozmiar stosu wypisywanych wielomianów
+    WriterRecord *records; ///< zapisy odroczonego wypisywania albo NULL
+    size_t record_count; ///< liczba zapisów
+    size_t record_capacity; ///< rozmiar tablicy zapisów
+    /** Funkcja przekazująca zebrane znaki i zapisy przy opróżnianiu bufora. */
+    void (*hand_off)(struct Writer *writer, void *arg);
+    void *hand_off_arg; ///< argument funkcji hand_off
+} Writer;
+
+/**
+ * Inicjuje wypisywanie do deskryptora pliku @p fd.
+ * @param[out] writer : stan wypisywania
+ * @param[in] fd : deskryptor pliku
+ * @param[in] flush_lines : czy opróżniać bufor na końcu każdego wiersza
+ */
+void WriterInit(Writer *writer, int fd, bool flush_lines);
+
+/**
+ * Inicjuje odroczone wypisywanie. Zamiast wypisywać bufor, funkcja
+ * WriterFlush wywołuje @p hand_off, która powinna zabrać zebrane znaki
+ * i zapisy funkcją WriterSwapPage.
+ * @param[out] writer : stan wypisywania
+ * @param[in] hand_off : funkcja przekazująca zebrane znaki i zapisy
+ * @param[in] arg : argument funkcji @p hand_off
+ */
+void WriterInitDeferred(Writer *writer, void (*hand_off)(Writer *writer, void *arg),
+                        void *arg);
+
+/**
+ * Opróżnia bufor i zwalnia pamięć używaną przy wypisywaniu.
+ * @param[in] writer : stan wypisywania
+ */
+void WriterFree(Writer *writer);
+
+/**
+ * Zwraca stan wypisywania na standardowe wyjście. Jego bufor jest
+ * opróżniany również przy zakończeniu programu funkcją exit.
+ * @return stan wypisywania na standardowe wyjście
+ */
+Writer *StdoutWriter(void);
+
+/**
+ * Sprawia, że w bieżącym wątku funkcja StdoutWriter zwraca @p writer.
+ * @param[in] writer : stan wypisywania albo NULL, żeby przywrócić
+ * wypisywanie na standardowe wyjście
+ */
+void StdoutRedirect(Writer *writer);
+
+/**
+ * Inicjuje pustą stronę odroczonego wypisywania.
+ * @param[out] page : strona
+ */
+void WriterPageInit(WriterPage *page);
+
+/**
+ * Zwalnia pamięć strony, usuwając wielomiany z jej zapisów.
+ * @param[in] page : strona
+ */
+void WriterPageFree(WriterPage *page);
+
+/**
+ * Zamienia znaki i zapisy odroczonego wypisywania z zawartością strony.
+ * @param[in] writer : stan odroczonego wypisywania
+ * @param[in,out] page : pusta strona, która dostaje zebrane znaki i zapisy
+ */
+void WriterSwapPage(Writer *writer, WriterPage *page);
+
+/**
+ * Wypisuje zawartość strony: znaki i wielomiany do @p writer, a błędy na
+ * standardowe wyjście błędów, w kolejności, w jakiej zostały zebrane.
+ * Opróżnia stronę.
+ * @param[in] writer : stan wypisywania
+ * @param[in,out] page : strona
+ */
+void WriterReplay(Writer *writer, WriterPage *page);
+
+/**
+ * Wypisuje zawartość bufora do deskryptora pliku. Przy błędzie zapisu
+ * ustawia pole failed, a niewypisane znaki są porzucane. Przy odroczonym
+ * wypisywaniu przekazuje niepuste znaki i zapisy funkcji hand_off.
+ * @param[in] writer : stan wypisywania
+ */
+void WriterFlush(Writer *writer);
+
+/**
+ * Wypisuje @p count znaków.
+ * @param[in] writer : stan wypisywania
+ * @param[in] chars : znaki
+ * @param[in] count : liczba znaków
+ */
+void WriteChars(Writer *writer, const char *chars, size_t count);
+
+/**
+ * Wypisuje znak.
+ * @param[in] writer : stan wypisywania
+ * @param[in] c : znak
+ */
+void WriteChar(Writer *writer, char c);
+
+/**
+ * Wypisuje liczbę całkowitą w zapisie dziesiętnym.
+ * @param[in] writer : stan wypisywania
+ * @param[in] value : liczba
+ */
+void WriteInteger(Writer *writer, long long int value);
+
+/**
+ * Wypisuje wielomian w formacie komendy PRINT.
+ * @param[in] writer : stan wypisywania
+ * @param[in] p : wielomian
+ */
+void WritePoly(Writer *writer, const Poly *p);
+
+/**
+ * Wypisuje na standardowe wyjście błędów błąd wiersza w formacie
+ * `ERROR numer treść`, a przy odroczonym wypisywaniu zapamiętuje go.
+ * Jeśli ustawione jest pole inline_errors, to błąd wypisywany jest razem
+ * z wynikami.
+ * @param[in] writer : stan wypisywania
+ * @param[in] line_number : numer wiersza
+ * @param[in] error : treść błędu
+ */
+void WriteError(Writer *writer, size_t line_number, const char *error);
+
+/**
+ * Kończy wiersz i, jeśli trzeba, opróżnia bufor.
+ * @param[in] writer : stan wypisywania
+ */
+void WriteEndLine(Writer *writer);
+
+#endif